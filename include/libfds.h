@@ -56,8 +56,10 @@
 #include <libfds/converters.h>
 #include <libfds/drec.h>
 #include <libfds/iemgr.h>
+#include <libfds/json.h>
 #include <libfds/ipfix_parsers.h>
 #include <libfds/ipfix_structs.h>
+#include <libfds/projection.h>
 #include <libfds/template.h>
 #include <libfds/template_mgr.h>
 #include <libfds/xml_parser.h>
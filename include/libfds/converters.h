@@ -1003,6 +1003,62 @@ fds_get_string(const void *field, size_t size, char *value)
     return FDS_OK;
 }
 
+/**
+ * \brief Get values of unsigned integers from multiple records (stored in big endian order
+ *   a.k.a. network byte order)
+ *
+ * The i-th value is read from a data field that starts at \p offset bytes from the i-th base
+ * pointer (e.g. the start of a data record) and converted to host byte order. Unlike
+ * fds_get_uint_be(), the size of the fields is determined only once for all values.
+ * \param[in]  bases  Array of base pointers
+ * \param[in]  offset Offset of the data fields from base pointers
+ * \param[in]  size   Size of the data fields (min: 1 byte, max: 8 bytes)
+ * \param[out] values Array for the results (at least \p cnt items)
+ * \param[in]  cnt    Number of values to convert
+ * \return On success returns #FDS_OK and fills the \p values.
+ *   Otherwise (usually the incorrect \p size of the fields) returns
+ *   #FDS_ERR_ARG and the \p values are not filled.
+ */
+FDS_API int
+fds_get_uint_be_bulk(const uint8_t *const *bases, size_t offset, size_t size, uint64_t *values,
+    size_t cnt);
+
+/**
+ * \brief Get values of signed integers from multiple records (stored in big endian order
+ *   a.k.a. network byte order)
+ *
+ * See fds_get_uint_be_bulk() for the description of the source fields.
+ * \param[in]  bases  Array of base pointers
+ * \param[in]  offset Offset of the data fields from base pointers
+ * \param[in]  size   Size of the data fields (min: 1 byte, max: 8 bytes)
+ * \param[out] values Array for the results (at least \p cnt items)
+ * \param[in]  cnt    Number of values to convert
+ * \return On success returns #FDS_OK and fills the \p values.
+ *   Otherwise (usually the incorrect \p size of the fields) returns
+ *   #FDS_ERR_ARG and the \p values are not filled.
+ */
+FDS_API int
+fds_get_int_be_bulk(const uint8_t *const *bases, size_t offset, size_t size, int64_t *values,
+    size_t cnt);
+
+/**
+ * \brief Get values of floats/doubles from multiple records (stored in big endian order
+ *   a.k.a. network byte order)
+ *
+ * See fds_get_uint_be_bulk() for the description of the source fields.
+ * \param[in]  bases  Array of base pointers
+ * \param[in]  offset Offset of the data fields from base pointers
+ * \param[in]  size   Size of the data fields (4 or 8 bytes)
+ * \param[out] values Array for the results (at least \p cnt items)
+ * \param[in]  cnt    Number of values to convert
+ * \return On success returns #FDS_OK and fills the \p values.
+ *   Otherwise (usually the incorrect \p size of the fields) returns
+ *   #FDS_ERR_ARG and the \p values are not filled.
+ */
+FDS_API int
+fds_get_float_be_bulk(const uint8_t *const *bases, size_t offset, size_t size, double *values,
+    size_t cnt);
+
 /**
  * @}
  *
@@ -1230,6 +1286,67 @@ FDS_API int
 fds_datetime2str_be(const void *field, size_t size, enum fds_iemgr_element_type type,
     char *str, size_t str_size, enum fds_convert_time_fmt fmt);
 
+/**
+ * \brief Cached date and time of a context of timestamp formatting
+ * \note Members of the structure are private and should not be accessed directly.
+ */
+struct fds_datetime_cache {
+    /** Seconds since the UNIX epoch                                                         */
+    time_t sec;
+    /** Is the cached value valid                                                            */
+    bool valid;
+    /** Length of the date and time                                                          */
+    uint8_t date_len;
+    /** Length of the timezone designator                                                    */
+    uint8_t zone_len;
+    /** Date and time i.e. "YYYY-MM-DDTHH:MM:SS" (without the terminating null byte)         */
+    char date[32];
+    /** Timezone designator i.e. "Z" or "+hhmm" (without the terminating null byte)          */
+    char zone[8];
+};
+
+/**
+ * \brief Context of timestamp formatting
+ *
+ * The context caches the formatted date and time (and the timezone designator) of the last
+ * converted second, separately for UTC and local time. Consecutive timestamps within the same
+ * second are formatted without calling gmtime_r()/localtime_r() and strftime().
+ *
+ * The context must be initialized by fds_datetime_ctx_init() (or zeroed) before the first use.
+ * \warning The context is not thread-safe. Use a separate context for each thread.
+ */
+struct fds_datetime_ctx {
+    /** Cached date and time (index 0 = UTC, index 1 = local time)                           */
+    struct fds_datetime_cache _cache[2];
+};
+
+/**
+ * \brief Initialize a context of timestamp formatting
+ * \param[in] ctx Context
+ */
+FDS_API void
+fds_datetime_ctx_init(struct fds_datetime_ctx *ctx);
+
+/**
+ * \brief Convert a value of a timestamp (in big endian order a.k.a.
+ *   network byte order) to a character string using a formatting context
+ *
+ * The output is the same as the output of fds_datetime2str_be(), however, the date and time
+ * of the last converted second is cached in the context \p ctx.
+ * \note fds_datetime2str_be() uses an internal context of the calling thread.
+ * \param[in]  ctx       Context
+ * \param[in]  field     Pointer to the data field (in "network byte order")
+ * \param[in]  size      Size of the data field (in bytes)
+ * \param[in]  type      Type of the timestamp
+ * \param[out] str       Pointer to an output character buffer
+ * \param[in]  str_size  Size of the output buffer (in bytes)
+ * \param[in]  fmt       Output format (see ::fds_convert_time_fmt)
+ * \return Same as a return value of fds_field2str_be().
+ */
+FDS_API int
+fds_datetime2str_ctx_be(struct fds_datetime_ctx *ctx, const void *field, size_t size,
+    enum fds_iemgr_element_type type, char *str, size_t str_size, enum fds_convert_time_fmt fmt);
+
 /**
  * \brief Convert a boolean value to a character string
  *
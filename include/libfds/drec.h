@@ -98,6 +98,10 @@ struct fds_drec_field {
  *
  * Try to find the first occurrence of the field defined by an Enterprise Number
  * and an Information Element ID in a data record.
+ *
+ * The field is located using the lookup index of the template. Fields with known offset (i.e.
+ * all fields of templates without variable-length fields) are accessed directly. Otherwise, only
+ * fields between the first variable-length field and the required field are skipped.
  * \param[in]  rec   Pointer to the data record
  * \param[in]  pen   Private Enterprise Number
  * \param[in]  id    Information Element ID
@@ -109,6 +113,90 @@ struct fds_drec_field {
 FDS_API int
 fds_drec_find(struct fds_drec *rec, uint32_t pen, uint16_t id, struct fds_drec_field *field);
 
+/** \brief Location of a data field in a prepared data record                            */
+struct fds_drec_loc {
+    /** Offset of the field data from the start of the record (behind octet prefix)      */
+    uint16_t offset;
+    /** Real length of the field                                                         */
+    uint16_t size;
+};
+
+/**
+ * \brief Prepared data record
+ *
+ * Data record with pre-calculated location of all its fields. Useful if multiple fields of
+ * the same record based on a template with variable-length fields (i.e. a dynamic template)
+ * must be accessed, because the record is parsed only once.
+ */
+struct fds_drec_prep {
+    /** Pointer to the data record                                                       */
+    struct fds_drec *rec;
+    /** Location of fields (caller-provided array, one item per a template field)        */
+    struct fds_drec_loc *locs;
+};
+
+/**
+ * \brief Prepare a data record for repeated access to its fields
+ *
+ * Locations of all fields in the record are determined and stored to the caller-provided
+ * array \p locs. After that, each field can be accessed in constant time using
+ * fds_drec_prep_get() or fds_drec_prep_find() until the record or the array is freed or
+ * modified.
+ *
+ * \code{.c}
+ *  struct fds_drec_loc locs[256]; // Templates with more fields are rejected
+ *  struct fds_drec_prep prep;
+ *  struct fds_drec_field field;
+ *
+ *  if (fds_drec_prepare(&prep, rec, locs, 256) != FDS_OK) {
+ *      // Malformed record...
+ *  }
+ *
+ *  if (fds_drec_prep_find(&prep, pen, id, &field) != FDS_EOC) {
+ *      // Add your code here...
+ *  }
+ * \endcode
+ *
+ * \param[out] prep     Prepared data record to initialize
+ * \param[in]  rec      Pointer to the data record
+ * \param[in]  locs     Array for locations of the fields
+ * \param[in]  locs_cnt Number of items of the array (must be at least number of fields in the
+ *   template of the record i.e. fds_template#fields_cnt_total)
+ * \return #FDS_OK on success.
+ * \return #FDS_ERR_ARG if the array is too small.
+ * \return #FDS_ERR_FORMAT if the fields exceed the size of the record.
+ */
+FDS_API int
+fds_drec_prepare(struct fds_drec_prep *prep, struct fds_drec *rec, struct fds_drec_loc *locs,
+    uint16_t locs_cnt);
+
+/**
+ * \brief Get a field of a prepared data record by its index
+ * \param[in]  prep  Prepared data record
+ * \param[in]  idx   Index of the field in the record (starts from 0)
+ * \param[out] field Pointer to a variable where the result will be stored
+ * \return If the index is valid, the function will fill \p field and return the index.
+ *   Otherwise returns #FDS_EOC and the \p field is not filled.
+ */
+FDS_API int
+fds_drec_prep_get(const struct fds_drec_prep *prep, uint16_t idx, struct fds_drec_field *field);
+
+/**
+ * \brief Find the first occurrence of a field in a prepared data record
+ *
+ * Same as fds_drec_find(), but the location of the field is not determined from the record.
+ * \param[in]  prep  Prepared data record
+ * \param[in]  pen   Private Enterprise Number
+ * \param[in]  id    Information Element ID
+ * \param[out] field Pointer to a variable where the result will be stored
+ * \return If the field is present in the record, this function will fill \p field and return
+ *   an index of the field in the record (the index starts from 0). Otherwise (the field is not
+ *   present in the record) returns #FDS_EOC and the \p field is not filled.
+ */
+FDS_API int
+fds_drec_prep_find(const struct fds_drec_prep *prep, uint32_t pen, uint16_t id,
+    struct fds_drec_field *field);
+
 /** \brief Iterator over all data fields in a data record                                */
 struct fds_drec_iter {
     /** Current field of an iterator                                                     */
@@ -295,6 +295,8 @@ struct fds_iemgr_elem {
 
 /** Element Manager  */
 typedef struct fds_iemgr fds_iemgr_t;
+/** Changes of definitions of elements between two managers */
+typedef struct fds_iemgr_diff fds_iemgr_diff_t;
 
 /**
  * \brief Check if a type of an Information Element is a signed integer
@@ -424,12 +426,104 @@ fds_iemgr_create();
 
 /**
  * \brief Create and copy a manager
+ *
+ * If the manager is immutable (see fds_iemgr_freeze()), scopes and elements are not copied but
+ * shared by both managers. Definitions of elements stay valid until all managers that share
+ * them are modified or destroyed.
  * \param[in] mgr Manager what will be copied
  * \return Copied manager on success. Otherwise NULL (i.e. memory allocation error)
  */
 FDS_API fds_iemgr_t *
 fds_iemgr_copy(const fds_iemgr_t *mgr);
 
+/**
+ * \brief Make scopes and elements of the manager immutable
+ *
+ * Nothing is copied, but copies of an immutable manager (see fds_iemgr_copy()) share its
+ * scopes and elements using a reference counter. Any modification of a manager (e.g.
+ * fds_iemgr_elem_add(), fds_iemgr_read_file()) makes its private copy first, therefore, other
+ * managers are not affected. A manager loaded from a binary image (see fds_iemgr_read_bin()) is
+ * always immutable.
+ *
+ * \note Lookup functions don't use any locks. Each thread should use its own copy of the
+ *   manager, because a manager itself cannot be modified while it is accessed by other threads.
+ * \param[in,out] mgr Manager
+ * \return #FDS_OK on success, otherwise #FDS_ERR_NOMEM and an error message is set
+ */
+FDS_API int
+fds_iemgr_freeze(fds_iemgr_t *mgr);
+
+/**
+ * \brief Share unchanged scopes with another immutable manager
+ *
+ * Each scope of the manager \p mgr that has exactly the same definition (including all its
+ * elements) as the corresponding scope of the manager \p base is replaced with the scope of
+ * \p base. Definitions of unchanged elements are therefore the same objects in both managers
+ * and stay valid until the last manager that shares them is modified or destroyed. This is
+ * useful after reloading definitions of elements, because only changed elements are reported
+ * by fds_iemgr_diff_create().
+ *
+ * The manager \p mgr becomes immutable (see fds_iemgr_freeze()).
+ * \param[in,out] mgr  Manager
+ * \param[in]     base Immutable manager (e.g. the previous version of the manager)
+ * \return #FDS_OK on success.
+ * \return #FDS_ERR_ARG if the manager \p base is not immutable.
+ * \return #FDS_ERR_NOMEM on memory allocation error.
+ * \note On failure, an error message of \p mgr is set.
+ */
+FDS_API int
+fds_iemgr_rebase(fds_iemgr_t *mgr, const fds_iemgr_t *base);
+
+/**
+ * \brief Find out which elements differ between two managers
+ *
+ * An element (PEN, ID) differs if it is defined only in one of the managers or if the managers
+ * use different definitions of the element. Definitions are compared by identity, not by
+ * content, therefore, all elements of two independently loaded managers differ. Use
+ * fds_iemgr_rebase() to share unchanged definitions first.
+ *
+ * The diff doesn't refer to the managers and it can be used after their destruction.
+ * \param[in] old_mgr Old manager (can be NULL, i.e. no elements)
+ * \param[in] new_mgr New manager (can be NULL, i.e. no elements)
+ * \return Pointer to the diff or NULL (memory allocation error)
+ */
+FDS_API fds_iemgr_diff_t *
+fds_iemgr_diff_create(const fds_iemgr_t *old_mgr, const fds_iemgr_t *new_mgr);
+
+/**
+ * \brief Destroy a diff of managers
+ * \param[in] diff Diff
+ */
+FDS_API void
+fds_iemgr_diff_destroy(fds_iemgr_diff_t *diff);
+
+/**
+ * \brief Get the number of elements that differ
+ * \param[in] diff Diff
+ * \return Number of elements
+ */
+FDS_API size_t
+fds_iemgr_diff_cnt(const fds_iemgr_diff_t *diff);
+
+/**
+ * \brief Check if an element differs
+ * \param[in] diff Diff
+ * \param[in] pen  Private Enterprise Number of the element
+ * \param[in] id   ID of the element
+ * \return True or false
+ */
+FDS_API bool
+fds_iemgr_diff_find(const fds_iemgr_diff_t *diff, uint32_t pen, uint16_t id);
+
+/**
+ * \brief Check if any element of a scope differs
+ * \param[in] diff Diff
+ * \param[in] pen  Private Enterprise Number of the scope
+ * \return True or false
+ */
+FDS_API bool
+fds_iemgr_diff_find_pen(const fds_iemgr_diff_t *diff, uint32_t pen);
+
 /**
  * Remove all elements from the manager
  * \param[in,out] mgr Manager
@@ -472,6 +566,57 @@ fds_iemgr_compare_timestamps(fds_iemgr_t *mgr);
 FDS_API int
 fds_iemgr_read_dir(fds_iemgr_t *mgr, const char *path);
 
+/**
+ * \brief Load XML files from dir using a precompiled binary image if possible
+ *
+ * If the image exists and all files and directories it was created from are unchanged
+ * (see fds_iemgr_read_bin()), the image is loaded. Otherwise the XML files are loaded
+ * (see fds_iemgr_read_dir()) and the image is created again (see fds_iemgr_save_bin()).
+ * Failure to create the image is ignored.
+ * \param[in,out] mgr   Manager
+ * \param[in]     path  Path to the directories with saved XML files
+ * \param[in]     image Path to the binary image
+ * \return FDS_OK on success, otherwise FDS_ERR_NOMEM or FDS_ERR_FORMAT and an error message is set
+ *   (see fds_iemgr_last_err())
+ * \warning All previously parsed elements will be removed
+ */
+FDS_API int
+fds_iemgr_read_dir_cached(fds_iemgr_t *mgr, const char *path, const char *image);
+
+/**
+ * \brief Save the manager to a binary image
+ *
+ * The image contains all scopes and elements of the manager and fingerprints (paths and
+ * modification times) of all parsed files. It can be loaded much faster than XML files
+ * (see fds_iemgr_read_bin()). The file is replaced atomically.
+ * \warning The image is not portable between different architectures.
+ * \param[in,out] mgr  Manager
+ * \param[in]     path Path to the image
+ * \return FDS_OK on success, otherwise FDS_ERR_DENIED or FDS_ERR_NOMEM and an error message is set
+ *   (see fds_iemgr_last_err())
+ */
+FDS_API int
+fds_iemgr_save_bin(fds_iemgr_t *mgr, const char *path);
+
+/**
+ * \brief Load the manager from a binary image
+ *
+ * The image is mapped into memory and its elements are not allocated one by one. Until
+ * the first modification of the manager (e.g. adding an element), names of scopes and elements
+ * point to the mapped image. The first modification converts the manager into a regular one.
+ * \param[in,out] mgr  Manager
+ * \param[in]     path Path to the image
+ * \return FDS_OK on success.
+ * \return FDS_ERR_DIFF if any of the files the image was created from has been modified.
+ * \return FDS_ERR_FORMAT if the image cannot be read or is malformed.
+ * \return FDS_ERR_NOMEM on memory allocation error.
+ * \note On failure, an error message is set (see fds_iemgr_last_err()). If the image is outdated
+ *   or malformed, elements of the manager are not modified.
+ * \warning All previously parsed elements will be removed on success.
+ */
+FDS_API int
+fds_iemgr_read_bin(fds_iemgr_t *mgr, const char *path);
+
 /**
  * \brief Load an XML file and save elements to the manager
  * \param[in,out] mgr       Manager with elements
@@ -490,6 +635,8 @@ fds_iemgr_read_file(fds_iemgr_t *mgr, const char *file_path, bool overwrite);
 
 /**
  * \brief Find an element with a given ID in the manager
+ *
+ * The lookup takes constant time, i.e. it is suitable for per-record processing.
  * \param[in] mgr Manager
  * \param[in] pen Private Enterprise Number
  * \param[in] id  ID of element
@@ -514,6 +661,34 @@ fds_iemgr_elem_find_id(const fds_iemgr_t *mgr, uint32_t pen, uint16_t id);
 FDS_API const struct fds_iemgr_elem *
 fds_iemgr_elem_find_name(const fds_iemgr_t *mgr, const char *name);
 
+/**
+ * \brief Find an element with a given name of a given length in the manager
+ *
+ * The same as fds_iemgr_elem_find_name(), but the name doesn't have to be NULL terminated,
+ * e.g. it can be part of a larger string. The lookup doesn't allocate any memory.
+ * \param[in] mgr  Manager
+ * \param[in] name Prefix and Name of element separated by ':', e.g. 'scope_name:element_name'
+ * \param[in] len  Length of the name (in bytes)
+ * \return Element if exists, otherwise NULL.
+ */
+FDS_API const struct fds_iemgr_elem *
+fds_iemgr_elem_find_name_len(const fds_iemgr_t *mgr, const char *name, size_t len);
+
+/**
+ * \brief Find elements with given names in the manager
+ *
+ * The same as calling fds_iemgr_elem_find_name() for each name, but the lookups are
+ * interleaved to hide memory latency.
+ * \param[in]  mgr   Manager
+ * \param[in]  names Array of names (see fds_iemgr_elem_find_name())
+ * \param[in]  cnt   Number of names
+ * \param[out] elems Array of \p cnt elements (NULL for each name that cannot be found)
+ * \return Number of found elements
+ */
+FDS_API size_t
+fds_iemgr_elem_find_names(const fds_iemgr_t *mgr, const char * const *names, size_t cnt,
+    const struct fds_iemgr_elem **elems);
+
 /**
  * \brief Add an element to the manager
  * \param[in,out] mgr        Manager
@@ -237,6 +237,56 @@ fds_dset_iter_init(struct fds_dset_iter *it, struct fds_ipfix_set_hdr *set,
 FDS_API int
 fds_dset_iter_next(struct fds_dset_iter *it);
 
+/** \brief Data Record prepared by the batch decoder                                         */
+struct fds_dset_rec {
+    /** Start of the data record           */
+    uint8_t *rec;
+    /** Size of the data record (in bytes) */
+    uint16_t size;
+};
+
+/**
+ * \brief Get multiple Data Records in the Data Set at once
+ *
+ * Behaves as repeated calls of fds_dset_iter_next(), but all Records are decoded in a single
+ * loop. In case of a template without variable-length fields, the number of Records is
+ * determined from the length of the Set.
+ *
+ * If the array is not large enough to hold all remaining Records, the function can be called
+ * again to get the next Records. It can be also freely combined with fds_dset_iter_next(). After
+ * the function returns #FDS_OK, the public part of the iterator points to the last prepared
+ * Record.
+ *
+ * \code{.c}
+ *   struct fds_dset_rec recs[64];
+ *   uint32_t recs_cnt;
+ *   int rc;
+ *
+ *   while ((rc = fds_dset_iter_batch(&it, recs, 64, &recs_cnt)) == FDS_OK) {
+ *      for (uint32_t i = 0; i < recs_cnt; ++i) {
+ *          // Add your code here...
+ *      }
+ *   }
+ *
+ *   if (rc != FDS_EOC) {
+ *      // Records before the malformed one are still stored in the array...
+ *      fprintf(stderr, "Error: %s\n", fds_dset_iter_err(&it));
+ *   }
+ * \endcode
+ * \param[in]  it       Pointer to the iterator
+ * \param[out] recs     Array of Records to fill
+ * \param[in]  recs_max Maximum number of Records to prepare (size of the array, must be > 0)
+ * \param[out] recs_cnt Number of prepared Records
+ * \return #FDS_OK on success and at least one Record is ready to use.
+ * \return #FDS_EOC if no more Records are available (the end of the Set has been reached).
+ * \return #FDS_ERR_FORMAT if the format of the Data Set is invalid (an appropriate error message
+ *   is set - see fds_dset_iter_err()). Records located before the malformed one are still
+ *   prepared and \p recs_cnt is set accordingly.
+ */
+FDS_API int
+fds_dset_iter_batch(struct fds_dset_iter *it, struct fds_dset_rec *recs, uint32_t recs_max,
+    uint32_t *recs_cnt);
+
 /**
  * \brief Get the last error message
  * \note The message is statically allocated string that can be passed to other function even
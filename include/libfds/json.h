@@ -0,0 +1,151 @@
+/**
+ * \file libfds/json.h
+ * \author agent <agent@local>
+ * \brief Conversion of IPFIX Data Records to JSON (header file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#ifndef LIBFDS_JSON_H
+#define LIBFDS_JSON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libfds/api.h>
+#include "drec.h"
+
+/**
+ * \defgroup fds_json IPFIX Data Record to JSON conversion
+ * \ingroup publicAPIs
+ * \brief Serialization of Data Records into JSON objects
+ *
+ * Each Data Record is converted into a single JSON object where each field is represented by
+ * a key in format "<scope>:<name>" (e.g. "iana:octetDeltaCount") of its Information Element
+ * definition or "en<PEN>:id<ID>" if the definition is unknown. Values are formatted according
+ * to the data type of the Information Element. If the same Information Element is present
+ * multiple times in the record, all its values are stored into an array. Padding fields are
+ * always skipped.
+ *
+ * The serializer caches preformatted keys of fields of each template (in the same way as
+ * projections cache extraction plans) and the date and time of the last converted timestamp.
+ *
+ * \code{.c}
+ *  fds_json_t *json = fds_json_create(0);
+ *  char *str = NULL;
+ *  size_t str_size = 0;
+ *
+ *  // For each record...
+ *  int len = fds_json_drec(json, rec, &str, &str_size);
+ *  if (len < 0) {
+ *      // Failed...
+ *  }
+ *
+ *  free(str);
+ *  fds_json_destroy(json);
+ * \endcode
+ *
+ * \warning The serializer is not thread-safe. Use a separate serializer for each thread.
+ * \warning Cached keys refer to the Information Element definitions of templates. If the
+ *   definitions are destroyed (e.g. the IE manager is replaced), a new serializer should be
+ *   used.
+ * @{
+ */
+
+/** Internal JSON serializer declaration                                                     */
+typedef struct fds_json fds_json_t;
+
+/** \brief Flags of the JSON serializer                                                      */
+enum fds_json_flags {
+    /** Timestamps as the number of milliseconds since the UNIX epoch (instead of ISO 8601)  */
+    FDS_JSON_TS_NUMERIC = (1U << 0),
+    /** Skip fields with unknown Information Element definitions                            */
+    FDS_JSON_UNKNOWN_SKIP = (1U << 1),
+    /** Skip reverse fields of Biflow records                                               */
+    FDS_JSON_REVERSE_SKIP = (1U << 2)
+};
+
+/**
+ * \brief Create a new JSON serializer
+ * \param[in] flags Serialization flags (see #fds_json_flags)
+ * \return Pointer to the serializer or NULL (memory allocation error)
+ */
+FDS_API fds_json_t *
+fds_json_create(uint32_t flags);
+
+/**
+ * \brief Destroy a JSON serializer
+ * \param[in] json Serializer
+ */
+FDS_API void
+fds_json_destroy(fds_json_t *json);
+
+/**
+ * \brief Convert a Data Record to a JSON object
+ *
+ * The output buffer is automatically enlarged (using realloc()) if it is not large enough to
+ * hold the whole JSON object. If \p str is NULL, a new buffer is allocated. The buffer must be
+ * freed by the user using free().
+ *
+ * Timestamps are formatted in ISO 8601 (UTC) with precision given by their data type, MAC
+ * addresses, IP addresses, strings and octet arrays (hexadecimal, prefixed with "0x") are
+ * formatted as JSON strings. Fields that cannot be converted (e.g. invalid size) are stored as
+ * null values.
+ * \note Template Withdrawals cannot be used.
+ * \param[in]     json     Serializer
+ * \param[in]     rec      Data Record
+ * \param[in,out] str      Pointer to the output buffer (can point to NULL)
+ * \param[in,out] str_size Size of the output buffer
+ * \return Length of the JSON object (without the terminating null byte) on success.
+ * \return #FDS_ERR_FORMAT if the record is malformed (fields exceed the end of the record).
+ * \return #FDS_ERR_NOMEM if a memory allocation error has occurred. The buffer is still valid
+ *   and must be freed by the user.
+ */
+FDS_API int
+fds_json_drec(fds_json_t *json, struct fds_drec *rec, char **str, size_t *str_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBFDS_JSON_H
+
+/**
+ * @}
+ */
@@ -0,0 +1,205 @@
+/**
+ * \file libfds/projection.h
+ * \author agent <agent@local>
+ * \brief Projections of IPFIX Data Records (header file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#ifndef LIBFDS_PROJECTION_H
+#define LIBFDS_PROJECTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <libfds/api.h>
+#include "drec.h"
+#include "ipfix_parsers.h"
+
+/**
+ * \defgroup fds_proj IPFIX Data Record projection
+ * \ingroup publicAPIs
+ * \brief Extraction of a fixed set of fields from Data Records of any template
+ *
+ * A projection is defined by a list of Information Elements that should be extracted from Data
+ * Records. For each template, an extraction plan is compiled when the first record of the
+ * template is extracted. The plan is cached in the projection and reused for all records based
+ * on a template with the same layout of fields. All requested fields are extracted in a single
+ * pass over the record. Fields of all Records of a Data Set can be also extracted into typed
+ * columns of values in host byte order (see fds_proj_columns()).
+ *
+ * \code{.c}
+ *  static const struct fds_proj_elem elems[] = {
+ *      {0, 8},  // sourceIPv4Address
+ *      {0, 12}, // destinationIPv4Address
+ *      {0, 1},  // octetDeltaCount
+ *  };
+ *
+ *  fds_proj_t *proj = fds_proj_create(elems, 3);
+ *  struct fds_drec_field fields[3];
+ *
+ *  // For each record...
+ *  if (fds_proj_extract(proj, rec, fields) < 0) {
+ *      // Memory allocation error...
+ *  }
+ *
+ *  if (fields[2].data != NULL) {
+ *      // octetDeltaCount is present
+ *  }
+ *
+ *  fds_proj_destroy(proj);
+ * \endcode
+ *
+ * \warning The projection is not thread-safe. Use a separate projection for each thread.
+ * @{
+ */
+
+/** Internal projection declaration                                                          */
+typedef struct fds_proj fds_proj_t;
+
+/** \brief Information Element to extract                                                    */
+struct fds_proj_elem {
+    /** Private Enterprise Number                                                            */
+    uint32_t en;
+    /** Information Element ID                                                               */
+    uint16_t id;
+};
+
+/**
+ * \brief Create a new projection
+ * \note If the same Information Element is present multiple times in a Data Record, only the
+ *   first occurrence is extracted.
+ * \param[in] elems    Array of Information Elements to extract
+ * \param[in] elem_cnt Number of Information Elements (must be at least 1)
+ * \return Pointer to the projection or NULL (memory allocation error or invalid arguments)
+ */
+FDS_API fds_proj_t *
+fds_proj_create(const struct fds_proj_elem *elems, uint16_t elem_cnt);
+
+/**
+ * \brief Destroy a projection
+ * \param[in] proj Projection
+ */
+FDS_API void
+fds_proj_destroy(fds_proj_t *proj);
+
+/**
+ * \brief Extract fields from a Data Record
+ *
+ * The \p fields array must have the same number of items as the array of Information Elements
+ * used to create the projection. The i-th item of the \p fields will be filled with the i-th
+ * requested Information Element. If an Information Element is not present in the record,
+ * the corresponding item will be cleared (i.e. all its members are NULL or zero).
+ * \note Template Withdrawals cannot be used.
+ * \param[in]  proj   Projection
+ * \param[in]  rec    Data Record
+ * \param[out] fields Array of extracted fields
+ * \return Number of extracted fields (i.e. fields present in the record).
+ * \return #FDS_ERR_NOMEM if an extraction plan of the template failed to compile.
+ */
+FDS_API int
+fds_proj_extract(fds_proj_t *proj, struct fds_drec *rec, struct fds_drec_field *fields);
+
+/** \brief Type of values of a column                                                        */
+enum fds_proj_col_type {
+    /** Unsigned integer (an array of uint64_t)                                              */
+    FDS_PROJ_COL_UINT,
+    /** Signed integer (an array of int64_t)                                                 */
+    FDS_PROJ_COL_INT,
+    /** Floating point number (an array of double)                                           */
+    FDS_PROJ_COL_FLOAT,
+    /**
+     * Timestamp (an array of uint64_t, milliseconds since the UNIX epoch)
+     * \note Type of the timestamp is determined by the definition of the Information Element.
+     *   Therefore, the template must have defined Information Elements (see
+     *   fds_template_ies_define()).
+     */
+    FDS_PROJ_COL_DATETIME
+};
+
+/** \brief Column of values of an Information Element                                       */
+struct fds_proj_col {
+    /** Type of values                                                                       */
+    enum fds_proj_col_type type;
+    /** Array of values (the type of items is given by #type)                                */
+    void *values;
+    /**
+     * Validity bitmap (at least (rows + 7) / 8 bytes)
+     *
+     * Bit (i % 8) of the byte (i / 8) is set if the i-th value is defined. Otherwise
+     * (the Information Element is missing in the record or it cannot be converted to the
+     * required type) the bit is cleared and the value is set to zero.
+     */
+    uint8_t *valid;
+};
+
+/**
+ * \brief Extract fields from Data Records of a Data Set into columns
+ *
+ * Data Records are read from an initialized Data Set iterator (see fds_dset_iter_init()) and
+ * values of the i-th requested Information Element are converted to host byte order and stored
+ * to the i-th column. The \p cols array must have the same number of items as the array of
+ * Information Elements used to create the projection.
+ *
+ * If the columns are not large enough to hold all remaining Records, the function can be called
+ * again to get the next Records. The i-th Record is always stored to the i-th row of columns.
+ *
+ * \param[in]  proj     Projection
+ * \param[in]  it       Data Set iterator
+ * \param[in]  cols     Array of columns
+ * \param[in]  rows_max Maximum number of rows (must be > 0)
+ * \param[out] rows_cnt Number of filled rows
+ * \return #FDS_OK on success and at least one row is filled.
+ * \return #FDS_EOC if no more Records are available (the end of the Set has been reached).
+ * \return #FDS_ERR_FORMAT if the format of the Data Set is invalid (see fds_dset_iter_err()).
+ *   Rows of Records located before the malformed one are still filled.
+ * \return #FDS_ERR_NOMEM if a memory allocation error has occurred.
+ */
+FDS_API int
+fds_proj_columns(fds_proj_t *proj, struct fds_dset_iter *it, const struct fds_proj_col *cols,
+    uint32_t rows_max, uint32_t *rows_cnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBFDS_PROJECTION_H
+
+/**
+ * @}
+ */
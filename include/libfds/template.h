@@ -287,6 +287,41 @@ struct fds_template {
     /** Number of scope fields (first N records of the Options Template)                         */
     uint16_t fields_cnt_scope;
 
+    /**
+     * \brief Lookup index of template fields
+     *
+     * Open addressing hash table that maps a combination of an Enterprise Number and
+     * an Information Element ID to the first occurrence of the field in #fields. The index is
+     * built during template parsing and it allows to find a field in constant time. It also
+     * holds precomputed layout of fields used for fast processing of Data Records.
+     * \warning For internal use only. Use fds_template_find() or fds_drec_find() instead.
+     */
+    struct index_s {
+        /** Number of slots minus one (the number of slots is always a power of two)            */
+        uint32_t mask;
+        /**
+         * Index of the first variable-length field (i.e. the last field with known offset).
+         * If the template doesn't have any variable-length field, the value is equal to
+         * #fields_cnt_total.
+         */
+        uint16_t var_first;
+        /** Array of slots (index of a field + 1, zero represents an empty slot)                 */
+        uint16_t *slots;
+        /** Number of variable-length fields                                                     */
+        uint16_t var_cnt;
+        /**
+         * Total length of fixed-length fields before the first variable-length field, between
+         * each pair of consecutive variable-length fields and after the last one (i.e.
+         * #var_cnt + 1 items). Stored in the same memory block as #slots.
+         */
+        uint16_t *var_segs;
+        /**
+         * Process-wide unique identifier of the layout of fields (assigned during parsing and
+         * shared by copies of the template). Zero for Template Withdrawals.
+         */
+        uint64_t layout_id;
+    } index; /**< Instance of the structure                                                      */
+
     /**
      * \brief Array of parse fields (reverse view)
      *
@@ -393,6 +428,9 @@ fds_template_cmp(const struct fds_template *t1, const struct fds_template *t2);
 
 /**
  * \brief Find the first occurrence of an Information Element in a template
+ *
+ * The lookup is performed using the internal index of the template (see fds_template#index)
+ * and it takes constant time regardless of the number of template fields.
  * \param[in] tmplt Template structure
  * \param[in] en    Enterprise Number
  * \param[in] id    Information Element ID
@@ -491,6 +529,102 @@ fds_template_flowkey_define(struct fds_template *tmplt, uint64_t flowkey);
 FDS_API int
 fds_template_flowkey_cmp(const struct fds_template *tmplt, uint64_t flowkey);
 
+/**
+ * \defgroup fds_tcache Cache of parsed templates
+ * \ingroup fds_template
+ * \brief Thread-safe cache of already parsed templates
+ *
+ * Many exporters (e.g. devices of the same vendor and model) usually send exactly the same
+ * templates. The cache remembers parsed templates with defined Information Elements based on
+ * their raw definition (i.e. fds_template#raw), so the same raw template doesn't have to be
+ * parsed and processed again. A single cache can be shared by all Transport Sessions (and threads)
+ * of a process.
+ *
+ * The cache always returns a new copy of a cached template, which is owned by the caller and
+ * can be freely modified (for example, inserted into a template manager). When the capacity of
+ * the cache is reached, the least recently used template is removed.
+ * \warning Cached templates refer to definitions of Information Elements of an IE manager.
+ *   Before the IE manager is destroyed or modified, the cache must be cleared using
+ *   fds_tcache_clear().
+ * @{
+ */
+
+/** Internal template cache declaration                                                     */
+typedef struct fds_tcache fds_tcache_t;
+
+/** Statistics of a template cache                                                          */
+struct fds_tcache_stats {
+    /** Number of templates found in the cache                                             */
+    uint64_t hits;
+    /** Number of templates not found in the cache (i.e. parsed)                           */
+    uint64_t misses;
+    /** Number of templates removed from the cache due to its capacity                     */
+    uint64_t evictions;
+    /** Number of currently cached templates                                               */
+    uint32_t entries;
+};
+
+/**
+ * \brief Create a new template cache
+ * \param[in] capacity Maximum number of cached templates (must be > 0)
+ * \return Pointer to the cache or NULL (memory allocation error or invalid arguments)
+ */
+FDS_API fds_tcache_t *
+fds_tcache_create(uint32_t capacity);
+
+/**
+ * \brief Destroy a template cache
+ *
+ * Templates returned by the cache are not affected.
+ * \param[in] cache Template cache
+ */
+FDS_API void
+fds_tcache_destroy(fds_tcache_t *cache);
+
+/**
+ * \brief Remove all templates from a template cache
+ *
+ * Statistics of hits, misses and evictions are preserved.
+ * \param[in] cache Template cache
+ */
+FDS_API void
+fds_tcache_clear(fds_tcache_t *cache);
+
+/**
+ * \brief Parse an IPFIX template (using a template cache)
+ *
+ * The result is the same as the result of fds_template_parse() followed by
+ * fds_template_ies_define() (with disabled preserve mode), if the IE manager \p iemgr is defined.
+ * If the template is not in the cache, it is parsed and its copy is inserted into the cache.
+ * \note Template withdrawals are never cached.
+ * \note The function is thread-safe.
+ * \param[in]     cache Template cache
+ * \param[in]     type  Type of template (::FDS_TYPE_TEMPLATE or ::FDS_TYPE_TEMPLATE_OPTS)
+ * \param[in]     ptr   Pointer to the header of the template
+ * \param[in,out] len   [in] Maximal length of the raw template /
+ *                      [out] real length of the raw template in octets
+ * \param[in]     iemgr Manager of Information Elements definitions (can be NULL)
+ * \param[out]    tmplt Parsed template (automatically allocated)
+ * \return On success, the function will set parameters \p tmplt, \p len and return #FDS_OK.
+ *   Otherwise, the parameters will be unchanged and the function will return #FDS_ERR_FORMAT or
+ *   #FDS_ERR_NOMEM.
+ */
+FDS_API int
+fds_tcache_parse(fds_tcache_t *cache, enum fds_template_type type, const void *ptr,
+    uint16_t *len, const fds_iemgr_t *iemgr, struct fds_template **tmplt);
+
+/**
+ * \brief Get statistics of a template cache
+ * \param[in]  cache Template cache
+ * \param[out] stats Statistics
+ */
+FDS_API void
+fds_tcache_stats(fds_tcache_t *cache, struct fds_tcache_stats *stats);
+
+/**
+ * @}
+ */
+
 #ifdef __cplusplus
 }
 #endif
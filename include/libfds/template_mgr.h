@@ -47,7 +47,9 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <libfds/api.h>
 #include "template.h"
 #include "iemgr.h"
@@ -122,6 +124,10 @@ typedef struct fds_tmgr fds_tmgr_t;
 typedef struct fds_tsnapshot fds_tsnapshot_t;
 /** Internal template garbage declaration   */
 typedef struct fds_tgarbage fds_tgarbage_t;
+/** Internal pool allocator declaration      */
+typedef struct fds_tpool fds_tpool_t;
+/** Internal garbage reclamation service declaration */
+typedef struct fds_tgc fds_tgc_t;
 
 
 /**
@@ -138,6 +144,21 @@ typedef struct fds_tgarbage fds_tgarbage_t;
 FDS_API fds_tmgr_t *
 fds_tmgr_create(enum fds_session_type type);
 
+/**
+ * \brief Create a new template manager that allocates its internal objects from a pool
+ *
+ * Same as fds_tmgr_create(), but snapshots and their internal tables are allocated from the
+ * given pool allocator (see \ref fds_tpool). The pool can be dedicated to the manager or shared
+ * by multiple managers.
+ * \note The manager holds a reference to the pool, therefore, the pool can be destroyed by its
+ *   user (see fds_tpool_destroy()) before the manager.
+ * \param[in] type Session type
+ * \param[in] pool Pool allocator (NULL to use the heap, i.e. the same as fds_tmgr_create())
+ * \return Pointer to the manager or NULL (usually memory allocation error)
+ */
+FDS_API fds_tmgr_t *
+fds_tmgr_create_pool(enum fds_session_type type, fds_tpool_t *pool);
+
 /**
  * \brief Destroy a template manager
  * \warning The function, among the other, will immediately destroy all templates and snapshots
@@ -246,6 +267,30 @@ fds_tmgr_set_snapshot_timeout(fds_tmgr_t *tmgr, uint16_t timeout);
 FDS_API int
 fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr);
 
+/**
+ * \brief Replace a manager of Information Elements with its new version
+ *
+ * Unlike fds_tmgr_set_iemgr(), only templates that refer to changed definitions of IEs are
+ * redefined. Other templates keep their references to the definitions, therefore, the
+ * definitions must be shared by both IE managers (see fds_iemgr_rebase()) and the diff \p diff
+ * must be created for the current and the new IE manager (see fds_iemgr_diff_create()).
+ *
+ * The manager keeps a reverse index of IEs used by its templates, so affected templates are
+ * found without iterating over snapshots. If no template is affected, the snapshots are not
+ * touched at all and the cost depends only on the number of distinct IEs used by the templates.
+ * Otherwise, all snapshots are copied (i.e. the cost is linear in the number of snapshots and
+ * their records), but only affected templates are redefined.
+ *
+ * \warning Time context will be lost.
+ * \param[in] tmgr  Template manager
+ * \param[in] iemgr New manager of Information Elements (IEs) (can be NULL)
+ * \param[in] diff  Elements that differ between the current and the new IE manager
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM and references are still
+ *   the same.
+ */
+FDS_API int
+fds_tmgr_update_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr, const fds_iemgr_diff_t *diff);
+
 /**
  * \brief Set current time context of a processed packet
  *
@@ -290,6 +335,23 @@ fds_tmgr_set_time(fds_tmgr_t *tmgr, uint32_t exp_time);
 FDS_API int
 fds_tmgr_template_get(fds_tmgr_t *tmgr, uint16_t id, const struct fds_template **tmplt);
 
+/**
+ * \brief Get the time of the last refresh and the end of life of a template
+ *
+ * Refreshes of templates in the newest snapshot don't modify the templates (see
+ * fds_tmgr_template_add()), therefore, fds_template#time#last_seen and
+ * fds_template#time#end_of_life might be outdated. This function returns the values the manager
+ * actually uses, i.e. the recorded ones if the template has been refreshed this way, otherwise
+ * the values stored in the template.
+ * \param[in]  tmgr        Template manager
+ * \param[in]  tmplt       Template (e.g. returned by fds_tmgr_template_get())
+ * \param[out] last_seen   The last reception of the template (can be NULL)
+ * \param[out] end_of_life End of life of the template (can be NULL)
+ */
+FDS_API void
+fds_tmgr_template_time(const fds_tmgr_t *tmgr, const struct fds_template *tmplt,
+    uint32_t *last_seen, uint32_t *end_of_life);
+
 /**
  * \brief Add a template
  *
@@ -297,6 +359,14 @@ fds_tmgr_template_get(fds_tmgr_t *tmgr, uint16_t id, const struct fds_template *
  * IE definitions will be added to template's elements and the lifetime of the template will
  * be configured appropriately to the manager configuration.
  *
+ * \note If exactly the same template is already present in the newest snapshot, only the time
+ *   of the refresh and the new end of life are recorded by the manager and the \p tmplt is
+ *   immediately destroyed. No snapshot is created and no garbage is produced. The template
+ *   itself is never modified, i.e. its fds_template#time#last_seen and
+ *   fds_template#time#end_of_life keep values of its (re)definition, but the manager uses the
+ *   recorded values to check its validity and to save its state (see fds_tmgr_template_time()).
+ *   If the time context later goes back before the refresh, the newest snapshot is split and
+ *   the refreshed templates are copied, so the refresh becomes part of the history.
  * \warning Templates withdrawals cannot be added!
  * \warning This operation is related to a context (determined by the current Export Time).
  *   For more information see: fds_tmgr_set_time().
@@ -420,6 +490,579 @@ fds_tmgr_snapshot_get(const fds_tmgr_t *tmgr, const fds_tsnapshot_t **snap);
 FDS_API const struct fds_template *
 fds_tsnapshot_template_get(const fds_tsnapshot_t *snap, uint16_t id);
 
+/**
+ * \brief Save the state of a template manager to a file
+ *
+ * Templates of the newest snapshot (i.e. valid at the newest Export Time seen by the manager)
+ * are written in a compact binary format, including their raw definitions, timestamps (of the
+ * last refresh, see fds_tmgr_template_time()) and flow keys. The state can be later restored by
+ * fds_tmgr_load(), for example, after a restart of an application, so Data Records can be
+ * decoded before exporters resend their templates.
+ * History of the manager (older snapshots) and its configuration are not saved.
+ *
+ * \note The manager is not modified in any way, i.e. its time context and snapshots (including
+ *   their editability) are preserved. Therefore, if a historical snapshot has been modified and
+ *   the modifications haven't been propagated to the newest snapshot yet, the state cannot be
+ *   saved. Modifications are propagated when the time context is changed to a newer Export Time
+ *   (see fds_tmgr_set_time()).
+ * \note States of multiple managers can be written to the same file one after another.
+ * \param[in] tmgr Template manager
+ * \param[in] file Output file (opened for writing in binary mode)
+ * \return On success returns #FDS_OK. On write error returns #FDS_ERR_DENIED.
+ *   If modifications of a historical snapshot haven't been propagated yet, returns #FDS_ERR_ARG
+ *   and nothing is written.
+ */
+FDS_API int
+fds_tmgr_save(const fds_tmgr_t *tmgr, FILE *file);
+
+/**
+ * \brief Restore the state of a template manager from a file
+ *
+ * The previous content of the manager is moved to garbage (see fds_tmgr_clear()) and replaced
+ * by templates saved by fds_tmgr_save(). Raw templates are parsed again and references to
+ * IE definitions are based on the IE manager of this manager (see fds_tmgr_set_iemgr()).
+ * Timestamps of the templates (including their end of life) are restored as they were saved,
+ * so the configuration of the manager (e.g. UDP timeouts) should be the same as before.
+ * Templates that have expired at the saved Export Time are ignored.
+ *
+ * After success, the time context of the manager is set to the newest Export Time seen by the
+ * original manager.
+ * \param[in] tmgr Template manager
+ * \param[in] file Input file (opened for reading in binary mode)
+ * \return On success returns #FDS_OK. If the file is malformed or cannot be read, returns
+ *   #FDS_ERR_FORMAT. On memory allocation error returns #FDS_ERR_NOMEM. On failure, the manager
+ *   is empty.
+ */
+FDS_API int
+fds_tmgr_load(fds_tmgr_t *tmgr, FILE *file);
+
+/**
+ * \defgroup fds_tpub Publication of template snapshots
+ * \ingroup fds_template_mgr
+ * \brief Lock-free access to the newest snapshot of a template manager from multiple threads
+ *
+ * A template manager is not thread-safe, therefore, it must be owned (i.e. modified) by a single
+ * thread. However, snapshots and templates are immutable and can be read by other threads.
+ * The publisher shares the current snapshot of the manager with any number of reader threads and
+ * takes care of safe destruction of garbage (old snapshots and templates) based on quiescent
+ * states of the readers (epoch-based reclamation).
+ *
+ * The owner of the manager, after each modification of the manager (or periodically), calls
+ * fds_tpub_update() which publishes the current snapshot and retires garbage of the manager.
+ * Retired garbage is destroyed as soon as all online readers have passed a quiescent point
+ * (see fds_tpub_reader_quiescent()) i.e. when no reader can hold a reference to it.
+ *
+ * \code{.c}
+ *  // Reader thread
+ *  fds_tpub_reader_t *reader = fds_tpub_reader_register(pub);
+ *  while (running) {
+ *      const fds_tsnapshot_t *snap = fds_tpub_reader_get(reader);
+ *      // ... use the snapshot and its templates ...
+ *      fds_tpub_reader_quiescent(reader); // The snapshot must not be used anymore
+ *  }
+ *  fds_tpub_reader_unregister(reader);
+ * \endcode
+ * @{
+ */
+
+/** Internal snapshot publisher declaration                                                  */
+typedef struct fds_tpub fds_tpub_t;
+/** Internal snapshot reader declaration                                                     */
+typedef struct fds_tpub_reader fds_tpub_reader_t;
+
+/**
+ * \brief Create a new snapshot publisher
+ * \param[in] readers_max Maximum number of simultaneously registered readers (must be > 0)
+ * \return Pointer to the publisher or NULL (memory allocation error or invalid arguments)
+ */
+FDS_API fds_tpub_t *
+fds_tpub_create(uint16_t readers_max);
+
+/**
+ * \brief Destroy a snapshot publisher
+ *
+ * All retired garbage is immediately destroyed.
+ * \warning All readers must be unregistered first.
+ * \param[in] pub Publisher
+ */
+FDS_API void
+fds_tpub_destroy(fds_tpub_t *pub);
+
+/**
+ * \brief Publish the current snapshot of a template manager and retire its garbage
+ *
+ * The function collects garbage of the manager (see fds_tmgr_garbage_get()), publishes
+ * the current snapshot of the manager (see fds_tmgr_snapshot_get()) and retires the garbage.
+ * Finally, all garbage that cannot be referenced by any reader is destroyed
+ * (see fds_tpub_reclaim()).
+ * \warning Only the thread that owns the manager can call this function and the garbage of the
+ *   manager must not be collected by anyone else.
+ * \param[in] pub  Publisher
+ * \param[in] tmgr Template manager (its time context must be defined)
+ * \return #FDS_OK on success.
+ * \return #FDS_ERR_ARG if the time context of the manager is not defined.
+ * \return #FDS_ERR_NOMEM if a memory allocation error has occurred.
+ */
+FDS_API int
+fds_tpub_update(fds_tpub_t *pub, fds_tmgr_t *tmgr);
+
+/**
+ * \brief Destroy retired garbage that cannot be referenced by any reader
+ * \warning Only the thread that owns the manager can call this function.
+ * \param[in] pub Publisher
+ * \return Number of garbage batches that are still waiting for destruction.
+ */
+FDS_API size_t
+fds_tpub_reclaim(fds_tpub_t *pub);
+
+/**
+ * \brief Destroy retired garbage in a background thread
+ *
+ * Garbage retired by fds_tpub_update() is handed over to the reclamation service, which
+ * destroys it as soon as all online readers have passed a quiescent point. If the queue of
+ * the service is full, the garbage is kept and destroyed by the publisher as usual.
+ * \note The service can be shared by multiple publishers. When the service is replaced or
+ *   the publisher is destroyed, the function waits until the previous service has destroyed
+ *   all garbage retired by this publisher. Garbage of other publishers is not waited for.
+ * \warning Only the thread that owns the manager can call this function.
+ * \param[in] pub Publisher
+ * \param[in] tgc Reclamation service (NULL to destroy garbage by the publisher itself)
+ */
+FDS_API void
+fds_tpub_set_tgc(fds_tpub_t *pub, fds_tgc_t *tgc);
+
+/**
+ * \brief Register a new reader
+ *
+ * The reader is online after registration. Each reader thread should have its own reader.
+ * \param[in] pub Publisher
+ * \return Pointer to the reader or NULL (the maximum number of readers has been reached)
+ */
+FDS_API fds_tpub_reader_t *
+fds_tpub_reader_register(fds_tpub_t *pub);
+
+/**
+ * \brief Unregister a reader
+ *
+ * All snapshots and templates obtained by the reader must not be used anymore.
+ * \param[in] reader Reader
+ */
+FDS_API void
+fds_tpub_reader_unregister(fds_tpub_reader_t *reader);
+
+/**
+ * \brief Get the published snapshot (wait-free)
+ *
+ * The snapshot (and its templates) remains valid until the reader passes a quiescent point
+ * (see fds_tpub_reader_quiescent()), goes offline or is unregistered.
+ * \warning The reader must be online.
+ * \param[in] reader Reader
+ * \return Pointer to the snapshot or NULL (nothing has been published yet)
+ */
+FDS_API const fds_tsnapshot_t *
+fds_tpub_reader_get(const fds_tpub_reader_t *reader);
+
+/**
+ * \brief Announce a quiescent state of a reader
+ *
+ * The reader declares that it doesn't hold any reference to previously obtained snapshots
+ * and templates. It should be called regularly (e.g. after processing of each IPFIX Message),
+ * otherwise garbage cannot be destroyed.
+ * \param[in] reader Reader
+ */
+FDS_API void
+fds_tpub_reader_quiescent(fds_tpub_reader_t *reader);
+
+/**
+ * \brief Switch a reader to offline mode
+ *
+ * An offline reader doesn't block destruction of garbage (e.g. while the thread is waiting for
+ * new data), but it must not access the published snapshots. Previously obtained snapshots
+ * must not be used anymore.
+ * \param[in] reader Reader
+ */
+FDS_API void
+fds_tpub_reader_offline(fds_tpub_reader_t *reader);
+
+/**
+ * \brief Switch a reader to online mode
+ * \param[in] reader Reader
+ */
+FDS_API void
+fds_tpub_reader_online(fds_tpub_reader_t *reader);
+
+/**
+ * @}
+ */
+
+/**
+ * \defgroup fds_tpool Pool allocator of template managers
+ * \ingroup fds_template_mgr
+ * \brief Slab allocator of internal objects of template managers
+ *
+ * Under heavy template churn, template managers repeatedly allocate and free snapshots and their
+ * internal tables. A pool allocator keeps these fixed-size objects in slabs (large blocks of
+ * memory) to avoid heap fragmentation and contention of the system allocator. The pool can be
+ * dedicated to a single manager (i.e. a Transport Session) or shared by multiple managers.
+ * Optionally, the total size of memory reserved by the pool can be limited. If the limit is
+ * reached, operations of the managers fail with #FDS_ERR_NOMEM.
+ *
+ * The pool is thread-safe, i.e. garbage of the managers can be destroyed in another thread.
+ * Templates are not allocated from the pool.
+ *
+ * \code{.c}
+ *  fds_tpool_t *pool = fds_tpool_create(16 * 1024 * 1024); // 16 MiB
+ *  fds_tmgr_t *tmgr = fds_tmgr_create_pool(FDS_SESSION_UDP, pool);
+ *  fds_tpool_destroy(pool); // The manager holds its own reference
+ *  // ... use the manager ...
+ *  fds_tmgr_destroy(tmgr); // The pool is freed as soon as all its objects are freed
+ * \endcode
+ * @{
+ */
+
+/** \brief Statistics of a pool allocator                                                      */
+struct fds_tpool_stats {
+    /** Number of allocated objects                                                          */
+    uint64_t objects;
+    /** Total size of allocated objects (in bytes)                                           */
+    uint64_t bytes;
+    /** Total size of memory reserved by the pool, including unused objects (in bytes)      */
+    uint64_t reserved;
+    /** Number of failed allocations (memory allocation error or the limit has been reached) */
+    uint64_t failures;
+};
+
+/**
+ * \brief Create a new pool allocator
+ * \param[in] mem_limit Maximum size of memory reserved by the pool in bytes (0 = unlimited)
+ * \return Pointer to the pool or NULL (memory allocation error)
+ */
+FDS_API fds_tpool_t *
+fds_tpool_create(size_t mem_limit);
+
+/**
+ * \brief Destroy a pool allocator
+ *
+ * The pool is freed as soon as no template manager uses it and all its objects (including
+ * garbage of the managers) have been freed.
+ * \param[in] pool Pool allocator
+ */
+FDS_API void
+fds_tpool_destroy(fds_tpool_t *pool);
+
+/**
+ * \brief Get statistics of a pool allocator
+ * \param[in]  pool  Pool allocator
+ * \param[out] stats Statistics
+ */
+FDS_API void
+fds_tpool_stats(fds_tpool_t *pool, struct fds_tpool_stats *stats);
+
+/**
+ * @}
+ */
+
+/**
+ * \defgroup fds_treg Registry of template managers
+ * \ingroup fds_template_mgr
+ * \brief Template managers of many sessions (e.g. combinations of an exporter and an ODID)
+ *
+ * The registry owns template managers of sessions identified by a user defined 64-bit ID
+ * (for example, a combination of a Transport Session and an Observation Domain ID). Lookup of
+ * a session takes constant time. All managers share the same pool allocator (see \ref fds_tpool)
+ * and IE manager.
+ *
+ * Garbage is collected in batches, i.e. fds_treg_garbage_get() returns garbage of all sessions
+ * accessed since the previous call (and of removed sessions) as a single garbage object.
+ *
+ * Optionally, sessions that have not been accessed (see fds_treg_find()) for a given time are
+ * automatically removed. Idle sessions are tracked by a timer wheel, so the cost of expiration
+ * doesn't depend on the total number of sessions. The time of the registry (e.g. a monotonic
+ * time of the system in seconds) is independent of Export Time of the managers and must be
+ * updated by the user (see fds_treg_set_time()).
+ *
+ * \code{.c}
+ *  fds_treg_t *reg = fds_treg_create(pool, iemgr);
+ *  fds_treg_set_idle_timeout(reg, 600);
+ *  while (running) {
+ *      fds_treg_set_time(reg, monotonic_seconds());
+ *      fds_tmgr_t *tmgr = fds_treg_find(reg, session_id);
+ *      if (!tmgr && fds_treg_add(reg, session_id, FDS_SESSION_UDP, &tmgr) != FDS_OK) {
+ *          // ... memory allocation error ...
+ *      }
+ *      // ... use the manager ...
+ *      fds_tgarbage_t *gc;
+ *      fds_treg_garbage_get(reg, &gc);
+ *      // ... pass the garbage to a safe place for destruction ...
+ *  }
+ *  fds_treg_destroy(reg);
+ * \endcode
+ *
+ * \warning The registry is not thread-safe.
+ * \warning A pointer to a template manager is valid only until its session is removed (see
+ *   fds_treg_remove()) or expired (see fds_treg_set_time()).
+ * @{
+ */
+
+/** Internal registry declaration                                                            */
+typedef struct fds_treg fds_treg_t;
+
+/**
+ * \brief Create a new registry of template managers
+ * \param[in] pool  Pool allocator of all managers (can be NULL)
+ * \param[in] iemgr IE manager of all managers (can be NULL)
+ * \return Pointer to the registry or NULL (memory allocation error)
+ */
+FDS_API fds_treg_t *
+fds_treg_create(fds_tpool_t *pool, const fds_iemgr_t *iemgr);
+
+/**
+ * \brief Destroy a registry and all its template managers
+ * \warning All templates and snapshots of the managers are immediately destroyed (see
+ *   fds_tmgr_destroy()). Uncollected garbage of the registry is destroyed too.
+ * \param[in] reg Registry
+ */
+FDS_API void
+fds_treg_destroy(fds_treg_t *reg);
+
+/**
+ * \brief Set an IE manager of all template managers
+ *
+ * See fds_tmgr_set_iemgr() for more details.
+ * \warning Time context of all managers will be lost.
+ * \param[in] reg   Registry
+ * \param[in] iemgr IE manager (can be NULL)
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM.
+ */
+FDS_API int
+fds_treg_set_iemgr(fds_treg_t *reg, const fds_iemgr_t *iemgr);
+
+/**
+ * \brief Replace an IE manager of all template managers with its new version
+ *
+ * See fds_tmgr_update_iemgr() for more details.
+ * \param[in] reg   Registry
+ * \param[in] iemgr New IE manager (can be NULL)
+ * \param[in] diff  Elements that differ between the current and the new IE manager
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM.
+ */
+FDS_API int
+fds_treg_update_iemgr(fds_treg_t *reg, const fds_iemgr_t *iemgr, const fds_iemgr_diff_t *diff);
+
+/**
+ * \brief Set a timeout of idle sessions
+ *
+ * A session is removed if it has not been accessed for the given time. Sessions are expired
+ * by fds_treg_set_time() at most 1/128 of the timeout (rounded up to seconds) later.
+ * \param[in] reg     Registry
+ * \param[in] timeout Timeout in seconds (0 == disabled, default)
+ */
+FDS_API void
+fds_treg_set_idle_timeout(fds_treg_t *reg, uint32_t timeout);
+
+/**
+ * \brief Set the current time of a registry and expire idle sessions
+ *
+ * Template managers (including all their templates and snapshots) of expired sessions are
+ * moved to garbage (see fds_treg_garbage_get()).
+ * \note The time cannot go backwards. In such case, the function does nothing.
+ * \param[in] reg Registry
+ * \param[in] now Current time (in seconds)
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM.
+ */
+FDS_API int
+fds_treg_set_time(fds_treg_t *reg, uint32_t now);
+
+/**
+ * \brief Add a new session
+ *
+ * A new template manager is created using the shared pool allocator and IE manager.
+ * \param[in]  reg  Registry
+ * \param[in]  id   Session ID
+ * \param[in]  type Session type
+ * \param[out] tmgr Template manager of the session
+ * \return On success returns #FDS_OK and fills \p tmgr. If the session already exists, returns
+ *   #FDS_ERR_ARG. On memory allocation error returns #FDS_ERR_NOMEM.
+ */
+FDS_API int
+fds_treg_add(fds_treg_t *reg, uint64_t id, enum fds_session_type type, fds_tmgr_t **tmgr);
+
+/**
+ * \brief Find a session and mark it as accessed
+ * \param[in] reg Registry
+ * \param[in] id  Session ID
+ * \return Template manager of the session or NULL (not found)
+ */
+FDS_API fds_tmgr_t *
+fds_treg_find(fds_treg_t *reg, uint64_t id);
+
+/**
+ * \brief Remove a session
+ *
+ * All templates and snapshots of the manager are moved to garbage (see fds_treg_garbage_get())
+ * and the manager is destroyed.
+ * \param[in] reg Registry
+ * \param[in] id  Session ID
+ * \return On success returns #FDS_OK. If the session doesn't exist, returns #FDS_ERR_NOTFOUND.
+ *   On memory allocation error returns #FDS_ERR_NOMEM and the session is still registered.
+ */
+FDS_API int
+fds_treg_remove(fds_treg_t *reg, uint64_t id);
+
+/**
+ * \brief Get the number of registered sessions
+ * \param[in] reg Registry
+ * \return Number of sessions
+ */
+FDS_API uint32_t
+fds_treg_count(const fds_treg_t *reg);
+
+/**
+ * \brief Get garbage of the registry
+ *
+ * Garbage of all sessions accessed since the previous call and of removed sessions is returned
+ * as a single garbage object that must be destroyed by fds_tmgr_garbage_destroy().
+ * \param[in]  reg Registry
+ * \param[out] gc  Garbage (NULL if there is no garbage)
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM.
+ */
+FDS_API int
+fds_treg_garbage_get(fds_treg_t *reg, fds_tgarbage_t **gc);
+
+/**
+ * \brief Save states of all sessions to a file
+ *
+ * For each session, its ID, type and the state of its template manager (see fds_tmgr_save())
+ * are written.
+ * \param[in] reg  Registry
+ * \param[in] file Output file (opened for writing in binary mode)
+ * \return On success returns #FDS_OK. On write error returns #FDS_ERR_DENIED.
+ *   If a state of a session cannot be saved (see fds_tmgr_save()), returns #FDS_ERR_ARG.
+ */
+FDS_API int
+fds_treg_save(fds_treg_t *reg, FILE *file);
+
+/**
+ * \brief Restore sessions from a file
+ *
+ * Sessions saved by fds_treg_save() are added to the registry (see fds_treg_add()) and states
+ * of their template managers are restored (see fds_tmgr_load()).
+ * \param[in] reg  Registry
+ * \param[in] file Input file (opened for reading in binary mode)
+ * \return On success returns #FDS_OK. If the file is malformed or cannot be read, or any
+ *   restored session already exists, returns #FDS_ERR_FORMAT. On memory allocation error
+ *   returns #FDS_ERR_NOMEM. On failure, sessions restored so far remain in the registry.
+ */
+FDS_API int
+fds_treg_load(fds_treg_t *reg, FILE *file);
+
+/**
+ * @}
+ */
+
+/**
+ * \defgroup fds_tgc Background reclamation of garbage
+ * \ingroup fds_template_mgr
+ * \brief Destruction of template manager garbage outside of the processing thread
+ *
+ * Garbage of a template manager (see fds_tmgr_garbage_get()) can consist of long chains of old
+ * snapshots and templates, therefore, its destruction can take a considerable amount of time.
+ * The reclamation service takes over garbage batches and destroys them in a dedicated worker
+ * thread in the order of insertion (except deferred garbage, see below). The queue of the service is bounded, i.e. the owner of
+ * the garbage is never blocked. If the queue is full, the garbage is rejected and the caller
+ * must destroy it (or try it again later).
+ *
+ * Garbage retired by a snapshot publisher (see fds_tpub_set_tgc()) is deferred until all online
+ * readers of the publisher have passed a quiescent point. Until then, the garbage (and any newer
+ * garbage of the same publisher) waits in the queue, while other garbage is destroyed. If all
+ * garbage in the queue is deferred, the worker checks epochs of the readers with increasing
+ * intervals.
+ *
+ * \code{.c}
+ *  fds_tgc_t *tgc = fds_tgc_create(1024);
+ *  // ... processing thread ...
+ *  fds_tgarbage_t *gc;
+ *  if (fds_tmgr_garbage_get(tmgr, &gc) == FDS_OK && fds_tgc_push(tgc, gc) != FDS_OK) {
+ *      fds_tmgr_garbage_destroy(gc); // The queue is full
+ *  }
+ * \endcode
+ * @{
+ */
+
+/** \brief Statistics of a reclamation service                                                 */
+struct fds_tgc_stats {
+    /** Number of garbage batches in the queue (including deferred ones)                     */
+    size_t queue_depth;
+    /** The highest number of garbage batches in the queue                                   */
+    size_t queue_peak;
+    /** Number of accepted garbage batches                                                   */
+    uint64_t pushed;
+    /** Number of destroyed garbage batches                                                  */
+    uint64_t reclaimed;
+    /** Number of rejected garbage batches (the queue was full)                              */
+    uint64_t rejected;
+    /** Average time from insertion to the end of destruction of a batch (nanoseconds)       */
+    uint64_t latency_avg;
+    /** Maximum time from insertion to the end of destruction of a batch (nanoseconds)       */
+    uint64_t latency_max;
+};
+
+/**
+ * \brief Create a new reclamation service and start its worker thread
+ * \param[in] queue_size Maximum number of garbage batches waiting for destruction (must be > 0)
+ * \return Pointer to the service or NULL (memory allocation error, failed to start the thread
+ *   or invalid arguments)
+ */
+FDS_API fds_tgc_t *
+fds_tgc_create(size_t queue_size);
+
+/**
+ * \brief Stop the worker thread and destroy the reclamation service
+ *
+ * All garbage in the queue is destroyed immediately, regardless of readers of publishers.
+ * \warning All readers of publishers that use the service must be unregistered first.
+ * \param[in] tgc Reclamation service
+ */
+FDS_API void
+fds_tgc_destroy(fds_tgc_t *tgc);
+
+/**
+ * \brief Hand over garbage to the reclamation service
+ *
+ * The garbage will be destroyed in the worker thread. It must not be referenced by anyone
+ * (e.g. by readers of a publisher).
+ * \note Thread-safe
+ * \param[in] tgc Reclamation service
+ * \param[in] gc  Garbage (can be NULL)
+ * \return On success returns #FDS_OK and the service takes ownership of the garbage.
+ *   If the queue is full, returns #FDS_ERR_DENIED and the caller keeps the ownership.
+ */
+FDS_API int
+fds_tgc_push(fds_tgc_t *tgc, fds_tgarbage_t *gc);
+
+/**
+ * \brief Wait until all garbage in the queue has been destroyed
+ * \note Thread-safe
+ * \warning Deferred garbage is destroyed only after online readers of the corresponding
+ *   publisher pass a quiescent point. Otherwise the function never returns.
+ * \param[in] tgc Reclamation service
+ */
+FDS_API void
+fds_tgc_flush(fds_tgc_t *tgc);
+
+/**
+ * \brief Get statistics of a reclamation service
+ * \note Thread-safe
+ * \param[in]  tgc   Reclamation service
+ * \param[out] stats Statistics
+ */
+FDS_API void
+fds_tgc_stats(fds_tgc_t *tgc, struct fds_tgc_stats *stats);
+
+/**
+ * @}
+ */
+
 /**
  * @}
  */
@@ -7,7 +7,7 @@
 
 #include <stdint.h>
 
-const char gDigitsLut[200] = {
+static const char gDigitsLut[200] = {
     '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
     '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
     '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
@@ -101,4 +101,47 @@ i64toa_branchlut2(int64_t x, char* p)
     return u64toa_branchlut2(t, p);
 }
 
+/*
+ * Fixed-width conversions (zero padded, without the terminating null byte). The value must fit
+ * into the width. Used for components of dates and fractions of seconds.
+ */
+
+static inline char *
+u32toa_fixed2_branchlut2(uint32_t x, char *p)
+{
+    MIDDLE2(x);
+    return p;
+}
+
+static inline char *
+u32toa_fixed3_branchlut2(uint32_t x, char *p)
+{
+    *p++ = (char) ('0' + x / 100);
+    MIDDLE2(x % 100);
+    return p;
+}
+
+static inline char *
+u32toa_fixed4_branchlut2(uint32_t x, char *p)
+{
+    MIDDLE4(x);
+    return p;
+}
+
+static inline char *
+u32toa_fixed6_branchlut2(uint32_t x, char *p)
+{
+    MIDDLE2(x / 10000);
+    MIDDLE4(x % 10000);
+    return p;
+}
+
+static inline char *
+u32toa_fixed9_branchlut2(uint32_t x, char *p)
+{
+    *p++ = (char) ('0' + x / 100000000);
+    MIDDLE8(x % 100000000);
+    return p;
+}
+
 #endif /* BRANCHLUT_H */
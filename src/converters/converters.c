@@ -86,6 +86,148 @@ fds_set_float_be(void *field, size_t size, double value)
     }
 }
 
+int
+fds_get_uint_be_bulk(const uint8_t *const *bases, size_t offset, size_t size, uint64_t *values,
+    size_t cnt)
+{
+    // Each size has its own loop, so the compiler can emit a plain load + byte swap
+    switch (size) {
+    case 8:
+        for (size_t i = 0; i < cnt; ++i) {
+            uint64_t value;
+            memcpy(&value, bases[i] + offset, sizeof(value));
+            values[i] = be64toh(value);
+        }
+        return FDS_OK;
+
+    case 4:
+        for (size_t i = 0; i < cnt; ++i) {
+            uint32_t value;
+            memcpy(&value, bases[i] + offset, sizeof(value));
+            values[i] = ntohl(value);
+        }
+        return FDS_OK;
+
+    case 2:
+        for (size_t i = 0; i < cnt; ++i) {
+            uint16_t value;
+            memcpy(&value, bases[i] + offset, sizeof(value));
+            values[i] = ntohs(value);
+        }
+        return FDS_OK;
+
+    case 1:
+        for (size_t i = 0; i < cnt; ++i) {
+            values[i] = bases[i][offset];
+        }
+        return FDS_OK;
+
+    default:
+        // Other sizes (3,5,6,7)
+        break;
+    }
+
+    if (size == 0 || size > 8) {
+        return FDS_ERR_ARG;
+    }
+
+    for (size_t i = 0; i < cnt; ++i) {
+        uint64_t new_value = 0;
+        memcpy(&(((uint8_t *) &new_value)[8U - size]), bases[i] + offset, size);
+        values[i] = be64toh(new_value);
+    }
+    return FDS_OK;
+}
+
+int
+fds_get_int_be_bulk(const uint8_t *const *bases, size_t offset, size_t size, int64_t *values,
+    size_t cnt)
+{
+    switch (size) {
+    case 8:
+        for (size_t i = 0; i < cnt; ++i) {
+            uint64_t value;
+            memcpy(&value, bases[i] + offset, sizeof(value));
+            values[i] = (int64_t) be64toh(value);
+        }
+        return FDS_OK;
+
+    case 4:
+        for (size_t i = 0; i < cnt; ++i) {
+            uint32_t value;
+            memcpy(&value, bases[i] + offset, sizeof(value));
+            values[i] = (int32_t) ntohl(value);
+        }
+        return FDS_OK;
+
+    case 2:
+        for (size_t i = 0; i < cnt; ++i) {
+            uint16_t value;
+            memcpy(&value, bases[i] + offset, sizeof(value));
+            values[i] = (int16_t) ntohs(value);
+        }
+        return FDS_OK;
+
+    case 1:
+        for (size_t i = 0; i < cnt; ++i) {
+            values[i] = (int8_t) bases[i][offset];
+        }
+        return FDS_OK;
+
+    default:
+        // Other sizes (3,5,6,7)
+        break;
+    }
+
+    if (size == 0U || size > 8U) {
+        return FDS_ERR_ARG;
+    }
+
+    for (size_t i = 0; i < cnt; ++i) {
+        // Sign extension (see fds_get_int_be())
+        const uint8_t *field = bases[i] + offset;
+        int64_t new_value = ((*field) & 0x80) ? (-1) : 0;
+        memcpy(&(((int8_t *) &new_value)[8U - size]), field, size);
+        values[i] = be64toh(new_value);
+    }
+    return FDS_OK;
+}
+
+int
+fds_get_float_be_bulk(const uint8_t *const *bases, size_t offset, size_t size, double *values,
+    size_t cnt)
+{
+    if (size == sizeof(uint64_t)) {
+        for (size_t i = 0; i < cnt; ++i) {
+            union {
+                uint64_t u64;
+                double   dbl;
+            } cast_helper;
+
+            memcpy(&cast_helper.u64, bases[i] + offset, sizeof(cast_helper.u64));
+            cast_helper.u64 = be64toh(cast_helper.u64);
+            values[i] = cast_helper.dbl;
+        }
+        return FDS_OK;
+
+    } else if (size == sizeof(uint32_t)) {
+        for (size_t i = 0; i < cnt; ++i) {
+            union {
+                uint32_t u32;
+                float    flt;
+            } cast_helper;
+
+            memcpy(&cast_helper.u32, bases[i] + offset, sizeof(cast_helper.u32));
+            cast_helper.u32 = ntohl(cast_helper.u32);
+            values[i] = cast_helper.flt;
+        }
+        return FDS_OK;
+
+    } else {
+        return FDS_ERR_ARG;
+    }
+}
+
 /**
  * \brief Datetime wrapper function (from seconds to UTC string)
  * \param[in]  field     Pointer to the data field (in "network byte order")
@@ -343,46 +485,95 @@ fds_bool2str(const void *field, char *str, size_t str_size)
     return (int) (bool_len - 1); // Cast is OK. Max. size is length of "false".
 }
 
-int
-fds_datetime2str_be(const void *field, size_t size, enum fds_iemgr_element_type type,
-    char *str, size_t str_size, enum fds_convert_time_fmt fmt)
+/**
+ * \brief Update cached date and time of a formatting context
+ * \param[in] cache Cached value (UTC or local time)
+ * \param[in] sec   Seconds since the UNIX epoch
+ * \param[in] utc   UTC or local time
+ * \return #FDS_OK or #FDS_ERR_ARG (the timestamp cannot be converted)
+ */
+static int
+datetime_ctx_update(struct fds_datetime_cache *cache, time_t sec, bool utc)
 {
-    struct timespec ts;
-    if (fds_get_datetime_hp_be(field, size, type, &ts) != FDS_OK) {
-        return FDS_ERR_ARG;
-    }
-
-    // Convert common part
-    bool utc_time = true;
-    if (fmt & 0x10) { // The 5.bit is set -> local timestamp
-        utc_time = false;
-        fmt &= 0x0F;
-    }
-
-    struct tm timestamp;
-    if (utc_time) {
+    struct tm tm;
+    if (utc) {
         // Convert to UTC time
-        if (!gmtime_r(&ts.tv_sec, &timestamp)) {
+        if (!gmtime_r(&sec, &tm)) {
             return FDS_ERR_ARG;
         }
     } else {
         // Convert to local time
-        if (!localtime_r(&ts.tv_sec, &timestamp)) {
+        if (!localtime_r(&sec, &tm)) {
             return FDS_ERR_ARG;
         }
     }
 
-    size_t size_used = strftime(str, str_size, "%FT%T", &timestamp);
-    if (size_used == 0) {
-        return FDS_ERR_BUFFER;
+    const int year = tm.tm_year + 1900;
+    if (year >= 1000 && year <= 9999) {
+        // Common case (equivalent to "%FT%T")
+        char *p = cache->date;
+        p = u32toa_fixed4_branchlut2((uint32_t) year, p);
+        *p++ = '-';
+        p = u32toa_fixed2_branchlut2((uint32_t) tm.tm_mon + 1, p);
+        *p++ = '-';
+        p = u32toa_fixed2_branchlut2((uint32_t) tm.tm_mday, p);
+        *p++ = 'T';
+        p = u32toa_fixed2_branchlut2((uint32_t) tm.tm_hour, p);
+        *p++ = ':';
+        p = u32toa_fixed2_branchlut2((uint32_t) tm.tm_min, p);
+        *p++ = ':';
+        p = u32toa_fixed2_branchlut2((uint32_t) tm.tm_sec, p);
+        cache->date_len = (uint8_t) (p - cache->date);
+    } else {
+        size_t len = strftime(cache->date, sizeof(cache->date), "%FT%T", &tm);
+        if (len == 0) {
+            return FDS_ERR_ARG;
+        }
+        cache->date_len = (uint8_t) len;
+    }
+
+    if (utc) {
+        cache->zone[0] = 'Z';
+        cache->zone_len = 1;
+    } else {
+        char zone[sizeof(cache->zone) + 1];
+        size_t len = strftime(zone, sizeof(zone), "%z", &tm);
+        if (len == 0 || len > sizeof(cache->zone)) {
+            return FDS_ERR_ARG;
+        }
+        memcpy(cache->zone, zone, len);
+        cache->zone_len = (uint8_t) len;
+    }
+
+    cache->sec = sec;
+    cache->valid = true;
+    return FDS_OK;
+}
+
+void
+fds_datetime_ctx_init(struct fds_datetime_ctx *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int
+fds_datetime2str_ctx_be(struct fds_datetime_ctx *ctx, const void *field, size_t size,
+    enum fds_iemgr_element_type type, char *str, size_t str_size, enum fds_convert_time_fmt fmt)
+{
+    struct timespec ts;
+    if (fds_get_datetime_hp_be(field, size, type, &ts) != FDS_OK) {
+        return FDS_ERR_ARG;
     }
 
-    size_t size_remain = str_size - size_used;
-    char *str_remain = str + size_used;
+    bool utc_time = true;
+    if (fmt & 0x10) { // The 5.bit is set -> local timestamp
+        utc_time = false;
+        fmt &= 0x0F;
+    }
 
-    // Add the faction part
-    uint32_t frac;
-    int frac_width;
+    // Determine the fraction part
+    uint32_t frac = 0;
+    size_t frac_width;
 
     switch (fmt) {
     case FDS_CONVERT_TF_SEC_UTC:
@@ -404,37 +595,55 @@ fds_datetime2str_be(const void *field, size_t size, enum fds_iemgr_element_type
         return FDS_ERR_ARG;
     }
 
-    if (frac_width > 0) {
-        int ret = snprintf(str_remain, size_remain, ".%0*" PRIu32, frac_width, frac);
-        if (ret >= (int) size_remain || ret < 0) {
-            return FDS_ERR_BUFFER;
-        }
+    // Convert common part (only if the second has changed)
+    struct fds_datetime_cache *cache = &ctx->_cache[utc_time ? 0 : 1];
+    if ((!cache->valid || cache->sec != ts.tv_sec)
+            && datetime_ctx_update(cache, ts.tv_sec, utc_time) != FDS_OK) {
+        return FDS_ERR_ARG;
+    }
 
-        size_remain -= ret;
-        size_used += ret;
-        str_remain = str + size_used;
+    const size_t size_used = cache->date_len + (frac_width > 0 ? frac_width + 1 : 0)
+        + cache->zone_len;
+    if (size_used + 1 > str_size) { // +1 == '\0'
+        return FDS_ERR_BUFFER;
     }
 
-    // Add timezone information
-    if (utc_time) {
-        if (size_remain < 2) { // We need space for 'Z' and '\0'
-            return FDS_ERR_BUFFER;
-        }
+    char *p = str;
+    memcpy(p, cache->date, cache->date_len);
+    p += cache->date_len;
 
-        str_remain[0] = 'Z';
-        str_remain[1] = '\0';
-        size_used += 1; // Used size excludes the termination null byte!
-    } else {
-        size_t ret = strftime(str_remain, size_remain, "%z", &timestamp);
-        if (ret == 0) {
-            return FDS_ERR_BUFFER;
-        }
-        size_used += ret;
+    switch (frac_width) {
+    case 3:
+        *p++ = '.';
+        p = u32toa_fixed3_branchlut2(frac, p);
+        break;
+    case 6:
+        *p++ = '.';
+        p = u32toa_fixed6_branchlut2(frac, p);
+        break;
+    case 9:
+        *p++ = '.';
+        p = u32toa_fixed9_branchlut2(frac, p);
+        break;
+    default:
+        break;
     }
 
+    // Add timezone information
+    memcpy(p, cache->zone, cache->zone_len);
+    p[cache->zone_len] = '\0';
     return (int) size_used;
 }
 
+int
+fds_datetime2str_be(const void *field, size_t size, enum fds_iemgr_element_type type,
+    char *str, size_t str_size, enum fds_convert_time_fmt fmt)
+{
+    // Each thread has its own formatting context
+    static _Thread_local struct fds_datetime_ctx ctx;
+    return fds_datetime2str_ctx_be(&ctx, field, size, type, str, str_size, fmt);
+}
+
 int
 fds_mac2str(const void *field, size_t size, char *str, size_t str_size)
 {
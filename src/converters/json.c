@@ -0,0 +1,819 @@
+/**
+ * \file src/converters/json.c
+ * \author agent <agent@local>
+ * \brief Conversion of IPFIX Data Records to JSON (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libfds.h>
+#include "branchlut2.h"
+
+/** Number of items in a table of the cache of keys                                         */
+#define JSON_TABLE_SIZE 256U
+/** Maximum number of cached keys per Template ID (i.e. different layouts)                   */
+#define JSON_KEYS_WAYS 4U
+/** Default size of a newly allocated output buffer                                          */
+#define JSON_BUFFER_SIZE 1024U
+/** Maximum length of a formatted value (excluding strings and octet arrays)                */
+#define JSON_VALUE_MAXLEN 64U
+/** Information Element ID ("paddingOctets") for data padding                                */
+#define JSON_PADDING_IE 210
+/** IANA Private Enterprise Number for common forward fields                                 */
+#define JSON_PEN_FWD 0
+/** IANA Private Enterprise Number for common reverse fields                                 */
+#define JSON_PEN_REV 29305
+
+/** \brief Preformatted key of a field                                                       */
+struct json_key {
+    /** Definition of the Information Element the key is based on                          */
+    const struct fds_iemgr_elem *def;
+    /** Length of the key                                                                    */
+    size_t len;
+    /** Key (including quotation marks and the colon, i.e. "\"scope:name\":")               */
+    char *str;
+};
+
+/** \brief Preformatted keys of all fields of a template                                     */
+struct json_keys {
+    /** Next keys of the same Template ID (less recently used)                               */
+    struct json_keys *next;
+    /** Layout of template fields (see fds_template#index)                                   */
+    uint64_t layout_id;
+    /** Number of keys                                                                       */
+    uint16_t cnt;
+    /** Array of keys (one per template field)                                               */
+    struct json_key items[1];
+};
+
+/** \brief JSON serializer                                                                   */
+struct fds_json {
+    /** Serialization flags                                                                  */
+    uint32_t flags;
+    /** Context of timestamp formatting (caches the last converted second)                  */
+    struct fds_datetime_ctx date;
+    /** Auxiliary array of field locations                                                   */
+    struct fds_drec_loc *locs;
+    /** Number of items in the array of field locations                                      */
+    uint32_t locs_cnt;
+    /**
+     * Cache of preformatted keys (2-level table indexed by a Template ID). Each item is a list
+     * of up to #JSON_KEYS_WAYS keys of different layouts ordered from the most recently used.
+     */
+    struct json_keys **keys[JSON_TABLE_SIZE];
+};
+
+/** \brief Output buffer                                                                     */
+struct json_out {
+    /** Buffer                                                                               */
+    char *str;
+    /** Size of the buffer                                                                   */
+    size_t size;
+    /** Length of the content                                                                */
+    size_t len;
+};
+
+/** Hexadecimal digits                                                                       */
+static const char json_hex[] = "0123456789ABCDEF";
+
+/**
+ * \brief Make sure that the output buffer can hold additional characters
+ *
+ * The buffer is always able to hold also the terminating null byte.
+ * \param[in] out Output buffer
+ * \param[in] n   Number of characters to append
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static inline int
+json_reserve(struct json_out *out, size_t n)
+{
+    if (out->len + n < out->size) {
+        return FDS_OK;
+    }
+
+    size_t new_size = (out->size != 0) ? out->size : JSON_BUFFER_SIZE;
+    while (new_size <= out->len + n) {
+        new_size *= 2;
+    }
+
+    char *new_str = realloc(out->str, new_size);
+    if (!new_str) {
+        return FDS_ERR_NOMEM;
+    }
+
+    out->str = new_str;
+    out->size = new_size;
+    return FDS_OK;
+}
+
+/**
+ * \brief Get the length of a valid UTF-8 character
+ * \param[in] str Pointer to the character beginning
+ * \param[in] len Maximum length of the character (in bytes)
+ * \return Length of the character (1 - 4) or 0 if the character is not valid
+ */
+static inline size_t
+json_utf8_len(const uint8_t *str, size_t len)
+{
+    const uint8_t c = str[0];
+    uint8_t lo = 0x80;
+    uint8_t hi = 0xBF;
+    size_t cnt;
+
+    if (c < 0x80) {
+        return 1;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+        cnt = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        cnt = 3;
+        if (c == 0xE0) {
+            lo = 0xA0; // Overlong encoding
+        } else if (c == 0xED) {
+            hi = 0x9F; // UTF-16 surrogates
+        }
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        cnt = 4;
+        if (c == 0xF0) {
+            lo = 0x90; // Overlong encoding
+        } else if (c == 0xF4) {
+            hi = 0x8F; // Above U+10FFFF
+        }
+    } else {
+        return 0;
+    }
+
+    if (cnt > len || str[1] < lo || str[1] > hi) {
+        return 0;
+    }
+
+    for (size_t i = 2; i < cnt; ++i) {
+        if (str[i] < 0x80 || str[i] > 0xBF) {
+            return 0;
+        }
+    }
+
+    return cnt;
+}
+
+/**
+ * \brief Escape a string for a JSON string
+ *
+ * Quotation marks, backslashes and control characters are escaped and invalid UTF-8 characters
+ * are replaced with the replacement character (U+FFFD).
+ * \param[out] p   Output (must be able to hold at least 6 * \p len characters)
+ * \param[in]  str String to escape
+ * \param[in]  len Length of the string
+ * \return Pointer behind the last written character
+ */
+static char *
+json_escape(char *p, const uint8_t *str, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        const uint8_t c = str[i];
+        if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\') {
+            // Most common case
+            *p++ = (char) c;
+            i++;
+            continue;
+        }
+
+        if (c < 0x80) {
+            *p++ = '\\';
+            switch (c) {
+            case '"':  *p++ = '"';  break;
+            case '\\': *p++ = '\\'; break;
+            case '\b': *p++ = 'b';  break;
+            case '\f': *p++ = 'f';  break;
+            case '\n': *p++ = 'n';  break;
+            case '\r': *p++ = 'r';  break;
+            case '\t': *p++ = 't';  break;
+            default:
+                memcpy(p, "u00", 3);
+                p[3] = json_hex[c >> 4];
+                p[4] = json_hex[c & 0x0F];
+                p += 5;
+                break;
+            }
+            i++;
+            continue;
+        }
+
+        const size_t char_len = json_utf8_len(&str[i], len - i);
+        if (char_len == 0) {
+            // Invalid character -> replacement character
+            memcpy(p, "\xEF\xBF\xBD", 3);
+            p += 3;
+            i++;
+            continue;
+        }
+
+        if (c == 0xC2 && str[i + 1] < 0xA0) {
+            // C1 control character (U+0080 - U+009F)
+            memcpy(p, "\\u00", 4);
+            p[4] = json_hex[str[i + 1] >> 4];
+            p[5] = json_hex[str[i + 1] & 0x0F];
+            p += 6;
+        } else {
+            memcpy(p, &str[i], char_len);
+            p += char_len;
+        }
+        i += char_len;
+    }
+
+    return p;
+}
+
+/**
+ * \brief Format a key of a field
+ * \param[in] key    Key to (re)build
+ * \param[in] tfield Template field
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+json_key_build(struct json_key *key, const struct fds_tfield *tfield)
+{
+    const struct fds_iemgr_elem *def = tfield->def;
+    // Scopes created by fds_iemgr_elem_add() don't have a name -> use the numeric key
+    const bool use_name = (def != NULL && def->scope->name != NULL);
+    size_t max_len = 4 + 2 * FDS_CONVERT_STRLEN_INT; // quotation marks, colons
+    if (use_name) {
+        max_len += 6 * (strlen(def->scope->name) + strlen(def->name));
+    }
+
+    char *str = malloc(max_len);
+    if (!str) {
+        return FDS_ERR_NOMEM;
+    }
+
+    char *p = str;
+    *p++ = '"';
+    if (use_name) {
+        p = json_escape(p, (const uint8_t *) def->scope->name, strlen(def->scope->name));
+        *p++ = ':';
+        p = json_escape(p, (const uint8_t *) def->name, strlen(def->name));
+    } else {
+        *p++ = 'e';
+        *p++ = 'n';
+        p = u32toa_branchlut2(tfield->en, p);
+        memcpy(p, ":id", 3);
+        p = u32toa_branchlut2(tfield->id, p + 3);
+    }
+    *p++ = '"';
+    *p++ = ':';
+
+    free(key->str);
+    key->def = def;
+    key->len = (size_t) (p - str);
+    key->str = str;
+    return FDS_OK;
+}
+
+/**
+ * \brief Free preformatted keys
+ * \param[in] keys Keys to free
+ */
+static void
+json_keys_free(struct json_keys *keys)
+{
+    for (uint16_t i = 0; i < keys->cnt; ++i) {
+        free(keys->items[i].str);
+    }
+    free(keys);
+}
+
+/**
+ * \brief Build preformatted keys of fields of a template
+ * \param[in] tmplt Template
+ * \return Pointer to the keys or NULL (memory allocation error)
+ */
+static struct json_keys *
+json_keys_build(const struct fds_template *tmplt)
+{
+    const uint16_t fields_cnt = tmplt->fields_cnt_total;
+    size_t size = sizeof(struct json_keys);
+    if (fields_cnt > 1) {
+        size += (fields_cnt - 1U) * sizeof(struct json_key);
+    }
+
+    struct json_keys *keys = calloc(1, size);
+    if (!keys) {
+        return NULL;
+    }
+
+    keys->layout_id = tmplt->index.layout_id;
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        if (json_key_build(&keys->items[i], &tmplt->fields[i]) != FDS_OK) {
+            json_keys_free(keys);
+            return NULL;
+        }
+        keys->cnt++;
+    }
+
+    return keys;
+}
+
+/**
+ * \brief Get preformatted keys of fields of a template
+ *
+ * Keys are cached per layout of template fields, therefore, templates with the same ID from
+ * different sessions (or a redefined template) don't replace each other's keys unless there are
+ * more than #JSON_KEYS_WAYS layouts of the same ID. In that case, the least recently used keys
+ * are thrown away. Keys of fields with changed Information Element definitions are rebuilt.
+ * \param[in] json  Serializer
+ * \param[in] tmplt Template
+ * \return Pointer to the keys or NULL (memory allocation error)
+ */
+static struct json_keys *
+json_keys_get(struct fds_json *json, const struct fds_template *tmplt)
+{
+    const uint16_t id = tmplt->id;
+    struct json_keys **l2_table = json->keys[id / JSON_TABLE_SIZE];
+    if (!l2_table) {
+        l2_table = calloc(JSON_TABLE_SIZE, sizeof(*l2_table));
+        if (!l2_table) {
+            return NULL;
+        }
+        json->keys[id / JSON_TABLE_SIZE] = l2_table;
+    }
+
+    struct json_keys **head = &l2_table[id % JSON_TABLE_SIZE];
+    struct json_keys **prev = head;
+    struct json_keys *keys = *head;
+    uint32_t keys_cnt = 0;
+
+    while (keys != NULL && keys->layout_id != tmplt->index.layout_id) {
+        if (++keys_cnt == JSON_KEYS_WAYS) {
+            // Throw away the least recently used keys
+            *prev = NULL;
+            json_keys_free(keys);
+            keys = NULL;
+            break;
+        }
+        prev = &keys->next;
+        keys = keys->next;
+    }
+
+    if (!keys) {
+        keys = json_keys_build(tmplt);
+        if (!keys) {
+            return NULL;
+        }
+    } else {
+        // Unlink the keys
+        *prev = keys->next;
+
+        for (uint16_t i = 0; i < keys->cnt; ++i) {
+            // Definitions might have been changed (e.g. a new IE manager has been used)
+            if (keys->items[i].def == tmplt->fields[i].def) {
+                continue;
+            }
+
+            if (json_key_build(&keys->items[i], &tmplt->fields[i]) != FDS_OK) {
+                keys->next = *head;
+                *head = keys;
+                return NULL;
+            }
+        }
+    }
+
+    // Move the keys to the front
+    keys->next = *head;
+    *head = keys;
+    return keys;
+}
+
+/**
+ * \brief Format a timestamp
+ * \param[in] json Serializer
+ * \param[in] data Field data
+ * \param[in] size Field size
+ * \param[in] type Type of the timestamp
+ * \param[out] p   Output (at least #JSON_VALUE_MAXLEN characters)
+ * \return Pointer behind the last written character or NULL (conversion failed)
+ */
+static inline char *
+json_value_datetime(struct fds_json *json, const uint8_t *data, uint16_t size,
+    enum fds_iemgr_element_type type, char *p)
+{
+    if (json->flags & FDS_JSON_TS_NUMERIC) {
+        uint64_t ts;
+        if (fds_get_datetime_lp_be(data, size, type, &ts) != FDS_OK) {
+            return NULL;
+        }
+        return u64toa_branchlut2(ts, p);
+    }
+
+    enum fds_convert_time_fmt fmt;
+    switch (type) {
+    case FDS_ET_DATE_TIME_SECONDS:
+        fmt = FDS_CONVERT_TF_SEC_UTC;
+        break;
+    case FDS_ET_DATE_TIME_MILLISECONDS:
+        fmt = FDS_CONVERT_TF_MSEC_UTC;
+        break;
+    case FDS_ET_DATE_TIME_MICROSECONDS:
+        fmt = FDS_CONVERT_TF_USEC_UTC;
+        break;
+    default:
+        fmt = FDS_CONVERT_TF_NSEC_UTC;
+        break;
+    }
+
+    int ret = fds_datetime2str_ctx_be(&json->date, data, size, type, p + 1,
+        JSON_VALUE_MAXLEN - 2, fmt);
+    if (ret < 0) {
+        return NULL;
+    }
+
+    p[0] = '"';
+    p += ret + 1;
+    *p++ = '"';
+    return p;
+}
+
+/**
+ * \brief Format a floating point number
+ *
+ * Integral values are formatted directly, other values are formatted in the same way as
+ * fds_float2str_be() does. Infinite values and NaN are stored as JSON strings.
+ * \param[in]  data Field data
+ * \param[in]  size Field size
+ * \param[out] p    Output (at least #JSON_VALUE_MAXLEN characters)
+ * \return Pointer behind the last written character or NULL (conversion failed)
+ */
+static inline char *
+json_value_float(const uint8_t *data, uint16_t size, char *p)
+{
+    double value;
+    if (fds_get_float_be(data, size, &value) != FDS_OK) {
+        return NULL;
+    }
+
+    if (!isfinite(value)) {
+        const char *str = isnan(value) ? "\"NaN\"" : ((value > 0) ? "\"inf\"" : "\"-inf\"");
+        const size_t len = strlen(str);
+        memcpy(p, str, len);
+        return p + len;
+    }
+
+    // Integral values within the precision of the type are printed by "%g" without exponent
+    const double limit = (size == sizeof(float)) ? 1e6 : 1e15;
+    if (fabs(value) < limit && value == (double) (int64_t) value
+            && !(value == 0 && signbit(value))) {
+        return i64toa_branchlut2((int64_t) value, p);
+    }
+
+    int ret = fds_float2str_be(data, size, p, JSON_VALUE_MAXLEN);
+    return (ret < 0) ? NULL : (p + ret);
+}
+
+/**
+ * \brief Format an IPv4 address
+ * \param[in]  data Field data (4 bytes)
+ * \param[out] p    Output
+ * \return Pointer behind the last written character
+ */
+static inline char *
+json_value_ipv4(const uint8_t *data, char *p)
+{
+    *p++ = '"';
+    for (int i = 0; i < 4; ++i) {
+        p = u32toa_branchlut2(data[i], p);
+        *p++ = '.';
+    }
+    p[-1] = '"';
+    return p;
+}
+
+/**
+ * \brief Format a MAC address
+ * \param[in]  data Field data (6 bytes)
+ * \param[out] p    Output
+ * \return Pointer behind the last written character
+ */
+static inline char *
+json_value_mac(const uint8_t *data, char *p)
+{
+    *p++ = '"';
+    for (int i = 0; i < 6; ++i) {
+        *p++ = json_hex[data[i] >> 4];
+        *p++ = json_hex[data[i] & 0x0F];
+        *p++ = ':';
+    }
+    p[-1] = '"';
+    return p;
+}
+
+/**
+ * \brief Format an octet array
+ * \param[in]  data Field data
+ * \param[in]  size Field size
+ * \param[out] p    Output (at least 2 * \p size + 4 characters)
+ * \return Pointer behind the last written character
+ */
+static inline char *
+json_value_octets(const uint8_t *data, uint16_t size, char *p)
+{
+    memcpy(p, "\"0x", 3);
+    p += 3;
+    for (uint16_t i = 0; i < size; ++i) {
+        *p++ = json_hex[data[i] >> 4];
+        *p++ = json_hex[data[i] & 0x0F];
+    }
+    *p++ = '"';
+    return p;
+}
+
+/**
+ * \brief Format a value of a field
+ *
+ * If the value cannot be converted, null is stored instead.
+ * \param[in]  json   Serializer
+ * \param[in]  tfield Template field
+ * \param[in]  data   Field data
+ * \param[in]  size   Field size
+ * \param[out] p      Output (at least 6 * \p size + #JSON_VALUE_MAXLEN characters)
+ * \return Pointer behind the last written character
+ */
+static char *
+json_value(struct fds_json *json, const struct fds_tfield *tfield, const uint8_t *data,
+    uint16_t size, char *p)
+{
+    const enum fds_iemgr_element_type type = (tfield->def != NULL)
+        ? tfield->def->data_type : FDS_ET_OCTET_ARRAY;
+    char *end = NULL;
+
+    switch (type) {
+    case FDS_ET_UNSIGNED_8:
+    case FDS_ET_UNSIGNED_16:
+    case FDS_ET_UNSIGNED_32:
+    case FDS_ET_UNSIGNED_64: {
+        uint64_t value;
+        if (fds_get_uint_be(data, size, &value) == FDS_OK) {
+            end = u64toa_branchlut2(value, p);
+        }
+        } break;
+    case FDS_ET_SIGNED_8:
+    case FDS_ET_SIGNED_16:
+    case FDS_ET_SIGNED_32:
+    case FDS_ET_SIGNED_64: {
+        int64_t value;
+        if (fds_get_int_be(data, size, &value) == FDS_OK) {
+            end = i64toa_branchlut2(value, p);
+        }
+        } break;
+    case FDS_ET_FLOAT_32:
+    case FDS_ET_FLOAT_64:
+        end = json_value_float(data, size, p);
+        break;
+    case FDS_ET_BOOLEAN: {
+        bool value;
+        if (fds_get_bool(data, size, &value) == FDS_OK) {
+            const char *str = value ? "true" : "false";
+            const size_t len = value ? 4 : 5;
+            memcpy(p, str, len);
+            end = p + len;
+        }
+        } break;
+    case FDS_ET_MAC_ADDRESS:
+        if (size == 6U) {
+            end = json_value_mac(data, p);
+        }
+        break;
+    case FDS_ET_STRING:
+        *p = '"';
+        end = json_escape(p + 1, data, size);
+        *end++ = '"';
+        break;
+    case FDS_ET_DATE_TIME_SECONDS:
+    case FDS_ET_DATE_TIME_MILLISECONDS:
+    case FDS_ET_DATE_TIME_MICROSECONDS:
+    case FDS_ET_DATE_TIME_NANOSECONDS:
+        end = json_value_datetime(json, data, size, type, p);
+        break;
+    case FDS_ET_IPV4_ADDRESS:
+    case FDS_ET_IPV6_ADDRESS:
+        if (size == 4U) {
+            end = json_value_ipv4(data, p);
+        } else {
+            int ret = fds_ip2str(data, size, p + 1, JSON_VALUE_MAXLEN - 2);
+            if (ret >= 0) {
+                *p = '"';
+                end = p + ret + 1;
+                *end++ = '"';
+            }
+        }
+        break;
+    default:
+        // Octet arrays, lists and unknown types
+        end = json_value_octets(data, size, p);
+        break;
+    }
+
+    if (!end) {
+        memcpy(p, "null", 4);
+        end = p + 4;
+    }
+    return end;
+}
+
+fds_json_t *
+fds_json_create(uint32_t flags)
+{
+    struct fds_json *json = calloc(1, sizeof(*json));
+    if (!json) {
+        return NULL;
+    }
+
+    json->flags = flags;
+    fds_datetime_ctx_init(&json->date);
+    return json;
+}
+
+void
+fds_json_destroy(fds_json_t *json)
+{
+    for (uint32_t i = 0; i < JSON_TABLE_SIZE; ++i) {
+        struct json_keys **l2_table = json->keys[i];
+        if (!l2_table) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < JSON_TABLE_SIZE; ++j) {
+            struct json_keys *keys = l2_table[j];
+            while (keys != NULL) {
+                struct json_keys *next = keys->next;
+                json_keys_free(keys);
+                keys = next;
+            }
+        }
+        free(l2_table);
+    }
+
+    free(json->locs);
+    free(json);
+}
+
+/**
+ * \brief Convert a Data Record to a JSON object (auxiliary function)
+ * \param[in] json Serializer
+ * \param[in] rec  Data Record
+ * \param[in] out  Output buffer
+ * \return #FDS_OK, #FDS_ERR_FORMAT or #FDS_ERR_NOMEM
+ */
+static int
+json_drec(struct fds_json *json, struct fds_drec *rec, struct json_out *out)
+{
+    const struct fds_template *tmplt = rec->tmplt;
+    const uint16_t fields_cnt = tmplt->fields_cnt_total;
+
+    // Determine locations of all fields in a single pass
+    if (json->locs_cnt < fields_cnt) {
+        struct fds_drec_loc *locs = realloc(json->locs, fields_cnt * sizeof(*locs));
+        if (!locs) {
+            return FDS_ERR_NOMEM;
+        }
+        json->locs = locs;
+        json->locs_cnt = fields_cnt;
+    }
+
+    struct fds_drec_prep prep;
+    if (fds_drec_prepare(&prep, rec, json->locs, fields_cnt) != FDS_OK) {
+        return FDS_ERR_FORMAT;
+    }
+
+    const struct json_keys *keys = json_keys_get(json, tmplt);
+    if (!keys) {
+        return FDS_ERR_NOMEM;
+    }
+
+    if (json_reserve(out, 2) != FDS_OK) {
+        return FDS_ERR_NOMEM;
+    }
+    out->str[out->len++] = '{';
+
+    bool first = true;
+    for (uint16_t idx = 0; idx < fields_cnt; ++idx) {
+        const struct fds_tfield *tfield = &tmplt->fields[idx];
+        if (tfield->id == JSON_PADDING_IE && (tfield->en == JSON_PEN_FWD
+                || tfield->en == JSON_PEN_REV)) {
+            continue;
+        }
+        if ((json->flags & FDS_JSON_UNKNOWN_SKIP) && tfield->def == NULL) {
+            continue;
+        }
+        if ((json->flags & FDS_JSON_REVERSE_SKIP) && (tfield->flags & FDS_TFIELD_REVERSE)) {
+            continue;
+        }
+
+        const bool multi = (tfield->flags & FDS_TFIELD_MULTI_IE) != 0;
+        if (multi && fds_template_cfind(tmplt, tfield->en, tfield->id) != tfield) {
+            // Not the first occurrence -> already stored in the array
+            continue;
+        }
+
+        const struct json_key *key = &keys->items[idx];
+        const struct fds_drec_loc *loc = &json->locs[idx];
+        if (json_reserve(out, key->len + 2 + 6U * loc->size + JSON_VALUE_MAXLEN) != FDS_OK) {
+            return FDS_ERR_NOMEM;
+        }
+
+        char *p = &out->str[out->len];
+        if (!first) {
+            *p++ = ',';
+        }
+        memcpy(p, key->str, key->len);
+        p += key->len;
+        first = false;
+
+        if (!multi) {
+            p = json_value(json, tfield, &rec->data[loc->offset], loc->size, p);
+            out->len = (size_t) (p - out->str);
+            continue;
+        }
+
+        // Store all occurrences of the Information Element into an array
+        *p++ = '[';
+        out->len = (size_t) (p - out->str);
+        for (uint16_t i = idx; i < fields_cnt; ++i) {
+            const struct fds_tfield *item = &tmplt->fields[i];
+            if (item->id != tfield->id || item->en != tfield->en) {
+                continue;
+            }
+
+            loc = &json->locs[i];
+            if (json_reserve(out, 2 + 6U * loc->size + JSON_VALUE_MAXLEN) != FDS_OK) {
+                return FDS_ERR_NOMEM;
+            }
+
+            p = &out->str[out->len];
+            if (i != idx) {
+                *p++ = ',';
+            }
+            p = json_value(json, item, &rec->data[loc->offset], loc->size, p);
+            out->len = (size_t) (p - out->str);
+
+            if (item->flags & FDS_TFIELD_LAST_IE) {
+                break;
+            }
+        }
+        out->str[out->len++] = ']';
+    }
+
+    out->str[out->len++] = '}';
+    out->str[out->len] = '\0';
+    return FDS_OK;
+}
+
+int
+fds_json_drec(fds_json_t *json, struct fds_drec *rec, char **str, size_t *str_size)
+{
+    struct json_out out = {*str, (*str != NULL) ? *str_size : 0, 0};
+    int ret = json_drec(json, rec, &out);
+
+    *str = out.str;
+    *str_size = out.size;
+    if (ret != FDS_OK) {
+        return ret;
+    }
+
+    return (int) out.len;
+}
@@ -54,52 +54,147 @@
 int
 fds_drec_find(struct fds_drec *rec, uint32_t pen, uint16_t id, struct fds_drec_field *field)
 {
-    const uint16_t fields_cnt = rec->tmplt->fields_cnt_total;
+    const struct fds_template *tmplt = rec->tmplt;
+    const struct fds_tfield *field_def = fds_template_cfind(tmplt, pen, id);
+    if (!field_def) {
+        // The field is not present in the template
+        static_assert(FDS_EOC < 0, "Error codes must be always negative!");
+        return FDS_EOC;
+    }
+
     uint8_t *rec_start = rec->data;
+    const uint16_t field_idx = (uint16_t) (field_def - tmplt->fields);
+    uint16_t field_size = field_def->length;
+    uint16_t offset = field_def->offset;
+
+    if (offset == FDS_IPFIX_VAR_IE_LEN) {
+        // Unknown offset -> skip fields from the last field with known offset
+        const uint16_t idx_start = tmplt->index.var_first;
+        assert(idx_start < field_idx);
+        offset = tmplt->fields[idx_start].offset;
+
+        for (uint16_t idx = idx_start; idx < field_idx; ++idx) {
+            uint16_t size = tmplt->fields[idx].length;
+            if (size == FDS_IPFIX_VAR_IE_LEN) {
+                // This is field with variable length encoding -> read size from data
+                size = rec_start[offset];
+                offset++;
+
+                if (size == 255U) {
+                    // Real size is on next 2 bytes
+                    size = ntohs(*(uint16_t *) &rec_start[offset]);
+                    offset += 2U;
+                }
+            }
 
-    uint16_t offset = 0;
-    uint16_t field_size;
-    const struct fds_tfield *field_def;
+            offset += size;
+        }
+    }
 
-    uint16_t idx;
-    for (idx = 0; idx < fields_cnt; ++idx) {
-        // Determine the start of the field and its real length
-        field_def = &rec->tmplt->fields[idx];
-        field_size = field_def->length;
+    if (field_size == FDS_IPFIX_VAR_IE_LEN) {
+        // This is field with variable length encoding -> read size from data
+        field_size = rec_start[offset];
+        offset++;
+
+        if (field_size == 255U) {
+            // Real size is on next 2 bytes
+            field_size = ntohs(*(uint16_t *) &rec_start[offset]);
+            offset += 2U;
+        }
+    }
+
+    // We found required field
+    field->data = &rec_start[offset];
+    field->size = field_size;
+    field->info = field_def;
+    return field_idx;
+}
+
+int
+fds_drec_prepare(struct fds_drec_prep *prep, struct fds_drec *rec, struct fds_drec_loc *locs,
+    uint16_t locs_cnt)
+{
+    const struct fds_template *tmplt = rec->tmplt;
+    const uint16_t fields_cnt = tmplt->fields_cnt_total;
+    if (locs_cnt < fields_cnt) {
+        return FDS_ERR_ARG;
+    }
+
+    const uint8_t *rec_start = rec->data;
+    const uint32_t rec_size = rec->size;
+    uint32_t offset = 0;
+
+    for (uint16_t idx = 0; idx < fields_cnt; ++idx) {
+        uint32_t field_size = tmplt->fields[idx].length;
 
         if (field_size == FDS_IPFIX_VAR_IE_LEN) {
             // This is field with variable length encoding -> read size from data
+            if (offset + 1U > rec_size) {
+                return FDS_ERR_FORMAT;
+            }
+
             field_size = rec_start[offset];
             offset++;
 
             if (field_size == 255U) {
                 // Real size is on next 2 bytes
+                if (offset + 2U > rec_size) {
+                    return FDS_ERR_FORMAT;
+                }
+
                 field_size = ntohs(*(uint16_t *) &rec_start[offset]);
                 offset += 2U;
             }
         }
 
-        if (field_def->id == id && field_def->en == pen) {
-            // Field found
-            break;
+        if (offset + field_size > rec_size) {
+            return FDS_ERR_FORMAT;
         }
 
+        locs[idx].offset = (uint16_t) offset;
+        locs[idx].size = (uint16_t) field_size;
         offset += field_size;
     }
 
-    if (idx >= fields_cnt) {
-        // No more fields
-        static_assert(FDS_EOC < 0, "Error codes must be always negative!");
+    prep->rec = rec;
+    prep->locs = locs;
+    return FDS_OK;
+}
+
+int
+fds_drec_prep_get(const struct fds_drec_prep *prep, uint16_t idx, struct fds_drec_field *field)
+{
+    const struct fds_template *tmplt = prep->rec->tmplt;
+    if (idx >= tmplt->fields_cnt_total) {
         return FDS_EOC;
     }
 
-    // We found required field
-    field->data = &rec_start[offset];
-    field->size = field_size;
-    field->info = field_def;
+    const struct fds_drec_loc *loc = &prep->locs[idx];
+    field->data = &prep->rec->data[loc->offset];
+    field->size = loc->size;
+    field->info = &tmplt->fields[idx];
     return idx;
 }
 
+int
+fds_drec_prep_find(const struct fds_drec_prep *prep, uint32_t pen, uint16_t id,
+    struct fds_drec_field *field)
+{
+    const struct fds_template *tmplt = prep->rec->tmplt;
+    const struct fds_tfield *field_def = fds_template_cfind(tmplt, pen, id);
+    if (!field_def) {
+        // The field is not present in the template
+        return FDS_EOC;
+    }
+
+    const uint16_t field_idx = (uint16_t) (field_def - tmplt->fields);
+    const struct fds_drec_loc *loc = &prep->locs[field_idx];
+    field->data = &prep->rec->data[loc->offset];
+    field->size = loc->size;
+    field->info = field_def;
+    return field_idx;
+}
+
 void
 fds_drec_iter_init(struct fds_drec_iter *iter, struct fds_drec *record, uint16_t flags)
 {
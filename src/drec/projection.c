@@ -0,0 +1,579 @@
+/**
+ * \file src/drec/projection.c
+ * \author agent <agent@local>
+ * \brief Projections of IPFIX Data Records (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <arpa/inet.h> // ntohs
+
+#include <libfds.h>
+
+/** Number of items in a table of the cache of extraction plans */
+#define PROJ_TABLE_SIZE 256U
+/** Maximum number of cached extraction plans per Template ID (i.e. different layouts) */
+#define PROJ_PLAN_WAYS 4U
+/** Number of Data Records decoded at once during extraction into columns */
+#define PROJ_BATCH_SIZE 64U
+
+/** \brief Extraction of a single Information Element */
+struct proj_item {
+    /** Index of the item in the output array                                             */
+    uint16_t slot;
+    /** Index of the field in the template                                                */
+    uint16_t idx;
+    /** Offset of the field in the record (or #FDS_IPFIX_VAR_IE_LEN if not known)         */
+    uint16_t offset;
+    /** Length of the field in the template (or #FDS_IPFIX_VAR_IE_LEN)                    */
+    uint16_t length;
+};
+
+/**
+ * \brief Compiled extraction plan for a template
+ *
+ * Items are divided into 3 consecutive groups: fields with known offset, fields with unknown
+ * offset (sorted by their position in the template) and fields missing in the template.
+ */
+struct proj_plan {
+    /** Next plan of the same Template ID (less recently used)                            */
+    struct proj_plan *next;
+    /** Layout of template fields (see fds_template#index)                                */
+    uint64_t layout_id;
+    /** Number of fields with known offset                                                */
+    uint16_t direct_cnt;
+    /** Number of fields with unknown offset                                              */
+    uint16_t walk_cnt;
+    /** Number of missing fields                                                          */
+    uint16_t missing_cnt;
+    /** Index of the first field that must be skipped to reach fields with unknown offset */
+    uint16_t walk_start;
+    /** Array of items (the size is given by the projection)                              */
+    struct proj_item items[1];
+};
+
+/** \brief Projection */
+struct fds_proj {
+    /** Number of Information Elements to extract                                         */
+    uint16_t elem_cnt;
+    /** Array of Information Elements to extract                                          */
+    struct fds_proj_elem *elems;
+    /** Auxiliary array of extracted fields (one per Information Element)                 */
+    struct fds_drec_field *fields;
+    /** Auxiliary flags of columns converted in bulk (one per Information Element)        */
+    bool *col_bulk;
+    /**
+     * Cache of extraction plans (2-level table indexed by a Template ID). Each item is a list
+     * of up to #PROJ_PLAN_WAYS plans of different layouts ordered from the most recently used.
+     */
+    struct proj_plan **plans[PROJ_TABLE_SIZE];
+};
+
+/**
+ * \brief Calculate size of an extraction plan
+ * \param[in] elem_cnt Number of Information Elements to extract
+ */
+static inline size_t
+proj_plan_size(uint16_t elem_cnt)
+{
+    return sizeof(struct proj_plan) + (elem_cnt - 1U) * sizeof(struct proj_item);
+}
+
+/**
+ * \brief Compare items of an extraction plan by their position in a template
+ */
+static int
+proj_item_cmp(const void *p1, const void *p2)
+{
+    const struct proj_item *item1 = p1;
+    const struct proj_item *item2 = p2;
+    if (item1->idx != item2->idx) {
+        return (item1->idx < item2->idx) ? -1 : 1;
+    }
+
+    return (item1->slot < item2->slot) ? -1 : (item1->slot > item2->slot);
+}
+
+/**
+ * \brief Compile an extraction plan of a template
+ * \param[in]  proj  Projection
+ * \param[in]  tmplt Template
+ * \param[out] plan  Plan to fill (must be allocated for all Information Elements)
+ */
+static void
+proj_plan_compile(const struct fds_proj *proj, const struct fds_template *tmplt,
+    struct proj_plan *plan)
+{
+    const uint16_t elem_cnt = proj->elem_cnt;
+    uint16_t direct_cnt = 0;
+    uint16_t walk_cnt = 0;
+    uint16_t missing_cnt = 0;
+
+    // First pass: count items of each group
+    for (uint16_t i = 0; i < elem_cnt; ++i) {
+        const struct fds_proj_elem *elem = &proj->elems[i];
+        const struct fds_tfield *field = fds_template_cfind(tmplt, elem->en, elem->id);
+        if (!field) {
+            missing_cnt++;
+        } else if (field->offset != FDS_IPFIX_VAR_IE_LEN) {
+            direct_cnt++;
+        } else {
+            walk_cnt++;
+        }
+    }
+
+    // Second pass: fill items
+    struct proj_item *direct_ptr = &plan->items[0];
+    struct proj_item *walk_ptr = &plan->items[direct_cnt];
+    struct proj_item *missing_ptr = &plan->items[direct_cnt + walk_cnt];
+
+    for (uint16_t i = 0; i < elem_cnt; ++i) {
+        const struct fds_proj_elem *elem = &proj->elems[i];
+        const struct fds_tfield *field = fds_template_cfind(tmplt, elem->en, elem->id);
+        struct proj_item *item;
+        if (!field) {
+            item = missing_ptr++;
+            item->idx = 0;
+            item->offset = 0;
+            item->length = 0;
+        } else {
+            item = (field->offset != FDS_IPFIX_VAR_IE_LEN) ? direct_ptr++ : walk_ptr++;
+            item->idx = (uint16_t) (field - tmplt->fields);
+            item->offset = field->offset;
+            item->length = field->length;
+        }
+        item->slot = i;
+    }
+
+    // Fields with unknown offset must be processed in order of the template
+    qsort(&plan->items[direct_cnt], walk_cnt, sizeof(struct proj_item), proj_item_cmp);
+
+    plan->layout_id = tmplt->index.layout_id;
+    plan->direct_cnt = direct_cnt;
+    plan->walk_cnt = walk_cnt;
+    plan->missing_cnt = missing_cnt;
+    plan->walk_start = tmplt->index.var_first;
+}
+
+/**
+ * \brief Get an extraction plan of a template
+ *
+ * Plans are cached per layout of template fields, therefore, templates with the same ID from
+ * different sessions (or a redefined template) don't replace each other's plan unless there are
+ * more than #PROJ_PLAN_WAYS layouts of the same ID. In that case, the least recently used plan
+ * is recompiled.
+ * \param[in] proj  Projection
+ * \param[in] tmplt Template
+ * \return Pointer to the plan or NULL (memory allocation error)
+ */
+static const struct proj_plan *
+proj_plan_get(struct fds_proj *proj, const struct fds_template *tmplt)
+{
+    const uint16_t id = tmplt->id;
+    struct proj_plan **l2_table = proj->plans[id / PROJ_TABLE_SIZE];
+    if (!l2_table) {
+        l2_table = calloc(PROJ_TABLE_SIZE, sizeof(*l2_table));
+        if (!l2_table) {
+            return NULL;
+        }
+        proj->plans[id / PROJ_TABLE_SIZE] = l2_table;
+    }
+
+    struct proj_plan **head = &l2_table[id % PROJ_TABLE_SIZE];
+    struct proj_plan **prev = head;
+    struct proj_plan *plan = *head;
+    uint32_t plan_cnt = 0;
+
+    while (plan != NULL) {
+        ++plan_cnt;
+        if (plan->layout_id == tmplt->index.layout_id) {
+            break;
+        }
+        if (plan->next == NULL && plan_cnt == PROJ_PLAN_WAYS) {
+            // The least recently used plan will be replaced
+            break;
+        }
+        prev = &plan->next;
+        plan = plan->next;
+    }
+
+    if (!plan) {
+        plan = calloc(1, proj_plan_size(proj->elem_cnt));
+        if (!plan) {
+            return NULL;
+        }
+        proj_plan_compile(proj, tmplt, plan);
+    } else {
+        // Unlink the plan
+        *prev = plan->next;
+        if (plan->layout_id != tmplt->index.layout_id) {
+            // Size of all plans is the same, therefore, the old one can be reused
+            proj_plan_compile(proj, tmplt, plan);
+        }
+    }
+
+    // Move the plan to the front
+    plan->next = *head;
+    *head = plan;
+    return plan;
+}
+
+fds_proj_t *
+fds_proj_create(const struct fds_proj_elem *elems, uint16_t elem_cnt)
+{
+    if (elem_cnt == 0) {
+        return NULL;
+    }
+
+    struct fds_proj *proj = calloc(1, sizeof(*proj));
+    if (!proj) {
+        return NULL;
+    }
+
+    proj->elems = calloc(elem_cnt, sizeof(*proj->elems));
+    proj->fields = calloc(elem_cnt, sizeof(*proj->fields));
+    proj->col_bulk = calloc(elem_cnt, sizeof(*proj->col_bulk));
+    if (!proj->elems || !proj->fields || !proj->col_bulk) {
+        free(proj->elems);
+        free(proj->fields);
+        free(proj->col_bulk);
+        free(proj);
+        return NULL;
+    }
+
+    memcpy(proj->elems, elems, elem_cnt * sizeof(*proj->elems));
+    proj->elem_cnt = elem_cnt;
+    return proj;
+}
+
+void
+fds_proj_destroy(fds_proj_t *proj)
+{
+    for (uint32_t i = 0; i < PROJ_TABLE_SIZE; ++i) {
+        struct proj_plan **l2_table = proj->plans[i];
+        if (!l2_table) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < PROJ_TABLE_SIZE; ++j) {
+            struct proj_plan *plan = l2_table[j];
+            while (plan != NULL) {
+                struct proj_plan *next = plan->next;
+                free(plan);
+                plan = next;
+            }
+        }
+        free(l2_table);
+    }
+
+    free(proj->elems);
+    free(proj->fields);
+    free(proj->col_bulk);
+    free(proj);
+}
+
+/**
+ * \brief Get the real length of a field and the start of its data
+ * \param[in]     rec_start Start of the record
+ * \param[in,out] offset    Offset of the field (will be moved behind the octet prefix)
+ * \param[in]     length    Length of the field in the template
+ * \return Real length of the field
+ */
+static inline uint16_t
+proj_field_size(const uint8_t *rec_start, uint32_t *offset, uint16_t length)
+{
+    if (length != FDS_IPFIX_VAR_IE_LEN) {
+        return length;
+    }
+
+    // This is field with variable length encoding -> read size from data
+    uint16_t size = rec_start[*offset];
+    (*offset)++;
+
+    if (size == 255U) {
+        // Real size is on next 2 bytes
+        size = ntohs(*(const uint16_t *) &rec_start[*offset]);
+        (*offset) += 2U;
+    }
+
+    return size;
+}
+
+int
+fds_proj_extract(fds_proj_t *proj, struct fds_drec *rec, struct fds_drec_field *fields)
+{
+    const struct fds_template *tmplt = rec->tmplt;
+    const struct proj_plan *plan = proj_plan_get(proj, tmplt);
+    if (!plan) {
+        return FDS_ERR_NOMEM;
+    }
+
+    uint8_t *rec_start = rec->data;
+    const struct proj_item *item = &plan->items[0];
+    const struct proj_item *item_end;
+
+    // Fields with known offset
+    for (item_end = item + plan->direct_cnt; item < item_end; ++item) {
+        struct fds_drec_field *field = &fields[item->slot];
+        uint32_t offset = item->offset;
+        field->size = proj_field_size(rec_start, &offset, item->length);
+        field->data = &rec_start[offset];
+        field->info = &tmplt->fields[item->idx];
+    }
+
+    // Fields with unknown offset (single pass over the rest of the record)
+    if (plan->walk_cnt > 0) {
+        uint16_t idx = plan->walk_start;
+        uint32_t offset = tmplt->fields[idx].offset;
+
+        for (item_end = item + plan->walk_cnt; item < item_end; ++item) {
+            for (; idx < item->idx; ++idx) {
+                const uint16_t size = proj_field_size(rec_start, &offset,
+                    tmplt->fields[idx].length);
+                offset += size;
+            }
+
+            struct fds_drec_field *field = &fields[item->slot];
+            uint32_t data_offset = offset;
+            field->size = proj_field_size(rec_start, &data_offset, item->length);
+            field->data = &rec_start[data_offset];
+            field->info = &tmplt->fields[item->idx];
+        }
+    }
+
+    // Missing fields
+    for (item_end = item + plan->missing_cnt; item < item_end; ++item) {
+        struct fds_drec_field *field = &fields[item->slot];
+        field->data = NULL;
+        field->size = 0;
+        field->info = NULL;
+    }
+
+    return plan->direct_cnt + plan->walk_cnt;
+}
+
+/**
+ * \brief Store a value of a field into a column
+ * \param[in] col   Column
+ * \param[in] row   Row index
+ * \param[in] field Extracted field (data is NULL if the field is missing)
+ */
+static inline void
+proj_col_store(const struct fds_proj_col *col, uint32_t row, const struct fds_drec_field *field)
+{
+    int ret_code = FDS_ERR_ARG;
+
+    switch (col->type) {
+    case FDS_PROJ_COL_UINT: {
+        uint64_t *value = &((uint64_t *) col->values)[row];
+        if (field->data != NULL) {
+            ret_code = fds_get_uint_be(field->data, field->size, value);
+        }
+        if (ret_code != FDS_OK) {
+            *value = 0;
+        }
+        }
+        break;
+    case FDS_PROJ_COL_INT: {
+        int64_t *value = &((int64_t *) col->values)[row];
+        if (field->data != NULL) {
+            ret_code = fds_get_int_be(field->data, field->size, value);
+        }
+        if (ret_code != FDS_OK) {
+            *value = 0;
+        }
+        }
+        break;
+    case FDS_PROJ_COL_FLOAT: {
+        double *value = &((double *) col->values)[row];
+        if (field->data != NULL) {
+            ret_code = fds_get_float_be(field->data, field->size, value);
+        }
+        if (ret_code != FDS_OK) {
+            *value = 0.0;
+        }
+        }
+        break;
+    case FDS_PROJ_COL_DATETIME: {
+        uint64_t *value = &((uint64_t *) col->values)[row];
+        if (field->data != NULL && field->info->def != NULL) {
+            ret_code = fds_get_datetime_lp_be(field->data, field->size,
+                field->info->def->data_type, value);
+        }
+        if (ret_code != FDS_OK) {
+            *value = 0;
+        }
+        }
+        break;
+    default:
+        assert(false && "Unsupported type of a column!");
+        return;
+    }
+
+    if (ret_code == FDS_OK) {
+        col->valid[row / 8U] |= (uint8_t) (1U << (row % 8U));
+    }
+}
+
+/**
+ * \brief Convert values of a field with known offset and length of multiple records at once
+ * \param[in] col      Column
+ * \param[in] row      Row index of the first record
+ * \param[in] item     Extraction item of the field
+ * \param[in] bases    Array of records
+ * \param[in] rec_cnt  Number of records
+ * \return #FDS_OK on success (validity bits are set).
+ * \return #FDS_ERR_ARG if the values cannot be converted in bulk.
+ */
+static inline int
+proj_col_store_bulk(const struct fds_proj_col *col, uint32_t row, const struct proj_item *item,
+    const uint8_t *const *bases, uint32_t rec_cnt)
+{
+    int ret_code;
+
+    switch (col->type) {
+    case FDS_PROJ_COL_UINT:
+        ret_code = fds_get_uint_be_bulk(bases, item->offset, item->length,
+            &((uint64_t *) col->values)[row], rec_cnt);
+        break;
+    case FDS_PROJ_COL_INT:
+        ret_code = fds_get_int_be_bulk(bases, item->offset, item->length,
+            &((int64_t *) col->values)[row], rec_cnt);
+        break;
+    case FDS_PROJ_COL_FLOAT:
+        ret_code = fds_get_float_be_bulk(bases, item->offset, item->length,
+            &((double *) col->values)[row], rec_cnt);
+        break;
+    default:
+        // Timestamps depend on the definition of the field
+        ret_code = FDS_ERR_ARG;
+        break;
+    }
+
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+
+    for (uint32_t i = row; i < row + rec_cnt; ++i) {
+        col->valid[i / 8U] |= (uint8_t) (1U << (i % 8U));
+    }
+    return FDS_OK;
+}
+
+int
+fds_proj_columns(fds_proj_t *proj, struct fds_dset_iter *it, const struct fds_proj_col *cols,
+    uint32_t rows_max, uint32_t *rows_cnt)
+{
+    assert(rows_max > 0);
+    const uint16_t elem_cnt = proj->elem_cnt;
+    struct fds_dset_rec recs[PROJ_BATCH_SIZE];
+    const uint8_t *bases[PROJ_BATCH_SIZE];
+    uint32_t rows = 0;
+    int ret_code = FDS_OK;
+
+    *rows_cnt = 0;
+    const struct fds_template *tmplt = it->_private.tmplt;
+    const struct proj_plan *plan = proj_plan_get(proj, tmplt);
+    if (!plan) {
+        return FDS_ERR_NOMEM;
+    }
+
+    // Clear validity bitmaps
+    for (uint16_t i = 0; i < elem_cnt; ++i) {
+        memset(cols[i].valid, 0, (rows_max + 7U) / 8U);
+    }
+
+    struct fds_drec rec;
+    rec.tmplt = tmplt;
+    rec.snap = NULL;
+
+    while (rows < rows_max) {
+        uint32_t batch_max = rows_max - rows;
+        uint32_t batch_cnt;
+        if (batch_max > PROJ_BATCH_SIZE) {
+            batch_max = PROJ_BATCH_SIZE;
+        }
+
+        // Records before a malformed one are also processed
+        ret_code = fds_dset_iter_batch(it, recs, batch_max, &batch_cnt);
+        for (uint32_t i = 0; i < batch_cnt; ++i) {
+            bases[i] = recs[i].rec;
+        }
+
+        // Fields with known offset and length are converted for all records at once
+        uint16_t bulk_cnt = 0;
+        memset(proj->col_bulk, 0, elem_cnt * sizeof(*proj->col_bulk));
+        for (uint16_t i = 0; i < plan->direct_cnt && batch_cnt > 0; ++i) {
+            const struct proj_item *item = &plan->items[i];
+            if (item->length == FDS_IPFIX_VAR_IE_LEN) {
+                continue;
+            }
+
+            if (proj_col_store_bulk(&cols[item->slot], rows, item, bases, batch_cnt) == FDS_OK) {
+                proj->col_bulk[item->slot] = true;
+                bulk_cnt++;
+            }
+        }
+
+        // Other fields are processed record by record
+        for (uint32_t i = 0; i < batch_cnt && bulk_cnt < elem_cnt; ++i) {
+            rec.data = recs[i].rec;
+            rec.size = recs[i].size;
+            fds_proj_extract(proj, &rec, proj->fields); // The plan is already in the cache
+
+            for (uint16_t c = 0; c < elem_cnt; ++c) {
+                if (!proj->col_bulk[c]) {
+                    proj_col_store(&cols[c], rows + i, &proj->fields[c]);
+                }
+            }
+        }
+
+        rows += batch_cnt;
+        if (ret_code != FDS_OK) {
+            break;
+        }
+    }
+
+    *rows_cnt = rows;
+    if (ret_code == FDS_ERR_FORMAT) {
+        return FDS_ERR_FORMAT;
+    }
+
+    return (rows > 0) ? FDS_OK : FDS_EOC;
+}
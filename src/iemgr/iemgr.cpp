@@ -56,6 +56,7 @@
 #include "iemgr_common.h"
 #include "iemgr_scope.h"
 #include "iemgr_element.h"
+#include "iemgr_image.h"
 
 fds_iemgr_t *
 fds_iemgr_create()
@@ -79,7 +80,8 @@ fds_iemgr_copy(const fds_iemgr_t *mgr)
 
     fds_iemgr_t* res;
     try {
-        res = mgr_copy(mgr);
+        // Immutable content is shared instead of copied
+        res = (mgr->image != nullptr) ? image_share(mgr) : mgr_copy(mgr);
     } catch (...) {
         // Allocation error
         return nullptr;
@@ -95,10 +97,10 @@ fds_iemgr_copy(const fds_iemgr_t *mgr)
 void
 mtime_remove(fds_iemgr_t *mgr)
 {
-    for (const auto& mtime: mgr->mtime) {
+    for (const auto& mtime: mgr->tables->mtime) {
         free(mtime.first);
     }
-    mgr->mtime.clear();
+    mgr->tables->mtime.clear();
 }
 
 /**
@@ -122,7 +124,7 @@ mtime_save(fds_iemgr_t* mgr, const string& path)
         return false;
     }
 
-    mgr->mtime.emplace_back(file_path, sb.st_mtim);
+    mgr->tables->mtime.emplace_back(file_path, sb.st_mtim);
     return true;
 }
 
@@ -131,16 +133,167 @@ fds_iemgr_clear(fds_iemgr_t *mgr)
 {
     assert(mgr != nullptr);
 
-    for (const auto &scope: mgr->pens) {
-        scope_remove(scope.second);
+    if (mgr->image != nullptr) {
+        // Shared scopes, elements and tables are released at once by the last manager
+        image_release(mgr);
+        return;
     }
 
-    mgr->pens.clear();
-    mgr->prefixes.clear();
+    mgr_index_invalidate(mgr);
+    for (const auto &scope: mgr->tables->pens) {
+        scope_remove(scope.second);
+    }
 
+    mgr->tables->pens.clear();
+    mgr->tables->prefixes.clear();
     mtime_remove(mgr);
 }
 
+int
+fds_iemgr_freeze(fds_iemgr_t *mgr)
+{
+    assert(mgr != nullptr);
+
+    try {
+        image_freeze(mgr);
+    } catch (...) {
+        mgr->err_msg = "Error while allocating memory for shared elements.";
+        return FDS_ERR_NOMEM;
+    }
+
+    return FDS_OK;
+}
+
+int
+fds_iemgr_rebase(fds_iemgr_t *mgr, const fds_iemgr_t *base)
+{
+    assert(mgr != nullptr);
+    assert(base != nullptr);
+
+    if (base->image == nullptr) {
+        mgr->err_msg = "The base manager is not immutable.";
+        return FDS_ERR_ARG;
+    }
+
+    try {
+        image_freeze(mgr);
+        image_rebase(mgr, base);
+    } catch (...) {
+        mgr->err_msg = "Error while allocating memory for shared elements.";
+        return FDS_ERR_NOMEM;
+    }
+
+    return FDS_OK;
+}
+
+/**
+ * \brief Add elements that differ between two scopes with the same PEN to a diff
+ *
+ * An element differs if it is defined only in one of the scopes or if both scopes have
+ * different definitions (i.e. not the same object) of the element.
+ * \param[in,out] diff    Diff
+ * \param[in]     pen     PEN of the scopes
+ * \param[in]     old_ids Elements of the old scope (sorted by ID)
+ * \param[in]     new_ids Elements of the new scope (sorted by ID)
+ */
+static void
+diff_scope(fds_iemgr_diff& diff, uint32_t pen,
+    const vector<pair<uint16_t, fds_iemgr_elem *> >& old_ids,
+    const vector<pair<uint16_t, fds_iemgr_elem *> >& new_ids)
+{
+    const size_t keys_cnt = diff.keys.size();
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < old_ids.size() || j < new_ids.size()) {
+        if (j == new_ids.size() || (i < old_ids.size() && old_ids[i].first < new_ids[j].first)) {
+            // Removed element
+            diff.keys.push_back(index_key(pen, old_ids[i++].first));
+        } else if (i == old_ids.size() || new_ids[j].first < old_ids[i].first) {
+            // Added element
+            diff.keys.push_back(index_key(pen, new_ids[j++].first));
+        } else {
+            if (old_ids[i].second != new_ids[j].second) {
+                diff.keys.push_back(index_key(pen, old_ids[i].first));
+            }
+            ++i;
+            ++j;
+        }
+    }
+
+    if (diff.keys.size() != keys_cnt) {
+        diff.pens.push_back(pen);
+    }
+}
+
+fds_iemgr_diff_t *
+fds_iemgr_diff_create(const fds_iemgr_t *old_mgr, const fds_iemgr_t *new_mgr)
+{
+    static const vector<pair<uint32_t, fds_iemgr_scope_inter *> > pens_empty;
+    static const vector<pair<uint16_t, fds_iemgr_elem *> > ids_empty;
+    const auto& old_pens = (old_mgr != nullptr) ? old_mgr->tables->pens : pens_empty;
+    const auto& new_pens = (new_mgr != nullptr) ? new_mgr->tables->pens : pens_empty;
+
+    std::unique_ptr<fds_iemgr_diff_t> diff;
+    try {
+        diff.reset(new fds_iemgr_diff_t);
+
+        // Scopes are sorted by PEN, therefore, the keys of the diff are sorted too
+        size_t i = 0;
+        size_t j = 0;
+        while (i < old_pens.size() || j < new_pens.size()) {
+            if (j == new_pens.size() || (i < old_pens.size()
+                    && old_pens[i].first < new_pens[j].first)) {
+                diff_scope(*diff, old_pens[i].first, old_pens[i].second->ids, ids_empty);
+                ++i;
+            } else if (i == old_pens.size() || new_pens[j].first < old_pens[i].first) {
+                diff_scope(*diff, new_pens[j].first, ids_empty, new_pens[j].second->ids);
+                ++j;
+            } else {
+                // Shared scopes (see fds_iemgr_rebase()) are not compared at all
+                if (old_pens[i].second != new_pens[j].second) {
+                    diff_scope(*diff, old_pens[i].first, old_pens[i].second->ids,
+                        new_pens[j].second->ids);
+                }
+                ++i;
+                ++j;
+            }
+        }
+    } catch (...) {
+        // Memory allocation error
+        return nullptr;
+    }
+
+    return diff.release();
+}
+
+void
+fds_iemgr_diff_destroy(fds_iemgr_diff_t *diff)
+{
+    delete diff;
+}
+
+size_t
+fds_iemgr_diff_cnt(const fds_iemgr_diff_t *diff)
+{
+    assert(diff != nullptr);
+    return diff->keys.size();
+}
+
+bool
+fds_iemgr_diff_find(const fds_iemgr_diff_t *diff, uint32_t pen, uint16_t id)
+{
+    assert(diff != nullptr);
+    return std::binary_search(diff->keys.begin(), diff->keys.end(), index_key(pen, id));
+}
+
+bool
+fds_iemgr_diff_find_pen(const fds_iemgr_diff_t *diff, uint32_t pen)
+{
+    assert(diff != nullptr);
+    return std::binary_search(diff->pens.begin(), diff->pens.end(), pen);
+}
+
 void
 fds_iemgr_destroy(fds_iemgr_t *mgr)
 {
@@ -154,7 +307,7 @@ fds_iemgr_compare_timestamps(fds_iemgr *mgr)
     assert(mgr != nullptr);
 
     struct stat sb{};
-    for (const auto& mtime: mgr->mtime) {
+    for (const auto& mtime: mgr->tables->mtime) {
         if (stat(mtime.first, &sb) != 0) {
             mgr->err_msg = "Could not read information about the file '" +string(mtime.first)+ "'";
             return FDS_ERR_FORMAT;
@@ -365,21 +518,22 @@ mgr_check(fds_iemgr_t *mgr)
 {
     mgr_sort(mgr);
 
-    const auto pen_pair_it = find_pair(mgr->pens);
-    if (pen_pair_it != mgr->pens.end()) {
+    const auto pen_pair_it = find_pair(mgr->tables->pens);
+    if (pen_pair_it != mgr->tables->pens.end()) {
         mgr->err_msg = "PEN of a scope with PEN '"
             + to_string(pen_pair_it.base()->second->head.pen)
             + "' is defined multiple times.";
         return FDS_ERR_FORMAT;
     }
 
-    const auto pref_pair_it = find_pair(mgr->prefixes);
-    if (pref_pair_it != mgr->prefixes.end()) {
+    const auto pref_pair_it = find_pair(mgr->tables->prefixes);
+    if (pref_pair_it != mgr->tables->prefixes.end()) {
         mgr->err_msg = "Name '"+string(pref_pair_it.base()->second->head.name)
             + "' of a scope is defined multiple times.";
         return FDS_ERR_FORMAT;
     }
 
+    mgr_index_build(mgr);
     return FDS_OK;
 }
 
@@ -389,9 +543,10 @@ fds_iemgr_read_dir(fds_iemgr_t *mgr, const char *path)
     assert(mgr  != nullptr);
     assert(path != nullptr);
 
-    if (!mgr->pens.empty()) {
+    if (!mgr->tables->pens.empty() || mgr->image != nullptr) {
         fds_iemgr_clear(mgr);
     }
+    mgr_index_invalidate(mgr);
 
     try {
         if (!dirs_read(mgr, path)) {
@@ -412,6 +567,11 @@ fds_iemgr_read_file(fds_iemgr_t *mgr, const char *path, bool overwrite)
     assert(mgr  != nullptr);
     assert(path != nullptr);
 
+    if (!mgr_thaw(mgr)) {
+        return FDS_ERR_NOMEM;
+    }
+
+    mgr_index_invalidate(mgr);
     mgr->can_overwrite_elem = overwrite;
     mgr->overwrite_scope.first = true;
     try {
@@ -432,12 +592,91 @@ fds_iemgr_read_file(fds_iemgr_t *mgr, const char *path, bool overwrite)
     return mgr_check(mgr);
 }
 
+int
+fds_iemgr_save_bin(fds_iemgr_t *mgr, const char *path)
+{
+    assert(mgr  != nullptr);
+    assert(path != nullptr);
+
+    try {
+        return image_save(mgr, path, {});
+    } catch (...) {
+        mgr->err_msg = "Error while allocating memory for the image.";
+        return FDS_ERR_NOMEM;
+    }
+}
+
+int
+fds_iemgr_read_bin(fds_iemgr_t *mgr, const char *path)
+{
+    assert(mgr  != nullptr);
+    assert(path != nullptr);
+
+    try {
+        return image_load(mgr, path, {});
+    } catch (...) {
+        mgr->err_msg = "Error while allocating memory for the image.";
+        return FDS_ERR_NOMEM;
+    }
+}
+
+int
+fds_iemgr_read_dir_cached(fds_iemgr_t *mgr, const char *path, const char *image)
+{
+    assert(mgr   != nullptr);
+    assert(path  != nullptr);
+    assert(image != nullptr);
+
+    // Missing or outdated image is not an error
+    const string err_msg = mgr->err_msg;
+    vector<image_dir_fp> dirs;
+    try {
+        // Fingerprints of directories must be taken before the files are read
+        dirs = image_dirs(path);
+        if (image_load(mgr, image, dirs) == FDS_OK) {
+            return FDS_OK;
+        }
+    } catch (...) {
+        // Fall back to XML files
+    }
+    mgr->err_msg = err_msg;
+
+    const int ret = fds_iemgr_read_dir(mgr, path);
+    if (ret != FDS_OK) {
+        return ret;
+    }
+
+    // Failure to update the image (e.g. a read-only location) is not an error either
+    try {
+        image_save(mgr, image, dirs);
+    } catch (...) {
+        // Ignore
+    }
+    mgr->err_msg = err_msg;
+    return FDS_OK;
+}
+
 const fds_iemgr_elem *
 fds_iemgr_elem_find_id(const fds_iemgr_t *mgr, uint32_t pen, uint16_t id)
 {
     assert(mgr != nullptr);
 
-    auto scope = binary_find(mgr->pens, pen);
+    const fds_iemgr_index& index = mgr->tables->index;
+    if (index.valid) {
+        if (pen == 0) {
+            return (id < index.iana.size()) ? index.iana[id] : nullptr;
+        }
+
+        const uint64_t key = index_key(pen, id);
+        for (size_t pos = index_hash(index, key); ; pos = (pos + 1) & index.ent_mask) {
+            const fds_iemgr_index_rec& rec = index.ent[pos];
+            if (rec.elem == nullptr || rec.key == key) {
+                return rec.elem;
+            }
+        }
+    }
+
+    auto scope = binary_find(mgr->tables->pens, pen);
     if (scope == nullptr) {
         return nullptr;
     }
@@ -450,15 +689,59 @@ fds_iemgr_elem_find_id(const fds_iemgr_t *mgr, uint32_t pen, uint16_t id)
     return elem;
 }
 
-const struct fds_iemgr_elem *
-fds_iemgr_elem_find_name(const fds_iemgr_t *mgr, const char *name)
+/**
+ * \brief Find an element with a given name in lookup tables of a manager
+ * \param[in] index Valid lookup tables
+ * \param[in] name  Name (not NULL terminated)
+ * \param[in] len   Length of the name
+ * \param[in] hash  Hash of the name (see name_hash())
+ * \return Element if exists, otherwise nullptr
+ */
+static const fds_iemgr_elem *
+index_name_find(const fds_iemgr_index& index, const char *name, size_t len, uint64_t hash)
 {
-    assert(mgr  != nullptr);
-    assert(name != nullptr);
+    for (size_t pos = index_name_pos(index, hash); ; pos = (pos + 1) & index.names_mask) {
+        const fds_iemgr_index_name& rec = index.names[pos];
+        if (rec.elem == nullptr) {
+            return nullptr;
+        }
+        if (rec.hash == hash && index_name_eq(rec, name, len)) {
+            return rec.elem;
+        }
+    }
+}
+
+/**
+ * \brief Check that a name contains at most one ':'
+ * \param[in] name Name (not NULL terminated)
+ * \param[in] len  Length of the name
+ * \return True or false
+ */
+static bool
+name_check(const char *name, size_t len)
+{
+    const char *colon = static_cast<const char *>(memchr(name, ':', len));
+    if (colon == nullptr) {
+        return true;
+    }
+
+    colon++;
+    return memchr(colon, ':', len - (colon - name)) == nullptr;
+}
 
+/**
+ * \brief Find an element with a given name in sorted vectors of scopes and elements
+ * \param[in] mgr  Manager
+ * \param[in] name Name (not NULL terminated)
+ * \param[in] len  Length of the name
+ * \return Element if exists, otherwise nullptr
+ */
+static const fds_iemgr_elem *
+vector_name_find(const fds_iemgr_t *mgr, const char *name, size_t len)
+{
     pair<string, string> split;
     try {
-        if (!split_name(name, split)) {
+        if (!split_name(string(name, len), split)) {
             // Error: the element name cannot contain the second ":"
             return nullptr;
         }
@@ -468,7 +751,7 @@ fds_iemgr_elem_find_name(const fds_iemgr_t *mgr, const char *name)
     }
 
     // FIXME: the scope and IE can be defined as numbers
-    auto scope = binary_find(mgr->prefixes, split.first);
+    auto scope = binary_find(mgr->tables->prefixes, split.first);
     if (scope == nullptr) {
         return nullptr;
     }
@@ -481,6 +764,79 @@ fds_iemgr_elem_find_name(const fds_iemgr_t *mgr, const char *name)
     return elem;
 }
 
+const struct fds_iemgr_elem *
+fds_iemgr_elem_find_name(const fds_iemgr_t *mgr, const char *name)
+{
+    assert(mgr  != nullptr);
+    assert(name != nullptr);
+
+    return fds_iemgr_elem_find_name_len(mgr, name, strlen(name));
+}
+
+const struct fds_iemgr_elem *
+fds_iemgr_elem_find_name_len(const fds_iemgr_t *mgr, const char *name, size_t len)
+{
+    assert(mgr  != nullptr);
+    assert(name != nullptr || len == 0);
+
+    const fds_iemgr_index& index = mgr->tables->index;
+    if (!index.valid) {
+        return vector_name_find(mgr, name, len);
+    }
+
+    if (!name_check(name, len)) {
+        // Error: the element name cannot contain the second ":"
+        return nullptr;
+    }
+
+    return index_name_find(index, name, len, name_hash(NAME_HASH_INIT, name, len));
+}
+
+size_t
+fds_iemgr_elem_find_names(const fds_iemgr_t *mgr, const char * const *names, size_t cnt,
+    const struct fds_iemgr_elem **elems)
+{
+    assert(mgr != nullptr);
+
+    // Names are processed in groups, hashes of the whole group are computed first
+    constexpr size_t group_size = 16;
+    const fds_iemgr_index& index = mgr->tables->index;
+    size_t found = 0;
+
+    for (size_t start = 0; start < cnt; start += group_size) {
+        const size_t end = std::min(cnt, start + group_size);
+        if (!index.valid) {
+            for (size_t i = start; i < end; ++i) {
+                elems[i] = vector_name_find(mgr, names[i], strlen(names[i]));
+                found += (elems[i] != nullptr);
+            }
+            continue;
+        }
+
+        size_t lens[group_size];
+        uint64_t hashes[group_size];
+        for (size_t i = start; i < end; ++i) {
+            const size_t idx = i - start;
+            lens[idx] = strlen(names[i]);
+            hashes[idx] = name_hash(NAME_HASH_INIT, names[i], lens[idx]);
+            __builtin_prefetch(&index.names[index_name_pos(index, hashes[idx])]);
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            const size_t idx = i - start;
+            if (!name_check(names[i], lens[idx])) {
+                elems[i] = nullptr;
+                continue;
+            }
+
+            elems[i] = index_name_find(index, names[i], lens[idx], hashes[idx]);
+            found += (elems[i] != nullptr);
+        }
+    }
+
+    return found;
+}
+
 int
 fds_iemgr_elem_add(fds_iemgr_t *mgr, const struct fds_iemgr_elem *elem, uint32_t pen,
     bool overwrite)
@@ -492,14 +848,19 @@ fds_iemgr_elem_add(fds_iemgr_t *mgr, const struct fds_iemgr_elem *elem, uint32_t
         return FDS_ERR_FORMAT;
     }
 
+    if (!mgr_thaw(mgr)) {
+        return FDS_ERR_NOMEM;
+    }
+
+    mgr_index_invalidate(mgr);
     mgr->can_overwrite_elem = overwrite;
-    auto scope = find_second(mgr->pens, pen);
+    auto scope = find_second(mgr->tables->pens, pen);
     try {
         if (scope == nullptr) {
             scope = scope_create().release();
             scope->head.pen = pen;
             scope->head.biflow_mode = FDS_BF_INDIVIDUAL;
-            mgr->pens.emplace_back(scope->head.pen, scope);
+            mgr->tables->pens.emplace_back(scope->head.pen, scope);
             mgr_sort(mgr);
         }
 
@@ -513,6 +874,7 @@ fds_iemgr_elem_add(fds_iemgr_t *mgr, const struct fds_iemgr_elem *elem, uint32_t
     }
 
     scope_sort(scope);
+    mgr_index_build(mgr);
     return FDS_OK;
 }
 
@@ -522,7 +884,11 @@ fds_iemgr_elem_add_reverse(fds_iemgr_t *mgr, uint32_t pen, uint16_t id, uint16_t
 {
     assert(mgr != nullptr);
 
-    auto scope = binary_find(mgr->pens, pen);
+    if (!mgr_thaw(mgr)) {
+        return FDS_ERR_NOMEM;
+    }
+
+    auto scope = binary_find(mgr->tables->pens, pen);
     if (scope == nullptr) {
         mgr->err_msg = "Scope with PEN '" + to_string(pen) + "' cannot be found.";
         return FDS_ERR_NOTFOUND;
@@ -543,6 +909,7 @@ fds_iemgr_elem_add_reverse(fds_iemgr_t *mgr, uint32_t pen, uint16_t id, uint16_t
         return FDS_ERR_FORMAT;
     }
 
+    mgr_index_invalidate(mgr);
     fds_iemgr_elem* rev = nullptr;
     try {
         rev = element_add_reverse(mgr, scope, elem, new_id);
@@ -555,6 +922,7 @@ fds_iemgr_elem_add_reverse(fds_iemgr_t *mgr, uint32_t pen, uint16_t id, uint16_t
     }
 
     scope_sort(scope);
+    mgr_index_build(mgr);
     return FDS_OK;
 }
 
@@ -563,9 +931,15 @@ fds_iemgr_elem_remove(fds_iemgr_t *mgr, uint32_t pen, uint16_t id)
 {
     assert(mgr != nullptr);
 
+    if (!mgr_thaw(mgr)) {
+        return FDS_ERR_NOMEM;
+    }
+
+    mgr_index_invalidate(mgr);
     try {
         const int ret = element_destroy(mgr, pen, id);
         if (ret != FDS_OK) {
+            mgr_index_build(mgr);
             return ret;
         }
     } catch (...) {
@@ -573,6 +947,7 @@ fds_iemgr_elem_remove(fds_iemgr_t *mgr, uint32_t pen, uint16_t id)
         return FDS_ERR_NOMEM;
     }
 
+    mgr_index_build(mgr);
     return FDS_OK;
 }
 
@@ -581,7 +956,7 @@ fds_iemgr_scope_find_pen(const fds_iemgr_t *mgr, uint32_t pen)
 {
     assert(mgr != nullptr);
 
-    const auto res = binary_find(mgr->pens, pen);
+    const auto res = binary_find(mgr->tables->pens, pen);
     if (res == nullptr) {
         return nullptr;
     }
@@ -594,7 +969,7 @@ fds_iemgr_scope_find_name(const fds_iemgr_t *mgr, const char *name)
     assert(mgr != nullptr);
     assert(name != nullptr);
 
-    const auto res = binary_find(mgr->prefixes, string(name));
+    const auto res = binary_find(mgr->tables->prefixes, string(name));
     if (res == nullptr) {
         return nullptr;
     }
@@ -220,14 +220,14 @@ bool
 mgr_save_reverse(fds_iemgr_t* mgr)
 {
     fds_iemgr_scope_inter* tmp;
-    auto vec = mgr->pens;
+    auto vec = mgr->tables->pens;
 
     for (const auto& scope: vec) {
         if (scope.second->head.biflow_mode == FDS_BF_PEN) {
             tmp = scope_create_reverse(scope.second);
             scope_sort(tmp);
-            mgr->pens.emplace_back(tmp->head.pen, tmp);
-            mgr->prefixes.emplace_back(tmp->head.name, tmp);
+            mgr->tables->pens.emplace_back(tmp->head.pen, tmp);
+            mgr->tables->prefixes.emplace_back(tmp->head.name, tmp);
         }
         else {
             if (!scope_save_reverse_elem(scope.second)) {
@@ -250,13 +250,170 @@ mgr_remove_temp(fds_iemgr_t* mgr)
 void
 mgr_sort(fds_iemgr_t* mgr)
 {
-    sort_vec(mgr->pens);
-    sort_vec(mgr->prefixes);
+    sort_vec(mgr->tables->pens);
+    sort_vec(mgr->tables->prefixes);
 
     const auto func_pred = [](const pair<string, timespec>& lhs,
                               const pair<string, timespec>& rhs)
     { return lhs.first < rhs.first; };
-    sort(mgr->mtime.begin(), mgr->mtime.end(), func_pred);
+    sort(mgr->tables->mtime.begin(), mgr->tables->mtime.end(), func_pred);
+}
+
+void
+mgr_index_invalidate(fds_iemgr_t* mgr)
+{
+    fds_iemgr_index& index = mgr->tables->index;
+    index.valid = false;
+    index.iana.clear();
+    index.ent.clear();
+    index.ent_mask = 0;
+    index.names.clear();
+    index.names_mask = 0;
+}
+
+/**
+ * \brief Get the smallest size of an open addressing hash table for a number of records
+ *
+ * The load factor of the table is at most 50%.
+ * \param[in] cnt Number of records
+ * \return Size (a power of two)
+ */
+static size_t
+index_table_size(size_t cnt)
+{
+    size_t size = 16;
+    while (size < 2 * cnt) {
+        size *= 2;
+    }
+    return size;
+}
+
+/**
+ * \brief Insert an element into the hash table of element names
+ * \param[in,out] index  Lookup tables
+ * \param[in]     prefix Scope name (nullptr for a name without scope)
+ * \param[in]     name   Element name
+ * \param[in]     len    Length of the element name
+ * \param[in]     elem   Element
+ */
+static void
+index_name_insert(fds_iemgr_index& index, const string *prefix, const char *name, size_t len,
+    const fds_iemgr_elem *elem)
+{
+    fds_iemgr_index_name rec{NAME_HASH_INIT, elem, nullptr, name, 0, uint32_t(len)};
+    if (prefix != nullptr) {
+        rec.prefix = prefix->c_str();
+        rec.prefix_len = uint32_t(prefix->size());
+        rec.hash = name_hash(rec.hash, rec.prefix, rec.prefix_len);
+        rec.hash = name_hash(rec.hash, ":", 1);
+    }
+    rec.hash = name_hash(rec.hash, rec.name, rec.name_len);
+
+    size_t pos = index_name_pos(index, rec.hash);
+    while (index.names[pos].elem != nullptr) {
+        pos = (pos + 1) & index.names_mask;
+    }
+    index.names[pos] = rec;
+}
+
+/**
+ * \brief Fill lookup tables of a manager
+ * \param[in,out] index    Lookup tables
+ * \param[in]     pens     Scopes of the manager sorted by PEN
+ * \param[in]     prefixes Scopes of the manager sorted by name
+ * \param[in]     by_ids   Take names from elements sorted by ID (vectors of elements sorted by
+ *   name are not filled in managers loaded from a binary image)
+ * \throw std::bad_alloc on memory allocation error
+ */
+static void
+index_fill(fds_iemgr_index& index, const vector<pair<uint32_t, fds_iemgr_scope_inter *> >& pens,
+    const vector<pair<string, fds_iemgr_scope_inter *> >& prefixes, bool by_ids)
+{
+    size_t ent_cnt = 0;
+    for (const auto& scope: pens) {
+        if (scope.first == 0) {
+            // Elements are sorted by ID -> the last one has the highest ID
+            const auto& ids = scope.second->ids;
+            index.iana.assign(ids.empty() ? 0 : ids.back().first + 1U, nullptr);
+            for (const auto& elem: ids) {
+                index.iana[elem.first] = elem.second;
+            }
+            continue;
+        }
+
+        ent_cnt += scope.second->ids.size();
+    }
+
+    const size_t ent_size = index_table_size(ent_cnt);
+    index.ent.assign(ent_size, fds_iemgr_index_rec{0, nullptr});
+    index.ent_mask = ent_size - 1;
+    for (const auto& scope: pens) {
+        if (scope.first == 0) {
+            continue;
+        }
+
+        for (const auto& elem: scope.second->ids) {
+            const uint64_t key = index_key(scope.first, elem.first);
+            size_t pos = index_hash(index, key);
+            while (index.ent[pos].elem != nullptr) {
+                pos = (pos + 1) & index.ent_mask;
+            }
+            index.ent[pos] = fds_iemgr_index_rec{key, elem.second};
+        }
+    }
+
+    // Elements by full names and IANA elements also by names without the scope
+    size_t names_cnt = 0;
+    for (const auto& scope: prefixes) {
+        const size_t cnt = by_ids ? scope.second->ids.size() : scope.second->names.size();
+        names_cnt += (scope.first == "iana") ? 2 * cnt : cnt;
+    }
+
+    const size_t names_size = index_table_size(names_cnt);
+    index.names.assign(names_size, fds_iemgr_index_name{0, nullptr, nullptr, nullptr, 0, 0});
+    index.names_mask = names_size - 1;
+    for (const auto& scope: prefixes) {
+        const bool is_iana = (scope.first == "iana");
+        if (by_ids) {
+            for (const auto& elem: scope.second->ids) {
+                const char *name = elem.second->name;
+                if (name == nullptr) {
+                    continue;
+                }
+
+                index_name_insert(index, &scope.first, name, strlen(name), elem.second);
+                if (is_iana) {
+                    index_name_insert(index, nullptr, name, strlen(name), elem.second);
+                }
+            }
+            continue;
+        }
+
+        for (const auto& name: scope.second->names) {
+            const char *str = name.first.c_str();
+            index_name_insert(index, &scope.first, str, name.first.size(), name.second);
+            if (is_iana) {
+                index_name_insert(index, nullptr, str, name.first.size(), name.second);
+            }
+        }
+    }
+}
+
+void
+mgr_index_build(fds_iemgr_t* mgr)
+{
+    mgr_index_invalidate(mgr);
+
+    try {
+        const fds_iemgr_tables& tables = *mgr->tables;
+        index_fill(mgr->tables->index, tables.pens, tables.prefixes, mgr->image != nullptr);
+    } catch (...) {
+        // Memory allocation error -> use sorted vectors instead
+        mgr_index_invalidate(mgr);
+        return;
+    }
+
+    mgr->tables->index.valid = true;
 }
 
 fds_iemgr_t*
@@ -268,23 +425,26 @@ mgr_copy(const fds_iemgr_t* mgr)
     }
 
     fds_iemgr_scope_inter* scope;
-    for (const auto& tmp: mgr->pens) {
+    for (const auto& tmp: mgr->tables->pens) {
         if (tmp.second->is_reverse) {
             continue;
         }
 
         scope = scope_copy(tmp.second);
 
-        res->pens.emplace_back(scope->head.pen, scope);
-        res->prefixes.emplace_back(scope->head.name, scope);
+        res->tables->pens.emplace_back(scope->head.pen, scope);
+        if (scope->head.name != nullptr) {
+            // Scopes created by fds_iemgr_elem_add() don't have a name
+            res->tables->prefixes.emplace_back(scope->head.name, scope);
+        }
     }
 
-    for (const auto& mtime: mgr->mtime) {
+    for (const auto& mtime: mgr->tables->mtime) {
         char *path = strdup(mtime.first);
         if (path == nullptr) {
             return nullptr;
         }
-        res->mtime.emplace_back(path, mtime.second);
+        res->tables->mtime.emplace_back(path, mtime.second);
     }
 
     if (!mgr_save_reverse(res.get())) {
@@ -293,5 +453,6 @@ mgr_copy(const fds_iemgr_t* mgr)
 
     // New reverse scopes may have been added
     mgr_sort(res.get());
+    mgr_index_build(res.get());
     return res.release();
 }
@@ -86,10 +86,64 @@ struct fds_iemgr_scope_inter {
     bool                                        is_reverse; /**< True if scope is reverse */
 };
 
-/** Saved elements and sorted pointers by different values (PEN, PREFIX, etc.) */
-struct fds_iemgr {
-    /** Error message              */
-    string                         err_msg;
+/** Record of the hash table of enterprise-specific elements */
+struct fds_iemgr_index_rec {
+    uint64_t                   key;  /**< Combination of PEN and ID (see index_key())    */
+    const fds_iemgr_elem      *elem; /**< Element (nullptr if the record is unused)      */
+};
+
+/** Record of the hash table of elements by name */
+struct fds_iemgr_index_name {
+    uint64_t                   hash;       /**< Hash of the full name (see name_hash())       */
+    const fds_iemgr_elem      *elem;       /**< Element (nullptr if the record is unused)    */
+    const char                *prefix;     /**< Scope name (nullptr for a name without scope) */
+    const char                *name;       /**< Element name                                 */
+    uint32_t                   prefix_len; /**< Length of the scope name                     */
+    uint32_t                   name_len;   /**< Length of the element name                   */
+};
+
+/**
+ * \brief Direct lookup tables of elements by ID and name
+ *
+ * Tables are built after each modification of the manager (see mgr_index_build()). If the
+ * tables are not valid, the sorted vectors of scopes and elements are searched instead.
+ */
+struct fds_iemgr_index {
+    /** Tables are up-to-date                                                       */
+    bool                                valid = false;
+    /** Elements of the IANA scope (PEN 0) indexed by their IDs                     */
+    vector<const fds_iemgr_elem *>      iana;
+    /** Hash table of elements of other scopes (open addressing, linear probing)   */
+    vector<fds_iemgr_index_rec>         ent;
+    /** Mask of the hash table (its size is a power of two)                         */
+    size_t                              ent_mask = 0;
+    /**
+     * Hash table of elements by their full names (i.e. "scope:name") and names of IANA
+     * elements without the scope (open addressing, linear probing)
+     */
+    vector<fds_iemgr_index_name>        names;
+    /** Mask of the hash table of names (its size is a power of two)                */
+    size_t                              names_mask = 0;
+};
+
+/** Changes of definitions of elements between two managers */
+struct fds_iemgr_diff {
+    /** Changed elements (see index_key()), sorted from the lowest to the highest */
+    vector<uint64_t> keys;
+    /** PENs of the changed elements, sorted from the lowest to the highest       */
+    vector<uint32_t> pens;
+};
+
+/** Immutable content shared by managers (see iemgr_image.h) */
+struct iemgr_image;
+
+/**
+ * \brief Sorted pointers to scopes and lookup tables of a manager
+ *
+ * Immutable managers that refer to the same content share also these tables (see
+ * iemgr_image.h), therefore, they must not be modified until the manager is thawed.
+ */
+struct fds_iemgr_tables {
     /** First is absolute path to the file and second is modification time */
     vector<pair<char*, timespec> > mtime;
     /**
@@ -102,6 +156,24 @@ struct fds_iemgr {
      * Prefixes are sorted alphabetically.
      */
     vector<pair<string,   fds_iemgr_scope_inter *> > prefixes;
+    /** Direct lookup tables of elements by PEN and ID */
+    fds_iemgr_index                index;
+};
+
+/** Saved elements and sorted pointers by different values (PEN, PREFIX, etc.) */
+struct fds_iemgr {
+    /** Error message              */
+    string                         err_msg;
+    /** Tables of a modifiable manager (empty if the manager is immutable) */
+    fds_iemgr_tables               tables_own;
+    /** Tables in use, i.e. own tables or tables of the shared immutable content */
+    fds_iemgr_tables              *tables = &tables_own;
+    /**
+     * Shared immutable content that holds scopes, elements and tables of the manager (nullptr if
+     * the manager owns them). Such manager must be thawed before any modification (see
+     * mgr_thaw()).
+     */
+    iemgr_image                   *image = nullptr;
 
     /**
      * These are used only as a temporary values for overwriting.
@@ -113,6 +185,11 @@ struct fds_iemgr {
     bool                       can_overwrite_elem;
     /** First define if can overwrite scope and second are PENs of overwritten scopes */
     pair<bool, set<uint32_t> > overwrite_scope;
+
+    fds_iemgr() = default;
+    // The manager refers to its own tables
+    fds_iemgr(const fds_iemgr&) = delete;
+    fds_iemgr& operator=(const fds_iemgr&) = delete;
 };
 
 /** IDs of XML args */
@@ -396,6 +473,101 @@ mgr_remove_temp(fds_iemgr_t* mgr);
 void
 mgr_sort(fds_iemgr_t* mgr);
 
+/**
+ * \brief Get a key of an element in the hash table of enterprise-specific elements
+ * \param[in] pen Private Enterprise Number
+ * \param[in] id  ID of the element
+ * \return Key
+ */
+inline uint64_t
+index_key(uint32_t pen, uint16_t id)
+{
+    return (uint64_t(pen) << 16) | id;
+}
+
+/**
+ * \brief Get a position of a key in the hash table of enterprise-specific elements
+ * \param[in] index Lookup tables
+ * \param[in] key   Key (see index_key())
+ * \return Index of the first record to probe
+ */
+inline size_t
+index_hash(const fds_iemgr_index& index, uint64_t key)
+{
+    // Fibonacci hashing (the upper bits are the best mixed)
+    return size_t((key * 0x9E3779B97F4A7C15ULL) >> 32) & index.ent_mask;
+}
+
+/** Initial value of the hash of element names (64-bit FNV-1a offset basis) */
+#define NAME_HASH_INIT (0xCBF29CE484222325ULL)
+
+/**
+ * \brief Update a hash of an element name (64-bit FNV-1a)
+ * \param[in] hash Hash of the preceding part of the name
+ * \param[in] str  Next part of the name
+ * \param[in] len  Length of the part
+ * \return New hash
+ */
+inline uint64_t
+name_hash(uint64_t hash, const char *str, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (uint8_t) str[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * \brief Get a position of a hash in the hash table of element names
+ * \param[in] index Lookup tables
+ * \param[in] hash  Hash of a name (see name_hash())
+ * \return Index of the first record to probe
+ */
+inline size_t
+index_name_pos(const fds_iemgr_index& index, uint64_t hash)
+{
+    return size_t((hash * 0x9E3779B97F4A7C15ULL) >> 32) & index.names_mask;
+}
+
+/**
+ * \brief Compare a name with a full name of a record of the hash table of element names
+ * \param[in] rec  Record
+ * \param[in] name Name (not NULL terminated)
+ * \param[in] len  Length of the name
+ * \return True if the names are the same
+ */
+inline bool
+index_name_eq(const fds_iemgr_index_name& rec, const char *name, size_t len)
+{
+    if (rec.prefix == nullptr) {
+        return rec.name_len == len && memcmp(rec.name, name, len) == 0;
+    }
+
+    return rec.prefix_len + 1U + rec.name_len == len
+        && memcmp(rec.prefix, name, rec.prefix_len) == 0
+        && name[rec.prefix_len] == ':'
+        && memcmp(rec.name, name + rec.prefix_len + 1U, rec.name_len) == 0;
+}
+
+/**
+ * \brief Invalidate lookup tables of a manager
+ *
+ * Must be called before any modification of scopes or elements of the manager.
+ * \param[in,out] mgr Manager
+ */
+void
+mgr_index_invalidate(fds_iemgr_t* mgr);
+
+/**
+ * \brief Build lookup tables of a manager
+ *
+ * On memory allocation error, the tables stay invalid and lookups fall back to sorted vectors.
+ * \param[in,out] mgr Manager
+ */
+void
+mgr_index_build(fds_iemgr_t* mgr);
+
 /**
  * \brief Create copy of the manager. Don't copy temporary parts of the manager.
  * \param[in] mgr Manager
@@ -210,7 +210,7 @@ element_overwrite_reverse(fds_iemgr_t* mgr, fds_iemgr_scope_inter* scope, fds_ie
 {
     fds_iemgr_scope_inter* tmp_scope = scope;
     if (scope->head.biflow_mode == FDS_BF_PEN) {
-        tmp_scope = find_second(mgr->pens, scope->head.biflow_id);
+        tmp_scope = find_second(mgr->tables->pens, scope->head.biflow_id);
         if (tmp_scope == nullptr) {
             mgr->err_msg = "Reverse scope with PEN '" +to_string(scope->head.biflow_id)+ "' cannot be found";
             return false;
@@ -432,8 +432,8 @@ elements_remove_reverse(fds_iemgr_scope_inter* scope)
 int
 element_destroy(fds_iemgr_t *mgr, const uint32_t pen, const uint16_t id)
 {
-    const auto scope_pen_it = find_iterator(mgr->pens, pen);
-    if (scope_pen_it == mgr->pens.end()) {
+    const auto scope_pen_it = find_iterator(mgr->tables->pens, pen);
+    if (scope_pen_it == mgr->tables->pens.end()) {
         return FDS_ERR_NOTFOUND;
     }
     const auto scope = scope_pen_it.base()->second;
@@ -469,13 +469,13 @@ element_destroy(fds_iemgr_t *mgr, const uint32_t pen, const uint16_t id)
     }
 
     if (scope->ids.empty()) {
-        const auto scope_prefix_it = find_iterator(mgr->prefixes, string(scope->head.name));
-        if (scope_prefix_it == mgr->prefixes.end()) {
+        const auto scope_prefix_it = find_iterator(mgr->tables->prefixes, string(scope->head.name));
+        if (scope_prefix_it == mgr->tables->prefixes.end()) {
             return FDS_ERR_NOTFOUND;
         }
         scope_remove(scope);
-        mgr->pens.erase(scope_pen_it);
-        mgr->prefixes.erase(scope_prefix_it);
+        mgr->tables->pens.erase(scope_pen_it);
+        mgr->tables->prefixes.erase(scope_prefix_it);
         mgr_sort(mgr);
     }
     else {
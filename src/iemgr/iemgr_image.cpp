@@ -0,0 +1,832 @@
+/**
+ * \file   src/iemgr/iemgr_image.cpp
+ * \author agent <agent@local>
+ * \brief  Binary image of the iemgr (source file)
+ * \date   2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "iemgr_common.h"
+#include "iemgr_image.h"
+
+/** Identification of the image                                   */
+#define IMAGE_MAGIC      ("FDSIEMGR")
+/** Version of the image format                                   */
+#define IMAGE_VERSION    (1U)
+/** Byte order mark (images are not portable between architectures) */
+#define IMAGE_BYTE_ORDER (0x01020304U)
+/** Undefined reference (e.g. a scope without name)               */
+#define IMAGE_NONE       (UINT32_MAX)
+
+/**
+ * \brief Header of the image
+ *
+ * The header is followed by an array of fingerprints, an array of scopes (sorted by PEN), an
+ * array of elements (grouped by scopes and sorted by ID) and a table of NULL terminated strings.
+ * All references to strings are offsets in the table.
+ */
+struct image_hdr {
+    char     magic[8];   /**< Identification (see #IMAGE_MAGIC)                */
+    uint32_t version;    /**< Version of the format (see #IMAGE_VERSION)      */
+    uint32_t byte_order; /**< Byte order mark (see #IMAGE_BYTE_ORDER)         */
+    uint64_t size;       /**< Total size of the image                         */
+    uint32_t fp_cnt;     /**< Number of fingerprints                          */
+    uint32_t scope_cnt;  /**< Number of scopes                                */
+    uint32_t elem_cnt;   /**< Number of elements                              */
+    uint32_t str_size;   /**< Size of the table of strings                    */
+};
+
+/** Type of a fingerprint */
+enum image_fp_type {
+    IMAGE_FP_FILE = 0,   /**< Parsed file                                     */
+    IMAGE_FP_DIR  = 1    /**< Directory with files                            */
+};
+
+/** Fingerprint of a file or directory */
+struct image_fp {
+    uint32_t path;       /**< Absolute path                                   */
+    uint32_t type;       /**< Type (see #image_fp_type)                       */
+    int64_t  sec;        /**< Modification time (seconds)                     */
+    int64_t  nsec;       /**< Modification time (nanoseconds)                 */
+};
+
+/** Scope */
+struct image_scope {
+    uint32_t pen;        /**< Private Enterprise Number                       */
+    uint32_t name;       /**< Name (or #IMAGE_NONE)                           */
+    uint32_t biflow_mode;/**< Biflow mode                                     */
+    uint32_t biflow_id;  /**< Biflow ID                                       */
+    uint32_t is_reverse; /**< Reverse scope                                   */
+    uint32_t elem_first; /**< Index of the first element of the scope        */
+    uint32_t elem_cnt;   /**< Number of elements of the scope                 */
+    uint32_t reserved;   /**< Reserved (zero)                                 */
+};
+
+/** Element */
+struct image_elem {
+    uint32_t name;       /**< Name (or #IMAGE_NONE)                           */
+    uint32_t scope;      /**< Index of the scope of the element               */
+    uint32_t reverse;    /**< Index of the reverse element (or #IMAGE_NONE)   */
+    uint16_t id;         /**< ID                                              */
+    uint8_t  is_reverse; /**< Reverse element                                 */
+    uint8_t  reserved;   /**< Reserved (zero)                                 */
+    uint32_t data_type;  /**< Data type                                       */
+    uint32_t data_semantic; /**< Data semantic                                */
+    uint32_t data_unit;  /**< Data unit                                       */
+    uint32_t status;     /**< Status                                          */
+};
+
+static_assert(sizeof(image_hdr) == 40, "Unexpected size of the image header");
+static_assert(sizeof(image_fp) == 24, "Unexpected size of the image fingerprint");
+static_assert(sizeof(image_scope) == 32, "Unexpected size of the image scope");
+static_assert(sizeof(image_elem) == 32, "Unexpected size of the image element");
+
+/**
+ * \brief Immutable scopes and elements shared by one or more managers
+ *
+ * The content is either loaded from a binary image or taken over from a frozen manager.
+ */
+struct iemgr_image {
+    /** Number of managers that refer to the content                  */
+    std::atomic<unsigned int>        refcnt{1};
+    /** Mapped image                                                  */
+    void                            *addr = MAP_FAILED;
+    /** Size of the mapped image                                      */
+    size_t                           size = 0;
+    /** Scopes (their names point to the image)                       */
+    vector<fds_iemgr_scope_inter>    scopes;
+    /** Elements (their names point to the image)                     */
+    vector<fds_iemgr_elem>           elems;
+    /** Scopes taken over from a frozen manager                       */
+    vector<fds_iemgr_scope_inter *>  owned;
+    /** Contents that hold scopes of a rebased manager (see image_rebase()) */
+    vector<iemgr_image *>            deps;
+    /** Sorted pointers to scopes and lookup tables of all managers that refer to the content */
+    fds_iemgr_tables                 tables;
+
+    ~iemgr_image();
+};
+
+/**
+ * \brief Decrement a reference counter of shared content and destroy it, if not used anymore
+ * \param[in] image Shared content
+ */
+static void
+image_unref(iemgr_image *image)
+{
+    if (image->refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete image;
+    }
+}
+
+iemgr_image::~iemgr_image()
+{
+    for (const auto& mtime: tables.mtime) {
+        free(mtime.first);
+    }
+    for (auto scope: owned) {
+        scope_remove(scope);
+    }
+    for (auto image: deps) {
+        image_unref(image);
+    }
+    if (addr != MAP_FAILED) {
+        munmap(addr, size);
+    }
+}
+
+vector<image_dir_fp>
+image_dirs(const char *path)
+{
+    vector<image_dir_fp> res;
+    for (const char *name: {"system", "user"}) {
+        const string dir = string(path) + "/" + name + "/elements";
+        std::unique_ptr<char, decltype(&free)> abs_path(realpath(dir.c_str(), nullptr), &free);
+
+        struct stat sb{};
+        if (!abs_path || stat(abs_path.get(), &sb) != 0) {
+            res.emplace_back(dir, timespec{0, 0});
+            continue;
+        }
+
+        res.emplace_back(abs_path.get(), sb.st_mtim);
+    }
+
+    return res;
+}
+
+/**
+ * \brief Add a string to the table of strings
+ * \param[in,out] table Table of strings
+ * \param[in]     str   String (can be nullptr)
+ * \return Offset of the string in the table (or #IMAGE_NONE)
+ */
+static uint32_t
+image_str_add(string& table, const char *str)
+{
+    if (str == nullptr) {
+        return IMAGE_NONE;
+    }
+
+    const auto offset = uint32_t(table.size());
+    table.append(str, strlen(str) + 1);
+    return offset;
+}
+
+int
+image_save(fds_iemgr_t *mgr, const char *path, const vector<image_dir_fp>& dirs)
+{
+    string strs;
+    vector<image_fp> fps;
+    vector<image_scope> scopes;
+    vector<image_elem> elems;
+
+    for (const auto& mtime: mgr->tables->mtime) {
+        const uint32_t offset = image_str_add(strs, mtime.first);
+        fps.push_back(image_fp{offset, IMAGE_FP_FILE, mtime.second.tv_sec, mtime.second.tv_nsec});
+    }
+    for (const auto& dir: dirs) {
+        const uint32_t offset = image_str_add(strs, dir.first.c_str());
+        fps.push_back(image_fp{offset, IMAGE_FP_DIR, dir.second.tv_sec, dir.second.tv_nsec});
+    }
+
+    // Assign indexes to all elements first (reverse elements can be in other scopes)
+    std::map<const fds_iemgr_elem *, uint32_t> elem_idx;
+    uint32_t elem_cnt = 0;
+    for (const auto& scope: mgr->tables->pens) {
+        for (const auto& elem: scope.second->ids) {
+            elem_idx.emplace(elem.second, elem_cnt++);
+        }
+    }
+
+    for (const auto& scope: mgr->tables->pens) {
+        const fds_iemgr_scope& head = scope.second->head;
+        const auto scope_idx = uint32_t(scopes.size());
+        scopes.push_back(image_scope{head.pen, image_str_add(strs, head.name),
+            uint32_t(head.biflow_mode), head.biflow_id, scope.second->is_reverse,
+            uint32_t(elems.size()), uint32_t(scope.second->ids.size()), 0});
+
+        for (const auto& elem_pair: scope.second->ids) {
+            const fds_iemgr_elem *elem = elem_pair.second;
+            uint32_t reverse = IMAGE_NONE;
+            if (elem->reverse_elem != nullptr) {
+                const auto it = elem_idx.find(elem->reverse_elem);
+                reverse = (it != elem_idx.end()) ? it->second : IMAGE_NONE;
+            }
+
+            elems.push_back(image_elem{image_str_add(strs, elem->name), scope_idx, reverse,
+                elem->id, elem->is_reverse, 0, uint32_t(elem->data_type),
+                uint32_t(elem->data_semantic), uint32_t(elem->data_unit), uint32_t(elem->status)});
+        }
+    }
+
+    // Make sure that the table of strings is never empty
+    strs.push_back('\0');
+
+    image_hdr hdr{};
+    memcpy(hdr.magic, IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.version = IMAGE_VERSION;
+    hdr.byte_order = IMAGE_BYTE_ORDER;
+    hdr.fp_cnt = uint32_t(fps.size());
+    hdr.scope_cnt = uint32_t(scopes.size());
+    hdr.elem_cnt = uint32_t(elems.size());
+    hdr.str_size = uint32_t(strs.size());
+    hdr.size = sizeof(hdr) + fps.size() * sizeof(image_fp) + scopes.size() * sizeof(image_scope)
+        + elems.size() * sizeof(image_elem) + strs.size();
+
+    // Write a temporary file and replace the image atomically
+    const string tmp_path = string(path) + ".tmp." + to_string(getpid());
+    auto file = unique_file(fopen(tmp_path.c_str(), "wb"), &::fclose);
+    if (!file) {
+        mgr->err_msg = "Unable to create the file '" + tmp_path + "'";
+        return FDS_ERR_DENIED;
+    }
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, file.get()) == 1;
+    ok = ok && fwrite(fps.data(), sizeof(image_fp), fps.size(), file.get()) == fps.size();
+    ok = ok && fwrite(scopes.data(), sizeof(image_scope), scopes.size(), file.get())
+        == scopes.size();
+    ok = ok && fwrite(elems.data(), sizeof(image_elem), elems.size(), file.get())
+        == elems.size();
+    ok = ok && fwrite(strs.data(), 1, strs.size(), file.get()) == strs.size();
+    ok = (fclose(file.release()) == 0) && ok;
+    if (!ok || rename(tmp_path.c_str(), path) != 0) {
+        unlink(tmp_path.c_str());
+        mgr->err_msg = "Unable to write the file '" + string(path) + "'";
+        return FDS_ERR_DENIED;
+    }
+
+    return FDS_OK;
+}
+
+/** Parsed sections of a mapped image */
+struct image_view {
+    const image_hdr   *hdr;    /**< Header               */
+    const image_fp    *fps;    /**< Fingerprints         */
+    const image_scope *scopes; /**< Scopes               */
+    const image_elem  *elems;  /**< Elements             */
+    const char        *strs;   /**< Table of strings     */
+};
+
+/**
+ * \brief Check that an offset refers to a string in the table of strings
+ * \param[in] view   Image
+ * \param[in] offset Offset (#IMAGE_NONE is allowed only if \p none is true)
+ * \param[in] none   Undefined reference is allowed
+ * \return True or false
+ */
+static bool
+image_str_check(const image_view& view, uint32_t offset, bool none)
+{
+    if (offset == IMAGE_NONE) {
+        return none;
+    }
+    return offset < view.hdr->str_size;
+}
+
+/**
+ * \brief Check sections of a mapped image
+ * \param[in]  addr Mapped image
+ * \param[in]  size Size of the image
+ * \param[out] view Parsed sections
+ * \return True if the image is well-formed, otherwise False
+ */
+static bool
+image_check(const void *addr, size_t size, image_view& view)
+{
+    if (size < sizeof(image_hdr)) {
+        return false;
+    }
+
+    const auto *hdr = static_cast<const image_hdr *>(addr);
+    if (memcmp(hdr->magic, IMAGE_MAGIC, sizeof(hdr->magic)) != 0
+            || hdr->version != IMAGE_VERSION || hdr->byte_order != IMAGE_BYTE_ORDER
+            || hdr->size != size || hdr->str_size == 0) {
+        return false;
+    }
+
+    const uint64_t exp_size = sizeof(image_hdr) + uint64_t(hdr->fp_cnt) * sizeof(image_fp)
+        + uint64_t(hdr->scope_cnt) * sizeof(image_scope)
+        + uint64_t(hdr->elem_cnt) * sizeof(image_elem) + hdr->str_size;
+    if (exp_size != size) {
+        return false;
+    }
+
+    const auto *ptr = static_cast<const uint8_t *>(addr) + sizeof(image_hdr);
+    view.hdr = hdr;
+    view.fps = reinterpret_cast<const image_fp *>(ptr);
+    ptr += hdr->fp_cnt * sizeof(image_fp);
+    view.scopes = reinterpret_cast<const image_scope *>(ptr);
+    ptr += hdr->scope_cnt * sizeof(image_scope);
+    view.elems = reinterpret_cast<const image_elem *>(ptr);
+    ptr += hdr->elem_cnt * sizeof(image_elem);
+    view.strs = reinterpret_cast<const char *>(ptr);
+    if (view.strs[hdr->str_size - 1] != '\0') {
+        // All strings must be terminated inside the table
+        return false;
+    }
+
+    for (uint32_t i = 0; i < hdr->fp_cnt; ++i) {
+        if (!image_str_check(view, view.fps[i].path, false)) {
+            return false;
+        }
+    }
+
+    uint32_t elem_next = 0;
+    for (uint32_t i = 0; i < hdr->scope_cnt; ++i) {
+        const image_scope& scope = view.scopes[i];
+        if (!image_str_check(view, scope.name, true) || scope.elem_first != elem_next
+                || scope.elem_cnt > hdr->elem_cnt - elem_next) {
+            return false;
+        }
+
+        for (uint32_t idx = scope.elem_first; idx < scope.elem_first + scope.elem_cnt; ++idx) {
+            const image_elem& elem = view.elems[idx];
+            if (idx != scope.elem_first && view.elems[idx - 1].id >= elem.id) {
+                // Elements must be sorted by ID
+                return false;
+            }
+            if (!image_str_check(view, elem.name, true) || elem.scope >= hdr->scope_cnt
+                    || (elem.reverse != IMAGE_NONE && elem.reverse >= hdr->elem_cnt)) {
+                return false;
+            }
+        }
+
+        elem_next += scope.elem_cnt;
+    }
+
+    return elem_next == hdr->elem_cnt;
+}
+
+/**
+ * \brief Check that fingerprints of an image match the current state of the files
+ * \param[in] view Image
+ * \param[in] dirs Expected directories (empty if the image is not bound to directories)
+ * \return True or false
+ */
+static bool
+image_fp_check(const image_view& view, const vector<image_dir_fp>& dirs)
+{
+    set<string> dirs_exp;
+    set<string> dirs_img;
+    for (const auto& dir: dirs) {
+        dirs_exp.insert(dir.first);
+    }
+
+    struct stat sb{};
+    for (uint32_t i = 0; i < view.hdr->fp_cnt; ++i) {
+        const image_fp& fp = view.fps[i];
+        const char *path = view.strs + fp.path;
+        if (stat(path, &sb) != 0 || sb.st_mtim.tv_sec != fp.sec || sb.st_mtim.tv_nsec != fp.nsec) {
+            return false;
+        }
+
+        if (fp.type == IMAGE_FP_DIR) {
+            dirs_img.insert(path);
+        }
+    }
+
+    return dirs_exp.empty() || dirs_exp == dirs_img;
+}
+
+/**
+ * \brief Fill a manager with scopes and elements of a mapped image
+ * \param[in,out] mgr   Empty manager
+ * \param[in]     view  Image
+ * \param[in,out] image Storage of scopes and elements
+ * \return FDS_OK, FDS_ERR_FORMAT or FDS_ERR_NOMEM
+ * \throw std::bad_alloc on memory allocation error
+ */
+static int
+image_fill(fds_iemgr_t *mgr, const image_view& view, iemgr_image& image)
+{
+    const image_hdr *hdr = view.hdr;
+    // Names are not modified until the manager is thawed
+    auto str_get = [&view](uint32_t offset) -> char * {
+        return (offset == IMAGE_NONE) ? nullptr : const_cast<char *>(view.strs + offset);
+    };
+
+    image.scopes.resize(hdr->scope_cnt);
+    image.elems.resize(hdr->elem_cnt);
+    for (uint32_t i = 0; i < hdr->scope_cnt; ++i) {
+        const image_scope& src = view.scopes[i];
+        fds_iemgr_scope_inter& dst = image.scopes[i];
+        dst.head.pen = src.pen;
+        dst.head.name = str_get(src.name);
+        dst.head.biflow_mode = static_cast<fds_iemgr_element_biflow>(src.biflow_mode);
+        dst.head.biflow_id = src.biflow_id;
+        dst.is_reverse = (src.is_reverse != 0);
+
+        dst.ids.reserve(src.elem_cnt);
+        for (uint32_t idx = src.elem_first; idx < src.elem_first + src.elem_cnt; ++idx) {
+            dst.ids.emplace_back(view.elems[idx].id, &image.elems[idx]);
+        }
+    }
+
+    for (uint32_t i = 0; i < hdr->elem_cnt; ++i) {
+        const image_elem& src = view.elems[i];
+        fds_iemgr_elem& dst = image.elems[i];
+        dst.id = src.id;
+        dst.name = str_get(src.name);
+        dst.scope = &image.scopes[src.scope].head;
+        dst.data_type = static_cast<fds_iemgr_element_type>(src.data_type);
+        dst.data_semantic = static_cast<fds_iemgr_element_semantic>(src.data_semantic);
+        dst.data_unit = static_cast<fds_iemgr_element_unit>(src.data_unit);
+        dst.status = static_cast<fds_iemgr_element_status>(src.status);
+        dst.is_reverse = (src.is_reverse != 0);
+        dst.reverse_elem = (src.reverse == IMAGE_NONE) ? nullptr : &image.elems[src.reverse];
+    }
+
+    for (auto& scope: image.scopes) {
+        mgr->tables->pens.emplace_back(scope.head.pen, &scope);
+        if (scope.head.name != nullptr) {
+            mgr->tables->prefixes.emplace_back(scope.head.name, &scope);
+        }
+    }
+
+    for (uint32_t i = 0; i < hdr->fp_cnt; ++i) {
+        if (view.fps[i].type != IMAGE_FP_FILE) {
+            continue;
+        }
+
+        char *path = strdup(view.strs + view.fps[i].path);
+        if (path == nullptr) {
+            throw std::bad_alloc();
+        }
+        timespec mtime{time_t(view.fps[i].sec), long(view.fps[i].nsec)};
+        mgr->tables->mtime.emplace_back(path, mtime);
+    }
+
+    mgr_sort(mgr);
+    const fds_iemgr_tables& tables = *mgr->tables;
+    if (find_pair(tables.pens) != tables.pens.end()
+            || find_pair(tables.prefixes) != tables.prefixes.end()) {
+        mgr->err_msg = "Scopes of the image are defined multiple times.";
+        return FDS_ERR_FORMAT;
+    }
+
+    mgr_index_build(mgr);
+    if (!mgr->tables->index.valid) {
+        // Vectors of elements sorted by name are not filled, therefore, tables are required
+        mgr->err_msg = "Unable to build lookup tables of the image.";
+        return FDS_ERR_NOMEM;
+    }
+
+    return FDS_OK;
+}
+
+int
+image_load(fds_iemgr_t *mgr, const char *path, const vector<image_dir_fp>& dirs)
+{
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        mgr->err_msg = "Unable to open the file '" + string(path) + "'";
+        return FDS_ERR_FORMAT;
+    }
+
+    std::unique_ptr<iemgr_image> image(new iemgr_image);
+    struct stat sb{};
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        image->size = size_t(sb.st_size);
+        image->addr = mmap(nullptr, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    image_view view{};
+    if (image->addr == MAP_FAILED || !image_check(image->addr, image->size, view)) {
+        mgr->err_msg = "The file '" + string(path) + "' is not a valid image of the manager";
+        return FDS_ERR_FORMAT;
+    }
+
+    if (!image_fp_check(view, dirs)) {
+        mgr->err_msg = "The image '" + string(path) + "' is outdated";
+        return FDS_ERR_DIFF;
+    }
+
+    fds_iemgr_clear(mgr);
+    mgr->image = image.release();
+    mgr->tables = &mgr->image->tables;
+    int ret;
+    try {
+        ret = image_fill(mgr, view, *mgr->image);
+    } catch (...) {
+        mgr->err_msg = "Error while allocating memory for the image.";
+        ret = FDS_ERR_NOMEM;
+    }
+
+    if (ret != FDS_OK) {
+        fds_iemgr_clear(mgr);
+    }
+
+    return ret;
+}
+
+void
+image_release(fds_iemgr_t *mgr)
+{
+    iemgr_image *image = mgr->image;
+    mgr->image = nullptr;
+    mgr->tables = &mgr->tables_own;
+    if (image != nullptr) {
+        image_unref(image);
+    }
+}
+
+void
+image_freeze(fds_iemgr_t *mgr)
+{
+    if (mgr->image != nullptr) {
+        // Already immutable
+        return;
+    }
+
+    std::unique_ptr<iemgr_image> image(new iemgr_image);
+    image->owned.reserve(mgr->tables->pens.size());
+    for (const auto& scope: mgr->tables->pens) {
+        image->owned.push_back(scope.second);
+    }
+
+    // Tables are moved too (names in the hash table still refer to the same prefixes)
+    std::swap(image->tables, mgr->tables_own);
+    mgr->image = image.release();
+    mgr->tables = &mgr->image->tables;
+}
+
+fds_iemgr_t *
+image_share(const fds_iemgr_t *mgr)
+{
+    assert(mgr->image != nullptr);
+    auto res = unique_mgr(new fds_iemgr_t, &::fds_iemgr_destroy);
+    if (!mgr->err_msg.empty()) {
+        res->err_msg = mgr->err_msg;
+    }
+
+    // Scopes, elements and tables are shared
+    mgr->image->refcnt.fetch_add(1, std::memory_order_relaxed);
+    res->image = mgr->image;
+    res->tables = &res->image->tables;
+    return res.release();
+}
+
+/**
+ * \brief Check if two elements have the same definition
+ * \param[in] lhs Element
+ * \param[in] rhs Element
+ * \return True or false
+ */
+static bool
+image_elem_same(const fds_iemgr_elem *lhs, const fds_iemgr_elem *rhs)
+{
+    if (lhs->id != rhs->id || strcmp(lhs->name, rhs->name) != 0
+            || lhs->data_type != rhs->data_type || lhs->data_semantic != rhs->data_semantic
+            || lhs->data_unit != rhs->data_unit || lhs->status != rhs->status
+            || lhs->is_reverse != rhs->is_reverse) {
+        return false;
+    }
+
+    const fds_iemgr_elem *lhs_rev = lhs->reverse_elem;
+    const fds_iemgr_elem *rhs_rev = rhs->reverse_elem;
+    if (lhs_rev == nullptr || rhs_rev == nullptr) {
+        return lhs_rev == rhs_rev;
+    }
+
+    return lhs_rev->id == rhs_rev->id && lhs_rev->scope->pen == rhs_rev->scope->pen;
+}
+
+/**
+ * \brief Check if two scopes have the same definitions of the scope and all its elements
+ * \param[in] lhs Scope (can be nullptr)
+ * \param[in] rhs Scope (can be nullptr)
+ * \return True or false (also if any of the scopes is undefined)
+ */
+static bool
+image_scope_same(const fds_iemgr_scope_inter *lhs, const fds_iemgr_scope_inter *rhs)
+{
+    if (lhs == nullptr || rhs == nullptr) {
+        return false;
+    }
+
+    const fds_iemgr_scope& lhs_head = lhs->head;
+    const fds_iemgr_scope& rhs_head = rhs->head;
+    if (lhs_head.pen != rhs_head.pen || lhs_head.biflow_mode != rhs_head.biflow_mode
+            || lhs_head.biflow_id != rhs_head.biflow_id || lhs->is_reverse != rhs->is_reverse
+            || lhs->ids.size() != rhs->ids.size()) {
+        return false;
+    }
+
+    if (lhs_head.name == nullptr || rhs_head.name == nullptr) {
+        if (lhs_head.name != rhs_head.name) {
+            return false;
+        }
+    } else if (strcmp(lhs_head.name, rhs_head.name) != 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < lhs->ids.size(); ++i) {
+        if (!image_elem_same(lhs->ids[i].second, rhs->ids[i].second)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Check if shared content holds a scope
+ * \param[in] image Shared content without dependencies
+ * \param[in] scope Scope
+ * \return True or false
+ */
+static bool
+image_holds(const iemgr_image *image, const fds_iemgr_scope_inter *scope)
+{
+    const std::less<const fds_iemgr_scope_inter *> less;
+    if (!image->scopes.empty() && !less(scope, &image->scopes.front())
+            && !less(&image->scopes.back(), scope)) {
+        return true;
+    }
+
+    return std::find(image->owned.begin(), image->owned.end(), scope) != image->owned.end();
+}
+
+/**
+ * \brief Add contents that hold scopes (i.e. without dependencies) to a list
+ * \param[in]     image Shared content
+ * \param[in,out] list  List of contents
+ */
+static void
+image_holders(iemgr_image *image, vector<iemgr_image *>& list)
+{
+    if (image->deps.empty()) {
+        list.push_back(image);
+        return;
+    }
+
+    list.insert(list.end(), image->deps.begin(), image->deps.end());
+}
+
+void
+image_rebase(fds_iemgr_t *mgr, const fds_iemgr_t *base)
+{
+    assert(mgr->image != nullptr && base->image != nullptr);
+    if (mgr->image == base->image) {
+        // Everything is already shared
+        return;
+    }
+
+    auto pens = mgr->tables->pens;
+    bool replaced = false;
+    for (auto& rec: pens) {
+        fds_iemgr_scope_inter *scope = rec.second;
+        fds_iemgr_scope_inter *scope_base = binary_find(base->tables->pens, rec.first);
+        if (scope->is_reverse || !image_scope_same(scope, scope_base)) {
+            // Reverse scopes are replaced together with their forward scopes
+            continue;
+        }
+
+        if (scope->head.biflow_mode == FDS_BF_PEN) {
+            const uint32_t pen_rev = scope->head.biflow_id;
+            auto it = find_iterator(pens, pen_rev);
+            fds_iemgr_scope_inter *rev_base = binary_find(base->tables->pens, pen_rev);
+            if (it == pens.end() || !image_scope_same(it.base()->second, rev_base)) {
+                continue;
+            }
+
+            it.base()->second = rev_base;
+        }
+
+        rec.second = scope_base;
+        replaced = true;
+    }
+
+    if (!replaced) {
+        return;
+    }
+
+    decltype(mgr->tables->prefixes) prefixes;
+    for (const auto& rec: pens) {
+        if (rec.second->head.name != nullptr) {
+            prefixes.emplace_back(rec.second->head.name, rec.second);
+        }
+    }
+
+    // Keep only contents that still hold any scope of the manager
+    vector<iemgr_image *> candidates;
+    image_holders(mgr->image, candidates);
+    image_holders(base->image, candidates);
+    vector<iemgr_image *> holders;
+    for (auto image: candidates) {
+        if (std::find(holders.begin(), holders.end(), image) != holders.end()) {
+            continue;
+        }
+
+        for (const auto& rec: pens) {
+            if (image_holds(image, rec.second)) {
+                holders.push_back(image);
+                break;
+            }
+        }
+    }
+
+    if (pens == base->tables->pens) {
+        // All scopes are shared with the base manager -> share also its tables
+        base->image->refcnt.fetch_add(1, std::memory_order_relaxed);
+        image_release(mgr);
+        mgr->image = base->image;
+        mgr->tables = &mgr->image->tables;
+        return;
+    }
+
+    std::unique_ptr<iemgr_image> content(new iemgr_image);
+    fds_iemgr_tables& tables = content->tables;
+    tables.mtime.reserve(mgr->tables->mtime.size());
+    for (const auto& mtime: mgr->tables->mtime) {
+        char *path = strdup(mtime.first);
+        if (path == nullptr) {
+            throw std::bad_alloc();
+        }
+        tables.mtime.emplace_back(path, mtime.second);
+    }
+    content->deps = holders;
+    tables.pens.swap(pens);
+    tables.prefixes.swap(prefixes);
+
+    // Nothing can fail from here (holders are referenced by the new content)
+    for (auto image: holders) {
+        image->refcnt.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    image_release(mgr);
+    mgr->image = content.release();
+    mgr->tables = &mgr->image->tables;
+    // The content is not shared yet, therefore, its tables can be modified
+    mgr_sort(mgr);
+    mgr_index_build(mgr);
+}
+
+bool
+mgr_thaw(fds_iemgr_t *mgr)
+{
+    if (mgr->image == nullptr) {
+        return true;
+    }
+
+    fds_iemgr_t *copy;
+    try {
+        copy = mgr_copy(mgr);
+    } catch (...) {
+        copy = nullptr;
+    }
+
+    if (copy == nullptr) {
+        mgr->err_msg = "Unable to copy shared elements of the manager";
+        return false;
+    }
+
+    fds_iemgr_clear(mgr);
+    // Names in the hash table refer to prefixes of the copy -> the tables are moved at once
+    std::swap(mgr->tables_own, copy->tables_own);
+    fds_iemgr_destroy(copy);
+    return true;
+}
@@ -0,0 +1,151 @@
+/**
+ * \file   src/iemgr/iemgr_image.h
+ * \author agent <agent@local>
+ * \brief  Binary image of the iemgr (header file)
+ * \date   2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#pragma once
+
+#include "iemgr_common.h"
+#include <libfds/iemgr.h>
+
+/**
+ * \brief Fingerprint of a directory with definition files
+ *
+ * Unlike files, the directory itself is not part of the manager, but its modification time
+ * changes when a file is added or removed.
+ */
+using image_dir_fp = pair<string, timespec>;
+
+/**
+ * \brief Get fingerprints of directories read by fds_iemgr_read_dir()
+ * \param[in] path Path to the directory with 'system' and 'user' subdirectories
+ * \return Fingerprints (a directory that cannot be accessed has zero timestamp)
+ */
+vector<image_dir_fp>
+image_dirs(const char *path);
+
+/**
+ * \brief Save scopes, elements and fingerprints of a manager to a binary image
+ *
+ * The image is written to a temporary file first and then atomically renamed.
+ * \param[in,out] mgr  Manager
+ * \param[in]     path Path to the image
+ * \param[in]     dirs Fingerprints of directories with definition files
+ * \return FDS_OK on success, otherwise FDS_ERR_DENIED or FDS_ERR_NOMEM and an error message is set
+ */
+int
+image_save(fds_iemgr_t *mgr, const char *path, const vector<image_dir_fp>& dirs);
+
+/**
+ * \brief Replace the content of a manager with a binary image
+ *
+ * The image is mapped into memory. Elements are stored in a single array and their names are
+ * not copied, therefore, the manager is read-only until it is thawed (see mgr_thaw()).
+ * \param[in,out] mgr  Manager
+ * \param[in]     path Path to the image
+ * \param[in]     dirs Fingerprints of directories expected in the image (paths only, empty if
+ *   the image is not bound to directories)
+ * \return FDS_OK on success.
+ * \return FDS_ERR_DIFF if any file or directory has changed since the image was created.
+ * \return FDS_ERR_FORMAT if the image cannot be read or it is malformed.
+ * \return FDS_ERR_NOMEM on memory allocation error.
+ * \note On failure, an error message is set. If the image is outdated or malformed, scopes and
+ *   elements of the manager are not modified.
+ */
+int
+image_load(fds_iemgr_t *mgr, const char *path, const vector<image_dir_fp>& dirs);
+
+/**
+ * \brief Release shared content of a manager
+ *
+ * The content is destroyed when the last manager that refers to it is released.
+ * \warning Scopes and elements of the content must be removed from the manager first.
+ * \param[in,out] mgr Manager
+ */
+void
+image_release(fds_iemgr_t *mgr);
+
+/**
+ * \brief Make scopes and elements of a manager immutable and shareable
+ *
+ * Ownership of the scopes is transferred to a new shared content, nothing is copied. If the
+ * manager is already immutable (e.g. loaded from a binary image), nothing is done.
+ * \param[in,out] mgr Manager
+ * \throw std::bad_alloc on memory allocation error
+ */
+void
+image_freeze(fds_iemgr_t *mgr);
+
+/**
+ * \brief Create a manager that shares immutable content with another manager
+ *
+ * Nothing is copied, the new manager refers to scopes, elements and lookup tables of the
+ * content and only a reference counter of the content is incremented.
+ * \param[in] mgr Immutable manager
+ * \return New manager or nullptr (memory allocation error)
+ * \throw std::bad_alloc on memory allocation error
+ */
+fds_iemgr_t *
+image_share(const fds_iemgr_t *mgr);
+
+/**
+ * \brief Share unchanged scopes of an immutable manager with another immutable manager
+ *
+ * Each scope of the manager \p mgr that has the same definition (including all its elements)
+ * as the scope of the manager \p base is replaced by the scope of \p base. Scopes of the
+ * Biflow PEN mode are replaced together with their reverse scopes. The manager holds a
+ * reference to contents of both managers (only if any of their scopes is still used). If all
+ * scopes of the manager are replaced by scopes of \p base, the manager shares also its tables.
+ * \param[in,out] mgr  Immutable manager
+ * \param[in]     base Immutable manager
+ * \throw std::bad_alloc on memory allocation error (the manager is not modified)
+ */
+void
+image_rebase(fds_iemgr_t *mgr, const fds_iemgr_t *base);
+
+/**
+ * \brief Convert an immutable manager to a modifiable manager
+ *
+ * All scopes and elements are copied and the shared content is released. If the manager is
+ * not immutable, nothing is done.
+ * \param[in,out] mgr Manager
+ * \return True on success, otherwise False and an error message is set
+ */
+bool
+mgr_thaw(fds_iemgr_t *mgr);
@@ -73,6 +73,8 @@ scope_copy(const fds_iemgr_scope_inter* scope)
         elem = element_copy(res.get(), tmp.second);
         if (elem->reverse_elem != nullptr && scope->head.biflow_mode != FDS_BF_PEN) {
             elem->reverse_elem = element_copy(res.get(), tmp.second->reverse_elem);
+            // The copy must not refer to the element of the original scope
+            elem->reverse_elem->reverse_elem = elem;
         }
 
         res->ids.emplace_back(elem->id, elem);
@@ -159,7 +161,7 @@ scope_save_reverse_elem(fds_iemgr_scope_inter *scope)
 bool
 scope_set_biflow_overwrite(fds_iemgr_t* mgr, const fds_iemgr_scope_inter* scope)
 {
-    auto res = find_second(mgr->pens, scope->head.biflow_id);
+    auto res = find_second(mgr->tables->pens, scope->head.biflow_id);
     scope_remove_elements(res);
 
     return elements_copy_reverse(res, scope);
@@ -215,8 +217,8 @@ scope_overwrite(fds_iemgr_t* mgr, fds_iemgr_scope_inter* scope)
 fds_iemgr_scope_inter *
 scope_save(fds_iemgr_t* mgr, fds_iemgr_scope_inter* scope)
 {
-    mgr->prefixes.emplace_back(scope->head.name, scope);
-    mgr->pens.emplace_back(scope->head.pen, scope);
+    mgr->tables->prefixes.emplace_back(scope->head.name, scope);
+    mgr->tables->pens.emplace_back(scope->head.pen, scope);
 
     return scope;
 }
@@ -274,7 +276,7 @@ scope_write(fds_iemgr_t* mgr, unique_scope scope, bool biflow_read)
 fds_iemgr_scope_inter *
 scope_push(fds_iemgr_t* mgr, unique_scope scope, bool biflow_read)
 {
-    auto res = find_second(mgr->pens, scope->head.pen);
+    auto res = find_second(mgr->tables->pens, scope->head.pen);
     if (res != nullptr) {
         return scope_overwrite(mgr, res);
     }
@@ -189,6 +189,59 @@ fds_dset_iter_init(struct fds_dset_iter *it, struct fds_ipfix_set_hdr *set,
     }
 }
 
+/**
+ * \brief Determine the size of a Data Record based on a template with variable-length fields
+ *
+ * Fixed-length fields are skipped at once using precomputed lengths of fixed-length segments
+ * between variable-length fields (see fds_template#index). Only octet prefixes of
+ * variable-length fields are read.
+ * \param[in]  tmplt   Template
+ * \param[in]  rec     Start of the Record
+ * \param[in]  set_end First byte after the end of the Data Set
+ * \param[out] size    Size of the Record
+ * \return #FDS_OK on success.
+ * \return #FDS_ERR_FORMAT if the Record is longer than its enclosing Data Set.
+ */
+static inline int
+dset_rec_dyn_size(const struct fds_template *tmplt, const uint8_t *rec, const uint8_t *set_end,
+    uint32_t *size)
+{
+    const uint16_t *segs = tmplt->index.var_segs;
+    const uint16_t var_cnt = tmplt->index.var_cnt;
+    const uint32_t size_max = (uint32_t) (set_end - rec);
+    uint32_t size_total = segs[0];
+
+    for (uint16_t idx = 0; idx < var_cnt; ++idx) {
+        // This is a field with variable-length encoding
+        if (size_total + 1U > size_max) {
+            // The memory is beyond the end of the Data Set
+            return FDS_ERR_FORMAT;
+        }
+
+        uint32_t field_size = rec[size_total];
+        size_total += 1U;
+        if (field_size == 255U) {
+            if (size_total + 2U > size_max) {
+                // The memory is beyond the end of the Data Set
+                return FDS_ERR_FORMAT;
+            }
+
+            field_size = ntohs(*(const uint16_t *) &rec[size_total]);
+            size_total += 2U;
+        }
+
+        // Skip the field and all following fixed-length fields
+        size_total += field_size + segs[idx + 1];
+    }
+
+    if (size_total > size_max) {
+        return FDS_ERR_FORMAT;
+    }
+
+    *size = size_total;
+    return FDS_OK;
+}
+
 int
 fds_dset_iter_next(struct fds_dset_iter *it)
 {
@@ -208,8 +261,8 @@ fds_dset_iter_next(struct fds_dset_iter *it)
     // Is the rest of the message padding?
     const struct fds_template *tmplt = it->_private.tmplt;
     uint32_t size = tmplt->data_length;
-    if (it->_private.rec_next + size > it->_private.set_end) {
-        // The rest of the Data Set is padding
+    if (size == 0 || it->_private.rec_next + size > it->_private.set_end) {
+        // The rest of the Data Set is padding (or the Template has only zero-length fields)
         return FDS_EOC;
     }
 
@@ -222,49 +275,81 @@ fds_dset_iter_next(struct fds_dset_iter *it)
     }
 
     // Processing a dynamic record
-    size = 0;
-    uint16_t idx;
+    if (dset_rec_dyn_size(tmplt, it->_private.rec_next, it->_private.set_end, &size) != FDS_OK) {
+        // A variable-length Data Record is longer than its enclosing Data Set.
+        it->_private.err_msg = err_msg[ERR_DSET_VAR_LONG];
+        return FDS_ERR_FORMAT;
+    }
 
-    for (idx = 0; idx < tmplt->fields_cnt_total; ++idx) {
-        uint16_t field_size = tmplt->fields[idx].length;
-        if (field_size != FDS_IPFIX_VAR_IE_LEN) {
-            size += field_size;
-            continue;
-        }
+    it->rec = it->_private.rec_next;
+    it->size = (uint16_t) size;
+    it->_private.rec_next += size;
+    return FDS_OK;
+}
 
-        // This is a field with variable-length encoding
-        if (&it->_private.rec_next[size + 1] > it->_private.set_end) {
-            // The memory is beyond the end of the Data Set
-            break;
-        }
+int
+fds_dset_iter_batch(struct fds_dset_iter *it, struct fds_dset_rec *recs, uint32_t recs_max,
+    uint32_t *recs_cnt)
+{
+    assert(recs_max > 0);
+    *recs_cnt = 0;
 
+    if ((it->_private.flags & FDS_DSET_ITER_FAILED) != 0) {
+        // Initialization failed, error code is properly set
+        return FDS_ERR_FORMAT;
+    }
 
-        field_size = it->_private.rec_next[size];
-        size += 1U;
-        if (field_size != 255U) {
-            size += field_size;
-            continue;
+    const struct fds_template *tmplt = it->_private.tmplt;
+    const uint32_t size_min = tmplt->data_length;
+    uint8_t *rec_next = it->_private.rec_next;
+    uint8_t *set_end = it->_private.set_end;
+    assert(rec_next <= set_end);
+    uint32_t cnt = 0;
+    int ret_code = FDS_OK;
+
+    if ((tmplt->flags & FDS_TEMPLATE_DYNAMIC) == 0) {
+        // Static records -> the number of records is given by the remaining size of the Set
+        // (a template of zero-length fields only describes no data, the rest is padding)
+        cnt = (size_min > 0) ? (uint32_t) (set_end - rec_next) / size_min : 0;
+        if (cnt > recs_max) {
+            cnt = recs_max;
         }
 
-        if (&it->_private.rec_next[size + 2] > it->_private.set_end) {
-            // The memory is beyond the end of the Data Set
-            break;
+        for (uint32_t i = 0; i < cnt; ++i) {
+            recs[i].rec = rec_next;
+            recs[i].size = (uint16_t) size_min;
+            rec_next += size_min;
         }
+    } else {
+        // Dynamic records (the rest of the Set shorter than the minimal size is padding)
+        while (cnt < recs_max && rec_next + size_min <= set_end) {
+            uint32_t size;
+            if (dset_rec_dyn_size(tmplt, rec_next, set_end, &size) != FDS_OK) {
+                // A variable-length Data Record is longer than its enclosing Data Set.
+                it->_private.err_msg = err_msg[ERR_DSET_VAR_LONG];
+                ret_code = FDS_ERR_FORMAT;
+                break;
+            }
+
+            recs[cnt].rec = rec_next;
+            recs[cnt].size = (uint16_t) size;
+            rec_next += size;
+            cnt++;
+        }
+    }
 
-        field_size = ntohs(*(uint16_t *) &it->_private.rec_next[size]);
-        size += 2U + field_size;
+    it->_private.rec_next = rec_next;
+    *recs_cnt = cnt;
+    if (cnt > 0) {
+        it->rec = recs[cnt - 1].rec;
+        it->size = recs[cnt - 1].size;
     }
 
-    if (idx != tmplt->fields_cnt_total || &it->_private.rec_next[size] > it->_private.set_end) {
-        // A variable-length Data Record is longer than its enclosing Data Set.
-        it->_private.err_msg = err_msg[ERR_DSET_VAR_LONG];
-        return FDS_ERR_FORMAT;
+    if (ret_code != FDS_OK) {
+        return ret_code;
     }
 
-    it->rec = it->_private.rec_next;
-    it->size = (uint16_t) size;
-    it->_private.rec_next += size;
-    return FDS_OK;
+    return (cnt > 0) ? FDS_OK : FDS_EOC;
 }
 
 const char *
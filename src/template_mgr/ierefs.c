@@ -0,0 +1,282 @@
+/**
+ * \file src/template_mgr/ierefs.c
+ * \author agent <agent@local>
+ * \brief Reverse index of Information Elements used by templates (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libfds.h>
+#include "ierefs.h"
+
+/** Default number of records of the hash table (must be a power of 2)                        */
+#define IEREFS_SIZE_DEF 64U
+/** Default number of Template IDs of a record                                                */
+#define IEREFS_IDS_DEF  4U
+/** Flag of a key that represents all elements of a scope                                      */
+#define IEREFS_SCOPE    (1ULL << 48)
+
+/** Template IDs of templates that refer to an Information Element (or a scope) */
+struct ierefs_rec {
+    /** Combination of PEN and ID of the element (see ierefs_key())         */
+    uint64_t key;
+    /** Template IDs sorted from the lowest to the highest (NULL == unused) */
+    uint16_t *ids;
+    /** Number of Template IDs                                               */
+    uint32_t cnt;
+    /** Allocated size of the array of Template IDs                         */
+    uint32_t size;
+};
+
+/**
+ * \brief Get a key of an Information Element
+ * \param[in] pen Private Enterprise Number
+ * \param[in] id  Information Element ID
+ * \return Key
+ */
+static inline uint64_t
+ierefs_key(uint32_t pen, uint16_t id)
+{
+    return (((uint64_t) pen) << 16) | id;
+}
+
+/**
+ * \brief Hash function of a key (SplitMix64 finalizer)
+ * \param[in] key Key
+ * \return Hash value
+ */
+static inline uint64_t
+ierefs_hash(uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+/**
+ * \brief Find a record of a key or an unused record for the key
+ * \param[in] recs Hash table
+ * \param[in] mask Mask of the hash table
+ * \param[in] key  Key
+ * \return Pointer to the record
+ */
+static struct ierefs_rec *
+ierefs_find(struct ierefs_rec *recs, uint32_t mask, uint64_t key)
+{
+    uint32_t pos = (uint32_t) ierefs_hash(key) & mask;
+    while (recs[pos].ids != NULL && recs[pos].key != key) {
+        pos = (pos + 1U) & mask;
+    }
+    return &recs[pos];
+}
+
+/**
+ * \brief Make sure that the hash table can hold one more record
+ *
+ * The load factor of the table is at most 50%.
+ * \param[in] refs Index
+ * \return True on success, false on memory allocation error
+ */
+static bool
+ierefs_reserve(struct ierefs *refs)
+{
+    const uint32_t old_size = (refs->recs != NULL) ? refs->mask + 1U : 0U;
+    if (2U * (refs->cnt + 1U) <= old_size) {
+        return true;
+    }
+
+    const uint32_t new_size = (old_size != 0) ? 2U * old_size : IEREFS_SIZE_DEF;
+    struct ierefs_rec *new_recs = calloc(new_size, sizeof(*new_recs));
+    if (!new_recs) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < old_size; ++i) {
+        if (refs->recs[i].ids != NULL) {
+            *ierefs_find(new_recs, new_size - 1U, refs->recs[i].key) = refs->recs[i];
+        }
+    }
+
+    free(refs->recs);
+    refs->recs = new_recs;
+    refs->mask = new_size - 1U;
+    return true;
+}
+
+/**
+ * \brief Add a Template ID to a record of a key
+ * \param[in] refs Index
+ * \param[in] key  Key
+ * \param[in] id   Template ID
+ * \return True on success, false on memory allocation error
+ */
+static bool
+ierefs_insert(struct ierefs *refs, uint64_t key, uint16_t id)
+{
+    if (!ierefs_reserve(refs)) {
+        return false;
+    }
+
+    struct ierefs_rec *rec = ierefs_find(refs->recs, refs->mask, key);
+    if (rec->ids == NULL) {
+        rec->ids = malloc(IEREFS_IDS_DEF * sizeof(*rec->ids));
+        if (!rec->ids) {
+            return false;
+        }
+        rec->key = key;
+        rec->cnt = 0;
+        rec->size = IEREFS_IDS_DEF;
+        refs->cnt++;
+    }
+
+    // Binary search of the position of the Template ID
+    uint32_t low = 0;
+    uint32_t high = rec->cnt;
+    while (low < high) {
+        const uint32_t mid = low + (high - low) / 2U;
+        if (rec->ids[mid] < id) {
+            low = mid + 1U;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < rec->cnt && rec->ids[low] == id) {
+        // Already present
+        return true;
+    }
+
+    if (rec->cnt == rec->size) {
+        uint16_t *new_ids = realloc(rec->ids, 2U * rec->size * sizeof(*new_ids));
+        if (!new_ids) {
+            return false;
+        }
+        rec->ids = new_ids;
+        rec->size *= 2U;
+    }
+
+    memmove(&rec->ids[low + 1U], &rec->ids[low], (rec->cnt - low) * sizeof(*rec->ids));
+    rec->ids[low] = id;
+    rec->cnt++;
+    return true;
+}
+
+void
+ierefs_clear(struct ierefs *refs)
+{
+    if (refs->recs != NULL) {
+        for (uint32_t i = 0; i <= refs->mask; ++i) {
+            free(refs->recs[i].ids);
+        }
+        free(refs->recs);
+    }
+
+    refs->recs = NULL;
+    refs->mask = 0;
+    refs->cnt = 0;
+    refs->incomplete = false;
+}
+
+void
+ierefs_add(struct ierefs *refs, const struct fds_template *tmplt)
+{
+    if (refs->incomplete) {
+        // The index is useless anyway
+        return;
+    }
+
+    const uint16_t id = tmplt->id;
+    for (uint16_t i = 0; i < tmplt->fields_cnt_total; ++i) {
+        const struct fds_tfield *field = &tmplt->fields[i];
+        bool ok = ierefs_insert(refs, ierefs_key(field->en, field->id), id);
+
+        if (ok && tmplt->fields_rev != NULL) {
+            const struct fds_tfield *field_rev = &tmplt->fields_rev[i];
+            if (field_rev->en != field->en || field_rev->id != field->id) {
+                ok = ierefs_insert(refs, ierefs_key(field_rev->en, field_rev->id), id);
+            } else if (field->flags & FDS_TFIELD_BKEY) {
+                // The counterpart is searched by name, so any element of the scope is relevant
+                ok = ierefs_insert(refs, IEREFS_SCOPE | ierefs_key(field->en, 0), id);
+            }
+        }
+
+        if (!ok) {
+            refs->incomplete = true;
+            return;
+        }
+    }
+}
+
+int
+ierefs_affected(const struct ierefs *refs, const fds_iemgr_diff_t *diff, uint32_t *ids)
+{
+    if (refs->incomplete) {
+        return -1;
+    }
+
+    int cnt = 0;
+    for (uint32_t i = 0; refs->recs != NULL && i <= refs->mask; ++i) {
+        const struct ierefs_rec *rec = &refs->recs[i];
+        if (rec->ids == NULL) {
+            continue;
+        }
+
+        const uint32_t pen = (uint32_t) (rec->key >> 16);
+        const bool changed = (rec->key & IEREFS_SCOPE)
+            ? fds_iemgr_diff_find_pen(diff, pen)
+            : fds_iemgr_diff_find(diff, pen, (uint16_t) rec->key);
+        if (!changed) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < rec->cnt; ++j) {
+            const uint16_t id = rec->ids[j];
+            if (!ierefs_id_test(ids, id)) {
+                ids[id / 32U] |= ((uint32_t) 1U) << (id % 32U);
+                cnt++;
+            }
+        }
+    }
+
+    return cnt;
+}
@@ -0,0 +1,130 @@
+/**
+ * \file src/template_mgr/ierefs.h
+ * \author agent <agent@local>
+ * \brief Reverse index of Information Elements used by templates (internal header file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#ifndef IEREFS_H
+#define IEREFS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <libfds.h>
+
+/**
+ * \defgroup ierefs_aux_func Reverse index of Information Elements
+ * \ingroup template_manager
+ *
+ * \brief Template IDs of templates that refer to an Information Element
+ *
+ * The index maps a combination of PEN and ID of an Information Element to IDs of templates
+ * that contain the element. It allows a template manager to find templates affected by changed
+ * definitions of Information Elements (see fds_tmgr_update_iemgr()) without iterating over
+ * its snapshots.
+ *
+ * Templates are only added to the index, they are never removed (e.g. when they are withdrawn
+ * or expired). Therefore, the index might refer to templates that are not part of the manager
+ * anymore, but it never misses a template of the manager.
+ * @{
+ */
+
+/** Number of items of a bitset of all Template IDs */
+#define IEREFS_IDS_SIZE (65536U / 32U)
+
+/** Record of the index */
+struct ierefs_rec;
+
+/** Reverse index of Information Elements (zeroed structure is an empty index) */
+struct ierefs {
+    /** Hash table of records (open addressing, linear probing)                    */
+    struct ierefs_rec *recs;
+    /** Mask of the hash table (its size is a power of two)                        */
+    uint32_t mask;
+    /** Number of used records                                                      */
+    uint32_t cnt;
+    /** Some templates are missing due to a memory allocation error                */
+    bool incomplete;
+};
+
+/**
+ * \brief Remove all records of the index
+ * \param[in] refs Index
+ */
+void
+ierefs_clear(struct ierefs *refs);
+
+/**
+ * \brief Add Information Elements of a template to the index
+ *
+ * Reverse fields of Biflow templates are added too. A Biflow key field without directional
+ * counterpart refers to all elements of its scope.
+ * \note On memory allocation error, the index is marked as incomplete.
+ * \param[in] refs  Index
+ * \param[in] tmplt Template
+ */
+void
+ierefs_add(struct ierefs *refs, const struct fds_template *tmplt);
+
+/**
+ * \brief Find Template IDs of templates that might refer to changed definitions
+ * \param[in]  refs Index
+ * \param[in]  diff Changed definitions
+ * \param[out] ids  Bitset of Template IDs (#IEREFS_IDS_SIZE items, must be zeroed)
+ * \return Number of found Template IDs or a negative value if the index is incomplete (i.e.
+ *   any template might be affected and \p ids is not filled)
+ */
+int
+ierefs_affected(const struct ierefs *refs, const fds_iemgr_diff_t *diff, uint32_t *ids);
+
+/**
+ * \brief Check if a Template ID is in a bitset
+ * \param[in] ids Bitset of Template IDs
+ * \param[in] id  Template ID
+ * \return True or false
+ */
+static inline bool
+ierefs_id_test(const uint32_t *ids, uint16_t id)
+{
+    return (ids[id / 32U] >> (id % 32U)) & 1U;
+}
+
+/**
+ * @}
+ */
+
+#endif // IEREFS_H
@@ -0,0 +1,356 @@
+/**
+ * \file src/template_mgr/pool.c
+ * \author agent <agent@local>
+ * \brief Pool allocator of template manager objects (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "pool.h"
+#include "snapshot.h"
+
+/** Alignment of objects in a slab                                                               */
+#define POOL_ALIGN (alignof(max_align_t))
+/** Round up a size to the alignment of objects                                                  */
+#define POOL_ROUND(size) (((size) + POOL_ALIGN - 1U) & ~(POOL_ALIGN - 1U))
+/** Size of a slab header (objects of the slab are placed behind the header)                     */
+#define POOL_SLAB_HDR POOL_ROUND(sizeof(struct pool_slab))
+
+/** Sizes of objects of each class */
+static const size_t pool_sizes[POOL_CLASS_CNT] = {
+    [POOL_SNAPSHOT] = sizeof(struct fds_tsnapshot),
+    [POOL_L1_TABLE] = sizeof(struct snapshot_l1_table),
+    [POOL_L2_NODE]  = sizeof(struct snapshot_l2_node),
+    [POOL_L2_TABLE] = sizeof(struct snapshot_l2_table)
+};
+
+/** Unused object of a slab */
+struct pool_obj {
+    /** Next unused object of the same slab                                */
+    struct pool_obj *next;
+};
+
+/** Slab header */
+struct pool_slab {
+    /** Previous slab in the list of partially used slabs                  */
+    struct pool_slab *prev;
+    /** Next slab in the list of partially used slabs                      */
+    struct pool_slab *next;
+    /** Unused objects of the slab                                         */
+    struct pool_obj *free_list;
+    /** Number of allocated objects                                        */
+    uint32_t used;
+};
+
+/** Set of slabs of the same class */
+struct pool_cache {
+    /** Size of an object in a slab (aligned)                              */
+    size_t obj_size;
+    /** Number of objects per slab                                         */
+    uint32_t obj_cnt;
+    /** Number of completely unused slabs                                  */
+    uint32_t empty_cnt;
+    /** Slabs with at least one unused object                              */
+    struct pool_slab *partial;
+};
+
+/** Pool allocator */
+struct fds_tpool {
+    /** Mutex protecting all members below                                 */
+    pthread_mutex_t lock;
+    /** Number of references (the user and template managers)             */
+    uint32_t refs;
+    /** Maximum size of reserved memory (0 == unlimited)                   */
+    size_t limit;
+    /** Slabs of each class                                                */
+    struct pool_cache caches[POOL_CLASS_CNT];
+    /** Statistics                                                         */
+    struct fds_tpool_stats stats;
+};
+
+/**
+ * \brief Add a slab to the beginning of the list of partially used slabs
+ * \param[in] cache Set of slabs
+ * \param[in] slab  Slab to add
+ */
+static void
+pool_partial_add(struct pool_cache *cache, struct pool_slab *slab)
+{
+    slab->prev = NULL;
+    slab->next = cache->partial;
+    if (cache->partial) {
+        cache->partial->prev = slab;
+    }
+    cache->partial = slab;
+}
+
+/**
+ * \brief Remove a slab from the list of partially used slabs
+ * \param[in] cache Set of slabs
+ * \param[in] slab  Slab to remove
+ */
+static void
+pool_partial_remove(struct pool_cache *cache, struct pool_slab *slab)
+{
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        cache->partial = slab->next;
+    }
+
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+/**
+ * \brief Create a new slab and add it to the list of partially used slabs
+ * \param[in] pool  Pool
+ * \param[in] cache Set of slabs of the pool
+ * \return Pointer or NULL (memory allocation error or the limit has been reached)
+ */
+static struct pool_slab *
+pool_slab_create(struct fds_tpool *pool, struct pool_cache *cache)
+{
+    if (pool->limit != 0 && pool->stats.reserved + POOL_SLAB_SIZE > pool->limit) {
+        return NULL;
+    }
+
+    // Slabs are aligned to their size, so the slab of an object can be found by masking
+    struct pool_slab *slab = aligned_alloc(POOL_SLAB_SIZE, POOL_SLAB_SIZE);
+    if (!slab) {
+        return NULL;
+    }
+
+    uint8_t *objs = ((uint8_t *) slab) + POOL_SLAB_HDR;
+    slab->free_list = NULL;
+    slab->used = 0;
+    for (uint32_t i = cache->obj_cnt; i > 0; --i) {
+        struct pool_obj *obj = (struct pool_obj *) &objs[(i - 1U) * cache->obj_size];
+        obj->next = slab->free_list;
+        slab->free_list = obj;
+    }
+
+    pool_partial_add(cache, slab);
+    cache->empty_cnt++;
+    pool->stats.reserved += POOL_SLAB_SIZE;
+    return slab;
+}
+
+/**
+ * \brief Free all slabs and the pool
+ * \warning All objects must be already returned to the pool.
+ * \param[in] pool Pool
+ */
+static void
+pool_free_all(struct fds_tpool *pool)
+{
+    assert(pool->refs == 0 && pool->stats.objects == 0);
+
+    for (size_t i = 0; i < POOL_CLASS_CNT; ++i) {
+        struct pool_slab *slab = pool->caches[i].partial;
+        while (slab) {
+            struct pool_slab *tmp = slab;
+            slab = slab->next;
+            assert(tmp->used == 0);
+            free(tmp);
+        }
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+fds_tpool_t *
+fds_tpool_create(size_t mem_limit)
+{
+    struct fds_tpool *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        free(pool);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < POOL_CLASS_CNT; ++i) {
+        struct pool_cache *cache = &pool->caches[i];
+        cache->obj_size = POOL_ROUND(pool_sizes[i]);
+        cache->obj_cnt = (uint32_t) ((POOL_SLAB_SIZE - POOL_SLAB_HDR) / cache->obj_size);
+        assert(cache->obj_cnt > 0);
+    }
+
+    pool->refs = 1;
+    pool->limit = mem_limit;
+    return pool;
+}
+
+void
+fds_tpool_destroy(fds_tpool_t *pool)
+{
+    pool_release(pool);
+}
+
+void
+fds_tpool_stats(fds_tpool_t *pool, struct fds_tpool_stats *stats)
+{
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void
+pool_acquire(fds_tpool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->refs++;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void
+pool_release(fds_tpool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    assert(pool->refs > 0);
+    bool destroy = (--pool->refs == 0 && pool->stats.objects == 0);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (destroy) {
+        pool_free_all(pool);
+    }
+}
+
+size_t
+pool_obj_size(enum pool_class cls)
+{
+    assert(cls < POOL_CLASS_CNT);
+    return pool_sizes[cls];
+}
+
+void *
+pool_alloc(fds_tpool_t *pool, enum pool_class cls)
+{
+    assert(cls < POOL_CLASS_CNT);
+    if (!pool) {
+        return malloc(pool_sizes[cls]);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    struct pool_cache *cache = &pool->caches[cls];
+    struct pool_slab *slab = cache->partial;
+    if (!slab && (slab = pool_slab_create(pool, cache)) == NULL) {
+        pool->stats.failures++;
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+
+    struct pool_obj *obj = slab->free_list;
+    assert(obj != NULL);
+    slab->free_list = obj->next;
+    if (slab->used++ == 0) {
+        cache->empty_cnt--;
+    }
+    if (!slab->free_list) {
+        // The slab is full
+        pool_partial_remove(cache, slab);
+    }
+
+    pool->stats.objects++;
+    pool->stats.bytes += pool_sizes[cls];
+    pthread_mutex_unlock(&pool->lock);
+    return obj;
+}
+
+void
+pool_free(fds_tpool_t *pool, enum pool_class cls, void *ptr)
+{
+    assert(cls < POOL_CLASS_CNT);
+    if (!pool || !ptr) {
+        free(ptr);
+        return;
+    }
+
+    const uintptr_t slab_mask = ~((uintptr_t) POOL_SLAB_SIZE - 1U);
+    struct pool_slab *slab = (struct pool_slab *) ((uintptr_t) ptr & slab_mask);
+    struct pool_obj *obj = ptr;
+
+    pthread_mutex_lock(&pool->lock);
+    struct pool_cache *cache = &pool->caches[cls];
+    assert(slab->used > 0);
+    if (!slab->free_list) {
+        // The slab was full
+        pool_partial_add(cache, slab);
+    }
+
+    obj->next = slab->free_list;
+    slab->free_list = obj;
+    if (--slab->used == 0) {
+        if (cache->empty_cnt > 0) {
+            // Keep only one unused slab per class
+            pool_partial_remove(cache, slab);
+            free(slab);
+            pool->stats.reserved -= POOL_SLAB_SIZE;
+        } else {
+            cache->empty_cnt++;
+        }
+    }
+
+    pool->stats.objects--;
+    pool->stats.bytes -= pool_sizes[cls];
+    bool destroy = (pool->refs == 0 && pool->stats.objects == 0);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (destroy) {
+        pool_free_all(pool);
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * \file src/template_mgr/pool.h
+ * \author agent <agent@local>
+ * \brief Pool allocator of template manager objects (internal header file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <string.h>
+#include <libfds.h>
+
+/**
+ * \defgroup pool_aux_func Pool allocator of template manager objects
+ * \ingroup template_manager
+ *
+ * \brief Slab allocator of fixed-size objects used internally by template managers
+ *
+ * Each class of objects has its own set of slabs. A slab is an aligned block of memory of
+ * #POOL_SLAB_SIZE bytes that consists of a header and an array of objects of the same size.
+ * Since slabs are aligned to their size, the slab of an object is determined just by masking
+ * the address of the object. Slabs with at least one free object are kept in a list of
+ * partially used slabs of the class. A slab that becomes completely free is returned to the
+ * system unless it is the only spare slab of the class.
+ *
+ * All functions accept a NULL pool. In this case, objects are allocated directly on the heap.
+ * @{
+ */
+
+/** Size of a slab (must be a power of 2)                                                        */
+#define POOL_SLAB_SIZE (32768U)
+
+/** Classes of objects allocated from a pool */
+enum pool_class {
+    POOL_SNAPSHOT,      /**< Snapshot (struct fds_tsnapshot)          */
+    POOL_L1_TABLE,      /**< Snapshot L1 table                        */
+    POOL_L2_NODE,       /**< Snapshot L2 node                         */
+    POOL_L2_TABLE,      /**< Snapshot L2 table                        */
+    POOL_CLASS_CNT      /**< Number of classes (not a valid class)    */
+};
+
+/**
+ * \brief Allocate an object from a pool
+ *
+ * \note The content of the object is undefined. See pool_calloc().
+ * \param[in] pool Pool (can be NULL)
+ * \param[in] cls  Class of the object
+ * \return Pointer or NULL (memory allocation error or the limit of the pool has been reached)
+ */
+void *
+pool_alloc(fds_tpool_t *pool, enum pool_class cls);
+
+/**
+ * \brief Return an object to a pool
+ *
+ * If the pool has been already destroyed by its user and this is the last object of the pool,
+ * the pool is freed.
+ * \param[in] pool Pool (must be the same as used for the allocation)
+ * \param[in] cls  Class of the object (must be the same as used for the allocation)
+ * \param[in] ptr  Object (can be NULL)
+ */
+void
+pool_free(fds_tpool_t *pool, enum pool_class cls, void *ptr);
+
+/**
+ * \brief Get the size of an object of a class
+ * \param[in] cls Class of the object
+ * \return Size in bytes
+ */
+size_t
+pool_obj_size(enum pool_class cls);
+
+/**
+ * \brief Allocate a zeroed object from a pool
+ * \param[in] pool Pool (can be NULL)
+ * \param[in] cls  Class of the object
+ * \return Pointer or NULL (memory allocation error or the limit of the pool has been reached)
+ */
+static inline void *
+pool_calloc(fds_tpool_t *pool, enum pool_class cls)
+{
+    void *ptr = pool_alloc(pool, cls);
+    if (ptr) {
+        memset(ptr, 0, pool_obj_size(cls));
+    }
+    return ptr;
+}
+
+/**
+ * \brief Add a reference to a pool (e.g. a template manager that uses the pool)
+ * \param[in] pool Pool (can be NULL)
+ */
+void
+pool_acquire(fds_tpool_t *pool);
+
+/**
+ * \brief Remove a reference to a pool
+ *
+ * The pool is freed when there are no references and all its objects have been freed.
+ * \param[in] pool Pool (can be NULL)
+ */
+void
+pool_release(fds_tpool_t *pool);
+
+/** @} */ // end of the group
+
+#endif // POOL_H
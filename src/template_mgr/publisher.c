@@ -0,0 +1,332 @@
+/**
+ * \file src/template_mgr/publisher.c
+ * \author agent <agent@local>
+ * \brief Lock-free publication of template snapshots (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libfds.h>
+#include "garbage.h"
+#include "reclaim.h"
+
+/** Epoch value of offline (or unregistered) readers                        */
+#define TPUB_EPOCH_OFFLINE UINT64_MAX
+/** Expected size of a cache line (to avoid false sharing between readers) */
+#define TPUB_CACHE_LINE    64U
+/** Default number of pre-allocated records of retired garbage              */
+#define TPUB_RETIRED_DEF   8U
+
+/** Reader of published snapshots */
+struct fds_tpub_reader {
+    /** The last observed epoch (#TPUB_EPOCH_OFFLINE if offline or unused)  */
+    _Atomic uint64_t epoch;
+    /** Parent publisher                                                    */
+    struct fds_tpub *pub;
+    /** Is the slot used by a registered reader                             */
+    atomic_bool used;
+    /** Padding to fill the whole cache line                                */
+    uint8_t _pad[TPUB_CACHE_LINE - sizeof(_Atomic uint64_t) - sizeof(struct fds_tpub *)
+        - sizeof(atomic_bool)];
+};
+
+static_assert(sizeof(struct fds_tpub_reader) == TPUB_CACHE_LINE, "Unexpected reader size");
+
+/** Retired garbage waiting for destruction */
+struct tpub_retired {
+    /** Garbage                                                             */
+    fds_tgarbage_t *gc;
+    /** Epoch that all online readers must reach before destruction         */
+    uint64_t epoch;
+};
+
+/** Snapshot publisher */
+struct fds_tpub {
+    /** Published snapshot (can be NULL)                                    */
+    _Atomic(const fds_tsnapshot_t *) snap;
+    /** Global epoch                                                        */
+    _Atomic uint64_t epoch;
+
+    /** Retired garbage (sorted by epoch in ascending order)                */
+    struct {
+        /** Number of valid records                                         */
+        size_t cnt_used;
+        /** Number of pre-allocated records                                 */
+        size_t cnt_alloc;
+        /** Array of records                                                */
+        struct tpub_retired *array;
+    } retired;
+
+    /** Reclamation service of retired garbage (can be NULL)                */
+    fds_tgc_t *tgc;
+
+    /** Number of reader slots                                              */
+    uint16_t readers_max;
+    /** Array of reader slots                                               */
+    struct fds_tpub_reader *readers;
+};
+
+fds_tpub_t *
+fds_tpub_create(uint16_t readers_max)
+{
+    if (readers_max == 0) {
+        return NULL;
+    }
+
+    struct fds_tpub *pub = calloc(1, sizeof(*pub));
+    if (!pub) {
+        return NULL;
+    }
+
+    pub->readers = calloc(readers_max, sizeof(*pub->readers));
+    pub->retired.array = malloc(TPUB_RETIRED_DEF * sizeof(*pub->retired.array));
+    if (!pub->readers || !pub->retired.array) {
+        free(pub->readers);
+        free(pub->retired.array);
+        free(pub);
+        return NULL;
+    }
+
+    pub->readers_max = readers_max;
+    pub->retired.cnt_alloc = TPUB_RETIRED_DEF;
+    for (uint16_t i = 0; i < readers_max; ++i) {
+        struct fds_tpub_reader *reader = &pub->readers[i];
+        atomic_init(&reader->epoch, TPUB_EPOCH_OFFLINE);
+        atomic_init(&reader->used, false);
+        reader->pub = pub;
+    }
+
+    atomic_init(&pub->snap, NULL);
+    atomic_init(&pub->epoch, 1U);
+    return pub;
+}
+
+void
+fds_tpub_destroy(fds_tpub_t *pub)
+{
+    if (pub->tgc != NULL) {
+        // Garbage handed over to the service refers to this publisher
+        tgc_flush_pub(pub->tgc, pub);
+    }
+
+    for (size_t i = 0; i < pub->retired.cnt_used; ++i) {
+        garbage_destroy(pub->retired.array[i].gc);
+    }
+
+    free(pub->retired.array);
+    free(pub->readers);
+    free(pub);
+}
+
+uint64_t
+tpub_epoch_min(const struct fds_tpub *pub)
+{
+    uint64_t result = TPUB_EPOCH_OFFLINE;
+    for (uint16_t i = 0; i < pub->readers_max; ++i) {
+        // Unused slots are always offline, therefore, the "used" flag is not checked
+        const uint64_t epoch = atomic_load(&pub->readers[i].epoch);
+        if (epoch < result) {
+            result = epoch;
+        }
+    }
+
+    return result;
+}
+
+size_t
+fds_tpub_reclaim(fds_tpub_t *pub)
+{
+    if (pub->retired.cnt_used == 0) {
+        return 0;
+    }
+
+    const uint64_t epoch_min = tpub_epoch_min(pub);
+    size_t idx;
+    for (idx = 0; idx < pub->retired.cnt_used; ++idx) {
+        struct tpub_retired *rec = &pub->retired.array[idx];
+        if (rec->epoch > epoch_min) {
+            // Records are sorted by epoch -> the rest cannot be destroyed yet
+            break;
+        }
+
+        garbage_destroy(rec->gc);
+    }
+
+    if (idx == 0) {
+        return pub->retired.cnt_used;
+    }
+
+    pub->retired.cnt_used -= idx;
+    memmove(&pub->retired.array[0], &pub->retired.array[idx],
+        pub->retired.cnt_used * sizeof(*pub->retired.array));
+    return pub->retired.cnt_used;
+}
+
+/**
+ * \brief Make sure that there is a free record for retired garbage
+ * \param[in] pub Publisher
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+tpub_retired_reserve(struct fds_tpub *pub)
+{
+    if (pub->retired.cnt_used < pub->retired.cnt_alloc) {
+        return FDS_OK;
+    }
+
+    const size_t new_alloc = 2 * pub->retired.cnt_alloc;
+    struct tpub_retired *new_array;
+    new_array = realloc(pub->retired.array, new_alloc * sizeof(*new_array));
+    if (!new_array) {
+        return FDS_ERR_NOMEM;
+    }
+
+    pub->retired.array = new_array;
+    pub->retired.cnt_alloc = new_alloc;
+    return FDS_OK;
+}
+
+int
+fds_tpub_update(fds_tpub_t *pub, fds_tmgr_t *tmgr)
+{
+    // Reserve space for garbage first so it cannot be lost later
+    int ret_code = tpub_retired_reserve(pub);
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+
+    // Collect garbage (it also removes old snapshots from the manager)
+    fds_tgarbage_t *gc = NULL;
+    if ((ret_code = fds_tmgr_garbage_get(tmgr, &gc)) != FDS_OK) {
+        return ret_code;
+    }
+
+    const fds_tsnapshot_t *snap;
+    if ((ret_code = fds_tmgr_snapshot_get(tmgr, &snap)) != FDS_OK) {
+        // The previously published snapshot might be part of the garbage -> withdraw it
+        snap = NULL;
+    }
+
+    const fds_tsnapshot_t *snap_old = atomic_load_explicit(&pub->snap, memory_order_relaxed);
+    if (gc != NULL || snap != snap_old) {
+        // Publish the snapshot and start a new epoch
+        atomic_store(&pub->snap, snap);
+        const uint64_t epoch = atomic_fetch_add(&pub->epoch, 1U) + 1U;
+
+        if (gc != NULL && pub->tgc != NULL
+                && tgc_retire(pub->tgc, gc, pub, epoch) == FDS_OK) {
+            // The garbage will be destroyed by the reclamation service
+            gc = NULL;
+        }
+
+        if (gc != NULL) {
+            // Destroy the garbage later (also if the queue of the service is full)
+            struct tpub_retired *rec = &pub->retired.array[pub->retired.cnt_used++];
+            rec->gc = gc;
+            rec->epoch = epoch;
+        }
+    }
+
+    fds_tpub_reclaim(pub);
+    return ret_code;
+}
+
+void
+fds_tpub_set_tgc(fds_tpub_t *pub, fds_tgc_t *tgc)
+{
+    if (pub->tgc != NULL && pub->tgc != tgc) {
+        // Garbage handed over to the previous service refers to this publisher
+        tgc_flush_pub(pub->tgc, pub);
+    }
+
+    pub->tgc = tgc;
+}
+
+fds_tpub_reader_t *
+fds_tpub_reader_register(fds_tpub_t *pub)
+{
+    for (uint16_t i = 0; i < pub->readers_max; ++i) {
+        struct fds_tpub_reader *reader = &pub->readers[i];
+        bool expected = false;
+        if (atomic_load_explicit(&reader->used, memory_order_relaxed)
+                || !atomic_compare_exchange_strong(&reader->used, &expected, true)) {
+            continue;
+        }
+
+        fds_tpub_reader_online(reader);
+        return reader;
+    }
+
+    return NULL;
+}
+
+void
+fds_tpub_reader_unregister(fds_tpub_reader_t *reader)
+{
+    fds_tpub_reader_offline(reader);
+    atomic_store(&reader->used, false);
+}
+
+const fds_tsnapshot_t *
+fds_tpub_reader_get(const fds_tpub_reader_t *reader)
+{
+    // Sequentially consistent load cannot be reordered before the announcement of the epoch
+    return atomic_load(&reader->pub->snap);
+}
+
+void
+fds_tpub_reader_quiescent(fds_tpub_reader_t *reader)
+{
+    atomic_store(&reader->epoch, atomic_load(&reader->pub->epoch));
+}
+
+void
+fds_tpub_reader_offline(fds_tpub_reader_t *reader)
+{
+    atomic_store(&reader->epoch, TPUB_EPOCH_OFFLINE);
+}
+
+void
+fds_tpub_reader_online(fds_tpub_reader_t *reader)
+{
+    atomic_store(&reader->epoch, atomic_load(&reader->pub->epoch));
+}
@@ -0,0 +1,421 @@
+/**
+ * \file src/template_mgr/reclaim.c
+ * \author agent <agent@local>
+ * \brief Background reclamation of template manager garbage (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <libfds.h>
+#include "garbage.h"
+#include "reclaim.h"
+
+/** Initial interval of checking epochs of readers if all garbage is deferred (nanoseconds) */
+#define TGC_POLL_MIN 1000000L
+/** Maximum interval of checking epochs of readers (nanoseconds)                            */
+#define TGC_POLL_MAX 64000000L
+
+/** Garbage waiting in the queue */
+struct tgc_rec {
+    /** Garbage                                                             */
+    fds_tgarbage_t *gc;
+    /** Publisher of the snapshots (NULL if no reader can hold the garbage) */
+    const fds_tpub_t *pub;
+    /** Epoch that all online readers of the publisher must reach           */
+    uint64_t epoch;
+    /** Time of insertion into the queue (monotonic clock, nanoseconds)     */
+    uint64_t time;
+};
+
+/** Reclamation service */
+struct fds_tgc {
+    /** Worker thread                                                       */
+    pthread_t thread;
+    /** Mutex protecting all following members                              */
+    pthread_mutex_t lock;
+    /** Condition signalled when garbage is added or the service stops      */
+    pthread_cond_t cond_push;
+    /** Condition signalled when garbage is destroyed or the queue is empty */
+    pthread_cond_t cond_done;
+    /** Stop request                                                        */
+    bool stop;
+    /** The worker is destroying garbage removed from the queue             */
+    bool busy;
+    /** Publisher of the garbage that is being destroyed (if busy)          */
+    const fds_tpub_t *busy_pub;
+    /** Current interval of checking epochs of readers (nanoseconds)        */
+    long poll_interval;
+
+    /** Queue of garbage (circular buffer)                                  */
+    struct {
+        /** Array of records                                                */
+        struct tgc_rec *array;
+        /** Capacity of the array                                           */
+        size_t size;
+        /** Index of the oldest record                                      */
+        size_t head;
+        /** Number of valid records                                         */
+        size_t cnt;
+    } queue;
+
+    /** Statistics                                                          */
+    struct fds_tgc_stats stats;
+    /** Total reclaim latency (nanoseconds)                                 */
+    uint64_t latency_sum;
+};
+
+/**
+ * \brief Get the current value of the monotonic clock
+ * \return Time in nanoseconds
+ */
+static uint64_t
+tgc_time_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * \brief Wait for new garbage or an interval of checking epochs
+ *
+ * The interval is doubled after each call (up to #TGC_POLL_MAX), so readers that are stalled
+ * for a long time are not checked too often.
+ * \note The lock must be held by the caller.
+ * \param[in] tgc Reclamation service
+ */
+static void
+tgc_wait_poll(struct fds_tgc *tgc)
+{
+    // Condition variables use the realtime clock by default
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += tgc->poll_interval;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    if (tgc->poll_interval < TGC_POLL_MAX) {
+        tgc->poll_interval *= 2;
+    }
+
+    pthread_cond_timedwait(&tgc->cond_push, &tgc->lock, &ts);
+}
+
+/**
+ * \brief Find the oldest garbage in the queue that can be destroyed
+ *
+ * Garbage that can be still held by a reader is skipped. Garbage of a publisher is retired
+ * with increasing epochs, therefore, if garbage of a publisher is deferred, all its newer garbage
+ * is deferred too.
+ * \note The lock must be held by the caller.
+ * \param[in] tgc Reclamation service
+ * \return Position of the garbage relative to the head of the queue. If there is no such
+ *   garbage, returns the number of records in the queue.
+ */
+static size_t
+tgc_find_ready(const struct fds_tgc *tgc)
+{
+    const fds_tpub_t *deferred = NULL;
+    for (size_t i = 0; i < tgc->queue.cnt; ++i) {
+        const struct tgc_rec *rec = &tgc->queue.array[(tgc->queue.head + i) % tgc->queue.size];
+        if (tgc->stop || rec->pub == NULL) {
+            return i;
+        }
+
+        if (rec->pub == deferred) {
+            continue;
+        }
+
+        if (tpub_epoch_min(rec->pub) >= rec->epoch) {
+            return i;
+        }
+
+        // Some readers can still hold the garbage
+        deferred = rec->pub;
+    }
+
+    return tgc->queue.cnt;
+}
+
+/**
+ * \brief Remove a record from the queue
+ *
+ * Older records are moved by one position, so the order of the remaining records is preserved.
+ * \note The lock must be held by the caller.
+ * \param[in] tgc Reclamation service
+ * \param[in] pos Position of the record relative to the head of the queue
+ * \return The removed record
+ */
+static struct tgc_rec
+tgc_remove(struct fds_tgc *tgc, size_t pos)
+{
+    const size_t size = tgc->queue.size;
+    const size_t head = tgc->queue.head;
+    const struct tgc_rec rec = tgc->queue.array[(head + pos) % size];
+    for (size_t i = pos; i > 0; --i) {
+        tgc->queue.array[(head + i) % size] = tgc->queue.array[(head + i - 1) % size];
+    }
+
+    tgc->queue.head = (head + 1) % size;
+    tgc->queue.cnt--;
+    return rec;
+}
+
+/**
+ * \brief Main function of the worker thread
+ *
+ * Garbage is destroyed in the order of insertion, however, garbage that can be still held by
+ * a reader is skipped until all readers of its publisher pass a quiescent point. If all garbage
+ * is deferred, the worker checks epochs of the readers with increasing intervals. After a stop
+ * request, the remaining garbage is destroyed immediately.
+ * \param[in] arg Reclamation service
+ * \return Always NULL
+ */
+static void *
+tgc_worker(void *arg)
+{
+    struct fds_tgc *tgc = arg;
+    pthread_mutex_lock(&tgc->lock);
+
+    while (true) {
+        if (tgc->queue.cnt == 0) {
+            pthread_cond_broadcast(&tgc->cond_done);
+            if (tgc->stop) {
+                break;
+            }
+
+            tgc->poll_interval = TGC_POLL_MIN;
+            pthread_cond_wait(&tgc->cond_push, &tgc->lock);
+            continue;
+        }
+
+        const size_t pos = tgc_find_ready(tgc);
+        if (pos == tgc->queue.cnt) {
+            // All garbage is deferred
+            tgc_wait_poll(tgc);
+            continue;
+        }
+
+        const struct tgc_rec rec = tgc_remove(tgc, pos);
+        tgc->busy = true;
+        tgc->busy_pub = rec.pub;
+        tgc->poll_interval = TGC_POLL_MIN;
+
+        // Destroy the garbage without holding the lock
+        pthread_mutex_unlock(&tgc->lock);
+        garbage_destroy(rec.gc);
+        const uint64_t latency = tgc_time_now() - rec.time;
+        pthread_mutex_lock(&tgc->lock);
+
+        tgc->busy = false;
+        tgc->busy_pub = NULL;
+        tgc->stats.reclaimed++;
+        tgc->latency_sum += latency;
+        if (latency > tgc->stats.latency_max) {
+            tgc->stats.latency_max = latency;
+        }
+        pthread_cond_broadcast(&tgc->cond_done);
+    }
+
+    pthread_mutex_unlock(&tgc->lock);
+    return NULL;
+}
+
+fds_tgc_t *
+fds_tgc_create(size_t queue_size)
+{
+    if (queue_size == 0) {
+        return NULL;
+    }
+
+    struct fds_tgc *tgc = calloc(1, sizeof(*tgc));
+    if (!tgc) {
+        return NULL;
+    }
+
+    tgc->queue.array = malloc(queue_size * sizeof(*tgc->queue.array));
+    if (!tgc->queue.array) {
+        free(tgc);
+        return NULL;
+    }
+    tgc->queue.size = queue_size;
+    tgc->poll_interval = TGC_POLL_MIN;
+
+    if (pthread_mutex_init(&tgc->lock, NULL) != 0) {
+        goto err_lock;
+    }
+    if (pthread_cond_init(&tgc->cond_push, NULL) != 0) {
+        goto err_push;
+    }
+    if (pthread_cond_init(&tgc->cond_done, NULL) != 0) {
+        goto err_done;
+    }
+    if (pthread_create(&tgc->thread, NULL, &tgc_worker, tgc) != 0) {
+        goto err_thread;
+    }
+
+    return tgc;
+
+err_thread:
+    pthread_cond_destroy(&tgc->cond_done);
+err_done:
+    pthread_cond_destroy(&tgc->cond_push);
+err_push:
+    pthread_mutex_destroy(&tgc->lock);
+err_lock:
+    free(tgc->queue.array);
+    free(tgc);
+    return NULL;
+}
+
+void
+fds_tgc_destroy(fds_tgc_t *tgc)
+{
+    pthread_mutex_lock(&tgc->lock);
+    tgc->stop = true;
+    pthread_cond_signal(&tgc->cond_push);
+    pthread_mutex_unlock(&tgc->lock);
+
+    // The worker destroys all remaining garbage before it ends
+    pthread_join(tgc->thread, NULL);
+
+    pthread_cond_destroy(&tgc->cond_done);
+    pthread_cond_destroy(&tgc->cond_push);
+    pthread_mutex_destroy(&tgc->lock);
+    free(tgc->queue.array);
+    free(tgc);
+}
+
+int
+tgc_retire(fds_tgc_t *tgc, fds_tgarbage_t *gc, const fds_tpub_t *pub, uint64_t epoch)
+{
+    if (!gc) {
+        return FDS_OK;
+    }
+
+    const uint64_t now = tgc_time_now();
+    pthread_mutex_lock(&tgc->lock);
+    if (tgc->queue.cnt == tgc->queue.size) {
+        tgc->stats.rejected++;
+        pthread_mutex_unlock(&tgc->lock);
+        return FDS_ERR_DENIED;
+    }
+
+    const size_t idx = (tgc->queue.head + tgc->queue.cnt) % tgc->queue.size;
+    tgc->queue.array[idx] = (struct tgc_rec) {gc, pub, epoch, now};
+    tgc->queue.cnt++;
+    tgc->stats.pushed++;
+    if (tgc->queue.cnt > tgc->stats.queue_peak) {
+        tgc->stats.queue_peak = tgc->queue.cnt;
+    }
+
+    pthread_cond_signal(&tgc->cond_push);
+    pthread_mutex_unlock(&tgc->lock);
+    return FDS_OK;
+}
+
+int
+fds_tgc_push(fds_tgc_t *tgc, fds_tgarbage_t *gc)
+{
+    return tgc_retire(tgc, gc, NULL, 0);
+}
+
+void
+fds_tgc_flush(fds_tgc_t *tgc)
+{
+    pthread_mutex_lock(&tgc->lock);
+    while (tgc->queue.cnt != 0 || tgc->busy) {
+        pthread_cond_wait(&tgc->cond_done, &tgc->lock);
+    }
+    pthread_mutex_unlock(&tgc->lock);
+}
+
+/**
+ * \brief Check if there is garbage of a publisher in the queue or being destroyed
+ * \note The lock must be held by the caller.
+ * \param[in] tgc Reclamation service
+ * \param[in] pub Publisher
+ * \return True or false
+ */
+static bool
+tgc_has_pub(const struct fds_tgc *tgc, const fds_tpub_t *pub)
+{
+    if (tgc->busy && tgc->busy_pub == pub) {
+        return true;
+    }
+
+    for (size_t i = 0; i < tgc->queue.cnt; ++i) {
+        if (tgc->queue.array[(tgc->queue.head + i) % tgc->queue.size].pub == pub) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+tgc_flush_pub(fds_tgc_t *tgc, const fds_tpub_t *pub)
+{
+    pthread_mutex_lock(&tgc->lock);
+    if (tgc_has_pub(tgc, pub)) {
+        // Readers of the publisher might be already offline -> check epochs again immediately
+        tgc->poll_interval = TGC_POLL_MIN;
+        pthread_cond_signal(&tgc->cond_push);
+    }
+
+    while (tgc_has_pub(tgc, pub)) {
+        pthread_cond_wait(&tgc->cond_done, &tgc->lock);
+    }
+    pthread_mutex_unlock(&tgc->lock);
+}
+
+void
+fds_tgc_stats(fds_tgc_t *tgc, struct fds_tgc_stats *stats)
+{
+    pthread_mutex_lock(&tgc->lock);
+    *stats = tgc->stats;
+    stats->queue_depth = tgc->queue.cnt;
+    stats->latency_avg = (tgc->stats.reclaimed != 0)
+        ? tgc->latency_sum / tgc->stats.reclaimed : 0;
+    pthread_mutex_unlock(&tgc->lock);
+}
@@ -0,0 +1,94 @@
+/**
+ * \file src/template_mgr/reclaim.h
+ * \author agent <agent@local>
+ * \brief Background reclamation of template manager garbage (internal header file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#ifndef RECLAIM_H
+#define RECLAIM_H
+
+#include <stdint.h>
+#include <libfds.h>
+
+/**
+ * \defgroup reclaim_aux_func Background reclamation of garbage
+ * \ingroup template_manager
+ *
+ * \brief Interface between snapshot publishers and the reclamation service
+ * @{
+ */
+
+/**
+ * \brief Hand over garbage retired by a publisher to a reclamation service
+ *
+ * The garbage is destroyed as soon as all online readers of the publisher have reached the
+ * given epoch (see tpub_epoch_min()).
+ * \param[in] tgc   Reclamation service
+ * \param[in] gc    Garbage
+ * \param[in] pub   Publisher (can be NULL, i.e. the garbage is not referenced by any reader)
+ * \param[in] epoch Epoch of retirement
+ * \return On success returns #FDS_OK and the service takes ownership of the garbage.
+ *   If the queue of the service is full, returns #FDS_ERR_DENIED and the garbage is not
+ *   modified.
+ */
+int
+tgc_retire(fds_tgc_t *tgc, fds_tgarbage_t *gc, const fds_tpub_t *pub, uint64_t epoch);
+
+/**
+ * \brief Wait until all garbage retired by a publisher has been destroyed
+ *
+ * Garbage of other publishers that use the same service is not waited for.
+ * \note Thread-safe
+ * \param[in] tgc Reclamation service
+ * \param[in] pub Publisher
+ */
+void
+tgc_flush_pub(fds_tgc_t *tgc, const fds_tpub_t *pub);
+
+/**
+ * \brief Get the lowest epoch observed by online readers of a publisher
+ * \note Thread-safe
+ * \param[in] pub Publisher
+ * \return Epoch (UINT64_MAX if there are no online readers)
+ */
+uint64_t
+tpub_epoch_min(const fds_tpub_t *pub);
+
+/** @} */ // end of the group
+
+#endif // RECLAIM_H
@@ -0,0 +1,118 @@
+/**
+ * \file src/template_mgr/refresh.c
+ * \author agent <agent@local>
+ * \brief Timestamps of refreshed templates (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <libfds.h>
+#include "refresh.h"
+
+/** Size of L1 and L2 tables */
+#define REFRESH_TABLE_SIZE 256U
+
+void
+refresh_clear(struct refresh_tab *tab)
+{
+    if (!tab->l1) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < REFRESH_TABLE_SIZE; ++i) {
+        free(tab->l1[i]);
+    }
+
+    free(tab->l1);
+    tab->l1 = NULL;
+}
+
+int
+refresh_set(struct refresh_tab *tab, const struct fds_template *tmplt, uint32_t last_seen,
+    uint32_t end_of_life)
+{
+    const uint16_t l1_idx = tmplt->id / REFRESH_TABLE_SIZE;
+    const uint16_t l2_idx = tmplt->id % REFRESH_TABLE_SIZE;
+
+    if (!tab->l1) {
+        tab->l1 = calloc(REFRESH_TABLE_SIZE, sizeof(*tab->l1));
+        if (!tab->l1) {
+            return FDS_ERR_NOMEM;
+        }
+    }
+
+    struct refresh_rec *l2 = tab->l1[l1_idx];
+    if (!l2) {
+        l2 = calloc(REFRESH_TABLE_SIZE, sizeof(*l2));
+        if (!l2) {
+            return FDS_ERR_NOMEM;
+        }
+        tab->l1[l1_idx] = l2;
+    }
+
+    struct refresh_rec *rec = &l2[l2_idx];
+    rec->ptr = tmplt;
+    rec->last_seen = last_seen;
+    rec->end_of_life = end_of_life;
+    return FDS_OK;
+}
+
+const struct refresh_rec *
+refresh_find(const struct refresh_tab *tab, const struct fds_template *tmplt)
+{
+    if (!tab->l1) {
+        return NULL;
+    }
+
+    const struct refresh_rec *l2 = tab->l1[tmplt->id / REFRESH_TABLE_SIZE];
+    if (!l2) {
+        return NULL;
+    }
+
+    const struct refresh_rec *rec = &l2[tmplt->id % REFRESH_TABLE_SIZE];
+    return (rec->ptr == tmplt) ? rec : NULL;
+}
+
+void
+refresh_forget(struct refresh_tab *tab, const struct fds_template *tmplt)
+{
+    struct refresh_rec *rec = (struct refresh_rec *) refresh_find(tab, tmplt);
+    if (rec != NULL) {
+        rec->ptr = NULL;
+    }
+}
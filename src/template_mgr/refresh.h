@@ -0,0 +1,129 @@
+/**
+ * \file src/template_mgr/refresh.h
+ * \author agent <agent@local>
+ * \brief Timestamps of refreshed templates (internal header file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#ifndef REFRESH_H
+#define REFRESH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <libfds.h>
+
+/**
+ * \defgroup refresh_aux_func Timestamps of refreshed templates
+ * \ingroup template_manager
+ *
+ * \brief Side table of the last refresh of templates
+ *
+ * Templates that are part of a template manager are never modified because they might be shared
+ * by snapshots and readers. If exactly the same template is received again, only its refresh
+ * timestamps (i.e. the time of the last refresh and the new end of life) are stored in this
+ * table. A record refers to the template by its address and its Template ID, therefore, it
+ * is valid only for this particular template. Other templates with the same ID (e.g. older
+ * or newer definitions) keep their own timestamps.
+ *
+ * The table is organized as an L1 table of 256 pointers to L2 tables of 256 records (see
+ * \ref snapshot_aux_func). Tables are allocated on demand and never freed until the table is
+ * cleared, so a repeated refresh doesn't allocate any memory.
+ * @{
+ */
+
+/** Refresh timestamps of a template */
+struct refresh_rec {
+    /** Refreshed template (address only, NULL == unused)   */
+    const struct fds_template *ptr;
+    /** Export Time of the last refresh                      */
+    uint32_t last_seen;
+    /** End of life after the last refresh                   */
+    uint32_t end_of_life;
+};
+
+/** Table of refreshed templates (zeroed structure is an empty table) */
+struct refresh_tab {
+    /** L1 table i.e. array of pointers to L2 tables (NULL == not allocated yet) */
+    struct refresh_rec **l1;
+};
+
+/**
+ * \brief Remove all records and free the table
+ * \param[in] tab Table
+ */
+void
+refresh_clear(struct refresh_tab *tab);
+
+/**
+ * \brief Store refresh timestamps of a template
+ *
+ * A previous record of a template with the same ID is replaced.
+ * \param[in] tab         Table
+ * \param[in] tmplt       Refreshed template
+ * \param[in] last_seen   Export Time of the refresh
+ * \param[in] end_of_life End of life of the template
+ * \return #FDS_OK or #FDS_ERR_NOMEM (the table is unchanged)
+ */
+int
+refresh_set(struct refresh_tab *tab, const struct fds_template *tmplt, uint32_t last_seen,
+    uint32_t end_of_life);
+
+/**
+ * \brief Find refresh timestamps of a template
+ * \param[in] tab   Table
+ * \param[in] tmplt Template
+ * \return Pointer to the record or NULL (the template hasn't been refreshed)
+ */
+const struct refresh_rec *
+refresh_find(const struct refresh_tab *tab, const struct fds_template *tmplt);
+
+/**
+ * \brief Remove a record of a template (if any)
+ *
+ * Must be called before a new template is inserted into a manager, because it might have
+ * the same address as a previously destroyed template with the same ID.
+ * \param[in] tab   Table
+ * \param[in] tmplt Template
+ */
+void
+refresh_forget(struct refresh_tab *tab, const struct fds_template *tmplt);
+
+/**
+ * @}
+ */
+
+#endif // REFRESH_H
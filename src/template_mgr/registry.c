@@ -0,0 +1,699 @@
+/**
+ * \file src/template_mgr/registry.c
+ * \author agent <agent@local>
+ * \brief Registry of template managers of multiple sessions (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <arpa/inet.h> // htonl, ntohl
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libfds.h>
+
+#include "garbage.h"
+
+/** Default number of buckets of the hash table (must be a power of 2)                         */
+#define TREG_BUCKETS_DEF 64U
+/** Number of slots of the timer wheel (must be a power of 2)                                 */
+#define TREG_WHEEL_SIZE  256U
+/** Magic number of a file with a state of a registry ("FDSR")                               */
+#define TREG_FILE_MAGIC  0x46445352U
+/** Version of the file format                                                                 */
+#define TREG_FILE_VERSION 1U
+
+/** Registered session */
+struct treg_entry {
+    /** Session ID                                                         */
+    uint64_t id;
+    /** Template manager of the session                                    */
+    fds_tmgr_t *tmgr;
+    /** Session type                                                       */
+    enum fds_session_type type;
+    /** Time of the last access of the session                            */
+    uint32_t last_active;
+
+    /** Next entry in the same bucket of the hash table                   */
+    struct treg_entry *bucket_next;
+    /** Previous entry in the same slot of the timer wheel                */
+    struct treg_entry *wheel_prev;
+    /** Next entry in the same slot of the timer wheel                    */
+    struct treg_entry *wheel_next;
+    /** Slot of the timer wheel                                            */
+    uint32_t wheel_slot;
+
+    /** Previous entry in the list of accessed sessions                   */
+    struct treg_entry *dirty_prev;
+    /** Next entry in the list of accessed sessions                       */
+    struct treg_entry *dirty_next;
+    /** The entry is in the list of accessed sessions                     */
+    bool dirty;
+};
+
+/** Registry of template managers */
+struct fds_treg {
+    /** Pool allocator of all managers (can be NULL)                       */
+    fds_tpool_t *pool;
+    /** IE manager of all managers (can be NULL)                           */
+    const fds_iemgr_t *iemgr;
+    /** Current time                                                       */
+    uint32_t now;
+
+    struct {
+        /** Array of buckets                                               */
+        struct treg_entry **items;
+        /** Mask of the bucket index (number of buckets - 1)               */
+        uint64_t mask;
+        /** Number of registered sessions                                  */
+        uint32_t cnt;
+    } table; /**< Hash table of sessions                                   */
+
+    struct {
+        /** Slots (lists of sessions that expire in the same tick)        */
+        struct treg_entry *slots[TREG_WHEEL_SIZE];
+        /** Idle timeout of sessions (0 == disabled)                       */
+        uint32_t timeout;
+        /** Length of a tick (in seconds)                                  */
+        uint32_t tick;
+        /** The last processed tick                                        */
+        uint32_t tick_last;
+    } wheel; /**< Timer wheel of idle sessions                            */
+
+    /** Sessions accessed since the last garbage collection                */
+    struct treg_entry *dirty;
+    /** Garbage of removed sessions and of accessed sessions               */
+    fds_tgarbage_t *garbage;
+};
+
+/**
+ * \brief Hash function of a session ID (SplitMix64 finalizer)
+ * \param[in] id Session ID
+ * \return Hash value
+ */
+static inline uint64_t
+treg_hash(uint64_t id)
+{
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ULL;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebULL;
+    id ^= id >> 31;
+    return id;
+}
+
+/**
+ * \brief Find a session in the hash table
+ * \param[in] reg Registry
+ * \param[in] id  Session ID
+ * \return Pointer to the entry or NULL
+ */
+static struct treg_entry *
+treg_table_find(const struct fds_treg *reg, uint64_t id)
+{
+    struct treg_entry *entry = reg->table.items[treg_hash(id) & reg->table.mask];
+    while (entry && entry->id != id) {
+        entry = entry->bucket_next;
+    }
+    return entry;
+}
+
+/**
+ * \brief Double the number of buckets of the hash table
+ *
+ * If the memory allocation fails, the table is kept as is (i.e. only the lookup is slower).
+ * \param[in] reg Registry
+ */
+static void
+treg_table_grow(struct fds_treg *reg)
+{
+    const uint64_t old_cnt = reg->table.mask + 1U;
+    struct treg_entry **new_items = calloc(2U * old_cnt, sizeof(*new_items));
+    if (!new_items) {
+        return;
+    }
+
+    const uint64_t new_mask = (2U * old_cnt) - 1U;
+    for (uint64_t i = 0; i < old_cnt; ++i) {
+        struct treg_entry *entry = reg->table.items[i];
+        while (entry) {
+            struct treg_entry *next = entry->bucket_next;
+            struct treg_entry **bucket = &new_items[treg_hash(entry->id) & new_mask];
+            entry->bucket_next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+
+    free(reg->table.items);
+    reg->table.items = new_items;
+    reg->table.mask = new_mask;
+}
+
+/**
+ * \brief Remove a session from the hash table
+ * \param[in] reg   Registry
+ * \param[in] entry Session
+ */
+static void
+treg_table_remove(struct fds_treg *reg, struct treg_entry *entry)
+{
+    struct treg_entry **ptr = &reg->table.items[treg_hash(entry->id) & reg->table.mask];
+    while (*ptr != entry) {
+        assert(*ptr != NULL);
+        ptr = &(*ptr)->bucket_next;
+    }
+
+    *ptr = entry->bucket_next;
+    reg->table.cnt--;
+}
+
+/**
+ * \brief Get the first tick when a session can be expired
+ *
+ * If the session should have been already expired (e.g. the timeout has been shortened),
+ * the next unprocessed tick is returned.
+ * \param[in] reg   Registry
+ * \param[in] entry Session
+ * \return Tick
+ */
+static inline uint32_t
+treg_wheel_tick(const struct fds_treg *reg, const struct treg_entry *entry)
+{
+    const uint64_t expire = (uint64_t) entry->last_active + reg->wheel.timeout;
+    const uint32_t tick = (uint32_t) ((expire + reg->wheel.tick - 1U) / reg->wheel.tick);
+    return (tick > reg->wheel.tick_last) ? tick : reg->wheel.tick_last + 1U;
+}
+
+/**
+ * \brief Insert a session into the timer wheel (based on the time of its last access)
+ * \param[in] reg   Registry
+ * \param[in] entry Session (must not be in the wheel)
+ */
+static void
+treg_wheel_insert(struct fds_treg *reg, struct treg_entry *entry)
+{
+    const uint32_t slot = treg_wheel_tick(reg, entry) & (TREG_WHEEL_SIZE - 1U);
+    struct treg_entry *head = reg->wheel.slots[slot];
+
+    entry->wheel_slot = slot;
+    entry->wheel_prev = NULL;
+    entry->wheel_next = head;
+    if (head) {
+        head->wheel_prev = entry;
+    }
+    reg->wheel.slots[slot] = entry;
+}
+
+/**
+ * \brief Remove a session from the timer wheel
+ * \param[in] reg   Registry
+ * \param[in] entry Session (must be in the wheel)
+ */
+static void
+treg_wheel_remove(struct fds_treg *reg, struct treg_entry *entry)
+{
+    if (entry->wheel_prev) {
+        entry->wheel_prev->wheel_next = entry->wheel_next;
+    } else {
+        assert(reg->wheel.slots[entry->wheel_slot] == entry);
+        reg->wheel.slots[entry->wheel_slot] = entry->wheel_next;
+    }
+
+    if (entry->wheel_next) {
+        entry->wheel_next->wheel_prev = entry->wheel_prev;
+    }
+}
+
+/**
+ * \brief Add a session to the list of accessed sessions
+ * \param[in] reg   Registry
+ * \param[in] entry Session
+ */
+static void
+treg_dirty_add(struct fds_treg *reg, struct treg_entry *entry)
+{
+    if (entry->dirty) {
+        return;
+    }
+
+    entry->dirty = true;
+    entry->dirty_prev = NULL;
+    entry->dirty_next = reg->dirty;
+    if (reg->dirty) {
+        reg->dirty->dirty_prev = entry;
+    }
+    reg->dirty = entry;
+}
+
+/**
+ * \brief Remove a session from the list of accessed sessions
+ * \param[in] reg   Registry
+ * \param[in] entry Session
+ */
+static void
+treg_dirty_remove(struct fds_treg *reg, struct treg_entry *entry)
+{
+    if (!entry->dirty) {
+        return;
+    }
+
+    if (entry->dirty_prev) {
+        entry->dirty_prev->dirty_next = entry->dirty_next;
+    } else {
+        reg->dirty = entry->dirty_next;
+    }
+
+    if (entry->dirty_next) {
+        entry->dirty_next->dirty_prev = entry->dirty_prev;
+    }
+    entry->dirty = false;
+}
+
+/**
+ * \brief Move garbage of a template manager to the garbage of the registry
+ * \param[in] reg  Registry
+ * \param[in] tmgr Template manager
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+treg_garbage_move(struct fds_treg *reg, fds_tmgr_t *tmgr)
+{
+    fds_tgarbage_t *gc;
+    int ret_code = fds_tmgr_garbage_get(tmgr, &gc);
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+
+    // Garbage of the manager is destroyed together with the garbage of the registry
+    return garbage_append(reg->garbage, gc, (garbage_fn_t) &garbage_destroy);
+}
+
+/**
+ * \brief Remove a session and destroy its template manager
+ *
+ * All snapshots and templates of the manager are moved to the garbage of the registry.
+ * \param[in] reg   Registry
+ * \param[in] entry Session
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM and the session is
+ *   still registered.
+ */
+static int
+treg_entry_remove(struct fds_treg *reg, struct treg_entry *entry)
+{
+    fds_tmgr_clear(entry->tmgr);
+    int ret_code = treg_garbage_move(reg, entry->tmgr);
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+
+    treg_table_remove(reg, entry);
+    if (reg->wheel.timeout != 0) {
+        treg_wheel_remove(reg, entry);
+    }
+    treg_dirty_remove(reg, entry);
+
+    fds_tmgr_destroy(entry->tmgr);
+    free(entry);
+    return FDS_OK;
+}
+
+fds_treg_t *
+fds_treg_create(fds_tpool_t *pool, const fds_iemgr_t *iemgr)
+{
+    struct fds_treg *reg = calloc(1, sizeof(*reg));
+    if (!reg) {
+        return NULL;
+    }
+
+    reg->table.items = calloc(TREG_BUCKETS_DEF, sizeof(*reg->table.items));
+    reg->garbage = garbage_create();
+    if (!reg->table.items || !reg->garbage) {
+        garbage_destroy(reg->garbage);
+        free(reg->table.items);
+        free(reg);
+        return NULL;
+    }
+
+    reg->table.mask = TREG_BUCKETS_DEF - 1U;
+    reg->pool = pool;
+    reg->iemgr = iemgr;
+    return reg;
+}
+
+void
+fds_treg_destroy(fds_treg_t *reg)
+{
+    for (uint64_t i = 0; i <= reg->table.mask; ++i) {
+        struct treg_entry *entry = reg->table.items[i];
+        while (entry) {
+            struct treg_entry *next = entry->bucket_next;
+            fds_tmgr_destroy(entry->tmgr);
+            free(entry);
+            entry = next;
+        }
+    }
+
+    garbage_destroy(reg->garbage);
+    free(reg->table.items);
+    free(reg);
+}
+
+/**
+ * \brief Set an IE manager of all template managers (auxiliary function)
+ * \param[in] reg   Registry
+ * \param[in] iemgr IE manager
+ * \param[in] diff  Changed definitions (NULL == redefine all templates)
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+treg_iemgr_apply(fds_treg_t *reg, const fds_iemgr_t *iemgr, const fds_iemgr_diff_t *diff)
+{
+    reg->iemgr = iemgr;
+
+    for (uint64_t i = 0; i <= reg->table.mask; ++i) {
+        for (struct treg_entry *entry = reg->table.items[i]; entry; entry = entry->bucket_next) {
+            int ret_code = (diff == NULL)
+                ? fds_tmgr_set_iemgr(entry->tmgr, iemgr)
+                : fds_tmgr_update_iemgr(entry->tmgr, iemgr, diff);
+            if (ret_code != FDS_OK) {
+                return ret_code;
+            }
+
+            // Old templates are moved to garbage
+            treg_dirty_add(reg, entry);
+        }
+    }
+
+    return FDS_OK;
+}
+
+int
+fds_treg_set_iemgr(fds_treg_t *reg, const fds_iemgr_t *iemgr)
+{
+    return treg_iemgr_apply(reg, iemgr, NULL);
+}
+
+int
+fds_treg_update_iemgr(fds_treg_t *reg, const fds_iemgr_t *iemgr, const fds_iemgr_diff_t *diff)
+{
+    return treg_iemgr_apply(reg, iemgr, diff);
+}
+
+void
+fds_treg_set_idle_timeout(fds_treg_t *reg, uint32_t timeout)
+{
+    if (reg->wheel.timeout != 0) {
+        // Remove all sessions from the wheel
+        for (uint32_t i = 0; i < TREG_WHEEL_SIZE; ++i) {
+            reg->wheel.slots[i] = NULL;
+        }
+    }
+
+    reg->wheel.timeout = timeout;
+    if (timeout == 0) {
+        return;
+    }
+
+    // Each session is expired at most one tick after its timeout
+    const uint32_t ticks = TREG_WHEEL_SIZE / 2U;
+    reg->wheel.tick = (timeout / ticks) + ((timeout % ticks != 0) ? 1U : 0U);
+    reg->wheel.tick_last = reg->now / reg->wheel.tick;
+
+    for (uint64_t i = 0; i <= reg->table.mask; ++i) {
+        for (struct treg_entry *entry = reg->table.items[i]; entry; entry = entry->bucket_next) {
+            treg_wheel_insert(reg, entry);
+        }
+    }
+}
+
+int
+fds_treg_set_time(fds_treg_t *reg, uint32_t now)
+{
+    if (now <= reg->now) {
+        // Time cannot go backwards
+        return FDS_OK;
+    }
+
+    reg->now = now;
+    if (reg->wheel.timeout == 0) {
+        return FDS_OK;
+    }
+
+    // Process all ticks up to now (each slot at most once)
+    const uint32_t tick_now = now / reg->wheel.tick;
+    uint32_t tick = reg->wheel.tick_last;
+    if (tick_now - tick > TREG_WHEEL_SIZE) {
+        tick = tick_now - TREG_WHEEL_SIZE;
+    }
+
+    while (tick != tick_now) {
+        tick++;
+        const uint32_t slot = tick & (TREG_WHEEL_SIZE - 1U);
+        struct treg_entry *entry = reg->wheel.slots[slot];
+
+        while (entry) {
+            struct treg_entry *next = entry->wheel_next;
+            const uint64_t expire = (uint64_t) entry->last_active + reg->wheel.timeout;
+
+            if (expire <= now) {
+                // The session is idle
+                int ret_code = treg_entry_remove(reg, entry);
+                if (ret_code != FDS_OK) {
+                    reg->wheel.tick_last = tick - 1U;
+                    return ret_code;
+                }
+            } else if ((treg_wheel_tick(reg, entry) & (TREG_WHEEL_SIZE - 1U)) != slot) {
+                // The session has been accessed since its insertion -> move it (lazy update)
+                treg_wheel_remove(reg, entry);
+                treg_wheel_insert(reg, entry);
+            }
+
+            entry = next;
+        }
+    }
+
+    reg->wheel.tick_last = tick_now;
+    return FDS_OK;
+}
+
+int
+fds_treg_add(fds_treg_t *reg, uint64_t id, enum fds_session_type type, fds_tmgr_t **tmgr)
+{
+    if (treg_table_find(reg, id) != NULL) {
+        return FDS_ERR_ARG;
+    }
+
+    struct treg_entry *entry = calloc(1, sizeof(*entry));
+    if (!entry) {
+        return FDS_ERR_NOMEM;
+    }
+
+    entry->tmgr = fds_tmgr_create_pool(type, reg->pool);
+    if (!entry->tmgr) {
+        free(entry);
+        return FDS_ERR_NOMEM;
+    }
+
+    int ret_code = fds_tmgr_set_iemgr(entry->tmgr, reg->iemgr);
+    if (ret_code != FDS_OK) {
+        fds_tmgr_destroy(entry->tmgr);
+        free(entry);
+        return ret_code;
+    }
+
+    if (reg->table.cnt > reg->table.mask) {
+        // Keep the load factor of the hash table below 1
+        treg_table_grow(reg);
+    }
+
+    entry->id = id;
+    entry->type = type;
+    entry->last_active = reg->now;
+    struct treg_entry **bucket = &reg->table.items[treg_hash(id) & reg->table.mask];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    reg->table.cnt++;
+
+    if (reg->wheel.timeout != 0) {
+        treg_wheel_insert(reg, entry);
+    }
+    treg_dirty_add(reg, entry);
+
+    *tmgr = entry->tmgr;
+    return FDS_OK;
+}
+
+fds_tmgr_t *
+fds_treg_find(fds_treg_t *reg, uint64_t id)
+{
+    struct treg_entry *entry = treg_table_find(reg, id);
+    if (!entry) {
+        return NULL;
+    }
+
+    // The timer wheel is updated lazily (see fds_treg_set_time())
+    entry->last_active = reg->now;
+    treg_dirty_add(reg, entry);
+    return entry->tmgr;
+}
+
+int
+fds_treg_remove(fds_treg_t *reg, uint64_t id)
+{
+    struct treg_entry *entry = treg_table_find(reg, id);
+    if (!entry) {
+        return FDS_ERR_NOTFOUND;
+    }
+
+    return treg_entry_remove(reg, entry);
+}
+
+uint32_t
+fds_treg_count(const fds_treg_t *reg)
+{
+    return reg->table.cnt;
+}
+
+int
+fds_treg_garbage_get(fds_treg_t *reg, fds_tgarbage_t **gc)
+{
+    // Only managers accessed since the last call can produce new garbage
+    while (reg->dirty) {
+        struct treg_entry *entry = reg->dirty;
+        int ret_code = treg_garbage_move(reg, entry->tmgr);
+        if (ret_code != FDS_OK) {
+            return ret_code;
+        }
+        treg_dirty_remove(reg, entry);
+    }
+
+    if (garbage_empty(reg->garbage)) {
+        *gc = NULL;
+        return FDS_OK;
+    }
+
+    fds_tgarbage_t *new_garbage = garbage_create();
+    if (!new_garbage) {
+        return FDS_ERR_NOMEM;
+    }
+
+    *gc = reg->garbage;
+    reg->garbage = new_garbage;
+    return FDS_OK;
+}
+
+/*
+ * Format of the file (all values are in network byte order):
+ *
+ * File header: uint32_t magic, uint16_t version, uint16_t reserved, uint32_t count
+ * Session record, repeated "count" times:
+ *   uint32_t ID (upper half), uint32_t ID (lower half), uint32_t session type,
+ *   state of the template manager (see fds_tmgr_save())
+ */
+
+int
+fds_treg_save(fds_treg_t *reg, FILE *file)
+{
+    uint32_t hdr[3];
+    hdr[0] = htonl(TREG_FILE_MAGIC);
+    hdr[1] = htonl(TREG_FILE_VERSION << 16);
+    hdr[2] = htonl(reg->table.cnt);
+    if (fwrite(hdr, sizeof(hdr), 1, file) != 1) {
+        return FDS_ERR_DENIED;
+    }
+
+    for (uint64_t i = 0; i <= reg->table.mask; ++i) {
+        for (struct treg_entry *entry = reg->table.items[i]; entry; entry = entry->bucket_next) {
+            uint32_t rec[3];
+            rec[0] = htonl((uint32_t) (entry->id >> 32));
+            rec[1] = htonl((uint32_t) entry->id);
+            rec[2] = htonl((uint32_t) entry->type);
+            if (fwrite(rec, sizeof(rec), 1, file) != 1) {
+                return FDS_ERR_DENIED;
+            }
+
+            int ret_code = fds_tmgr_save(entry->tmgr, file);
+            if (ret_code != FDS_OK) {
+                return ret_code;
+            }
+        }
+    }
+
+    return FDS_OK;
+}
+
+int
+fds_treg_load(fds_treg_t *reg, FILE *file)
+{
+    uint32_t hdr[3];
+    if (fread(hdr, sizeof(hdr), 1, file) != 1 || ntohl(hdr[0]) != TREG_FILE_MAGIC
+            || (ntohl(hdr[1]) >> 16) != TREG_FILE_VERSION) {
+        return FDS_ERR_FORMAT;
+    }
+
+    const uint32_t cnt = ntohl(hdr[2]);
+    for (uint32_t i = 0; i < cnt; ++i) {
+        uint32_t rec[3];
+        if (fread(rec, sizeof(rec), 1, file) != 1) {
+            return FDS_ERR_FORMAT;
+        }
+
+        const uint64_t id = ((uint64_t) ntohl(rec[0]) << 32) | ntohl(rec[1]);
+        const uint32_t type = ntohl(rec[2]);
+        if (type > FDS_SESSION_FILE) {
+            return FDS_ERR_FORMAT;
+        }
+
+        fds_tmgr_t *tmgr;
+        int ret_code = fds_treg_add(reg, id, (enum fds_session_type) type, &tmgr);
+        if (ret_code == FDS_ERR_ARG) {
+            // Duplicated session
+            return FDS_ERR_FORMAT;
+        } else if (ret_code != FDS_OK) {
+            return ret_code;
+        }
+
+        if ((ret_code = fds_tmgr_load(tmgr, file)) != FDS_OK) {
+            fds_treg_remove(reg, id);
+            return ret_code;
+        }
+    }
+
+    return FDS_OK;
+}
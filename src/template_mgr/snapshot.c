@@ -46,6 +46,7 @@
 #include <assert.h>
 #include <string.h>  // memcpy
 
+#include "pool.h"
 #include "snapshot.h"
 
 /**
@@ -80,7 +81,7 @@ snapshot_bit_clear(snapshot_bitset_t *set, uint16_t bit)
  * \return #FDS_OK or #FDS_ERR_NOTFOUND
  */
 static inline int
-snapshot_bit_next(snapshot_bitset_t *set, uint16_t start, uint16_t *bit)
+snapshot_bit_next(const snapshot_bitset_t *set, uint16_t start, uint16_t *bit)
 {
     if (start >= SNAPSHOT_TABLE_SIZE) {
         return FDS_ERR_NOTFOUND;
@@ -120,140 +121,239 @@ snapshot_bit_next(snapshot_bitset_t *set, uint16_t start, uint16_t *bit)
     return FDS_OK;
 }
 
+/**
+ * \brief Check if a bit is set
+ * \param[in] set Bitset
+ * \param[in] bit Bit index (start from 0)
+ * \return True or false
+ */
+static inline bool
+snapshot_bit_test(const snapshot_bitset_t *set, uint16_t bit)
+{
+    assert(bit < SNAPSHOT_TABLE_SIZE);
+    return (set->set[bit / SNAPSHOT_BITSET_BPI] >> (bit % SNAPSHOT_BITSET_BPI)) & 1U;
+}
+
 fds_tsnapshot_t *
-snapshot_create() {
-    struct fds_tsnapshot *snap = calloc(1, sizeof(*snap));
+snapshot_create(fds_tpool_t *pool) {
+    struct fds_tsnapshot *snap = pool_calloc(pool, POOL_SNAPSHOT);
     if (!snap) {
         return NULL;
     }
 
-    // L1 table and its bitset will be clear after calloc() -> nothing to do
+    // Compact table is empty after calloc() -> nothing to do
+    snap->pool = pool;
     return snap;
 }
 
-void
-snapshot_destroy(struct fds_tsnapshot *snap)
+/**
+ * \brief Release a reference to an L2 table
+ *
+ * If this is the last reference, the table is freed.
+ * \param[in] pool  Pool allocator
+ * \param[in] table L2 table
+ */
+static void
+snapshot_l2_release(fds_tpool_t *pool, struct snapshot_l2_table *table)
+{
+    if (atomic_fetch_sub_explicit(&table->ref_cnt, 1, memory_order_acq_rel) == 1) {
+        pool_free(pool, POOL_L2_TABLE, table);
+    }
+}
+
+/**
+ * \brief Get an L2 table of a node that can be modified (copy-on-write)
+ *
+ * If the table is shared with another snapshot, a private copy of the table is created.
+ * \param[in] pool Pool allocator
+ * \param[in] node L2 node
+ * \return Pointer to the table or NULL (memory allocation error)
+ */
+static struct snapshot_l2_table *
+snapshot_l2_private(fds_tpool_t *pool, struct snapshot_l2_node *node)
+{
+    struct snapshot_l2_table *old_table = node->table;
+    if (atomic_load_explicit(&old_table->ref_cnt, memory_order_acquire) == 1) {
+        // Only this node refers to the table
+        return old_table;
+    }
+
+    struct snapshot_l2_table *new_table = pool_alloc(pool, POOL_L2_TABLE);
+    if (!new_table) {
+        return NULL;
+    }
+
+    memcpy(new_table, old_table, sizeof(*new_table));
+    atomic_init(&new_table->ref_cnt, 1);
+    node->table = new_table;
+    snapshot_l2_release(pool, old_table);
+    return new_table;
+}
+
+/**
+ * \brief Destroy an L1 table (i.e. all L2 nodes and release their tables)
+ * \param[in] pool     Pool allocator
+ * \param[in] l1_table L1 table
+ */
+static void
+snapshot_l1_destroy(fds_tpool_t *pool, struct snapshot_l1_table *l1_table)
 {
-    // Delete all L2 tables
     uint16_t idx = 0;
-    while (snapshot_bit_next(&snap->l1_table.bitset, idx, &idx) == FDS_OK) {
-        free(snap->l1_table.tables[idx]);
+    while (snapshot_bit_next(&l1_table->bitset, idx, &idx) == FDS_OK) {
+        struct snapshot_l2_node *node = l1_table->nodes[idx];
+        snapshot_l2_release(pool, node->table);
+        pool_free(pool, POOL_L2_NODE, node);
         idx++;
     }
 
-    // Delete the snapshot itself
-    free(snap);
+    pool_free(pool, POOL_L1_TABLE, l1_table);
 }
 
-struct fds_tsnapshot *
-snapshot_copy(const struct fds_tsnapshot *snap)
+/**
+ * \brief Make a copy of an L1 table
+ *
+ * L2 tables are shared with the original table. Empty L2 tables are not copied.
+ * \param[in] pool     Pool allocator
+ * \param[in] l1_table L1 table
+ * \return Pointer or NULL (memory allocation error)
+ */
+static struct snapshot_l1_table *
+snapshot_l1_copy(fds_tpool_t *pool, const struct snapshot_l1_table *l1_table)
 {
-    // Copy snapshot
-    struct fds_tsnapshot *new_snap = malloc(sizeof(*new_snap));
-    if (!new_snap) {
+    struct snapshot_l1_table *new_l1 = pool_calloc(pool, POOL_L1_TABLE);
+    if (!new_l1) {
         return NULL;
     }
 
-    memcpy(new_snap, snap, sizeof(*new_snap));
-
-    // Copy all L2 tables
-    uint16_t copy_idx = 0;
-    bool failed = false;
-
-    snapshot_bitset_t *bitset = &new_snap->l1_table.bitset;
-    while (snapshot_bit_next(bitset, copy_idx, &copy_idx) == FDS_OK) {
-        const struct snapshot_l2_table *old_l2 = snap->l1_table.tables[copy_idx];
-        if (old_l2->rec_cnt == 0) {
+    uint16_t idx = 0;
+    while (snapshot_bit_next(&l1_table->bitset, idx, &idx) == FDS_OK) {
+        const struct snapshot_l2_node *old_node = l1_table->nodes[idx];
+        if (old_node->table->rec_cnt == 0) {
             // Do not copy empty tables
-            new_snap->l1_table.tables[copy_idx] = NULL;
-            snapshot_bit_clear(bitset, copy_idx);
-            copy_idx++;
+            idx++;
             continue;
         }
 
-        struct snapshot_l2_table *new_l2 = malloc(sizeof(*new_l2));
-        if (!new_l2) {
-            failed = true;
-            break;
-        }
-        memcpy(new_l2, old_l2, sizeof(*new_l2));
-        new_snap->l1_table.tables[copy_idx] = new_l2;
-        copy_idx++;
-    }
-
-    if (failed) {
-        // Free successfully copied tables
-        uint16_t idx = 0;
-        while (snapshot_bit_next(bitset, idx, &idx) == FDS_OK && idx < copy_idx) {
-            free(new_snap->l1_table.tables[idx]);
-            idx++;
+        struct snapshot_l2_node *new_node = pool_alloc(pool, POOL_L2_NODE);
+        if (!new_node) {
+            snapshot_l1_destroy(pool, new_l1);
+            return NULL;
         }
 
-        free(new_snap);
-        return NULL;
+        memcpy(new_node, old_node, sizeof(*new_node));
+        atomic_fetch_add_explicit(&new_node->table->ref_cnt, 1, memory_order_relaxed);
+        new_l1->nodes[idx] = new_node;
+        snapshot_bit_set(&new_l1->bitset, idx);
+        idx++;
     }
 
-    return new_snap;
+    return new_l1;
 }
 
-int
-snapshot_rec_add(struct fds_tsnapshot *snap, struct snapshot_rec *rec)
+/**
+ * \brief Add a record to an L1 table
+ * \param[in]  pool     Pool allocator
+ * \param[in]  l1_table L1 table
+ * \param[in]  rec      Snapshot record (including ownership flags)
+ * \param[out] is_new   Set to true, if the record hasn't been in the table
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+snapshot_l1_add(fds_tpool_t *pool, struct snapshot_l1_table *l1_table,
+    const struct snapshot_rec *rec, bool *is_new)
 {
-    assert(rec->id >= FDS_IPFIX_SET_MIN_DSET);
-
     const uint16_t l1_idx = rec->id / SNAPSHOT_TABLE_SIZE;
-    struct snapshot_l2_table *l2_table = snap->l1_table.tables[l1_idx];
-    if (!l2_table) {
-        // Create L2 table
-        l2_table = calloc(1, sizeof(*l2_table));
-        if (!l2_table) {
+    struct snapshot_l2_node *l2_node = l1_table->nodes[l1_idx];
+    struct snapshot_l2_table *l2_table;
+
+    if (!l2_node) {
+        // Create L2 node and table
+        l2_node = pool_calloc(pool, POOL_L2_NODE);
+        l2_table = pool_calloc(pool, POOL_L2_TABLE);
+        if (!l2_node || !l2_table) {
+            pool_free(pool, POOL_L2_NODE, l2_node);
+            pool_free(pool, POOL_L2_TABLE, l2_table);
             return FDS_ERR_NOMEM;
         }
 
-        snap->l1_table.tables[l1_idx] = l2_table;
-        snapshot_bit_set(&snap->l1_table.bitset, l1_idx);
+        atomic_init(&l2_table->ref_cnt, 1);
+        l2_node->table = l2_table;
+        l1_table->nodes[l1_idx] = l2_node;
+        snapshot_bit_set(&l1_table->bitset, l1_idx);
+    } else {
+        // Make sure that the table is not shared
+        l2_table = snapshot_l2_private(pool, l2_node);
+        if (!l2_table) {
+            return FDS_ERR_NOMEM;
+        }
     }
 
     const uint16_t l2_idx = rec->id % SNAPSHOT_TABLE_SIZE;
     struct snapshot_rec *l2_rec = &l2_table->recs[l2_idx];
-    if (l2_rec->id == 0) {
+    *is_new = (l2_rec->id == 0);
+    if (*is_new) {
         // New record
         snapshot_bit_set(&l2_table->bitset, l2_idx);
         l2_table->rec_cnt++;
-        snap->rec_cnt++;
     }
 
+    // Ownership flags are stored in the node
     *l2_rec = *rec;
+    l2_rec->flags &= ~SNAPSHOT_TF_OWNERSHIP;
+
+    if (rec->flags & SNAPSHOT_TF_CREATE) {
+        snapshot_bit_set(&l2_node->create, l2_idx);
+    } else {
+        snapshot_bit_clear(&l2_node->create, l2_idx);
+    }
+
+    if (rec->flags & SNAPSHOT_TF_DESTROY) {
+        snapshot_bit_set(&l2_node->destroy, l2_idx);
+    } else {
+        snapshot_bit_clear(&l2_node->destroy, l2_idx);
+    }
+
     return FDS_OK;
 }
 
-int
-snapshot_rec_remove(struct fds_tsnapshot *snap, uint16_t id)
+/**
+ * \brief Remove a record from an L1 table
+ * \param[in] pool     Pool allocator
+ * \param[in] l1_table L1 table
+ * \param[in] id       Template ID
+ * \return #FDS_OK, #FDS_ERR_NOTFOUND or #FDS_ERR_NOMEM
+ */
+static int
+snapshot_l1_remove(fds_tpool_t *pool, struct snapshot_l1_table *l1_table, uint16_t id)
 {
-    assert(id >= FDS_IPFIX_SET_MIN_DSET);
-
     // Find the record
     const uint16_t l1_idx = id / SNAPSHOT_TABLE_SIZE;
-    struct snapshot_l2_table *l2_table = snap->l1_table.tables[l1_idx];
-    if (!l2_table) {
+    struct snapshot_l2_node *l2_node = l1_table->nodes[l1_idx];
+    if (!l2_node) {
         return FDS_ERR_NOTFOUND;
     }
 
     const uint16_t l2_idx = id % SNAPSHOT_TABLE_SIZE;
-    struct snapshot_rec *l2_rec = &l2_table->recs[l2_idx];
-    if (l2_rec->id == 0) {
+    if (l2_node->table->recs[l2_idx].id == 0) {
         return FDS_ERR_NOTFOUND;
     }
 
+    // Make sure that the table is not shared
+    struct snapshot_l2_table *l2_table = snapshot_l2_private(pool, l2_node);
+    if (!l2_table) {
+        return FDS_ERR_NOMEM;
+    }
+
     // Remove it
+    struct snapshot_rec *l2_rec = &l2_table->recs[l2_idx];
     assert(l2_rec->id == id);
     assert(l2_table->rec_cnt > 0);
-    assert(snap->rec_cnt > 0);
 
-    *l2_rec = (struct snapshot_rec) {0, 0, 0, NULL};
+    *l2_rec = (struct snapshot_rec) {0, 0, NULL};
     snapshot_bit_clear(&l2_table->bitset, l2_idx);
+    snapshot_bit_clear(&l2_node->create, l2_idx);
+    snapshot_bit_clear(&l2_node->destroy, l2_idx);
     l2_table->rec_cnt--;
-    snap->rec_cnt--;
 
     /* We don't want to free empty L2 table here.
      * Someone can iterate over the table (i.e. snapshot_rec_for()) and by removing the last
@@ -263,18 +363,257 @@ snapshot_rec_remove(struct fds_tsnapshot *snap, uint16_t id)
     return FDS_OK;
 }
 
+/**
+ * \brief Find a position of a record in the compact table
+ * \param[in]  snap Snapshot (must use the compact layout)
+ * \param[in]  id   Template ID
+ * \param[out] idx  Position of the record (or position where the record should be inserted)
+ * \return True if the record has been found. Otherwise false.
+ */
+static inline bool
+snapshot_small_find(const struct fds_tsnapshot *snap, uint16_t id, uint16_t *idx)
+{
+    const struct snapshot_rec *recs = snap->small.recs;
+    uint16_t low = 0;
+    uint16_t high = snap->rec_cnt;
+
+    while (low < high) {
+        const uint16_t mid = (uint16_t) ((low + high) / 2U);
+        if (recs[mid].id < id) {
+            low = mid + 1U;
+        } else {
+            high = mid;
+        }
+    }
+
+    *idx = low;
+    return (low < snap->rec_cnt && recs[low].id == id);
+}
+
+/**
+ * \brief Convert a snapshot from the compact layout to the large layout
+ * \param[in] snap Snapshot (must use the compact layout)
+ * \return #FDS_OK or #FDS_ERR_NOMEM (the snapshot is not modified)
+ */
+static int
+snapshot_small2large(struct fds_tsnapshot *snap)
+{
+    assert(snap->l1_table == NULL);
+    struct snapshot_l1_table *l1_table = pool_calloc(snap->pool, POOL_L1_TABLE);
+    if (!l1_table) {
+        return FDS_ERR_NOMEM;
+    }
+
+    for (uint16_t i = 0; i < snap->rec_cnt; ++i) {
+        struct snapshot_rec rec = snap->small.recs[i];
+        rec.flags |= snap->small.owner[i];
+
+        bool is_new;
+        if (snapshot_l1_add(snap->pool, l1_table, &rec, &is_new) != FDS_OK) {
+            snapshot_l1_destroy(snap->pool, l1_table);
+            return FDS_ERR_NOMEM;
+        }
+        assert(is_new);
+    }
+
+    snap->l1_table = l1_table;
+    return FDS_OK;
+}
+
+/**
+ * \brief Get ownership flags of a record
+ * \warning The record MUST exist in the snapshot.
+ * \param[in] snap Snapshot
+ * \param[in] id   Template ID
+ * \return Ownership flags
+ */
+static uint16_t
+snapshot_owner_get(const struct fds_tsnapshot *snap, uint16_t id)
+{
+    if (!snap->l1_table) {
+        uint16_t idx;
+        bool found = snapshot_small_find(snap, id, &idx);
+        assert(found);
+        (void) found;
+        return snap->small.owner[idx];
+    }
+
+    const struct snapshot_l2_node *l2_node = snap->l1_table->nodes[id / SNAPSHOT_TABLE_SIZE];
+    const uint16_t l2_idx = id % SNAPSHOT_TABLE_SIZE;
+    uint16_t flags = 0;
+
+    if (snapshot_bit_test(&l2_node->create, l2_idx)) {
+        flags |= SNAPSHOT_TF_CREATE;
+    }
+
+    if (snapshot_bit_test(&l2_node->destroy, l2_idx)) {
+        flags |= SNAPSHOT_TF_DESTROY;
+    }
+
+    return flags;
+}
+
+/**
+ * \brief Modify ownership flags of a record
+ * \warning The record MUST exist in the snapshot.
+ * \param[in] snap  Snapshot
+ * \param[in] id    Template ID
+ * \param[in] set   Ownership flags to set
+ * \param[in] clear Ownership flags to clear
+ */
+static void
+snapshot_owner_modify(struct fds_tsnapshot *snap, uint16_t id, uint16_t set, uint16_t clear)
+{
+    assert(((set | clear) & ~SNAPSHOT_TF_OWNERSHIP) == 0);
+
+    if (!snap->l1_table) {
+        uint16_t idx;
+        bool found = snapshot_small_find(snap, id, &idx);
+        assert(found);
+        (void) found;
+        snap->small.owner[idx] = (uint8_t) ((snap->small.owner[idx] & ~clear) | set);
+        return;
+    }
+
+    struct snapshot_l2_node *l2_node = snap->l1_table->nodes[id / SNAPSHOT_TABLE_SIZE];
+    const uint16_t l2_idx = id % SNAPSHOT_TABLE_SIZE;
+
+    if (clear & SNAPSHOT_TF_CREATE) {
+        snapshot_bit_clear(&l2_node->create, l2_idx);
+    }
+    if (clear & SNAPSHOT_TF_DESTROY) {
+        snapshot_bit_clear(&l2_node->destroy, l2_idx);
+    }
+    if (set & SNAPSHOT_TF_CREATE) {
+        snapshot_bit_set(&l2_node->create, l2_idx);
+    }
+    if (set & SNAPSHOT_TF_DESTROY) {
+        snapshot_bit_set(&l2_node->destroy, l2_idx);
+    }
+}
+
+void
+snapshot_destroy(struct fds_tsnapshot *snap)
+{
+    if (snap->l1_table) {
+        snapshot_l1_destroy(snap->pool, snap->l1_table);
+    }
+
+    // Delete the snapshot itself
+    pool_free(snap->pool, POOL_SNAPSHOT, snap);
+}
+
+struct fds_tsnapshot *
+snapshot_copy(const struct fds_tsnapshot *snap)
+{
+    // Copy snapshot (including the compact table)
+    struct fds_tsnapshot *new_snap = pool_alloc(snap->pool, POOL_SNAPSHOT);
+    if (!new_snap) {
+        return NULL;
+    }
+
+    memcpy(new_snap, snap, sizeof(*new_snap));
+    if (!snap->l1_table) {
+        return new_snap;
+    }
+
+    // Copy the L1 table (L2 tables are shared)
+    new_snap->l1_table = snapshot_l1_copy(snap->pool, snap->l1_table);
+    if (!new_snap->l1_table) {
+        pool_free(snap->pool, POOL_SNAPSHOT, new_snap);
+        return NULL;
+    }
+
+    return new_snap;
+}
+
+int
+snapshot_rec_add(struct fds_tsnapshot *snap, const struct snapshot_rec *rec)
+{
+    assert(rec->id >= FDS_IPFIX_SET_MIN_DSET);
+
+    if (!snap->l1_table) {
+        uint16_t idx;
+        if (!snapshot_small_find(snap, rec->id, &idx)) {
+            if (snap->rec_cnt == SNAPSHOT_SMALL_SIZE) {
+                // The compact table is full -> convert the snapshot to the large layout
+                if (snapshot_small2large(snap) != FDS_OK) {
+                    return FDS_ERR_NOMEM;
+                }
+
+                return snapshot_rec_add(snap, rec);
+            }
+
+            // Make space for the new record
+            struct snapshot_small_table *small = &snap->small;
+            const size_t move_cnt = snap->rec_cnt - idx;
+            memmove(&small->recs[idx + 1], &small->recs[idx], move_cnt * sizeof(small->recs[0]));
+            memmove(&small->owner[idx + 1], &small->owner[idx], move_cnt);
+            snap->rec_cnt++;
+        }
+
+        snap->small.recs[idx] = *rec;
+        snap->small.recs[idx].flags &= ~SNAPSHOT_TF_OWNERSHIP;
+        snap->small.owner[idx] = (uint8_t) (rec->flags & SNAPSHOT_TF_OWNERSHIP);
+        return FDS_OK;
+    }
+
+    bool is_new;
+    int ret_code = snapshot_l1_add(snap->pool, snap->l1_table, rec, &is_new);
+    if (ret_code == FDS_OK && is_new) {
+        snap->rec_cnt++;
+    }
+
+    return ret_code;
+}
+
+int
+snapshot_rec_remove(struct fds_tsnapshot *snap, uint16_t id)
+{
+    assert(id >= FDS_IPFIX_SET_MIN_DSET);
+
+    if (!snap->l1_table) {
+        uint16_t idx;
+        if (!snapshot_small_find(snap, id, &idx)) {
+            return FDS_ERR_NOTFOUND;
+        }
+
+        struct snapshot_small_table *small = &snap->small;
+        const size_t move_cnt = snap->rec_cnt - idx - 1U;
+        memmove(&small->recs[idx], &small->recs[idx + 1], move_cnt * sizeof(small->recs[0]));
+        memmove(&small->owner[idx], &small->owner[idx + 1], move_cnt);
+        snap->rec_cnt--;
+        small->recs[snap->rec_cnt] = (struct snapshot_rec) {0, 0, NULL};
+        small->owner[snap->rec_cnt] = 0;
+        return FDS_OK;
+    }
+
+    int ret_code = snapshot_l1_remove(snap->pool, snap->l1_table, id);
+    if (ret_code == FDS_OK) {
+        assert(snap->rec_cnt > 0);
+        snap->rec_cnt--;
+    }
+
+    return ret_code;
+}
+
 const struct snapshot_rec *
 snapshot_rec_cfind(const struct fds_tsnapshot *snap, uint16_t id)
 {
+    if (!snap->l1_table) {
+        uint16_t idx;
+        return snapshot_small_find(snap, id, &idx) ? &snap->small.recs[idx] : NULL;
+    }
+
     // Find the record
     const uint16_t l1_idx = id / SNAPSHOT_TABLE_SIZE;
-    struct snapshot_l2_table *l2_table = snap->l1_table.tables[l1_idx];
-    if (!l2_table) {
+    const struct snapshot_l2_node *l2_node = snap->l1_table->nodes[l1_idx];
+    if (!l2_node) {
         return NULL;
     }
 
     const uint16_t l2_idx = id % SNAPSHOT_TABLE_SIZE;
-    struct snapshot_rec *l2_rec = &l2_table->recs[l2_idx];
+    const struct snapshot_rec *l2_rec = &l2_node->table->recs[l2_idx];
     if (l2_rec->id == 0) {
         return NULL;
     }
@@ -282,35 +621,123 @@ snapshot_rec_cfind(const struct fds_tsnapshot *snap, uint16_t id)
     return l2_rec;
 }
 
-struct snapshot_rec *
-snapshot_rec_find(struct fds_tsnapshot *snap, uint16_t id)
+uint16_t
+snapshot_rec_flags(const struct fds_tsnapshot *snap, uint16_t id)
 {
-    return (struct snapshot_rec *) snapshot_rec_cfind(snap, id);
+    const struct snapshot_rec *rec = snapshot_rec_cfind(snap, id);
+    assert(rec != NULL);
+    return rec->flags | snapshot_owner_get(snap, id);
 }
 
 void
-snapshot_rec_for(struct fds_tsnapshot *snap, snapshot_rec_cb cb, void *data)
+snapshot_rec_flags_set(struct fds_tsnapshot *snap, uint16_t id, uint16_t flags)
 {
+    assert(snapshot_rec_cfind(snap, id) != NULL);
+    snapshot_owner_modify(snap, id, flags, 0);
+}
+
+void
+snapshot_rec_flags_clear(struct fds_tsnapshot *snap, uint16_t id, uint16_t flags)
+{
+    assert(snapshot_rec_cfind(snap, id) != NULL);
+    snapshot_owner_modify(snap, id, 0, flags);
+}
+
+void
+snapshot_flags_clear(struct fds_tsnapshot *snap, uint16_t flags)
+{
+    assert((flags & ~SNAPSHOT_TF_OWNERSHIP) == 0);
+
+    if (!snap->l1_table) {
+        for (uint16_t i = 0; i < snap->rec_cnt; ++i) {
+            snap->small.owner[i] &= (uint8_t) ~flags;
+        }
+        return;
+    }
+
     uint16_t l1_idx = 0;
-    snapshot_bitset_t *l1_bitset = &snap->l1_table.bitset;
+    while (snapshot_bit_next(&snap->l1_table->bitset, l1_idx, &l1_idx) == FDS_OK) {
+        struct snapshot_l2_node *l2_node = snap->l1_table->nodes[l1_idx];
+        if (flags & SNAPSHOT_TF_CREATE) {
+            memset(&l2_node->create, 0, sizeof(l2_node->create));
+        }
+
+        if (flags & SNAPSHOT_TF_DESTROY) {
+            memset(&l2_node->destroy, 0, sizeof(l2_node->destroy));
+        }
+
+        l1_idx++;
+    }
+}
+
+/**
+ * \brief Call a function on each snapshot record in a snapshot with the compact layout
+ * \param[in] snap Snapshot
+ * \param[in] cb   Callback function
+ * \param[in] data User defined data that will be passed to the callback
+ */
+static void
+snapshot_small_for(const struct fds_tsnapshot *snap, snapshot_rec_cb cb, void *data)
+{
+    uint16_t idx = 0;
+    while (idx < snap->rec_cnt) {
+        /* The callback can remove (i.e. move other records in the array) or replace the record,
+         * therefore, pass a copy and find the next record by its ID.
+         */
+        const struct snapshot_rec rec = snap->small.recs[idx];
+        if (!cb(&rec, data)) {
+            return;
+        }
+
+        // Only existing records can be replaced, so the layout cannot be changed
+        assert(snap->l1_table == NULL);
+
+        // Skip to the first record with a greater ID
+        while (idx < snap->rec_cnt && snap->small.recs[idx].id <= rec.id) {
+            idx++;
+        }
+    }
+}
+
+void
+snapshot_rec_for(const struct fds_tsnapshot *snap, snapshot_rec_cb cb, void *data)
+{
+    if (!snap->l1_table) {
+        snapshot_small_for(snap, cb, data);
+        return;
+    }
+
+    uint16_t l1_idx = 0;
+    const snapshot_bitset_t *l1_bitset = &snap->l1_table->bitset;
 
     // For each L2 table
     while (snapshot_bit_next(l1_bitset, l1_idx, &l1_idx) == FDS_OK) {
-        struct snapshot_l2_table *l2_table = snap->l1_table.tables[l1_idx];
-        snapshot_bitset_t *l2_bitset = &l2_table->bitset;
+        /* Hold a reference to the table during the iteration. If the callback modifies the
+         * snapshot, a private copy of the table is created (see snapshot_l2_private()) and this
+         * one remains valid and unchanged.
+         */
+        struct snapshot_l2_table *l2_table = snap->l1_table->nodes[l1_idx]->table;
+        atomic_fetch_add_explicit(&l2_table->ref_cnt, 1, memory_order_relaxed);
+        const snapshot_bitset_t *l2_bitset = &l2_table->bitset;
 
         // For each record in the L2 table
         uint16_t l2_idx = 0;
+        bool proceed = true;
         while (snapshot_bit_next(l2_bitset, l2_idx, &l2_idx) == FDS_OK) {
             // Call user defined function
-            struct snapshot_rec *l2_rec = &l2_table->recs[l2_idx];
+            const struct snapshot_rec *l2_rec = &l2_table->recs[l2_idx];
             if (!cb(l2_rec, data)) {
-                return;
+                proceed = false;
+                break;
             }
             l2_idx++;
         }
 
+        snapshot_l2_release(snap->pool, l2_table);
+        if (!proceed) {
+            return;
+        }
+
         l1_idx++;
     }
 }
-
@@ -42,6 +42,7 @@
 #ifndef SNAPSHOT_H
 #define SNAPSHOT_H
 
+#include <stdatomic.h>
 #include <libfds.h>
 
 /**
@@ -54,24 +55,35 @@
  * and removing snapshot records (a.k.a. a reference to template). Snapshot logic must be
  * therefor implemented by somewhere else, in this case in the template manager.
  *
- * Snapshot is organized as hierarchy of L1 and L2 tables. Main L1 table consists of 256
- * pointers to L2 tables. Each L2 table consists of 256 snapshot records. Therefore, the snapshot
- * is able to handle up to 65536 snapshot records. Each record represents reference to a template.
+ * Snapshots with only a few records (up to #SNAPSHOT_SMALL_SIZE) use a compact layout, i.e.
+ * a small array of records sorted by Template ID that is embedded in the snapshot structure.
+ * When the number of records exceeds the limit, the snapshot is converted to a large layout
+ * described below and it keeps the layout until destruction.
+ *
+ * Large snapshot is organized as hierarchy of L1 and L2 tables. Main L1 table consists of 256
+ * pointers to L2 nodes. Each L2 node refers to an L2 table that consists of 256 snapshot records.
+ * Therefore, the snapshot is able to handle up to 65536 snapshot records. Each record represents
+ * reference to a template.
+ *
+ * L2 tables are reference counted and shared among copies of the snapshot (copy-on-write).
+ * A table is copied only when a record is added to or removed from a shared table. Ownership
+ * flags of records (::SNAPSHOT_TF_CREATE and ::SNAPSHOT_TF_DESTROY) are specific for each
+ * snapshot, therefore, they are stored in L2 nodes (i.e. outside of the shared tables) and must
+ * be always accessed using snapshot_rec_flags() and related functions.
  *
  * \verbatim
- *    +----------+      +-------+        +--------+
- *    |          |      |       |    +-->| Record |
- *    | Snapshot |   +->|  L2   |----+   +--------+
- *    |          |   |  | table |    |
- *    +----------+   |  |       |    |   +--------+
- *    |          |   |  +-------+    +-->| Record |
- *    |          |   |     ...       |   +--------+
- *    |          |---+  +-------+    |
- *    | L1 table |      |       |    |      ...
- *    |          |----->|  L2   |    |
- *    |          |      | table |    |   +--------+
- *    |          |      |       |    +-->| Record |
- *    +----------+      +-------+        +--------+
+ *    +----------+      +------+    +-------+        +--------+
+ *    |          |      |      |    |       |    +-->| Record |
+ *    | Snapshot |   +->|  L2  |--->|  L2   |----+   +--------+
+ *    |          |   |  | node |    | table |    |
+ *    +----------+   |  +------+    |       |    |   +--------+
+ *    |          |   |     ...      +-------+    +-->| Record |
+ *    |          |---+  +------+        ^        |   +--------+
+ *    | L1 table |      |      |        |        |
+ *    |          |----->|  L2  |--------+        |      ...
+ *    |          |      | node |  (shared with   |   +--------+
+ *    |          |      +------+   a copy)       +-->| Record |
+ *    +----------+                                   +--------+
  * \endverbatim
  *
  * @{
@@ -82,6 +94,8 @@ struct fds_tmgr;
 
 /** L1 and L2 table size (must be a power of 2) */
 #define SNAPSHOT_TABLE_SIZE (256U)
+/** Maximum number of records of a snapshot in the compact layout */
+#define SNAPSHOT_SMALL_SIZE (16U)
 /** \brief Bits per an item of an index array */
 #define SNAPSHOT_BITSET_BPI (8 * sizeof(uint32_t))
 
@@ -116,11 +130,14 @@ enum snapshot_rec_flags {
      * \brief Timeout enabled
      *
      * If this flag is set, a referenced template has limited lifetime that is described by
-     * variable snapshot_rec#lifetime.
+     * fds_template#time#end_of_life of the template.
      */
     SNAPSHOT_TF_TIMEOUT = (1 << 2)
 };
 
+/** Ownership flags of a snapshot record (specific for each snapshot)                            */
+#define SNAPSHOT_TF_OWNERSHIP (SNAPSHOT_TF_CREATE | SNAPSHOT_TF_DESTROY)
+
 /** Snapshot record (a.k.a. reference to a template)                                             */
 struct snapshot_rec {
     /** Template ID (must be >= 256)           */
@@ -130,29 +147,36 @@ struct snapshot_rec {
      *
      * The flags argument contains a bitwise OR of zero or more of the flags defined in
      * #snapshot_rec_flags enumeration.
+     * \note Records stored in a snapshot never contain ownership flags (::SNAPSHOT_TF_OWNERSHIP)
+     *   as they are shared among multiple snapshots. Use snapshot_rec_flags() instead.
      */
     uint16_t flags;
-    /**
-     * \brief Template lifetime
-     *
-     * Time after which this template is not valid anymore, exclusive. This values is valid only
-     * if the lifetime flag (::SNAPSHOT_TF_TIMEOUT) is set.
-     */
-    uint32_t lifetime;
     /** Reference to a corresponding template  */
     struct fds_template *ptr;
 };
 
 /** Snapshot L1 table */
 struct snapshot_l1_table {
-    /** Array of L2 tables        */
-    struct snapshot_l2_table *tables[SNAPSHOT_TABLE_SIZE];
-    /** Bitset of used L2 tables  */
+    /** Array of L2 nodes         */
+    struct snapshot_l2_node *nodes[SNAPSHOT_TABLE_SIZE];
+    /** Bitset of used L2 nodes   */
     snapshot_bitset_t bitset;
 };
 
+/** Snapshot L2 node (snapshot specific reference to an L2 table) */
+struct snapshot_l2_node {
+    /** L2 table (can be shared with other snapshots)                    */
+    struct snapshot_l2_table *table;
+    /** Bitset of records with ::SNAPSHOT_TF_CREATE flag in this snapshot  */
+    snapshot_bitset_t create;
+    /** Bitset of records with ::SNAPSHOT_TF_DESTROY flag in this snapshot */
+    snapshot_bitset_t destroy;
+};
+
 /** Snapshot L2 table */
 struct snapshot_l2_table {
+    /** Number of L2 nodes that refer to this table (if greater than 1, do NOT modify) */
+    atomic_uint_fast32_t ref_cnt;
     /** Bitset of valid records   */
     snapshot_bitset_t bitset;
     /** Records in the array      */
@@ -161,9 +185,18 @@ struct snapshot_l2_table {
     struct snapshot_rec recs[SNAPSHOT_TABLE_SIZE];
 };
 
+/** Snapshot compact table (sorted array of records) */
+struct snapshot_small_table {
+    /** Records sorted by Template ID (only first fds_tsnapshot#rec_cnt are valid)     */
+    struct snapshot_rec recs[SNAPSHOT_SMALL_SIZE];
+    /** Ownership flags of the records (see ::SNAPSHOT_TF_OWNERSHIP)                   */
+    uint8_t owner[SNAPSHOT_SMALL_SIZE];
+};
+
 /**
  * \brief Snapshot of valid templates at specific time
- * \warning User can safely manipulate directly with every parameter except #l1_table.
+ * \warning User can safely manipulate directly with every parameter except #small and
+ *   #l1_table.
  *   To add/remove or find a template always use snapshot functions \ref snapshot_aux_func.
  */
 struct fds_tsnapshot {
@@ -203,12 +236,19 @@ struct fds_tsnapshot {
 
     /** Number of records in the snapshot */
     uint16_t rec_cnt;
+    /** Pool allocator of the snapshot and its tables (NULL == heap) */
+    fds_tpool_t *pool;
 
     /**
-     * \brief Table of templates 2-level table of templates.
+     * \brief Compact table of templates (valid only if #l1_table is NULL)
      * \warning Do NOT use directly.
      */
-    struct snapshot_l1_table l1_table;
+    struct snapshot_small_table small;
+    /**
+     * \brief 2-level table of templates (NULL if the compact table is used)
+     * \warning Do NOT use directly.
+     */
+    struct snapshot_l1_table *l1_table;
 };
 
 
@@ -217,10 +257,12 @@ struct fds_tsnapshot {
  *
  * Values of the function will be set to default i.e. zero values and the internal array of the
  * templates will be prepared for further insertion.
+ * \note The snapshot, its copies and their internal tables are allocated from the given pool.
+ * \param[in] pool Pool allocator (can be NULL)
  * \return Pointer or NULL in case of memory error.
  */
 fds_tsnapshot_t *
-snapshot_create();
+snapshot_create(fds_tpool_t *pool);
 
 /**
  * \brief Destroy a snapshot
@@ -235,8 +277,9 @@ snapshot_destroy(struct fds_tsnapshot *snap);
 /**
  * \brief Make a copy of a snapshot
  *
- * The new copy of the snapshot will have its own copy of the array of template references, but the
- * templates will NOT be copied.
+ * The new copy of the snapshot shares L2 tables of template references with the original
+ * snapshot (a table is copied later only if it is modified), but the templates will NOT be
+ * copied. Ownership flags of the records are copied too.
  * \param[in] snap Snapshot
  * \return Pointer or NULL (in case of memory error)
  */
@@ -246,7 +289,8 @@ snapshot_copy(const struct fds_tsnapshot *snap);
 /**
  * \brief Add a snapshot record
  *
- * In other words, this function can be used to add a reference to a template.
+ * In other words, this function can be used to add a reference to a template. Ownership flags
+ * (::SNAPSHOT_TF_OWNERSHIP) of the record are stored separately in the snapshot.
  * \param[in] snap  Snapshot
  * \param[in] rec   Snapshot record
  * \warning If there is already a record with the same ID, it will be rewritten with the new one.
@@ -254,7 +298,7 @@ snapshot_copy(const struct fds_tsnapshot *snap);
  *   added.
  */
 int
-snapshot_rec_add(struct fds_tsnapshot *snap, struct snapshot_rec *rec);
+snapshot_rec_add(struct fds_tsnapshot *snap, const struct snapshot_rec *rec);
 
 /**
  * \brief Remove a snapshot record
@@ -263,7 +307,7 @@ snapshot_rec_add(struct fds_tsnapshot *snap, struct snapshot_rec *rec);
  * will not be freed)
  * \param[in] snap Snapshot
  * \param[in] id   Template ID (from the snapshot record)
- * \return #FDS_OK or #FDS_ERR_NOTFOUND
+ * \return #FDS_OK, #FDS_ERR_NOTFOUND or #FDS_ERR_NOMEM (a copy of a shared table failed)
  */
 int
 snapshot_rec_remove(struct fds_tsnapshot *snap, uint16_t id);
@@ -271,41 +315,74 @@ snapshot_rec_remove(struct fds_tsnapshot *snap, uint16_t id);
 /**
  * \brief Get a snapshot record of a template
  *
+ * \warning The record is shared among snapshots, therefore, it must not be modified. To modify
+ *   it, use snapshot_rec_add() with a modified copy of the record.
  * \param[in] snap Snapshot
  * \param[in] id   Template ID (from the snapshot record)
  * \return Pointer of NULL (if template doesn't exist in the snapshot)
  */
-struct snapshot_rec *
-snapshot_rec_find(struct fds_tsnapshot *snap, uint16_t id);
+const struct snapshot_rec *
+snapshot_rec_cfind(const struct fds_tsnapshot *snap, uint16_t id);
 
 /**
- * \brief Const alternative of snapshot_rec_find()
- * \copydetails snapshot_rec_find
+ * \brief Get all flags of a snapshot record (including ownership flags)
+ * \warning The record MUST exist in the snapshot.
+ * \param[in] snap Snapshot
+ * \param[in] id   Template ID (from the snapshot record)
+ * \return Bitwise OR of #snapshot_rec_flags
  */
-const struct snapshot_rec *
-snapshot_rec_cfind(const struct fds_tsnapshot *snap, uint16_t id);
+uint16_t
+snapshot_rec_flags(const struct fds_tsnapshot *snap, uint16_t id);
+
+/**
+ * \brief Set ownership flags of a snapshot record
+ * \warning The record MUST exist in the snapshot.
+ * \param[in] snap  Snapshot
+ * \param[in] id    Template ID (from the snapshot record)
+ * \param[in] flags Ownership flags to set (see ::SNAPSHOT_TF_OWNERSHIP)
+ */
+void
+snapshot_rec_flags_set(struct fds_tsnapshot *snap, uint16_t id, uint16_t flags);
+
+/**
+ * \brief Clear ownership flags of a snapshot record
+ * \warning The record MUST exist in the snapshot.
+ * \param[in] snap  Snapshot
+ * \param[in] id    Template ID (from the snapshot record)
+ * \param[in] flags Ownership flags to clear (see ::SNAPSHOT_TF_OWNERSHIP)
+ */
+void
+snapshot_rec_flags_clear(struct fds_tsnapshot *snap, uint16_t id, uint16_t flags);
+
+/**
+ * \brief Clear ownership flags of all snapshot records in a snapshot
+ * \param[in] snap  Snapshot
+ * \param[in] flags Ownership flags to clear (see ::SNAPSHOT_TF_OWNERSHIP)
+ */
+void
+snapshot_flags_clear(struct fds_tsnapshot *snap, uint16_t flags);
 
 /**
  * \brief Function callback for a snapshot record
  *
- * \param[in] snap Snapshot
+ * \param[in] rec  Snapshot record (without ownership flags, see snapshot_rec_flags())
  * \param[in] data User defined data for the callback (optional)
  * \return Continue iteration
  */
-typedef bool (*snapshot_rec_cb)(struct snapshot_rec *rec, void *data);
+typedef bool (*snapshot_rec_cb)(const struct snapshot_rec *rec, void *data);
 
 /**
  * \brief Call a function on each snapshot record in a snapshot
  *
  * It is guaranteed that records will be processed in the order given by their Template ID
- * in ascending order. It is also safe to call snapshot_rec_remove() from the callback on
- * this record.
+ * in ascending order. It is also safe to call snapshot_rec_remove() and snapshot_rec_add() from
+ * the callback on this record.
  * \param[in] snap Snapshot
  * \param[in] cb   Callback function
  * \param[in] data User defined data that will be passed to the callback
  */
 void
-snapshot_rec_for(struct fds_tsnapshot *snap, snapshot_rec_cb cb, void *data);
+snapshot_rec_for(const struct fds_tsnapshot *snap, snapshot_rec_cb cb, void *data);
 
 /** @} */ // end of the group
 
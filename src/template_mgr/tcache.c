@@ -0,0 +1,451 @@
+/**
+ * \file src/template_mgr/tcache.c
+ * \author agent <agent@local>
+ * \brief Process-wide cache of parsed templates (source file)
+ * \date 2026
+ */
+
+/* Copyright (C) 2026 CESNET, z.s.p.o.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+
+#include <arpa/inet.h> // ntohs
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libfds.h>
+
+/** Mask of the Enterprise bit of a Field Specifier                         */
+#define TCACHE_EN_BIT    0x8000U
+/** FNV-1a offset basis (64 bits)                                          */
+#define TCACHE_FNV_BASIS 14695981039346656037ULL
+/** FNV-1a prime (64 bits)                                                 */
+#define TCACHE_FNV_PRIME 1099511628211ULL
+
+/** Cached template */
+struct tcache_entry {
+    /** Parsed template with defined IEs (immutable)                       */
+    struct fds_template *tmplt;
+    /** IE manager used to define IEs of the template                      */
+    const fds_iemgr_t *iemgr;
+    /** Hash of the raw template, its type and the IE manager              */
+    uint64_t hash;
+    /** Number of references (the cache itself holds one of them)          */
+    atomic_uint_fast32_t ref_cnt;
+
+    /** Next entry in the same bucket                                      */
+    struct tcache_entry *bucket_next;
+    /** More recently used entry                                           */
+    struct tcache_entry *lru_prev;
+    /** Less recently used entry                                           */
+    struct tcache_entry *lru_next;
+};
+
+/** Cache of parsed templates */
+struct fds_tcache {
+    /** Mutex protecting all members below                                 */
+    pthread_mutex_t lock;
+
+    /** Maximum number of cached templates                                 */
+    uint32_t capacity;
+    /** Hash table (number of buckets is a power of two)                   */
+    struct tcache_entry **buckets;
+    /** Mask of the bucket index                                           */
+    uint64_t bucket_mask;
+
+    /** The most recently used entry                                       */
+    struct tcache_entry *lru_head;
+    /** The least recently used entry                                      */
+    struct tcache_entry *lru_tail;
+
+    /** Statistics                                                         */
+    struct fds_tcache_stats stats;
+};
+
+fds_tcache_t *
+fds_tcache_create(uint32_t capacity)
+{
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    struct fds_tcache *cache = calloc(1, sizeof(*cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    // Keep the load factor of the hash table below 0.5
+    uint64_t buckets_cnt = 1;
+    while (buckets_cnt < 2ULL * capacity) {
+        buckets_cnt <<= 1;
+    }
+
+    cache->buckets = calloc(buckets_cnt, sizeof(*cache->buckets));
+    if (!cache->buckets || pthread_mutex_init(&cache->lock, NULL) != 0) {
+        free(cache->buckets);
+        free(cache);
+        return NULL;
+    }
+
+    cache->capacity = capacity;
+    cache->bucket_mask = buckets_cnt - 1U;
+    return cache;
+}
+
+/**
+ * \brief Release a reference to a cache entry
+ *
+ * The entry is destroyed when the last reference is released.
+ * \param[in] entry Cache entry
+ */
+static void
+tcache_entry_release(struct tcache_entry *entry)
+{
+    if (atomic_fetch_sub(&entry->ref_cnt, 1U) != 1U) {
+        return;
+    }
+
+    fds_template_destroy(entry->tmplt);
+    free(entry);
+}
+
+/**
+ * \brief Remove an entry from the LRU list
+ * \warning The cache MUST be locked.
+ * \param[in] cache Template cache
+ * \param[in] entry Cache entry
+ */
+static void
+tcache_lru_remove(struct fds_tcache *cache, struct tcache_entry *entry)
+{
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+/**
+ * \brief Insert an entry as the most recently used one
+ * \warning The cache MUST be locked.
+ * \param[in] cache Template cache
+ * \param[in] entry Cache entry
+ */
+static void
+tcache_lru_push(struct fds_tcache *cache, struct tcache_entry *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    } else {
+        cache->lru_tail = entry;
+    }
+    cache->lru_head = entry;
+}
+
+/**
+ * \brief Remove an entry from the hash table and the LRU list
+ * \warning The cache MUST be locked.
+ * \param[in] cache Template cache
+ * \param[in] entry Cache entry
+ */
+static void
+tcache_entry_unlink(struct fds_tcache *cache, struct tcache_entry *entry)
+{
+    struct tcache_entry **ptr = &cache->buckets[entry->hash & cache->bucket_mask];
+    while (*ptr != entry) {
+        assert(*ptr != NULL);
+        ptr = &(*ptr)->bucket_next;
+    }
+
+    *ptr = entry->bucket_next;
+    entry->bucket_next = NULL;
+    tcache_lru_remove(cache, entry);
+    cache->stats.entries--;
+}
+
+void
+fds_tcache_clear(fds_tcache_t *cache)
+{
+    pthread_mutex_lock(&cache->lock);
+    struct tcache_entry *list = cache->lru_head;
+    memset(cache->buckets, 0, (cache->bucket_mask + 1U) * sizeof(*cache->buckets));
+    cache->lru_head = cache->lru_tail = NULL;
+    cache->stats.entries = 0;
+    pthread_mutex_unlock(&cache->lock);
+
+    // Entries that are currently copied by other threads will be destroyed by them
+    while (list) {
+        struct tcache_entry *next = list->lru_next;
+        tcache_entry_release(list);
+        list = next;
+    }
+}
+
+void
+fds_tcache_destroy(fds_tcache_t *cache)
+{
+    fds_tcache_clear(cache);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->buckets);
+    free(cache);
+}
+
+void
+fds_tcache_stats(fds_tcache_t *cache, struct fds_tcache_stats *stats)
+{
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * \brief Get the length of a raw template without parsing it
+ * \param[in]  type Type of the template
+ * \param[in]  ptr  Pointer to the template header
+ * \param[in]  max  Maximal length of the raw template
+ * \param[out] len  Length of the raw template (in octets)
+ * \return #FDS_OK on success. Otherwise (malformed or template withdrawal) returns #FDS_ERR_FORMAT.
+ */
+static int
+tcache_raw_len(enum fds_template_type type, const uint8_t *ptr, uint16_t max, uint16_t *len)
+{
+    const struct fds_ipfix_opts_trec *rec = (const struct fds_ipfix_opts_trec *) ptr;
+    const size_t size_normal = sizeof(struct fds_ipfix_trec) - sizeof(fds_ipfix_tmplt_ie);
+    const size_t size_opts = sizeof(struct fds_ipfix_opts_trec) - sizeof(fds_ipfix_tmplt_ie);
+    const size_t size_header = (type == FDS_TYPE_TEMPLATE_OPTS) ? size_opts : size_normal;
+    if (max < size_header) {
+        return FDS_ERR_FORMAT;
+    }
+
+    const uint16_t fields_cnt = ntohs(rec->count);
+    if (fields_cnt == 0) {
+        return FDS_ERR_FORMAT;
+    }
+
+    size_t offset = size_header;
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        if (offset + 4U > max) {
+            return FDS_ERR_FORMAT;
+        }
+
+        const uint16_t ie_id = ntohs(*(const uint16_t *) &ptr[offset]);
+        offset += ((ie_id & TCACHE_EN_BIT) != 0) ? 8U : 4U;
+    }
+
+    if (offset > max) {
+        return FDS_ERR_FORMAT;
+    }
+
+    *len = (uint16_t) offset;
+    return FDS_OK;
+}
+
+/**
+ * \brief Calculate a hash of a raw template
+ * \param[in] type  Type of the template
+ * \param[in] ptr   Raw template
+ * \param[in] len   Length of the raw template
+ * \param[in] iemgr IE manager
+ * \return Hash value
+ */
+static uint64_t
+tcache_hash(enum fds_template_type type, const uint8_t *ptr, uint16_t len,
+    const fds_iemgr_t *iemgr)
+{
+    uint64_t hash = TCACHE_FNV_BASIS;
+    for (uint16_t i = 0; i < len; ++i) {
+        hash = (hash ^ ptr[i]) * TCACHE_FNV_PRIME;
+    }
+
+    hash = (hash ^ (uint64_t) type) * TCACHE_FNV_PRIME;
+    hash = (hash ^ (uint64_t) (uintptr_t) iemgr) * TCACHE_FNV_PRIME;
+    return hash;
+}
+
+/**
+ * \brief Find a cached template
+ * \warning The cache MUST be locked.
+ * \return Pointer to the entry or NULL
+ */
+static struct tcache_entry *
+tcache_find(const struct fds_tcache *cache, uint64_t hash, enum fds_template_type type,
+    const uint8_t *ptr, uint16_t len, const fds_iemgr_t *iemgr)
+{
+    struct tcache_entry *entry = cache->buckets[hash & cache->bucket_mask];
+    for (; entry != NULL; entry = entry->bucket_next) {
+        const struct fds_template *tmplt = entry->tmplt;
+        if (entry->hash != hash || entry->iemgr != iemgr || tmplt->type != type
+                || tmplt->raw.length != len) {
+            continue;
+        }
+
+        if (memcmp(tmplt->raw.data, ptr, len) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Parse a template and define its IEs (i.e. without the cache)
+ * \return Same as fds_tcache_parse()
+ */
+static int
+tcache_parse_new(enum fds_template_type type, const void *ptr, uint16_t *len,
+    const fds_iemgr_t *iemgr, struct fds_template **tmplt)
+{
+    struct fds_template *result;
+    int ret_code = fds_template_parse(type, ptr, len, &result);
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+
+    if (iemgr != NULL && (ret_code = fds_template_ies_define(result, iemgr, false)) != FDS_OK) {
+        fds_template_destroy(result);
+        return ret_code;
+    }
+
+    *tmplt = result;
+    return FDS_OK;
+}
+
+int
+fds_tcache_parse(fds_tcache_t *cache, enum fds_template_type type, const void *ptr,
+    uint16_t *len, const fds_iemgr_t *iemgr, struct fds_template **tmplt)
+{
+    uint16_t raw_len;
+    if (tcache_raw_len(type, ptr, *len, &raw_len) != FDS_OK) {
+        // Template withdrawals and malformed templates are not cached
+        return tcache_parse_new(type, ptr, len, iemgr, tmplt);
+    }
+
+    const uint64_t hash = tcache_hash(type, ptr, raw_len, iemgr);
+
+    pthread_mutex_lock(&cache->lock);
+    struct tcache_entry *entry = tcache_find(cache, hash, type, ptr, raw_len, iemgr);
+    if (entry != NULL) {
+        // Hit -> make it the most recently used one and hold it until it is copied
+        cache->stats.hits++;
+        if (entry != cache->lru_head) {
+            tcache_lru_remove(cache, entry);
+            tcache_lru_push(cache, entry);
+        }
+        atomic_fetch_add(&entry->ref_cnt, 1U);
+    } else {
+        cache->stats.misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (entry != NULL) {
+        struct fds_template *result = fds_template_copy(entry->tmplt);
+        tcache_entry_release(entry);
+        if (!result) {
+            return FDS_ERR_NOMEM;
+        }
+
+        *len = raw_len;
+        *tmplt = result;
+        return FDS_OK;
+    }
+
+    // Miss -> parse the template and insert its copy into the cache
+    struct fds_template *result;
+    int ret_code = tcache_parse_new(type, ptr, len, iemgr, &result);
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+    assert(*len == raw_len);
+
+    entry = calloc(1, sizeof(*entry));
+    struct fds_template *cpy = fds_template_copy(result);
+    if (!entry || !cpy) {
+        // The template is valid, it just cannot be cached
+        free(entry);
+        if (cpy) {
+            fds_template_destroy(cpy);
+        }
+
+        *tmplt = result;
+        return FDS_OK;
+    }
+
+    entry->tmplt = cpy;
+    entry->iemgr = iemgr;
+    entry->hash = hash;
+    atomic_init(&entry->ref_cnt, 1U);
+
+    struct tcache_entry *evicted = NULL;
+    pthread_mutex_lock(&cache->lock);
+    if (tcache_find(cache, hash, type, ptr, raw_len, iemgr) != NULL) {
+        // Another thread has already inserted the same template
+        pthread_mutex_unlock(&cache->lock);
+        tcache_entry_release(entry);
+        *tmplt = result;
+        return FDS_OK;
+    }
+
+    if (cache->stats.entries == cache->capacity) {
+        // Remove the least recently used template
+        evicted = cache->lru_tail;
+        tcache_entry_unlink(cache, evicted);
+        cache->stats.evictions++;
+    }
+
+    entry->bucket_next = cache->buckets[hash & cache->bucket_mask];
+    cache->buckets[hash & cache->bucket_mask] = entry;
+    tcache_lru_push(cache, entry);
+    cache->stats.entries++;
+    pthread_mutex_unlock(&cache->lock);
+
+    if (evicted != NULL) {
+        tcache_entry_release(evicted);
+    }
+
+    *tmplt = result;
+    return FDS_OK;
+}
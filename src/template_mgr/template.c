@@ -46,6 +46,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <libfds.h>
 
@@ -57,6 +58,21 @@
     - sizeof(struct fds_tfield) \
     + ((elem_cnt) * sizeof(struct fds_tfield))
 
+/*
+ * All parts of a template are stored in a single memory block in the following order:
+ * template structure (including fields), reverse fields, raw template, lookup index.
+ * Space for reverse fields is always reserved, even if the template is not a Biflow template.
+ */
+/** Offset of reverse fields in a memory block of a template                                 */
+#define TEMPLATE_OFFSET_REV(elem_cnt) \
+    TEMPLATE_STRUCT_SIZE(elem_cnt)
+/** Offset of the raw template in a memory block of a template                               */
+#define TEMPLATE_OFFSET_RAW(elem_cnt) \
+    (TEMPLATE_OFFSET_REV(elem_cnt) + ((elem_cnt) * sizeof(struct fds_tfield)))
+/** Offset of the lookup index in a memory block of a template (aligned to 2 bytes)          */
+#define TEMPLATE_OFFSET_IDX(elem_cnt, raw_len) \
+    ((TEMPLATE_OFFSET_RAW(elem_cnt) + (raw_len) + 1U) & ~((size_t) 1U))
+
 /** Return only first bit from a _value_ */
 #define EN_BIT_GET(_value_)  ((_value_) & (uint16_t) 0x8000)
 /** Return _value_ without the first bit */
@@ -505,6 +521,112 @@ template_parse_fields(struct fds_template *tmplt, const fds_ipfix_tmplt_ie *fiel
     return FDS_OK;
 }
 
+/**
+ * \brief Calculate a hash of a field identification (for the lookup index)
+ * \param[in] en Enterprise Number
+ * \param[in] id Information Element ID
+ * \return Hash value
+ */
+static inline uint32_t
+template_index_hash(uint32_t en, uint16_t id)
+{
+    uint32_t hash = (en * 2654435761U) ^ id;
+    hash ^= hash >> 15;
+    hash *= 2246822519U;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/**
+ * \brief Get the number of slots of a lookup index of template fields
+ * \param[in]  tmplt     Template structure (with parsed fields)
+ * \param[out] slots_cnt Number of slots of the hash table (a power of two)
+ * \param[out] var_cnt   Number of variable-length fields
+ * \return Total number of items of the index (see fds_template#index)
+ */
+static size_t
+template_index_size(const struct fds_template *tmplt, uint32_t *slots_cnt, uint16_t *var_cnt)
+{
+    const uint16_t fields_cnt = tmplt->fields_cnt_total;
+
+    // Load factor of the table is at most 50%
+    uint32_t slots = 2;
+    while (slots < 2U * fields_cnt) {
+        slots <<= 1;
+    }
+
+    // Layout of variable-length fields is stored behind the slots (see fds_template#index)
+    uint16_t vars = 0;
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        if (tmplt->fields[i].length == FDS_IPFIX_VAR_IE_LEN) {
+            vars++;
+        }
+    }
+
+    *slots_cnt = slots;
+    *var_cnt = vars;
+    return slots + vars + 1U;
+}
+
+/**
+ * \brief Build a lookup index of template fields
+ *
+ * The index maps each combination of an Enterprise Number and an Information Element ID to
+ * the first occurrence of the field in the template (see fds_template#index). Since template
+ * fields (IDs and Enterprise Numbers) cannot be changed after parsing, the index must be built
+ * only once. A unique identifier of the layout of fields is also assigned.
+ * \param[in] tmplt Template structure
+ * \param[in] slots Zeroed memory for the index (see template_index_size())
+ */
+static void
+template_index_build(struct fds_template *tmplt, uint16_t *slots)
+{
+    const uint16_t fields_cnt = tmplt->fields_cnt_total;
+    uint32_t slots_cnt;
+    uint16_t var_cnt;
+    template_index_size(tmplt, &slots_cnt, &var_cnt);
+
+    uint16_t *var_segs = &slots[slots_cnt];
+    uint16_t seg_idx = 0;
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        const uint16_t length = tmplt->fields[i].length;
+        if (length == FDS_IPFIX_VAR_IE_LEN) {
+            seg_idx++;
+            continue;
+        }
+
+        var_segs[seg_idx] += length; // Overflow is resolved by check of total data length
+    }
+
+    const uint32_t mask = slots_cnt - 1;
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        const struct fds_tfield *field = &tmplt->fields[i];
+        uint32_t pos = template_index_hash(field->en, field->id) & mask;
+
+        // Linear probing (only the first occurrence of each IE is stored)
+        while (slots[pos] != 0) {
+            const struct fds_tfield *other = &tmplt->fields[slots[pos] - 1U];
+            if (other->id == field->id && other->en == field->en) {
+                break;
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        if (slots[pos] == 0) {
+            slots[pos] = i + 1U;
+        }
+    }
+
+    // Identifier of the layout of fields (the first assigned value is 1)
+    static atomic_uint_fast64_t layout_cnt = 0;
+
+    tmplt->index.mask = mask;
+    tmplt->index.slots = slots;
+    tmplt->index.var_cnt = var_cnt;
+    tmplt->index.var_segs = var_segs;
+    tmplt->index.layout_id = atomic_fetch_add_explicit(&layout_cnt, 1, memory_order_relaxed) + 1U;
+}
+
 /**
  * \brief Set feature flags of all Field Specifiers in a template
  *
@@ -584,6 +706,7 @@ template_calc_features(struct fds_template *tmplt)
     const uint16_t fields_total = tmplt->fields_cnt_total;
     uint32_t data_len = 0; // Get (minimum) data length of a record referenced by this template
     uint16_t field_offset = 0;
+    tmplt->index.var_first = fields_total;
 
     for (uint16_t i = 0; i < fields_total; ++i) {
         struct fds_tfield *field_ptr = &tmplt->fields[i];
@@ -596,6 +719,10 @@ template_calc_features(struct fds_template *tmplt)
         const uint16_t field_len = field_ptr->length;
         if (field_len == FDS_IPFIX_VAR_IE_LEN) {
             // Variable length Information Element must be at least 1 byte long
+            if ((tmplt->flags & FDS_TEMPLATE_DYNAMIC) == 0) {
+                // The first variable-length field (i.e. the last field with known offset)
+                tmplt->index.var_first = i;
+            }
             tmplt->flags |= FDS_TEMPLATE_DYNAMIC;
             data_len += 1;
             field_offset = FDS_IPFIX_VAR_IE_LEN;
@@ -627,22 +754,48 @@ template_calc_features(struct fds_template *tmplt)
 }
 
 /**
- * \brief Create a copy of a raw template and assign the copy to a template structure
- * \param[in] tmplt Template structure
- * \param[in] ptr   Pointer to the raw template
- * \param[in] len   Real length of the raw template
- * \return #FDS_OK or #FDS_ERR_NOMEM
+ * \brief Extend a memory block of a parsed template with a raw template and a lookup index
+ *
+ * The template structure is reallocated to fit all its parts (see TEMPLATE_OFFSET_IDX()),
+ * the raw template is copied and the lookup index of fields is built. Space for reverse
+ * fields is reserved too, therefore, no other allocation is required later.
+ * \param[in,out] tmplt Template structure (can be moved to a new memory location)
+ * \param[in]     ptr   Pointer to the raw template
+ * \param[in]     len   Real length of the raw template
+ * \return On success returns #FDS_OK. Otherwise returns #FDS_ERR_NOMEM and the original
+ *   template structure is untouched.
  */
-static inline int
-template_raw_copy(struct fds_template *tmplt, const void *ptr, uint16_t len)
+static int
+template_block_finish(struct fds_template **tmplt, const void *ptr, uint16_t len)
 {
-    tmplt->raw.data = (uint8_t *) malloc(len);
-    if (!tmplt->raw.data) {
+    struct fds_template *old = *tmplt;
+    const uint16_t fields_cnt = old->fields_cnt_total;
+    const size_t offset_raw = TEMPLATE_OFFSET_RAW(fields_cnt);
+    const size_t offset_idx = TEMPLATE_OFFSET_IDX(fields_cnt, len);
+
+    uint32_t slots_cnt;
+    uint16_t var_cnt;
+    const size_t idx_cnt = (fields_cnt != 0)
+        ? template_index_size(old, &slots_cnt, &var_cnt)
+        : 0;
+
+    uint8_t *block = realloc(old, offset_idx + idx_cnt * sizeof(uint16_t));
+    if (!block) {
         return FDS_ERR_NOMEM;
     }
 
-    memcpy(tmplt->raw.data, ptr, len);
-    tmplt->raw.length = len;
+    struct fds_template *new = (struct fds_template *) block;
+    new->raw.data = &block[offset_raw];
+    new->raw.length = len;
+    memcpy(new->raw.data, ptr, len);
+
+    if (idx_cnt != 0) {
+        uint16_t *slots = (uint16_t *) &block[offset_idx];
+        memset(slots, 0, idx_cnt * sizeof(*slots));
+        template_index_build(new, slots);
+    }
+
+    *tmplt = new;
     return FDS_OK;
 }
 
@@ -664,7 +817,7 @@ fds_template_parse(enum fds_template_type type, const void *ptr, uint16_t *len,
 
     if (template->fields_cnt_total == 0) {
         // No fields... just copy the raw template
-        ret_code = template_raw_copy(template, ptr, len_header);
+        ret_code = template_block_finish(&template, ptr, len_header);
         if (ret_code != FDS_OK) {
             fds_template_destroy(template);
             return ret_code;
@@ -684,9 +837,9 @@ fds_template_parse(enum fds_template_type type, const void *ptr, uint16_t *len,
         return ret_code;
     }
 
-    // Copy raw template
+    // Copy raw template and build the lookup index of fields (required by Options Template detector)
     len_real = len_header + len_fields;
-    ret_code = template_raw_copy(template, ptr, len_real);
+    ret_code = template_block_finish(&template, ptr, len_real);
     if (ret_code != FDS_OK) {
         fds_template_destroy(template);
         return ret_code;
@@ -707,36 +860,37 @@ fds_template_parse(enum fds_template_type type, const void *ptr, uint16_t *len,
 struct fds_template *
 fds_template_copy(const struct fds_template *tmplt)
 {
-    const size_t size_main = TEMPLATE_STRUCT_SIZE(tmplt->fields_cnt_total);
-    const size_t size_raw = tmplt->raw.length;
-    const size_t size_rev = tmplt->fields_cnt_total * sizeof(*(tmplt->fields_rev));
-
-    struct fds_template *cpy_main = malloc(size_main);
-    uint8_t *cpy_raw = malloc(size_raw);
-    struct fds_tfield *cpy_rev = (tmplt->fields_rev) ? malloc(size_rev) : NULL;
-    if (!cpy_main || !cpy_raw || (tmplt->fields_rev && !cpy_rev)) {
-        free(cpy_main);
-        free(cpy_raw);
-        free(cpy_rev);
+    // All parts of the template are stored in a single memory block
+    const uint16_t fields_cnt = tmplt->fields_cnt_total;
+    const size_t offset_idx = TEMPLATE_OFFSET_IDX(fields_cnt, tmplt->raw.length);
+    const size_t size_idx = (tmplt->index.slots)
+        ? (tmplt->index.mask + 1U + tmplt->index.var_cnt + 1U) * sizeof(*(tmplt->index.slots))
+        : 0;
+
+    uint8_t *block = malloc(offset_idx + size_idx);
+    if (!block) {
         return NULL;
     }
 
-    memcpy(cpy_main, tmplt, size_main);
-    memcpy(cpy_raw, tmplt->raw.data, size_raw);
+    memcpy(block, tmplt, offset_idx + size_idx);
+
+    // Update pointers to the parts of the new block
+    struct fds_template *cpy = (struct fds_template *) block;
+    cpy->raw.data = &block[TEMPLATE_OFFSET_RAW(fields_cnt)];
     if (tmplt->fields_rev) {
-        memcpy(cpy_rev, tmplt->fields_rev, size_rev);
+        cpy->fields_rev = (struct fds_tfield *) &block[TEMPLATE_OFFSET_REV(fields_cnt)];
     }
-
-    cpy_main->raw.data = cpy_raw;
-    cpy_main->fields_rev = cpy_rev;
-    return cpy_main;
+    if (tmplt->index.slots) {
+        cpy->index.slots = (uint16_t *) &block[offset_idx];
+        cpy->index.var_segs = &cpy->index.slots[tmplt->index.mask + 1U];
+    }
+    return cpy;
 }
 
 void
 fds_template_destroy(struct fds_template *tmplt)
 {
-    free(tmplt->raw.data);
-    free(tmplt->fields_rev);
+    // All parts of the template are stored in a single memory block
     free(tmplt);
 }
 
@@ -762,14 +916,22 @@ is_structured(const struct fds_iemgr_elem *elem)
 const struct fds_tfield *
 fds_template_cfind(const struct fds_template *tmplt, uint32_t en, uint16_t id)
 {
-    const uint16_t field_cnt = tmplt->fields_cnt_total;
-    for (uint16_t i = 0; i < field_cnt; ++i) {
-        const struct fds_tfield *ptr = &tmplt->fields[i];
-        if (ptr->id != id || ptr->en != en) {
-            continue;
-        }
+    const uint16_t *slots = tmplt->index.slots;
+    if (!slots) {
+        // Template Withdrawal (no fields)
+        return NULL;
+    }
+
+    const uint32_t mask = tmplt->index.mask;
+    uint32_t pos = template_index_hash(en, id) & mask;
 
-        return ptr;
+    // Linear probing until an empty slot is reached
+    while (slots[pos] != 0) {
+        const struct fds_tfield *ptr = &tmplt->fields[slots[pos] - 1U];
+        if (ptr->id == id && ptr->en == en) {
+            return ptr;
+        }
+        pos = (pos + 1) & mask;
     }
 
     return NULL;
@@ -888,9 +1050,10 @@ template_ies_biflow_src2dst(const fds_iemgr_t *iemgr, uint32_t pen, uint16_t *id
  * \warning Function expects that template fields already have references to IE definitions.
  * \warning This function can be used only if at least one template field is reverse. Otherwise
  *   flags doesn't make sense.
+ * \note Space for reverse fields is reserved in the memory block of the template.
  * \param[in] tmplt Template
  * \param[in] iemgr IE manager
- * \return On success returns #FDS_OK. Otherwise (memory allocation error) returns #FDS_ERR_NOMEM.
+ * \return Always returns #FDS_OK.
  */
 static int
 template_ies_biflow(struct fds_template *tmplt, const fds_iemgr_t *iemgr)
@@ -903,12 +1066,10 @@ template_ies_biflow(struct fds_template *tmplt, const fds_iemgr_t *iemgr)
     // Create reverse template fields if required
     const uint16_t fields_cnt = tmplt->fields_cnt_total;
     if (!tmplt->fields_rev) {
-        // Create reverse template fields
+        // Create reverse template fields (space is reserved in the memory block of the template)
         const size_t fields_size = fields_cnt * sizeof(tmplt->fields[0]);
-        tmplt->fields_rev = malloc(fields_size);
-        if (!tmplt->fields_rev) {
-            return FDS_ERR_NOMEM;
-        }
+        uint8_t *block = (uint8_t *) tmplt;
+        tmplt->fields_rev = (struct fds_tfield *) &block[TEMPLATE_OFFSET_REV(fields_cnt)];
 
         // Copy fields
         memcpy(tmplt->fields_rev, tmplt->fields, fields_size);
@@ -996,8 +1157,7 @@ fds_template_ies_define(struct fds_template *tmplt, const fds_iemgr_t *iemgr, bo
     }
 
     if (!preserve && tmplt->fields_rev != NULL) {
-        // Cleanup first
-        free(tmplt->fields_rev);
+        // Cleanup first (reverse fields are part of the memory block of the template)
         tmplt->fields_rev = NULL;
     }
 
@@ -43,9 +43,13 @@
 #include <stdint.h>
 #include <libfds.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "garbage.h"
+#include "ierefs.h"
+#include "pool.h"
+#include "refresh.h"
 #include "snapshot.h"
 
 /** Default snapshot lifetime if the history mod is enabled */
@@ -81,7 +85,8 @@ enum withdraw_mod_e {
  * the template manager's hierarchy, "Delete" flags (if possible) must be moved to another snapshot
  * first. Flags are only thing that can be modified on frozen snapshots! A newly added template
  * (a refreshed template is also a new one) inserted to the manager's snapshot always has both
- * flags ("Create" and "Delete") set.
+ * flags ("Create" and "Delete") set. The only exception is a refresh of a template in the newest
+ * snapshot that doesn't change anything, which is ignored (see mgr_template_refresh()).
  *
  * All template operations (adding/withdrawing/etc.) are always performed on a snapshot in the
  * hierarchy (usually on the newest one) that is in editable mode. When a reference to a template
@@ -161,8 +166,21 @@ struct fds_tmgr {
          *  fds_tmgr#time_now)
          */
         struct fds_tsnapshot *current;
+        /** Number of editable snapshots in the linked-list */
+        size_t editable_cnt;
     } list; /**< Link to snapshots in a linked-list */
 
+    struct {
+        /** Array of snapshots sorted from the oldest to the newest (valid only if #valid) */
+        struct fds_tsnapshot **items;
+        /** Number of snapshots in the array */
+        size_t cnt;
+        /** Allocated size of the array */
+        size_t size;
+        /** The array is synchronized with the linked-list */
+        bool valid;
+    } index; /**< Time index of snapshots (for logarithmic seek) */
+
     struct {
         /** Type of session */
         enum fds_session_type session_type;
@@ -176,19 +194,24 @@ struct fds_tmgr {
 
     /** Database of IPFIX Information Elements  */
     const fds_iemgr_t *ies_db;
+    /** Templates that refer to Information Elements (see fds_tmgr_update_iemgr())   */
+    struct ierefs ierefs;
+
+    struct {
+        /** Timestamps of refreshed templates (see mgr_template_refresh())             */
+        struct refresh_tab tab;
+        /** Export Time of the latest refresh (valid only if #pending)                */
+        uint32_t time_last;
+        /** The newest snapshot hasn't been split since the refresh (see mgr_refresh_split()) */
+        bool pending;
+    } refresh; /**< Refreshed templates */
 
     /** Garbage ready to throw away (old unreachable templates/snapshots/etc.) */
     fds_tgarbage_t *garbage;
+    /** Pool allocator of snapshots (NULL == heap) */
+    fds_tpool_t *pool;
 };
 
-/**
- * \brief Maximum of two integers
- * \param[in] a First integer
- * \param[in] b Second integer
- * \return Maximum
- */
-#define MAX(a, b) (((a) > (b)) ? (a) : (b))
-
 /**
  * \brief Compare snapshot timestamps (with timestamp wraparound support)
  * \param t1 First timestamp
@@ -259,6 +282,177 @@ mgr_time_cmp(uint32_t t1, uint32_t t2)
  */
 #define TIME_GT(t1, t2) (mgr_time_cmp((t1), (t2)) > 0)
 
+/** Default number of preallocated items of the time index */
+#define INDEX_DEF_SIZE 16
+
+/**
+ * \brief Mark the time index of snapshots as outdated
+ *
+ * The index will be rebuilt from the linked-list of snapshots during the next seek operation.
+ * It is cheaper to use this function instead of updating the index after each change, if
+ * multiple snapshots are going to be removed at once.
+ * \param[in] mgr Template manager
+ */
+static inline void
+mgr_index_invalidate(struct fds_tmgr *mgr)
+{
+    mgr->index.valid = false;
+    mgr->index.cnt = 0;
+}
+
+/**
+ * \brief Make sure that the time index has enough space for at least \p cnt snapshots
+ * \param[in] mgr Template manager
+ * \param[in] cnt Number of snapshots
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+mgr_index_reserve(struct fds_tmgr *mgr, size_t cnt)
+{
+    if (cnt <= mgr->index.size) {
+        return FDS_OK;
+    }
+
+    size_t new_size = (mgr->index.size != 0) ? mgr->index.size : INDEX_DEF_SIZE;
+    while (new_size < cnt) {
+        new_size *= 2;
+    }
+
+    struct fds_tsnapshot **new_items = realloc(mgr->index.items, new_size * sizeof(*new_items));
+    if (!new_items) {
+        return FDS_ERR_NOMEM;
+    }
+
+    mgr->index.items = new_items;
+    mgr->index.size = new_size;
+    return FDS_OK;
+}
+
+/**
+ * \brief Rebuild the time index of snapshots (if necessary)
+ * \param[in] mgr Template manager
+ * \return #FDS_OK or #FDS_ERR_NOMEM (the index remains invalid)
+ */
+static int
+mgr_index_rebuild(struct fds_tmgr *mgr)
+{
+    if (mgr->index.valid) {
+        return FDS_OK;
+    }
+
+    size_t cnt = 0;
+    for (struct fds_tsnapshot *ptr = mgr->list.oldest; ptr != NULL; ptr = ptr->link.newer) {
+        cnt++;
+    }
+
+    if (mgr_index_reserve(mgr, cnt) != FDS_OK) {
+        return FDS_ERR_NOMEM;
+    }
+
+    size_t idx = 0;
+    for (struct fds_tsnapshot *ptr = mgr->list.oldest; ptr != NULL; ptr = ptr->link.newer) {
+        mgr->index.items[idx++] = ptr;
+    }
+
+    mgr->index.cnt = cnt;
+    mgr->index.valid = true;
+    return FDS_OK;
+}
+
+/**
+ * \brief Get the number of indexed snapshots with start time before \p time or the same
+ *
+ * In other words, the function returns the position of the first snapshot that starts after
+ * the \p time. Because all snapshots are always within the snapshot lifetime window, comparison
+ * of timestamps with wraparound support preserves order of the index.
+ * \warning The index MUST be valid.
+ * \param[in] mgr  Template manager
+ * \param[in] time Timestamp
+ * \return Position
+ */
+static size_t
+mgr_index_upper(const struct fds_tmgr *mgr, uint32_t time)
+{
+    assert(mgr->index.valid);
+    size_t low = 0;
+    size_t high = mgr->index.cnt;
+
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (TIME_LE(mgr->index.items[mid]->start_time, time)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * \brief Find the newest snapshot with start time before \p time or the same
+ * \param[in]  mgr  Template manager
+ * \param[in]  time Timestamp
+ * \param[out] snap Snapshot (NULL, if all snapshots start after the \p time)
+ * \return #FDS_OK on success. #FDS_ERR_NOMEM, if the index cannot be rebuilt.
+ */
+static int
+mgr_index_find(struct fds_tmgr *mgr, uint32_t time, struct fds_tsnapshot **snap)
+{
+    if (mgr_index_rebuild(mgr) != FDS_OK) {
+        return FDS_ERR_NOMEM;
+    }
+
+    const size_t pos = mgr_index_upper(mgr, time);
+    *snap = (pos > 0) ? mgr->index.items[pos - 1] : NULL;
+    return FDS_OK;
+}
+
+/**
+ * \brief Insert a new snapshot into the time index
+ *
+ * The new snapshot \p new must be already linked next to the \p anchor. If the index is not valid,
+ * nothing happens. If the index cannot be updated, it is marked as invalid.
+ * \param[in] mgr    Template manager
+ * \param[in] anchor Snapshot that has been used as an anchor
+ * \param[in] new    Inserted snapshot
+ * \param[in] newer  The new snapshot is a successor (true) or a predecessor (false) of the anchor
+ */
+static void
+mgr_index_insert(struct fds_tmgr *mgr, const struct fds_tsnapshot *anchor,
+    struct fds_tsnapshot *new, bool newer)
+{
+    if (!mgr->index.valid) {
+        return;
+    }
+
+    if (mgr_index_reserve(mgr, mgr->index.cnt + 1) != FDS_OK) {
+        mgr_index_invalidate(mgr);
+        return;
+    }
+
+    // Find the position of the anchor (the most common case is appending a new snapshot)
+    size_t pos = mgr->index.cnt;
+    if (pos == 0 || mgr->index.items[pos - 1] != anchor) {
+        pos = mgr_index_upper(mgr, anchor->start_time);
+        while (pos > 0 && mgr->index.items[pos - 1] != anchor) {
+            // Skip snapshots with the same start time
+            assert(TIME_EQ(mgr->index.items[pos - 1]->start_time, anchor->start_time));
+            pos--;
+        }
+        assert(pos > 0);
+    }
+
+    if (!newer) {
+        pos--;
+    }
+
+    struct fds_tsnapshot **items = mgr->index.items;
+    memmove(&items[pos + 1], &items[pos], (mgr->index.cnt - pos) * sizeof(*items));
+    items[pos] = new;
+    mgr->index.cnt++;
+}
+
 
 /**
  * \brief Insert a new snapshot into hierarchy (as a newer snapshot)
@@ -295,6 +489,7 @@ mgr_link_newer(struct fds_tsnapshot *anchor, struct fds_tsnapshot *new)
 
     anchor->link.newer = new;
     new->link.older = anchor;
+    mgr_index_insert(new->link.mgr, anchor, new, true);
 }
 
 /**
@@ -332,6 +527,7 @@ mgr_link_older(struct fds_tsnapshot *anchor, struct fds_tsnapshot *new)
 
     new->link.newer = anchor;
     anchor->link.older = new;
+    mgr_index_insert(new->link.mgr, anchor, new, false);
 }
 
 /**
@@ -345,7 +541,7 @@ mgr_link_older(struct fds_tsnapshot *anchor, struct fds_tsnapshot *new)
 static struct fds_tsnapshot *
 mgr_snap_create(struct fds_tmgr *mgr, uint32_t time)
 {
-    struct fds_tsnapshot *snap = snapshot_create();
+    struct fds_tsnapshot *snap = snapshot_create(mgr->pool);
     if (!snap) {
         return NULL;
     }
@@ -365,22 +561,24 @@ mgr_snap_create(struct fds_tmgr *mgr, uint32_t time)
         mgr->list.oldest = snap;
         mgr->list.newest = snap;
         snap->link.mgr = mgr;
+        mgr_index_invalidate(mgr);
     }
 
+    mgr->list.editable_cnt++;
     return snap;
 }
 
 /**
  * \brief Callback function that will free all templates with set "Delete" flag
  * \param[in] rec  Snapshot record
- * \param[in] data Not used
+ * \param[in] data Snapshot from which the record comes
  * \return Always true.
  */
 static bool
-mgr_snap_destroy_cb(struct snapshot_rec *rec, void *data)
+mgr_snap_destroy_cb(const struct snapshot_rec *rec, void *data)
 {
-    (void) data; // Not used...
-    if (rec->flags & SNAPSHOT_TF_DESTROY) {
+    const struct fds_tsnapshot *snap = data;
+    if (snapshot_rec_flags(snap, rec->id) & SNAPSHOT_TF_DESTROY) {
         fds_template_destroy(rec->ptr);
     }
     return true;
@@ -399,37 +597,30 @@ static void
 mgr_snap_destroy(struct fds_tsnapshot *snap)
 {
     // Free all templates with the "Delete flag"
-    snapshot_rec_for(snap, &mgr_snap_destroy_cb, NULL);
+    snapshot_rec_for(snap, &mgr_snap_destroy_cb, snap);
     snapshot_destroy(snap);
 }
 
 /**
- * \brief Try to move "Delete" flag
+ * \brief Try to pass "Delete" flag to an ancestor
  *
- * If possible, the flag will be moved to the first snapshot older (predecessor) than this one
- * that has a reference to a template with the given ID.
- * \param[in] snap Snapshot
- * \param[in] id   Template ID
+ * If possible, the flag will be set in the first snapshot older (predecessor) than this one
+ * that has a reference to the given template.
+ * \note The flag of the snapshot \p snap is not modified.
+ * \param[in] snap  Snapshot
+ * \param[in] id    Template ID
+ * \param[in] tmplt Template (address only)
  * \return On success returns #FDS_OK. If the other snapshot is not found, the function will
- *   return #FDS_ERR_NOTFOUND and the flag will not be changed.
+ *   return #FDS_ERR_NOTFOUND.
  */
 static int
-mgr_snap_dflag_move(struct fds_tsnapshot *snap, uint16_t id)
+mgr_snap_dflag_pass(const struct fds_tsnapshot *snap, uint16_t id,
+    const struct fds_template *tmplt)
 {
-    // Make sure that the snapshot has the "Delete" flag
-    struct snapshot_rec *snap_rec = snapshot_rec_find(snap, id);
-    assert((snap_rec->flags & SNAPSHOT_TF_DESTROY) != 0);
-
-    if (snap_rec->flags & SNAPSHOT_TF_CREATE) {
-        // No one in the past can have a reference to this template
-        return FDS_ERR_NOTFOUND;
-    }
-
     struct fds_tsnapshot *ancestor = snap->link.older;
-    struct snapshot_rec *ancestor_rec;
     while (ancestor != NULL) {
-        ancestor_rec = snapshot_rec_find(ancestor, id);
-        if (!ancestor_rec || ancestor_rec->ptr != snap_rec->ptr) {
+        const struct snapshot_rec *ancestor_rec = snapshot_rec_cfind(ancestor, id);
+        if (!ancestor_rec || ancestor_rec->ptr != tmplt) {
             /* This snapshot doesn't have a pointer to the template or the pointer is different
              * due to history modification. We have to skip to the next ancestor.
              */
@@ -446,9 +637,40 @@ mgr_snap_dflag_move(struct fds_tsnapshot *snap, uint16_t id)
         return FDS_ERR_NOTFOUND;
     }
 
+    snapshot_rec_flags_set(ancestor, id, SNAPSHOT_TF_DESTROY);
+    return FDS_OK;
+}
+
+/**
+ * \brief Try to move "Delete" flag
+ *
+ * If possible, the flag will be moved to the first snapshot older (predecessor) than this one
+ * that has a reference to a template with the given ID.
+ * \param[in] snap Snapshot
+ * \param[in] id   Template ID
+ * \return On success returns #FDS_OK. If the other snapshot is not found, the function will
+ *   return #FDS_ERR_NOTFOUND and the flag will not be changed.
+ */
+static int
+mgr_snap_dflag_move(struct fds_tsnapshot *snap, uint16_t id)
+{
+    // Make sure that the snapshot has the "Delete" flag
+    const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap, id);
+    const uint16_t snap_flags = snapshot_rec_flags(snap, id);
+    assert((snap_flags & SNAPSHOT_TF_DESTROY) != 0);
+
+    if (snap_flags & SNAPSHOT_TF_CREATE) {
+        // No one in the past can have a reference to this template
+        return FDS_ERR_NOTFOUND;
+    }
+
+    if (mgr_snap_dflag_pass(snap, id, snap_rec->ptr) != FDS_OK) {
+        // Not found
+        return FDS_ERR_NOTFOUND;
+    }
+
     // Transfer the flag
-    snap_rec->flags &= ~SNAPSHOT_TF_DESTROY;
-    ancestor_rec->flags |= SNAPSHOT_TF_DESTROY;
+    snapshot_rec_flags_clear(snap, id, SNAPSHOT_TF_DESTROY);
     return FDS_OK;
 }
 
@@ -461,13 +683,13 @@ mgr_snap_dflag_move(struct fds_tsnapshot *snap, uint16_t id)
  * \return Always true
  */
 static bool
-mgr_snap_remove_cb(struct snapshot_rec *rec, void *data)
+mgr_snap_remove_cb(const struct snapshot_rec *rec, void *data)
 {
     struct fds_tsnapshot *snap = data;
-    assert(snapshot_rec_find(snap, rec->id) == rec);
+    assert(snapshot_rec_cfind(snap, rec->id) != NULL);
 
     // Process only records with "Delete" flag
-    if (rec->flags & SNAPSHOT_TF_DESTROY) {
+    if (snapshot_rec_flags(snap, rec->id) & SNAPSHOT_TF_DESTROY) {
         /* Try to move the flag. It can remain here, if this is the last reference among snapshots
          * in the template manager and the template will be destroyed together with this snapshot.
          */
@@ -516,6 +738,11 @@ mgr_snap_remove(struct fds_tsnapshot *snap)
         mgr->list.current = NULL;
     }
 
+    if (snap->editable) {
+        assert(mgr->list.editable_cnt > 0);
+        mgr->list.editable_cnt--;
+    }
+
     // Clear pointers (just for sure)
     snap->link.newer = snap->link.older = NULL;
     snap->link.mgr = NULL;
@@ -526,37 +753,76 @@ mgr_snap_remove(struct fds_tsnapshot *snap)
 }
 
 /**
- * \brief Clear "Create flag" of a snapshot record (callback function)
+ * \brief Clear "Delete flag" of a snapshot record in another snapshot (callback function)
  * \param[in] rec  Snapshot record
- * \param[in] data Not used
+ * \param[in] data Snapshot in which the flag will be cleared
  * \return Always true
  */
 static bool
-mgr_snap_clone_cflag_cb(struct snapshot_rec *rec, void *data)
+mgr_snap_clone_dflag_cb(const struct snapshot_rec *rec, void *data)
 {
-    (void) data;
-    rec->flags &= ~SNAPSHOT_TF_CREATE;
+    struct fds_tsnapshot *snap = data;
+    snapshot_rec_flags_clear(snap, rec->id, SNAPSHOT_TF_DESTROY);
     return true;
 }
 
 /**
- * \brief Clear "Delete flag" of a snapshot record (callback function)
- * \param[in] rec  Snapshot record
- * \param[in] data Not used
- * \return Always true
+ * \brief Get the Export Time of the last refresh of a template
+ *
+ * Templates are not modified when they are refreshed (see mgr_template_refresh()), therefore,
+ * the table of refreshed templates must be checked first.
+ * \param[in] mgr   Template manager
+ * \param[in] tmplt Template
+ * \return Timestamp
  */
-static bool
-mgr_snap_clone_dflag_cb(struct snapshot_rec *rec, void *data)
+static inline uint32_t
+mgr_tmplt_last_seen(const struct fds_tmgr *mgr, const struct fds_template *tmplt)
 {
-    (void) data;
-    rec->flags &= ~SNAPSHOT_TF_DESTROY;
-    return true;
+    const struct refresh_rec *rec = refresh_find(&mgr->refresh.tab, tmplt);
+    return (rec != NULL) ? rec->last_seen : tmplt->time.last_seen;
+}
+
+/**
+ * \brief Get the end of life of a template (including its last refresh)
+ * \param[in] mgr   Template manager
+ * \param[in] tmplt Template
+ * \return Timestamp
+ */
+static inline uint32_t
+mgr_tmplt_end_of_life(const struct fds_tmgr *mgr, const struct fds_template *tmplt)
+{
+    const struct refresh_rec *rec = refresh_find(&mgr->refresh.tab, tmplt);
+    return (rec != NULL) ? rec->end_of_life : tmplt->time.end_of_life;
+}
+
+/**
+ * \brief Prepare a new template for insertion into a manager
+ *
+ * A record of a previously destroyed template with the same address is removed from the table
+ * of refreshed templates. If the template is a copy of a refreshed template \p orig, the copy
+ * takes over the timestamps of the last refresh (nobody else can have a reference to the copy
+ * yet).
+ * \param[in] mgr   Template manager
+ * \param[in] tmplt New template
+ * \param[in] orig  Original template (can be NULL)
+ */
+static void
+mgr_tmplt_prepare(struct fds_tmgr *mgr, struct fds_template *tmplt,
+    const struct fds_template *orig)
+{
+    refresh_forget(&mgr->refresh.tab, tmplt);
+    if (orig == NULL) {
+        return;
+    }
+
+    tmplt->time.last_seen = mgr_tmplt_last_seen(mgr, orig);
+    tmplt->time.end_of_life = mgr_tmplt_end_of_life(mgr, orig);
 }
 
 /** Auxiliary structure for mgr_snap_clone_remove_exp_cb() callback function */
 struct mgr_snap_clone_remove_exp {
-    /** Old snapshot         */
-    struct fds_tsnapshot *old;
+    /** Template manager     */
+    const struct fds_tmgr *mgr;
     /** New snapshot (clone) */
     struct fds_tsnapshot *new;
 
@@ -564,19 +830,20 @@ struct mgr_snap_clone_remove_exp {
     uint32_t lifetime_min;
     /** True, if at least one template has enabled timeout   */
     bool lifetime_enabled;
+    /** Operation result                                     */
+    int ret_code;
 };
 
 /**
  * \brief Expired snapshot record checker (callback function)
  *
- * Check if a snapshot record has expired in the new snapshot and remove it. The function makes
- * sure that "Delete" flag will be moved back to the old snapshot.
+ * Check if a snapshot record has expired in the new snapshot and remove it.
  * \param[in] rec  Snapshot record
  * \param[in] data Structure mgr_snap_clone_remove_exp
- * \return Always true
+ * \return True on success. On error returns false and a new return code is set.
  */
 static bool
-mgr_snap_clone_remove_exp_cb(struct snapshot_rec *rec, void *data)
+mgr_snap_clone_remove_exp_cb(const struct snapshot_rec *rec, void *data)
 {
     struct mgr_snap_clone_remove_exp *info = data;
 
@@ -587,14 +854,15 @@ mgr_snap_clone_remove_exp_cb(struct snapshot_rec *rec, void *data)
     }
 
     // The record is from the new snapshot
-    assert(snapshot_rec_find(info->new, rec->id) == rec);
+    assert(snapshot_rec_cfind(info->new, rec->id) != NULL);
     // Check that lifetime is really enabled
     assert(TIME_NE(rec->ptr->time.last_seen, rec->ptr->time.end_of_life)); // Must be different
 
-    if (TIME_GE(rec->lifetime, info->new->start_time)) {
+    const uint32_t end_of_life = mgr_tmplt_end_of_life(info->mgr, rec->ptr);
+    if (TIME_GE(end_of_life, info->new->start_time)) {
         // Template is still valid, calculate new minimal lifetime
-        if (TIME_LT(rec->lifetime, info->lifetime_min)) {
-            info->lifetime_min = rec->lifetime;
+        if (!info->lifetime_enabled || TIME_LT(end_of_life, info->lifetime_min)) {
+            info->lifetime_min = end_of_life;
         }
 
         info->lifetime_enabled = true;
@@ -602,13 +870,11 @@ mgr_snap_clone_remove_exp_cb(struct snapshot_rec *rec, void *data)
     }
 
     // Remove the record
-    if (rec->flags & SNAPSHOT_TF_DESTROY) {
-        // Move "Delete" flag back
-        struct snapshot_rec *old_rec = snapshot_rec_find(info->old, rec->id);
-        assert(old_rec != NULL);
-        old_rec->flags |= SNAPSHOT_TF_DESTROY;
+    if (snapshot_rec_remove(info->new, rec->id) != FDS_OK) {
+        info->ret_code = FDS_ERR_NOMEM;
+        return false;
     }
-    snapshot_rec_remove(info->new, rec->id);
+
     return true;
 }
 
@@ -626,6 +892,8 @@ mgr_snap_clone_remove_exp_cb(struct snapshot_rec *rec, void *data)
  * \note The function doesn't check editability of the source snapshot, because this method is,
  *   among other things, necessary for creating a snapshot between two historical snapshots
  *   when at least one template has expired.
+ * \note Tables of template references are shared with the source snapshot and copied later
+ *   only if they are modified.
  *
  * \param[in]  src   Source snapshot
  * \param[out] dst   New snapshot
@@ -653,31 +921,38 @@ mgr_snap_clone(struct fds_tsnapshot *src, struct fds_tsnapshot **dst, uint32_t s
     new_snap->link.newer = NULL;
     new_snap->link.older = NULL;
 
-    // Insert into snapshot hierarchy
-    mgr_link_newer(src, new_snap);
-
-    /*
-     * Transfer ownership of templates i.e. old snapshot records will not have "Delete" flag
-     * anymore. Also remove "Create" flags that must remain in the parent.
-     */
-    snapshot_rec_for(src, &mgr_snap_clone_dflag_cb, NULL);
-    snapshot_rec_for(new_snap,  &mgr_snap_clone_cflag_cb, NULL);
-
     // Check if there is a template that has expired...
     fds_tmgr_t *mgr = src->link.mgr;
     if (TIME_NE(src->start_time, start) && src->lifetime.enabled
             && TIME_LE(src->lifetime.min_value, start)) {
         // Remove expired templates and calculate new lifetime
-        const uint32_t max_timeout = MAX(mgr->limits.lifetime_normal, mgr->limits.lifetime_opts);
-        const uint32_t max_lifetime = new_snap->start_time + max_timeout;
-
-        struct mgr_snap_clone_remove_exp data = {src, new_snap, max_lifetime, false};
+        struct mgr_snap_clone_remove_exp data = {mgr, new_snap, 0, false, FDS_OK};
         snapshot_rec_for(new_snap, mgr_snap_clone_remove_exp_cb, &data);
+        if (data.ret_code != FDS_OK) {
+            // The source snapshot hasn't been modified yet
+            snapshot_destroy(new_snap);
+            return data.ret_code;
+        }
 
         new_snap->lifetime.enabled = data.lifetime_enabled;
         new_snap->lifetime.min_value = data.lifetime_min + 1;
+
+        /* Transfer ownership of remaining templates i.e. old snapshot records will not have
+         * "Delete" flag anymore. Expired templates remain in the ownership of the source.
+         */
+        snapshot_rec_for(new_snap, &mgr_snap_clone_dflag_cb, src);
+    } else {
+        // Transfer ownership of all templates
+        snapshot_flags_clear(src, SNAPSHOT_TF_DESTROY);
     }
 
+    // Remove "Create" flags that must remain in the parent
+    snapshot_flags_clear(new_snap, SNAPSHOT_TF_CREATE);
+
+    // Insert into snapshot hierarchy
+    mgr_link_newer(src, new_snap);
+    mgr->list.editable_cnt++;
+
     /* TODO: optimization enable/disable???
     if (src->start_time == start) {
         // Move the source snapshot into the garbage  because it cannot be accessible anymore
@@ -739,7 +1014,8 @@ mgr_snap_edit(struct fds_tsnapshot *src, struct fds_tsnapshot **dst)
  * \note Expiration of the snapshot (minimal lifetime) will be recalculated based on a validity
  *   of the template, if necessary.
  * \note Flag ::SNAPSHOT_TF_TIMEOUT will be set automatically if the fds_template#time#last_seen
- *   and fds_template#time#end_of_life are different.
+ *   and fds_template#time#end_of_life are different. If the template has been refreshed, the
+ *   timestamps of the last refresh are used instead (see mgr_template_refresh()).
  * \warning All fds_template#time variables must be already set!
  * \param[in] snap  Snapshot
  * \param[in] tmplt Template
@@ -750,16 +1026,18 @@ static int
 mgr_snap_template_add_ref(struct fds_tsnapshot *snap, struct fds_template *tmplt, uint16_t flags)
 {
     // Do NOT overwrite template references
-    assert(snapshot_rec_find(snap, tmplt->id) == NULL);
+    assert(snapshot_rec_cfind(snap, tmplt->id) == NULL);
 
     // This flag should be set only by this function
     assert((flags & SNAPSHOT_TF_TIMEOUT) == 0);
 
-    if (TIME_NE(tmplt->time.last_seen, tmplt->time.end_of_life)) {
+    const uint32_t last_seen = mgr_tmplt_last_seen(snap->link.mgr, tmplt);
+    const uint32_t end_of_life = mgr_tmplt_end_of_life(snap->link.mgr, tmplt);
+    if (TIME_NE(last_seen, end_of_life)) {
         // Timeout of this template is enabled
-        assert(TIME_LT(tmplt->time.last_seen, tmplt->time.end_of_life));
+        assert(TIME_LT(last_seen, end_of_life));
         flags |= SNAPSHOT_TF_TIMEOUT;
-        const uint32_t invalid_time = tmplt->time.end_of_life + 1;
+        const uint32_t invalid_time = end_of_life + 1;
 
         if (!snap->lifetime.enabled) {
             snap->lifetime.enabled = true;
@@ -777,7 +1055,6 @@ mgr_snap_template_add_ref(struct fds_tsnapshot *snap, struct fds_template *tmplt
     struct snapshot_rec new_rec;
     new_rec.id = tmplt->id;
     new_rec.flags = flags;
-    new_rec.lifetime = tmplt->time.end_of_life;
     new_rec.ptr = tmplt;
 
     return snapshot_rec_add(snap, &new_rec);
@@ -823,7 +1100,7 @@ mgr_snap_template_add(struct fds_tsnapshot *snap, struct fds_template *tmplt)
 
     // Is a template with the same ID already in the snapshot?
     bool is_refresh = false;
-    struct snapshot_rec *snap_rec = snapshot_rec_find(snap, tmplt->id);
+    const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap, tmplt->id);
     if (snap_rec != NULL) {
         is_refresh = (fds_template_cmp(snap_rec->ptr, tmplt) == 0);
         if (!is_refresh && mgr->cfg.withdraw_mod == WITHDRAW_REQUIRED) {
@@ -852,11 +1129,18 @@ mgr_snap_template_add(struct fds_tsnapshot *snap, struct fds_template *tmplt)
         if ((ret_code = fds_template_ies_define(tmplt2add, mgr->ies_db, false)) != FDS_OK) {
             return ret_code;
         }
+        ierefs_add(&mgr->ierefs, tmplt2add);
     }
 
     if (snap_rec != NULL) {
         // Remove the old template from the snapshot. This can eventually move "Delete flag"...
-        mgr_snap_template_remove(snap, tmplt2add->id);
+        if ((ret_code = mgr_snap_template_remove(snap, tmplt2add->id)) != FDS_OK) {
+            if (is_refresh) {
+                fds_template_destroy(tmplt2add);
+            }
+
+            return ret_code;
+        }
     }
 
     // Update timestamp info
@@ -865,6 +1149,7 @@ mgr_snap_template_add(struct fds_tsnapshot *snap, struct fds_template *tmplt)
         : mgr->limits.lifetime_opts;
     tmplt2add->time.last_seen = mgr->time_now;
     tmplt2add->time.end_of_life = mgr->time_now + lifetime;
+    mgr_tmplt_prepare(mgr, tmplt2add, NULL);
 
     // Add a reference of the template to the snapshot
     const uint16_t flags = SNAPSHOT_TF_CREATE | SNAPSHOT_TF_DESTROY; // First owner of the template
@@ -899,7 +1184,7 @@ static int
 mgr_snap_template_remove(struct fds_tsnapshot *snap, uint16_t id)
 {
     // Is the template is the snapshot
-    struct snapshot_rec *snap_rec = snapshot_rec_find(snap, id);
+    const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap, id);
     if (!snap_rec) {
         return FDS_ERR_NOTFOUND;
     }
@@ -907,38 +1192,46 @@ mgr_snap_template_remove(struct fds_tsnapshot *snap, uint16_t id)
     // Make sure that the snapshot is editable
     assert(snap->editable);
 
-    if (snap->lifetime.enabled && snap->rec_cnt == 1) {
+    // Remove the record first (it's the only operation that can fail)
+    const uint16_t flags = snapshot_rec_flags(snap, id);
+    struct fds_template *tmplt = snap_rec->ptr;
+    int ret_code;
+    if ((ret_code = snapshot_rec_remove(snap, id)) != FDS_OK) {
+        return ret_code;
+    }
+
+    if (snap->lifetime.enabled && snap->rec_cnt == 0) {
         // The last record in the snapshot -> disable lifetime
         snap->lifetime.enabled = false;
     }
 
-    if ((snap_rec->flags & SNAPSHOT_TF_DESTROY) == 0) {
-        // The snapshot is not responsible for destruction of the template -> remove the record
-        return snapshot_rec_remove(snap, id);
+    if ((flags & SNAPSHOT_TF_DESTROY) == 0) {
+        // The snapshot is not responsible for destruction of the template
+        return FDS_OK;
     }
 
     // We have the "Delete" flag
-    if (snap_rec->flags & SNAPSHOT_TF_CREATE) {
+    if (flags & SNAPSHOT_TF_CREATE) {
         /* We have the "Create" and "Delete" flags at the same time.
          * The template has been added to this snapshot and immediately we want to remove it.
          * In other words, this snapshot hasn't been frozen yet, thus, no one can have a reference
          * to the template (we can directly free the template).
          */
-        fds_template_destroy(snap_rec->ptr);
-        return snapshot_rec_remove(snap, id);
+        fds_template_destroy(tmplt);
+        return FDS_OK;
     }
 
     /* Let's try to move the delete flag to the first snapshot in the past that also has
      * a reference to this snapshot.
      */
-    if (mgr_snap_dflag_move(snap, id) == FDS_ERR_NOTFOUND) {
+    if (mgr_snap_dflag_pass(snap, id, tmplt) == FDS_ERR_NOTFOUND) {
         // This snapshot has the last reference -> move the template to the garbage
         fds_tgarbage_t *gc = snap->link.mgr->garbage;
         garbage_fn_t delete_fn = (garbage_fn_t) &fds_template_destroy;
-        garbage_append(gc, snap_rec->ptr, delete_fn);
+        garbage_append(gc, tmplt, delete_fn);
     }
 
-    return snapshot_rec_remove(snap, id);
+    return FDS_OK;
 }
 
 /**
@@ -970,7 +1263,7 @@ mgr_snap_template_withdraw(struct fds_tsnapshot *snap, uint16_t id, enum fds_tem
         return FDS_ERR_DENIED;
     }
 
-    struct snapshot_rec *snap_rec = snapshot_rec_find(snap, id);
+    const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap, id);
     if (!snap_rec) {
         // The template not found
         return FDS_ERR_NOTFOUND;
@@ -989,7 +1282,7 @@ mgr_snap_template_withdraw(struct fds_tsnapshot *snap, uint16_t id, enum fds_tem
     int ret_code;
 
     for (struct fds_tsnapshot *ptr = snap; ptr != NULL; ptr = ptr->link.newer) {
-        struct snapshot_rec *rec = snapshot_rec_find(ptr, id);
+        const struct snapshot_rec *rec = snapshot_rec_cfind(ptr, id);
         if (!rec) {
             /* Snapshot doesn't have a reference to the template, but there can be still anyone
              * else in the future due to history modification that caused this "gap".
@@ -997,7 +1290,7 @@ mgr_snap_template_withdraw(struct fds_tsnapshot *snap, uint16_t id, enum fds_tem
             continue;
         }
 
-        if (TIME_GT(rec->ptr->time.last_seen, mgr->time_now)) {
+        if (TIME_GT(mgr_tmplt_last_seen(mgr, rec->ptr), mgr->time_now)) {
             /* We found a new future definition of the template that we want to remove. We have
              * to stop here because we cannot remove template from the future by withdrawal request
              * from the past.
@@ -1044,16 +1337,17 @@ struct mgr_snap_freeze {
  * \return True on success. On error returns false and a new return code is set.
  */
 static bool
-mgr_snap_freeze_cb(struct snapshot_rec *rec, void *data)
+mgr_snap_freeze_cb(const struct snapshot_rec *rec, void *data)
 {
     struct mgr_snap_freeze *info = data;
     struct fds_tmgr *mgr = info->snap->link.mgr;
-    assert(snapshot_rec_find(info->snap, rec->id) == rec);
+    assert(snapshot_rec_cfind(info->snap, rec->id) != NULL);
+    const uint16_t rec_flags = snapshot_rec_flags(info->snap, rec->id);
 
     /* We are only interested into records that has been added into this snapshot (i.e. with
      * "Create" flag)
      */
-    if ((rec->flags & SNAPSHOT_TF_CREATE) == 0) {
+    if ((rec_flags & SNAPSHOT_TF_CREATE) == 0) {
         // Skip
         return true;
     }
@@ -1061,7 +1355,7 @@ mgr_snap_freeze_cb(struct snapshot_rec *rec, void *data)
     /* Because the snapshot hasn't been frozen yet, the added template (with "Create" flag) cannot
      * be referenced by any other snapshot, therefore, there MUST be also present "Delete" flag.
      */
-    assert((rec->flags & SNAPSHOT_TF_DESTROY) != 0);
+    assert((rec_flags & SNAPSHOT_TF_DESTROY) != 0);
     // We are trying to modify history, make sure that we have rights...
     assert(mgr->cfg.en_history_mod);
 
@@ -1070,16 +1364,17 @@ mgr_snap_freeze_cb(struct snapshot_rec *rec, void *data)
     // We would like to propagate this template to all descendants
     for (struct fds_tsnapshot *dsc = info->snap->link.newer; dsc != NULL; dsc = dsc->link.newer) {
         // Is the template still valid in this snapshot (and descendants)?
-        if ((rec->flags & SNAPSHOT_TF_TIMEOUT) != 0 && TIME_LT(rec->lifetime, dsc->start_time)) {
+        if ((rec->flags & SNAPSHOT_TF_TIMEOUT) != 0
+                && TIME_LT(mgr_tmplt_end_of_life(mgr, rec->ptr), dsc->start_time)) {
             // Stop propagation
             break;
         }
 
         // Does the descent's snapshot has a template with the same ID?
-        struct snapshot_rec *dsc_rec = snapshot_rec_find(dsc, rec->id);
+        const struct snapshot_rec *dsc_rec = snapshot_rec_cfind(dsc, rec->id);
         if (dsc_rec != NULL) {
-            const uint32_t dsc_seen = dsc_rec->ptr->time.last_seen;
-            const uint32_t rec_seen = rec->ptr->time.last_seen;
+            const uint32_t dsc_seen = mgr_tmplt_last_seen(mgr, dsc_rec->ptr);
+            const uint32_t rec_seen = mgr_tmplt_last_seen(mgr, rec->ptr);
 
             if (TIME_LT(rec_seen, dsc_seen)) {
                 /* The descendant's template is newer. We cannot rewrite the newer template
@@ -1123,12 +1418,11 @@ mgr_snap_freeze_cb(struct snapshot_rec *rec, void *data)
         /* Move the "Delete" flag (responsibility to destroy the template) to the last modified
          * snapshot.
          */
-        struct snapshot_rec *last_rec = snapshot_rec_find(last_insert, rec->id);
-        assert(last_rec->ptr == rec->ptr);
-        assert((last_rec->flags & (SNAPSHOT_TF_CREATE | SNAPSHOT_TF_DESTROY)) == 0);
+        assert(snapshot_rec_cfind(last_insert, rec->id)->ptr == rec->ptr);
+        assert((snapshot_rec_flags(last_insert, rec->id) & SNAPSHOT_TF_OWNERSHIP) == 0);
 
-        last_rec->flags |= SNAPSHOT_TF_DESTROY;
-        rec->flags &= ~SNAPSHOT_TF_DESTROY;
+        snapshot_rec_flags_set(last_insert, rec->id, SNAPSHOT_TF_DESTROY);
+        snapshot_rec_flags_clear(info->snap, rec->id, SNAPSHOT_TF_DESTROY);
     }
 
     return true;
@@ -1152,6 +1446,8 @@ mgr_snap_freeze(struct fds_tsnapshot *snap)
     }
 
     snap->editable = false;
+    assert(snap->link.mgr->list.editable_cnt > 0);
+    snap->link.mgr->list.editable_cnt--;
     if (!snap->link.newer) {
         // This is the newest snapshot -> we don't have to propagate changes
         return FDS_OK;
@@ -1215,9 +1511,14 @@ mgr_cleanup(struct fds_tmgr *mgr)
         // Modify global pointers
         mgr->list.oldest = mgr->list.newest;
         mgr->list.current = NULL;
+        mgr->list.editable_cnt = mgr->list.newest->editable ? 1U : 0U;
+        mgr_index_invalidate(mgr);
         return;
     }
 
+    // Multiple snapshots can be removed, so the index will be rebuilt later
+    mgr_index_invalidate(mgr);
+
     // Proceed from the oldest to the newest snapshot
     struct fds_tsnapshot *next = mgr->list.oldest;
     const uint32_t newest_time = mgr->list.newest->start_time;
@@ -1251,6 +1552,63 @@ mgr_cleanup(struct fds_tmgr *mgr)
     mgr->list.current = NULL;
 }
 
+/** Auxiliary structure for mgr_snap_lifetime_cb() callback function */
+struct mgr_snap_lifetime {
+    /** Template manager                                     */
+    const struct fds_tmgr *mgr;
+    /** New minimal lifetime value (calculated)              */
+    uint32_t lifetime_min;
+    /** True, if at least one template has enabled timeout   */
+    bool lifetime_enabled;
+};
+
+/**
+ * \brief Calculate minimal lifetime of snapshot records (callback function)
+ * \param[in] rec  Snapshot record
+ * \param[in] data Structure mgr_snap_lifetime
+ * \return Always true
+ */
+static bool
+mgr_snap_lifetime_cb(const struct snapshot_rec *rec, void *data)
+{
+    struct mgr_snap_lifetime *info = data;
+    if ((rec->flags & SNAPSHOT_TF_TIMEOUT) == 0) {
+        return true;
+    }
+
+    const uint32_t end_of_life = mgr_tmplt_end_of_life(info->mgr, rec->ptr);
+    if (!info->lifetime_enabled || TIME_LT(end_of_life, info->lifetime_min)) {
+        info->lifetime_min = end_of_life;
+    }
+
+    info->lifetime_enabled = true;
+    return true;
+}
+
+/**
+ * \brief Check if at least one template of a snapshot has expired
+ *
+ * Templates can be refreshed without modification of snapshots (see mgr_template_refresh()),
+ * therefore, the lifetime of a snapshot is only a lower estimation. If the estimation has
+ * expired, the real lifetime is recalculated first.
+ * \param[in] snap Snapshot
+ * \param[in] time Export time
+ * \return True or false
+ */
+static bool
+mgr_snap_expired(struct fds_tsnapshot *snap, uint32_t time)
+{
+    if (!snap->lifetime.enabled || TIME_GT(snap->lifetime.min_value, time)) {
+        return false;
+    }
+
+    struct mgr_snap_lifetime data = {snap->link.mgr, 0, false};
+    snapshot_rec_for(snap, &mgr_snap_lifetime_cb, &data);
+    snap->lifetime.enabled = data.lifetime_enabled;
+    snap->lifetime.min_value = data.lifetime_min + 1;
+    return snap->lifetime.enabled && TIME_LE(snap->lifetime.min_value, time);
+}
+
 /**
  * \brief Seek for a snapshot (in the future)
  *
@@ -1272,6 +1630,35 @@ mgr_seek_forwards(fds_tmgr_t *tmgr, uint32_t time)
     int ret_code;
     struct fds_tsnapshot *snap = tmgr->list.current;
 
+    /* Jump directly to the required snapshot using the time index, if there is nothing to freeze
+     * on the way (i.e. there is no editable snapshot except the current one and the target).
+     */
+    while (snap->link.newer && TIME_LE(snap->link.newer->start_time, time)) {
+        struct fds_tsnapshot *target;
+        if (mgr_index_find(tmgr, time, &target) != FDS_OK) {
+            // Unable to build the index -> use the linked-list instead
+            break;
+        }
+
+        assert(target != NULL && target != snap);
+        const size_t others = tmgr->list.editable_cnt - (target->editable ? 1U : 0U);
+        if (others == 0) {
+            snap = target;
+            break;
+        }
+
+        if (others != 1 || !snap->editable) {
+            // Other editable snapshots must be frozen in order
+            break;
+        }
+
+        // Freeze the current snapshot (its modifications can be propagated to newer snapshots)
+        if ((ret_code = mgr_snap_freeze(snap)) != FDS_OK) {
+            tmgr->list.current = NULL;
+            return ret_code;
+        }
+    }
+
     // Find a snapshot where "start time" >= time and "end time" <= time
     while (snap) {
         // Make sure that we don't go too far
@@ -1304,7 +1691,7 @@ mgr_seek_forwards(fds_tmgr_t *tmgr, uint32_t time)
         return ret_code;
     }
 
-    if (snap->lifetime.enabled && TIME_LE(snap->lifetime.min_value, time)) {
+    if (mgr_snap_expired(snap, time)) {
         // At least one template will expire -> create a new snapshot without these templates
         if ((ret_code = mgr_snap_clone(snap, &snap, time)) != FDS_OK) {
             tmgr->list.current = NULL;
@@ -1335,7 +1722,15 @@ mgr_seek_backwards(struct fds_tmgr *tmgr, uint32_t time)
     assert(tmgr->list.current && TIME_GT(tmgr->list.current->start_time, time));
 
     // Find a snapshot where "start time" >= time and "end time" <= time
-    struct fds_tsnapshot *snap = tmgr->list.current->link.older; // Start from the previous snap
+    struct fds_tsnapshot *snap;
+    if (mgr_index_find(tmgr, time, &snap) == FDS_OK) {
+        // Because we are in the past, the snapshot must be frozen
+        assert(!snap || (snap->editable == false && TIME_GT(snap->link.newer->start_time, time)));
+    } else {
+        // Unable to build the index -> use the linked-list instead
+        snap = tmgr->list.current->link.older; // Start from the previous snap
+    }
+
     while (snap) {
         // Because we are in the past, all snapshots must be frozen
         assert(snap->editable == false);
@@ -1363,7 +1758,7 @@ mgr_seek_backwards(struct fds_tmgr *tmgr, uint32_t time)
     }
 
     // Snapshot found...
-    if (snap->lifetime.enabled && TIME_LE(snap->lifetime.min_value, time)) {
+    if (mgr_snap_expired(snap, time)) {
         // At least one template will expire -> create a new snapshot without these templates
         assert(TIME_LT(snap->start_time, time));
 
@@ -1378,19 +1773,130 @@ mgr_seek_backwards(struct fds_tmgr *tmgr, uint32_t time)
     return FDS_OK;
 }
 
-fds_tmgr_t *
-fds_tmgr_create(enum fds_session_type type)
-{
-    fds_tmgr_t *mgr = calloc(1, sizeof(*mgr));
-    if (!mgr) {
-        return NULL;
-    }
-
-    mgr->garbage = garbage_create();
-    if (!mgr->garbage) {
-        fds_tmgr_destroy(mgr);
-        return NULL;
-    }
+/** Auxiliary structure for mgr_refresh_split_cb() callback function */
+struct mgr_refresh_split {
+    /** New snapshot (clone of the newest snapshot) */
+    struct fds_tsnapshot *snap;
+    /** Operation result                             */
+    int ret_code;
+};
+
+/**
+ * \brief Replace a refreshed template with its copy (callback function)
+ *
+ * The copy takes over the timestamps of the last refresh. The original template is still
+ * referenced by older snapshots, therefore, its "Delete" flag is passed to them.
+ * \param[in] rec  Snapshot record
+ * \param[in] data Structure mgr_refresh_split
+ * \return True on success. On error returns false and a new return code is set.
+ */
+static bool
+mgr_refresh_split_cb(const struct snapshot_rec *rec, void *data)
+{
+    struct mgr_refresh_split *info = data;
+    struct fds_tmgr *mgr = info->snap->link.mgr;
+    if (refresh_find(&mgr->refresh.tab, rec->ptr) == NULL) {
+        // The template hasn't been refreshed -> keep it shared with older snapshots
+        return true;
+    }
+
+    struct fds_template *ptr_old = rec->ptr;
+    struct fds_template *ptr_new = fds_template_copy(ptr_old);
+    if (!ptr_new) {
+        info->ret_code = FDS_ERR_NOMEM;
+        return false;
+    }
+    mgr_tmplt_prepare(mgr, ptr_new, ptr_old);
+
+    // Replace the record (the snapshot is the first owner of the copy)
+    const uint16_t flags = snapshot_rec_flags(info->snap, rec->id);
+    struct snapshot_rec rec_new = *rec;
+    rec_new.flags = rec->flags | SNAPSHOT_TF_CREATE | SNAPSHOT_TF_DESTROY;
+    rec_new.ptr = ptr_new;
+    if (snapshot_rec_add(info->snap, &rec_new) != FDS_OK) {
+        fds_template_destroy(ptr_new);
+        info->ret_code = FDS_ERR_NOMEM;
+        return false;
+    }
+
+    if ((flags & SNAPSHOT_TF_DESTROY) != 0
+            && mgr_snap_dflag_pass(info->snap, rec->id, ptr_old) == FDS_ERR_NOTFOUND) {
+        // This snapshot had the last reference -> move the template to the garbage
+        garbage_append(mgr->garbage, ptr_old, (garbage_fn_t) &fds_template_destroy);
+    }
+
+    return true;
+}
+
+/**
+ * \brief Make refreshes of templates in the newest snapshot visible in history
+ *
+ * Templates refreshed using the fast path (see mgr_template_refresh()) are not modified, so
+ * the newest snapshot would report the last refresh for all Export Times since its start time.
+ * Before the time context goes back before the last refresh, the newest snapshot is cloned
+ * with the start time of the last refresh and refreshed templates in the clone are replaced with
+ * copies that hold timestamps of the refresh. Older snapshots keep the original templates, so,
+ * for example, a refresh in history cannot overwrite a newer refresh (see mgr_snap_freeze_cb()).
+ *
+ * Records in the table of refreshed templates are preserved because the original templates are
+ * still valid until the end of life of their last refresh.
+ * \param[in] tmgr Template manager
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+mgr_refresh_split(struct fds_tmgr *tmgr)
+{
+    assert(tmgr->refresh.pending);
+    struct fds_tsnapshot *snap_old = tmgr->list.newest;
+    const uint32_t time = tmgr->refresh.time_last;
+    tmgr->refresh.pending = false;
+
+    if (TIME_LE(time, snap_old->start_time)) {
+        // The newest snapshot has been created by (or after) the last refresh
+        return FDS_OK;
+    }
+
+    int ret_code;
+    struct fds_tsnapshot *snap_new;
+    if ((ret_code = mgr_snap_freeze(snap_old)) != FDS_OK
+            || (ret_code = mgr_snap_clone(snap_old, &snap_new, time)) != FDS_OK) {
+        tmgr->list.current = NULL;
+        return ret_code;
+    }
+
+    if (tmgr->list.current == snap_old) {
+        // The current Export Time cannot be older than the last refresh
+        assert(TIME_GE(tmgr->time_now, time));
+        tmgr->list.current = snap_new;
+    }
+
+    struct mgr_refresh_split data = {snap_new, FDS_OK};
+    snapshot_rec_for(snap_new, &mgr_refresh_split_cb, &data);
+    return data.ret_code;
+}
+
+fds_tmgr_t *
+fds_tmgr_create(enum fds_session_type type)
+{
+    return fds_tmgr_create_pool(type, NULL);
+}
+
+fds_tmgr_t *
+fds_tmgr_create_pool(enum fds_session_type type, fds_tpool_t *pool)
+{
+    fds_tmgr_t *mgr = calloc(1, sizeof(*mgr));
+    if (!mgr) {
+        return NULL;
+    }
+
+    pool_acquire(pool);
+    mgr->pool = pool;
+
+    mgr->garbage = garbage_create();
+    if (!mgr->garbage) {
+        fds_tmgr_destroy(mgr);
+        return NULL;
+    }
 
     // Prepare configuration based on the type of a session
     mgr->limits.lifetime_snapshot = SNAPSHOT_DEF_LIFETIME;
@@ -1445,12 +1951,26 @@ fds_tmgr_destroy(fds_tmgr_t *tmgr)
         garbage_destroy(tmgr->garbage);
     }
 
+    free(tmgr->index.items);
+    ierefs_clear(&tmgr->ierefs);
+    refresh_clear(&tmgr->refresh.tab);
+    tmgr->refresh.pending = false;
+    // Snapshots in the garbage of the user hold the pool until they are destroyed
+    pool_release(tmgr->pool);
+
     // Finally destroy the manager
     free(tmgr);
 }
 
-void
-fds_tmgr_clear(fds_tmgr_t *tmgr)
+/**
+ * \brief Move all snapshots of a manager to garbage
+ *
+ * Unlike fds_tmgr_clear(), the reverse index of Information Elements and the table of refreshed
+ * templates are preserved.
+ * \param[in] tmgr Template manager
+ */
+static void
+mgr_snap_clear(fds_tmgr_t *tmgr)
 {
     // Move all snapshots to garbage
     garbage_fn_t delete_fn = (garbage_fn_t) &mgr_snap_destroy;
@@ -1463,7 +1983,18 @@ fds_tmgr_clear(fds_tmgr_t *tmgr)
 
     // Modify global pointers
     tmgr->list.oldest = tmgr->list.newest = tmgr->list.current = NULL;
+    tmgr->list.editable_cnt = 0;
     tmgr->time_newest = tmgr->time_now = 0;
+    mgr_index_invalidate(tmgr);
+}
+
+void
+fds_tmgr_clear(fds_tmgr_t *tmgr)
+{
+    mgr_snap_clear(tmgr);
+    ierefs_clear(&tmgr->ierefs);
+    refresh_clear(&tmgr->refresh.tab);
+    tmgr->refresh.pending = false;
 }
 
 int
@@ -1520,6 +2051,14 @@ fds_tmgr_set_time(fds_tmgr_t *tmgr, uint32_t exp_time)
         }
     }
 
+    if (tmgr->refresh.pending && TIME_LT(exp_time, tmgr->refresh.time_last)) {
+        // Going back before the last refresh -> the refresh must be part of history
+        int ret_code;
+        if ((ret_code = mgr_refresh_split(tmgr)) != FDS_OK) {
+            return ret_code;
+        }
+    }
+
     tmgr->time_now = exp_time;
     if (TIME_GT(exp_time, tmgr->time_newest)) {
         tmgr->time_newest = exp_time;
@@ -1603,6 +2142,82 @@ mgr_modify_prepare(struct fds_tmgr *tmgr)
     return FDS_OK;
 }
 
+/**
+ * \brief Try to refresh a template in the newest snapshot (fast path)
+ *
+ * If the current snapshot is the newest one and it already contains exactly the same template,
+ * only the timestamps of the refresh (i.e. the Export Time and the new end of life) are stored
+ * in the table of refreshed templates of the manager. The snapshot is not frozen, cloned or
+ * modified in any way and the template is not copied. Memory is allocated only when a template
+ * with a Template ID from a new range of IDs is refreshed for the first time.
+ *
+ * The timestamps of the table are used instead of fds_template#time#last_seen and
+ * fds_template#time#end_of_life of the template whenever the manager decides whether the
+ * template is still valid (see mgr_snap_expired()) or older/newer than another definition.
+ * The minimal lifetime of snapshots that refer to the template becomes a lower estimation.
+ *
+ * The newest snapshot covers all Export Times since its start time. If the time context goes
+ * back before the last refresh, the snapshot is split first (see mgr_refresh_split()). If the
+ * template has been already refreshed later than the current Export Time, the refresh is ignored.
+ *
+ * \note The template in the snapshot is never modified because it might be already shared by
+ *   other snapshots and readers (see fds_tmgr_snapshot_get()).
+ * \note Historical snapshots are not refreshed this way because the modification must be
+ *   propagated to newer snapshots (or it may be denied).
+ * \warning The current snapshot MUST be set.
+ * \param[in] tmgr  Template manager
+ * \param[in] tmplt Template to be added
+ * \return True, if the template has been refreshed and the \p tmplt has been destroyed.
+ *   Otherwise (the template must be added using the standard way) returns false.
+ */
+static bool
+mgr_template_refresh(struct fds_tmgr *tmgr, struct fds_template *tmplt)
+{
+    const struct fds_tsnapshot *snap = tmgr->list.current;
+    if (snap->link.newer != NULL) {
+        // This is a historical snapshot
+        return false;
+    }
+
+    const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap, tmplt->id);
+    if (!snap_rec || fds_template_cmp(snap_rec->ptr, tmplt) != 0) {
+        // This is a new template or a template that is different than the previous one
+        return false;
+    }
+
+    const struct fds_template *ref = snap_rec->ptr;
+    const uint32_t lifetime = (ref->type == FDS_TYPE_TEMPLATE)
+        ? tmgr->limits.lifetime_normal
+        : tmgr->limits.lifetime_opts;
+    const bool has_timeout = (snap_rec->flags & SNAPSHOT_TF_TIMEOUT) != 0;
+    if (has_timeout != (lifetime != 0)) {
+        // Timeouts have been reconfigured
+        return false;
+    }
+
+    const uint32_t last_seen = mgr_tmplt_last_seen(tmgr, ref);
+    const uint32_t end_of_life = mgr_tmplt_end_of_life(tmgr, ref);
+    const uint32_t end_of_life_new = tmgr->time_now + lifetime;
+    if (TIME_LE(tmgr->time_now, last_seen)) {
+        // The template has been already refreshed later (or now), its lifetime cannot be shortened
+        if (TIME_GT(end_of_life_new, end_of_life)) {
+            // ... but the lifetime has been extended
+            return false;
+        }
+    } else if (TIME_LT(end_of_life_new, end_of_life)) {
+        // The lifetime has been shortened
+        return false;
+    } else if (refresh_set(&tmgr->refresh.tab, ref, tmgr->time_now, end_of_life_new) != FDS_OK) {
+        // Use the standard way instead
+        return false;
+    } else if (!tmgr->refresh.pending || TIME_GT(tmgr->time_now, tmgr->refresh.time_last)) {
+        tmgr->refresh.time_last = tmgr->time_now;
+        tmgr->refresh.pending = true;
+    }
+
+    fds_template_destroy(tmplt);
+    return true;
+}
 
 int
 fds_tmgr_template_add(fds_tmgr_t *tmgr, struct fds_template *tmplt)
@@ -1617,6 +2232,10 @@ fds_tmgr_template_add(fds_tmgr_t *tmgr, struct fds_template *tmplt)
         return FDS_ERR_ARG;
     }
 
+    if (mgr_template_refresh(tmgr, tmplt)) {
+        return FDS_OK;
+    }
+
     int ret_code;
     if ((ret_code = mgr_modify_prepare(tmgr)) != FDS_OK) {
         return ret_code;
@@ -1666,10 +2285,10 @@ struct mgr_template_withdrawal_all {
  * \return On success returns true. Otherwise returns false and sets an error code appropriately.
  */
 static bool
-mgr_template_withdraw_all_cb(struct snapshot_rec *rec, void *data)
+mgr_template_withdraw_all_cb(const struct snapshot_rec *rec, void *data)
 {
     struct mgr_template_withdrawal_all *info = data;
-    assert(snapshot_rec_find(info->snap, rec->id) == rec);
+    assert(snapshot_rec_cfind(info->snap, rec->id) != NULL);
 
     if (info->type != FDS_TYPE_TEMPLATE_UNDEF && info->type != rec->ptr->type) {
         // Skip this template (we are removing a different type of templates)
@@ -1726,7 +2345,7 @@ fds_tmgr_template_remove(fds_tmgr_t *tmgr, uint16_t id, enum fds_template_type t
         // Check history consistency
         assert(!ptr->link.newer || TIME_LE(ptr->start_time, ptr->link.newer->start_time));
 
-        struct snapshot_rec *rec = snapshot_rec_find(ptr, id);
+        const struct snapshot_rec *rec = snapshot_rec_cfind(ptr, id);
         if (!rec) {
             // Not found -> skip
             continue;
@@ -1764,6 +2383,7 @@ fds_tmgr_template_remove(fds_tmgr_t *tmgr, uint16_t id, enum fds_template_type t
              * In other words, there is no record with "Create" flag in the new clone.
              */
             ptr->editable = false;
+            tmgr->list.editable_cnt--;
         }
     }
 
@@ -1829,6 +2449,19 @@ fds_tmgr_template_get(fds_tmgr_t *tmgr, uint16_t id, const struct fds_template *
     }
 }
 
+void
+fds_tmgr_template_time(const fds_tmgr_t *tmgr, const struct fds_template *tmplt,
+    uint32_t *last_seen, uint32_t *end_of_life)
+{
+    if (last_seen) {
+        *last_seen = mgr_tmplt_last_seen(tmgr, tmplt);
+    }
+
+    if (end_of_life) {
+        *end_of_life = mgr_tmplt_end_of_life(tmgr, tmplt);
+    }
+}
+
 int
 fds_tmgr_set_udp_timeouts(fds_tmgr_t *tmgr, uint16_t tl_data, uint16_t tl_opts)
 {
@@ -1853,10 +2486,141 @@ struct fds_tmgr_set_iemgr_data {
     struct fds_tsnapshot *snap;
     /** New IE manager                 */
     const struct fds_iemgr *ie_defs;
+    /** Changed definitions (NULL == all templates are redefined) */
+    const fds_iemgr_diff_t *diff;
+    /** Bitset of possibly affected Template IDs (NULL == any template might be affected) */
+    const uint32_t *ids;
     /** Status code of whole operation */
     int ret_code;
 };
 
+/**
+ * \brief Check if a template refers to an IE with a changed definition
+ *
+ * Reverse fields are checked too. A Biflow key field without directional counterpart is
+ * affected by any change in its scope, because the counterpart is searched by name.
+ * \param[in] tmplt Template
+ * \param[in] diff  Changed definitions
+ * \return True or false
+ */
+static bool
+mgr_template_affected(const struct fds_template *tmplt, const fds_iemgr_diff_t *diff)
+{
+    for (uint16_t i = 0; i < tmplt->fields_cnt_total; ++i) {
+        const struct fds_tfield *field = &tmplt->fields[i];
+        if (fds_iemgr_diff_find(diff, field->en, field->id)) {
+            return true;
+        }
+
+        if (!tmplt->fields_rev) {
+            continue;
+        }
+
+        const struct fds_tfield *field_rev = &tmplt->fields_rev[i];
+        if (field_rev->en == field->en && field_rev->id == field->id) {
+            if ((field->flags & FDS_TFIELD_BKEY) && fds_iemgr_diff_find_pen(diff, field->en)) {
+                return true;
+            }
+            continue;
+        }
+
+        if (fds_iemgr_diff_find(diff, field_rev->en, field_rev->id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * \brief Check if a template of a snapshot record is affected by changed definitions
+ * \param[in] rec  Snapshot record
+ * \param[in] diff Changed definitions
+ * \param[in] ids  Bitset of possibly affected Template IDs (can be NULL)
+ * \return True or false
+ */
+static inline bool
+mgr_rec_affected(const struct snapshot_rec *rec, const fds_iemgr_diff_t *diff,
+    const uint32_t *ids)
+{
+    if (ids != NULL && !ierefs_id_test(ids, rec->id)) {
+        // No template with this ID refers to a changed definition
+        return false;
+    }
+
+    return mgr_template_affected(rec->ptr, diff);
+}
+
+/** \brief Auxiliary data structure for mgr_affected_cb() */
+struct mgr_affected_data {
+    /** Changed definitions                   */
+    const fds_iemgr_diff_t *diff;
+    /** At least one template is affected     */
+    bool affected;
+};
+
+/**
+ * \brief Check if a template of a snapshot record is affected by changed definitions
+ * \param[in] rec  Snapshot record
+ * \param[in] data Auxiliary data structure
+ * \return False if an affected template has been found (stop iteration), true otherwise
+ */
+static bool
+mgr_affected_cb(const struct snapshot_rec *rec, void *data)
+{
+    struct mgr_affected_data *info = data;
+    if (mgr_template_affected(rec->ptr, info->diff)) {
+        info->affected = true;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Check if any template of a manager is affected by changed definitions
+ *
+ * If the bitset of possibly affected Template IDs is available, only records with these IDs
+ * are checked. Otherwise, all records of all snapshots are checked.
+ * \param[in] tmgr Template manager
+ * \param[in] diff Changed definitions
+ * \param[in] ids  Bitset of possibly affected Template IDs (can be NULL)
+ * \return True or false
+ */
+static bool
+mgr_affected(const fds_tmgr_t *tmgr, const fds_iemgr_diff_t *diff, const uint32_t *ids)
+{
+    const struct fds_tsnapshot *snap_ptr;
+    if (ids == NULL) {
+        struct mgr_affected_data check = {diff, false};
+        for (snap_ptr = tmgr->list.newest; snap_ptr != NULL; snap_ptr = snap_ptr->link.older) {
+            snapshot_rec_for(snap_ptr, &mgr_affected_cb, &check);
+            if (check.affected) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    for (uint32_t i = 0; i < IEREFS_IDS_SIZE; ++i) {
+        uint32_t bits = ids[i];
+        while (bits != 0) {
+            const uint16_t id = (uint16_t) (i * 32U + (uint32_t) __builtin_ctz(bits));
+            bits &= bits - 1U;
+
+            for (snap_ptr = tmgr->list.newest; snap_ptr != NULL; snap_ptr = snap_ptr->link.older) {
+                const struct snapshot_rec *rec = snapshot_rec_cfind(snap_ptr, id);
+                if (rec != NULL && mgr_template_affected(rec->ptr, diff)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
 /**
  * \brief Create an updated copy of a template and propagate it (auxiliary function)
  *
@@ -1865,55 +2629,77 @@ struct fds_tmgr_set_iemgr_data {
  *
  * If an error has occurred during modification, a status code will be changed from #FDS_OK to the
  * corresponding error. If the error code is different from the #FDS_OK, the snapshot record \p rec
- * will be removed. Therefore, if this callback function is called on all snapshot records in
- * a snapshot and an error has occurred during processing, in the snapshot will remain only
- * successfully copied templates.
+ * will lose its "Delete" flag. Therefore, if this callback function is called on all snapshot
+ * records in a snapshot and an error has occurred during processing, the snapshot will be
+ * responsible only for successfully copied templates.
  * \param[in] rec  Snapshot record
  * \param[in] data Auxiliary data structure
  * \return Always true
  */
 static bool
-fds_tmgr_set_iemgr_cb(struct snapshot_rec *rec, void *data)
+fds_tmgr_set_iemgr_cb(const struct snapshot_rec *rec, void *data)
 {
     struct fds_tmgr_set_iemgr_data *info = data;
-    assert(snapshot_rec_find(info->snap, rec->id) == rec);
+    assert(snapshot_rec_cfind(info->snap, rec->id) != NULL);
 
-    // Something went wrong -> we have to remove all remaining references
+    // Something went wrong -> we have to give up ownership of all remaining references
     if (info->ret_code != FDS_OK) {
-        snapshot_rec_remove(info->snap, rec->id);
+        snapshot_rec_flags_clear(info->snap, rec->id, SNAPSHOT_TF_DESTROY);
         return true;
     }
 
     // Is the record responsible for the template?
-    if ((rec->flags & SNAPSHOT_TF_DESTROY) == 0) {
+    const uint16_t rec_flags = snapshot_rec_flags(info->snap, rec->id);
+    if ((rec_flags & SNAPSHOT_TF_DESTROY) == 0) {
         // Skip
         return true;
     }
 
+    if (info->diff != NULL && !mgr_rec_affected(rec, info->diff, info->ids)) {
+        /* Definitions of the template are still valid and the template is shared with the
+         * original snapshot. The ownership is moved later, when everything is ready
+         * (see mgr_ownership_move()). */
+        snapshot_rec_flags_clear(info->snap, rec->id, SNAPSHOT_TF_DESTROY);
+        return true;
+    }
+
     // Create a copy of the template
     struct fds_template *ptr_old = rec->ptr;
     struct fds_template *ptr_new = fds_template_copy(rec->ptr);
     if (!ptr_new) {
         // Failed!
         info->ret_code = FDS_ERR_NOMEM;
+        snapshot_rec_flags_clear(info->snap, rec->id, SNAPSHOT_TF_DESTROY);
         return true;
     }
+    mgr_tmplt_prepare(info->snap->link.mgr, ptr_new, ptr_old);
 
     // Add new definitions
     info->ret_code = fds_template_ies_define(ptr_new, info->ie_defs, false);
     if (info->ret_code != FDS_OK) {
         fds_template_destroy(ptr_new);
+        snapshot_rec_flags_clear(info->snap, rec->id, SNAPSHOT_TF_DESTROY);
         return true;
     }
+    // Reverse fields might have been changed
+    ierefs_add(&info->snap->link.mgr->ierefs, ptr_new);
 
-    rec->ptr = ptr_new;
+    // Replace the record (records are shared, so a modified copy must be added)
+    struct snapshot_rec rec_new = *rec;
+    rec_new.flags = rec_flags;
+    rec_new.ptr = ptr_new;
+    if (snapshot_rec_add(info->snap, &rec_new) != FDS_OK) {
+        fds_template_destroy(ptr_new);
+        info->ret_code = FDS_ERR_NOMEM;
+        snapshot_rec_flags_clear(info->snap, rec->id, SNAPSHOT_TF_DESTROY);
+        return true;
+    }
 
     // Now propagate the pointer to predecessors
     struct fds_tsnapshot *snap_ptr = info->snap->link.older;
-    struct snapshot_rec *snap_rec;
-
     while (snap_ptr) {
-        snap_rec = snapshot_rec_find(snap_ptr, rec->id);
+        struct fds_tsnapshot *snap_now = snap_ptr;
+        const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap_now, rec->id);
         snap_ptr = snap_ptr->link.older; // For the next iteration
 
         if (!snap_rec || snap_rec->ptr != ptr_old) {
@@ -1921,8 +2707,18 @@ fds_tmgr_set_iemgr_cb(struct snapshot_rec *rec, void *data)
         }
 
         // Replace the old pointer
-        snap_rec->ptr = ptr_new;
-        if (snap_rec->flags & SNAPSHOT_TF_CREATE) {
+        rec_new = *snap_rec;
+        rec_new.flags = snapshot_rec_flags(snap_now, rec->id);
+        rec_new.ptr = ptr_new;
+        if (snapshot_rec_add(snap_now, &rec_new) != FDS_OK) {
+            /* The predecessor still refers to the old template, however, it will be destroyed
+             * without touching templates because of the error.
+             */
+            info->ret_code = FDS_ERR_NOMEM;
+            break;
+        }
+
+        if (rec_new.flags & SNAPSHOT_TF_CREATE) {
             // This is the oldest owner of the template
             break;
         }
@@ -1931,8 +2727,71 @@ fds_tmgr_set_iemgr_cb(struct snapshot_rec *rec, void *data)
     return true;
 }
 
-int
-fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr)
+/** \brief Auxiliary data structure for mgr_ownership_move_cb() */
+struct mgr_ownership_data {
+    /** Original snapshot */
+    struct fds_tsnapshot *snap_old;
+    /** Copy of the original snapshot */
+    struct fds_tsnapshot *snap_new;
+};
+
+/**
+ * \brief Move the ownership of a template shared by the original and the copied snapshot
+ * \param[in] rec  Snapshot record of the original snapshot
+ * \param[in] data Auxiliary data structure
+ * \return Always true
+ */
+static bool
+mgr_ownership_move_cb(const struct snapshot_rec *rec, void *data)
+{
+    struct mgr_ownership_data *info = data;
+    if ((snapshot_rec_flags(info->snap_old, rec->id) & SNAPSHOT_TF_DESTROY) == 0) {
+        return true;
+    }
+
+    const struct snapshot_rec *rec_new = snapshot_rec_cfind(info->snap_new, rec->id);
+    if (!rec_new || rec_new->ptr != rec->ptr) {
+        // The template has been replaced
+        return true;
+    }
+
+    snapshot_rec_flags_clear(info->snap_old, rec->id, SNAPSHOT_TF_DESTROY);
+    snapshot_rec_flags_set(info->snap_new, rec->id, SNAPSHOT_TF_DESTROY);
+    return true;
+}
+
+/**
+ * \brief Move the ownership of shared templates from the original hierarchy to its copy
+ * \param[in] old_head The newest snapshot of the original hierarchy
+ * \param[in] new_head The newest snapshot of the copied hierarchy
+ */
+static void
+mgr_ownership_move(struct fds_tsnapshot *old_head, struct fds_tsnapshot *new_head)
+{
+    struct mgr_ownership_data data;
+    data.snap_old = old_head;
+    data.snap_new = new_head;
+
+    while (data.snap_old != NULL && data.snap_new != NULL) {
+        snapshot_rec_for(data.snap_old, &mgr_ownership_move_cb, &data);
+        data.snap_old = data.snap_old->link.older;
+        data.snap_new = data.snap_new->link.older;
+    }
+}
+
+/**
+ * \brief Redefine templates using a new IE manager
+ *
+ * The whole hierarchy of snapshots is copied and all templates (or only affected ones) are
+ * replaced with redefined copies. Affected templates are looked up in the reverse index of
+ * Information Elements, so nothing is copied if no template is affected.
+ * \param[in] tmgr  Template manager
+ * \param[in] iemgr New IE manager
+ * \param[in] diff  Changed definitions (NULL == redefine all templates)
+ * \return #FDS_OK or #FDS_ERR_NOMEM
+ */
+static int
+mgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr, const fds_iemgr_diff_t *diff)
 {
     // To make it faster, first clean up hierarchy
     mgr_cleanup(tmgr);
@@ -1944,6 +2803,30 @@ fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr)
         return FDS_OK;
     }
 
+    uint32_t *ids = NULL;
+    if (diff != NULL) {
+        // Templates are shared by snapshots, so a copy is required only if anything changes
+        ids = calloc(IEREFS_IDS_SIZE, sizeof(*ids));
+        if (!ids) {
+            return FDS_ERR_NOMEM;
+        }
+
+        const int ids_cnt = ierefs_affected(&tmgr->ierefs, diff, ids);
+        if (ids_cnt < 0) {
+            // The index is incomplete -> check all templates
+            free(ids);
+            ids = NULL;
+        }
+
+        /* The index might also refer to templates that are not in the manager anymore, so
+         * records with the found IDs must be checked too. */
+        if (ids_cnt == 0 || !mgr_affected(tmgr, diff, ids)) {
+            free(ids);
+            tmgr->ies_db = iemgr;
+            return FDS_OK;
+        }
+    }
+
     // Copy whole hierarchy (from the head to the tail)
     struct fds_tsnapshot *new_head = NULL, *new_tail, *new_last = NULL;
     struct fds_tsnapshot *tmp_old, *tmp_new;
@@ -1985,6 +2868,7 @@ fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr)
             snapshot_destroy(tmp);
         }
 
+        free(ids);
         return FDS_ERR_NOMEM;
     }
 
@@ -1995,6 +2879,8 @@ fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr)
         struct fds_tmgr_set_iemgr_data data;
         data.snap = edit_ptr;
         data.ie_defs = iemgr;
+        data.diff = diff;
+        data.ids = ids;
         data.ret_code = FDS_OK;
 
         snapshot_rec_for(edit_ptr, &fds_tmgr_set_iemgr_cb, &data);
@@ -2022,18 +2908,43 @@ fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr)
             mgr_snap_destroy(tmp);
         }
 
+        free(ids);
         return FDS_ERR_NOMEM;
     }
 
-    // Ufff, everything is ready -> replace whole hierarchy
-    fds_tmgr_clear(tmgr);
+    if (diff != NULL) {
+        // Unaffected templates are shared by both hierarchies
+        mgr_ownership_move(tmgr->list.newest, new_head);
+    }
+
+    // Ufff, everything is ready -> replace whole hierarchy (templates are still indexed)
+    free(ids);
+    mgr_snap_clear(tmgr);
     tmgr->list.oldest = new_tail;
     tmgr->list.newest = new_head;
     tmgr->ies_db = iemgr;
 
+    for (edit_ptr = new_head; edit_ptr != NULL; edit_ptr = edit_ptr->link.older) {
+        if (edit_ptr->editable) {
+            tmgr->list.editable_cnt++;
+        }
+    }
+
     return FDS_OK;
 }
 
+int
+fds_tmgr_set_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr)
+{
+    return mgr_set_iemgr(tmgr, iemgr, NULL);
+}
+
+int
+fds_tmgr_update_iemgr(fds_tmgr_t *tmgr, const fds_iemgr_t *iemgr, const fds_iemgr_diff_t *diff)
+{
+    return mgr_set_iemgr(tmgr, iemgr, diff);
+}
+
 int
 fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
 {
@@ -2043,7 +2954,7 @@ fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
         return FDS_ERR_ARG;
     }
 
-    struct snapshot_rec *snap_rec = snapshot_rec_find(snap, id);
+    const struct snapshot_rec *snap_rec = snapshot_rec_cfind(snap, id);
     if (!snap_rec) {
         return FDS_ERR_NOTFOUND;
     }
@@ -2076,10 +2987,10 @@ fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
 
     const struct fds_template *tmplt_orig = NULL;
     struct fds_template *tmplt_new = NULL;
-    struct snapshot_rec *rec_last_modif = NULL;
+    struct fds_tsnapshot *snap_last_modif = NULL;
 
     for (struct fds_tsnapshot *it = snap; it != NULL; it = it->link.newer) {
-        struct snapshot_rec *rec = snapshot_rec_find(it, id);
+        const struct snapshot_rec *rec = snapshot_rec_cfind(it, id);
         if (!rec) {
             /* Snapshot doesn't have a reference to the template, but there can be still anyone
              * else in the future due to history modification that caused this "gap".
@@ -2111,7 +3022,7 @@ fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
             }
 
             // We have to find the new snapshot record
-            rec = snapshot_rec_find(it, id);
+            rec = snapshot_rec_cfind(it, id);
             assert(rec != NULL);
         }
 
@@ -2124,6 +3035,7 @@ fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
             if (!tmplt_new) {
                 return FDS_ERR_NOMEM;
             }
+            mgr_tmplt_prepare(tmgr, tmplt_new, rec->ptr);
 
             // Apply modifications
             if ((ret_code = fds_template_flowkey_define(tmplt_new, key)) != FDS_OK) {
@@ -2148,12 +3060,11 @@ fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
                 return ret_code;
             }
 
-            // We have to find the record again because remove/add operation can change address
-            rec_last_modif = snapshot_rec_find(it, id);
+            snap_last_modif = it;
             tmplt_orig = old_ptr;
         } else {
             // Just replace the old one with the new one
-            assert(snapshot_rec_find(it, id)->ptr == tmplt_orig);
+            assert(snapshot_rec_cfind(it, id)->ptr == tmplt_orig);
             if ((ret_code = mgr_snap_template_remove(it, id)) != FDS_OK) {
                 return ret_code;
             }
@@ -2164,17 +3075,260 @@ fds_tmgr_template_set_fkey(fds_tmgr_t *tmgr, uint16_t id, uint64_t key)
             }
 
             // Remove the destroy flag from the previous record
-            assert(rec_last_modif->flags & SNAPSHOT_TF_DESTROY);
-            rec_last_modif->flags &= ~SNAPSHOT_TF_DESTROY;
+            assert(snapshot_rec_flags(snap_last_modif, id) & SNAPSHOT_TF_DESTROY);
+            snapshot_rec_flags_clear(snap_last_modif, id, SNAPSHOT_TF_DESTROY);
+            snap_last_modif = it;
+        }
+    }
+
+    return FDS_OK;
+}
+
+/** Magic number of a file with a state of a template manager ("FDST")                         */
+#define MGR_FILE_MAGIC   0x46445354U
+/** Version of the file format                                                                 */
+#define MGR_FILE_VERSION 1U
+/** Flag of the file header: the time context is defined                                       */
+#define MGR_FILE_CONTEXT 0x0001U
+/** Size of the file header                                                                    */
+#define MGR_FILE_HDR_LEN 16U
+/** Size of the header of a template record                                                    */
+#define MGR_FILE_REC_LEN 24U
+
+/*
+ * Format of the file (all values are in network byte order):
+ *
+ * File header (MGR_FILE_HDR_LEN):
+ *   uint32_t magic, uint16_t version, uint16_t flags, uint32_t export time, uint32_t count
+ * Template record (MGR_FILE_REC_LEN + length of the raw template), repeated "count" times:
+ *   uint8_t type, uint8_t reserved, uint16_t raw length, uint32_t first seen,
+ *   uint32_t last seen, uint32_t end of life, uint64_t flow key, raw template
+ */
+
+/** \brief Write a 16-bit value in network byte order to a buffer */
+static inline void
+mgr_file_put16(uint8_t *ptr, uint16_t value)
+{
+    ptr[0] = (uint8_t) (value >> 8);
+    ptr[1] = (uint8_t) value;
+}
+
+/** \brief Write a 32-bit value in network byte order to a buffer */
+static inline void
+mgr_file_put32(uint8_t *ptr, uint32_t value)
+{
+    mgr_file_put16(ptr, (uint16_t) (value >> 16));
+    mgr_file_put16(ptr + 2, (uint16_t) value);
+}
+
+/** \brief Read a 16-bit value in network byte order from a buffer */
+static inline uint16_t
+mgr_file_get16(const uint8_t *ptr)
+{
+    return (uint16_t) ((ptr[0] << 8) | ptr[1]);
+}
+
+/** \brief Read a 32-bit value in network byte order from a buffer */
+static inline uint32_t
+mgr_file_get32(const uint8_t *ptr)
+{
+    return ((uint32_t) mgr_file_get16(ptr) << 16) | mgr_file_get16(ptr + 2);
+}
 
-            // We have to find the record again because remove/add operation can change address
-            rec_last_modif = snapshot_rec_find(it, id);
+/** \brief Auxiliary structure for mgr_save_cb() */
+struct mgr_save_data {
+    /** Template manager              */
+    const struct fds_tmgr *mgr;
+    /** Output file                   */
+    FILE *file;
+    /** Operation result              */
+    int ret_code;
+};
+
+/**
+ * \brief Write a template record to a file (callback function)
+ * \param[in] rec  Snapshot record
+ * \param[in] data Auxiliary data structure (struct mgr_save_data)
+ * \return On success returns true. Otherwise returns false and sets an error code appropriately.
+ */
+static bool
+mgr_save_cb(const struct snapshot_rec *rec, void *data)
+{
+    struct mgr_save_data *info = data;
+    const struct fds_template *tmplt = rec->ptr;
+
+    // Flow key is stored as flags of the template fields
+    uint64_t flowkey = 0;
+    for (uint16_t i = 0; i < tmplt->fields_cnt_total && i < 64U; ++i) {
+        if (tmplt->fields[i].flags & FDS_TFIELD_FKEY) {
+            flowkey |= (uint64_t) 1U << i;
         }
     }
 
+    uint8_t hdr[MGR_FILE_REC_LEN];
+    hdr[0] = (uint8_t) tmplt->type;
+    hdr[1] = 0;
+    mgr_file_put16(&hdr[2], tmplt->raw.length);
+    mgr_file_put32(&hdr[4], tmplt->time.first_seen);
+    mgr_file_put32(&hdr[8], mgr_tmplt_last_seen(info->mgr, tmplt));
+    mgr_file_put32(&hdr[12], mgr_tmplt_end_of_life(info->mgr, tmplt));
+    mgr_file_put32(&hdr[16], (uint32_t) (flowkey >> 32));
+    mgr_file_put32(&hdr[20], (uint32_t) flowkey);
+
+    if (fwrite(hdr, sizeof(hdr), 1, info->file) != 1
+            || fwrite(tmplt->raw.data, tmplt->raw.length, 1, info->file) != 1) {
+        info->ret_code = FDS_ERR_DENIED;
+        return false;
+    }
+
+    return true;
+}
+
+int
+fds_tmgr_save(const fds_tmgr_t *tmgr, FILE *file)
+{
+    uint8_t hdr[MGR_FILE_HDR_LEN];
+    mgr_file_put32(&hdr[0], MGR_FILE_MAGIC);
+    mgr_file_put16(&hdr[4], MGR_FILE_VERSION);
+
+    const struct fds_tsnapshot *snap = tmgr->list.newest;
+    if (snap != NULL && tmgr->list.editable_cnt > (snap->editable ? 1U : 0U)) {
+        /* A historical snapshot has been modified, but the modifications haven't been propagated
+         * to the newest snapshot yet (see fds_tmgr_set_time())
+         */
+        return FDS_ERR_ARG;
+    }
+
+    mgr_file_put16(&hdr[6], (snap != NULL) ? MGR_FILE_CONTEXT : 0);
+    mgr_file_put32(&hdr[8], (snap != NULL) ? tmgr->time_newest : 0);
+    mgr_file_put32(&hdr[12], (snap != NULL) ? snap->rec_cnt : 0);
+    if (fwrite(hdr, sizeof(hdr), 1, file) != 1) {
+        return FDS_ERR_DENIED;
+    }
+
+    if (!snap) {
+        return FDS_OK;
+    }
+
+    struct mgr_save_data data;
+    data.mgr = tmgr;
+    data.file = file;
+    data.ret_code = FDS_OK;
+    snapshot_rec_for(snap, &mgr_save_cb, &data);
+    return data.ret_code;
+}
+
+/**
+ * \brief Read a template record from a file and add it to a snapshot
+ *
+ * Templates that have already expired at the start time of the snapshot are ignored.
+ * \param[in] snap Snapshot (must be editable and empty at the beginning)
+ * \param[in] file Input file
+ * \param[in] buffer Buffer for the raw template (at least UINT16_MAX bytes)
+ * \return #FDS_OK, #FDS_ERR_FORMAT (malformed file or read error) or #FDS_ERR_NOMEM
+ */
+static int
+mgr_load_rec(struct fds_tsnapshot *snap, FILE *file, uint8_t *buffer)
+{
+    struct fds_tmgr *mgr = snap->link.mgr;
+    uint8_t hdr[MGR_FILE_REC_LEN];
+    if (fread(hdr, sizeof(hdr), 1, file) != 1) {
+        return FDS_ERR_FORMAT;
+    }
+
+    const enum fds_template_type type = (enum fds_template_type) hdr[0];
+    uint16_t len = mgr_file_get16(&hdr[2]);
+    if ((type != FDS_TYPE_TEMPLATE && type != FDS_TYPE_TEMPLATE_OPTS) || len == 0
+            || fread(buffer, len, 1, file) != 1) {
+        return FDS_ERR_FORMAT;
+    }
+
+    // Parse the raw template
+    struct fds_template *tmplt;
+    const uint16_t len_raw = len;
+    int ret_code = fds_template_parse(type, buffer, &len, &tmplt);
+    if (ret_code != FDS_OK) {
+        return ret_code;
+    }
+
+    tmplt->time.first_seen = mgr_file_get32(&hdr[4]);
+    tmplt->time.last_seen = mgr_file_get32(&hdr[8]);
+    tmplt->time.end_of_life = mgr_file_get32(&hdr[12]);
+    uint64_t flowkey = mgr_file_get32(&hdr[16]);
+    flowkey = (flowkey << 32) | mgr_file_get32(&hdr[20]);
+
+    if (len != len_raw || tmplt->fields_cnt_total == 0
+            || TIME_GT(tmplt->time.last_seen, tmplt->time.end_of_life)
+            || snapshot_rec_cfind(snap, tmplt->id) != NULL) {
+        // Unexpected length, withdrawal, invalid timestamps or duplicated definition
+        fds_template_destroy(tmplt);
+        return FDS_ERR_FORMAT;
+    }
+
+    if (TIME_NE(tmplt->time.last_seen, tmplt->time.end_of_life)
+            && TIME_LT(tmplt->time.end_of_life, snap->start_time)) {
+        // The template has already expired
+        fds_template_destroy(tmplt);
+        return FDS_OK;
+    }
+
+    if ((ret_code = fds_template_ies_define(tmplt, mgr->ies_db, false)) != FDS_OK
+            || (flowkey != 0 && (ret_code = fds_template_flowkey_define(tmplt, flowkey)) != FDS_OK)
+            || (ret_code = mgr_snap_template_add_ref(snap, tmplt, SNAPSHOT_TF_OWNERSHIP)) != FDS_OK) {
+        fds_template_destroy(tmplt);
+        return (ret_code == FDS_ERR_NOMEM) ? FDS_ERR_NOMEM : FDS_ERR_FORMAT;
+    }
+
+    ierefs_add(&mgr->ierefs, tmplt);
     return FDS_OK;
 }
 
+int
+fds_tmgr_load(fds_tmgr_t *tmgr, FILE *file)
+{
+    uint8_t hdr[MGR_FILE_HDR_LEN];
+    if (fread(hdr, sizeof(hdr), 1, file) != 1
+            || mgr_file_get32(&hdr[0]) != MGR_FILE_MAGIC
+            || mgr_file_get16(&hdr[4]) != MGR_FILE_VERSION) {
+        return FDS_ERR_FORMAT;
+    }
+
+    const uint16_t flags = mgr_file_get16(&hdr[6]);
+    const uint32_t exp_time = mgr_file_get32(&hdr[8]);
+    const uint32_t rec_cnt = mgr_file_get32(&hdr[12]);
+
+    // The previous content of the manager is moved to garbage
+    fds_tmgr_clear(tmgr);
+    if ((flags & MGR_FILE_CONTEXT) == 0) {
+        return (rec_cnt == 0) ? FDS_OK : FDS_ERR_FORMAT;
+    }
+
+    uint8_t *buffer = malloc(UINT16_MAX);
+    if (!buffer) {
+        return FDS_ERR_NOMEM;
+    }
+
+    int ret_code;
+    if ((ret_code = fds_tmgr_set_time(tmgr, exp_time)) != FDS_OK) {
+        free(buffer);
+        return ret_code;
+    }
+
+    struct fds_tsnapshot *snap = tmgr->list.current;
+    assert(snap != NULL && snap->editable && snap->rec_cnt == 0);
+    for (uint32_t i = 0; i < rec_cnt && ret_code == FDS_OK; ++i) {
+        ret_code = mgr_load_rec(snap, file, buffer);
+    }
+
+    free(buffer);
+    if (ret_code != FDS_OK) {
+        // Do not leave a partially restored manager
+        fds_tmgr_clear(tmgr);
+    }
+
+    return ret_code;
+}
+
 /**
  * @}
  */
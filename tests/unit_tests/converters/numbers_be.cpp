@@ -50,6 +50,8 @@
 #include <gtest/gtest.h>
 #include <cstring>
 #include <cmath>
+#include <string>
+#include <vector>
 #include <endian.h>
 #include <arpa/inet.h> // ntohs, ntohl
 
@@ -2031,6 +2033,94 @@ TEST_F(ConverterFloat, SetAndGetNan)
 	EXPECT_TRUE(std::isnan(conv_res));
 }
 
+/*
+ * Bulk conversion of fields from multiple records
+ */
+class ConverterBulk : public ::testing::Test {
+protected:
+	/** Number of records */
+	static const size_t REC_CNT = 37;
+	/** Size of each record */
+	static const size_t REC_SIZE = 21;
+	/** Records (odd size to test unaligned access) */
+	uint8_t data[REC_CNT * REC_SIZE];
+	/** Pointers to the records */
+	const uint8_t *bases[REC_CNT];
+
+	void SetUp() override
+	{
+		for (size_t i = 0; i < sizeof(data); ++i) {
+			data[i] = static_cast<uint8_t>(i * 131U + 7U);
+		}
+		for (size_t i = 0; i < REC_CNT; ++i) {
+			// Records in reverse order
+			bases[i] = &data[(REC_CNT - 1 - i) * REC_SIZE];
+		}
+	}
+};
+
+TEST_F(ConverterBulk, Uint)
+{
+	std::vector<uint64_t> values(REC_CNT);
+	for (size_t size = 1; size <= 8; ++size) {
+		SCOPED_TRACE("Size: " + std::to_string(size));
+		for (size_t offset : {0U, 3U, 13U}) {
+			ASSERT_EQ(fds_get_uint_be_bulk(bases, offset, size, values.data(), REC_CNT), FDS_OK);
+			for (size_t i = 0; i < REC_CNT; ++i) {
+				uint64_t ref;
+				ASSERT_EQ(fds_get_uint_be(bases[i] + offset, size, &ref), FDS_OK);
+				EXPECT_EQ(values[i], ref);
+			}
+		}
+	}
+
+	EXPECT_EQ(fds_get_uint_be_bulk(bases, 0, 0, values.data(), REC_CNT), FDS_ERR_ARG);
+	EXPECT_EQ(fds_get_uint_be_bulk(bases, 0, 9, values.data(), REC_CNT), FDS_ERR_ARG);
+}
+
+TEST_F(ConverterBulk, Int)
+{
+	std::vector<int64_t> values(REC_CNT);
+	for (size_t size = 1; size <= 8; ++size) {
+		SCOPED_TRACE("Size: " + std::to_string(size));
+		for (size_t offset : {0U, 3U, 13U}) {
+			ASSERT_EQ(fds_get_int_be_bulk(bases, offset, size, values.data(), REC_CNT), FDS_OK);
+			for (size_t i = 0; i < REC_CNT; ++i) {
+				int64_t ref;
+				ASSERT_EQ(fds_get_int_be(bases[i] + offset, size, &ref), FDS_OK);
+				EXPECT_EQ(values[i], ref);
+			}
+		}
+	}
+
+	EXPECT_EQ(fds_get_int_be_bulk(bases, 0, 0, values.data(), REC_CNT), FDS_ERR_ARG);
+	EXPECT_EQ(fds_get_int_be_bulk(bases, 0, 9, values.data(), REC_CNT), FDS_ERR_ARG);
+}
+
+TEST_F(ConverterBulk, Float)
+{
+	std::vector<double> values(REC_CNT);
+	for (size_t size : {BYTES_4, BYTES_8}) {
+		SCOPED_TRACE("Size: " + std::to_string(size));
+		for (size_t offset : {0U, 3U, 13U}) {
+			ASSERT_EQ(fds_get_float_be_bulk(bases, offset, size, values.data(), REC_CNT), FDS_OK);
+			for (size_t i = 0; i < REC_CNT; ++i) {
+				double ref;
+				ASSERT_EQ(fds_get_float_be(bases[i] + offset, size, &ref), FDS_OK);
+				if (std::isnan(ref)) {
+					EXPECT_TRUE(std::isnan(values[i]));
+				} else {
+					EXPECT_EQ(values[i], ref);
+				}
+			}
+		}
+	}
+
+	for (size_t size : {BYTES_1, BYTES_2, BYTES_3, BYTES_5, BYTES_6, BYTES_7}) {
+		EXPECT_EQ(fds_get_float_be_bulk(bases, 0, size, values.data(), REC_CNT), FDS_ERR_ARG);
+	}
+}
+
 /**
  * @}
  */
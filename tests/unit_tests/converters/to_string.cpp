@@ -47,6 +47,7 @@
 #include <endian.h>
 #include <string>
 #include <memory>
+#include <array>
 #include <cmath>
 
 #include <iomanip> // setprecision
@@ -980,6 +981,47 @@ TEST(ConverterToStrings, datetime2strNormalAndSmallBuffer)
     */
 }
 
+TEST(ConverterToStrings, datetime2strContext)
+{
+    struct fds_datetime_ctx ctx;
+    fds_datetime_ctx_init(&ctx);
+
+    const enum fds_iemgr_element_type type = FDS_ET_DATE_TIME_MILLISECONDS;
+    const std::array<enum fds_convert_time_fmt, 4> fmts = {
+        FDS_CONVERT_TF_MSEC_UTC, FDS_CONVERT_TF_MSEC_LOCAL,
+        FDS_CONVERT_TF_SEC_UTC, FDS_CONVERT_TF_NSEC_LOCAL
+    };
+
+    // Timestamps within the same second and across seconds (cached values must be replaced)
+    uint8_t data[BYTES_8];
+    char res[FDS_CONVERT_STRLEN_DATE];
+    for (uint64_t ts_ms = 1501161713000ULL; ts_ms < 1501161716500ULL; ts_ms += 77) {
+        struct timespec ts = {static_cast<time_t>(ts_ms / 1000),
+            static_cast<long>((ts_ms % 1000) * 1000000)};
+        ASSERT_EQ(fds_set_datetime_hp_be(data, BYTES_8, type, ts), FDS_OK);
+
+        for (const auto fmt : fmts) {
+            std::string exp_value;
+            datetime2str_get_expectation(ts, type, fmt, exp_value);
+
+            int ret_code = fds_datetime2str_ctx_be(&ctx, data, BYTES_8, type, res, sizeof(res),
+                fmt);
+            ASSERT_EQ(ret_code, static_cast<int>(exp_value.length()));
+            EXPECT_EQ(std::string(res), exp_value);
+
+            // Insufficient buffer size
+            EXPECT_EQ(fds_datetime2str_ctx_be(&ctx, data, BYTES_8, type, res, exp_value.length(),
+                fmt), FDS_ERR_BUFFER);
+        }
+    }
+
+    // Invalid arguments
+    EXPECT_EQ(fds_datetime2str_ctx_be(&ctx, data, BYTES_4, type, res, sizeof(res),
+        FDS_CONVERT_TF_MSEC_UTC), FDS_ERR_ARG);
+    EXPECT_EQ(fds_datetime2str_ctx_be(&ctx, data, BYTES_8, type, res, sizeof(res),
+        static_cast<enum fds_convert_time_fmt>(0x05)), FDS_ERR_ARG);
+}
+
 /*
  * Test invalid input size
  */
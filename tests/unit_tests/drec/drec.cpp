@@ -124,6 +124,10 @@ class drecIter : public drecFind {
     // Nothing, we need just another name :D
 };
 
+class drecPrep : public drecFind {
+    // Nothing, we need just another name :D
+};
+
 // SIMPLE FIND -------------------------------------------------------------------------------------
 // Try to find missing field
 TEST_F(drecFind, missing)
@@ -245,6 +249,108 @@ TEST_F(drecFind, varAfterVar)
     // Cannot check empty string!
 }
 
+// Results of the search must match the first occurrence found by the iterator
+TEST_F(drecFind, matchIterator)
+{
+    struct fds_drec_iter it;
+    fds_drec_iter_init(&it, &rec, 0);
+
+    int idx;
+    while ((idx = fds_drec_iter_next(&it)) != FDS_EOC) {
+        const struct fds_tfield *info = it.field.info;
+        if ((info->flags & FDS_TFIELD_MULTI_IE) != 0 && (info->flags & FDS_TFIELD_LAST_IE) != 0) {
+            // Not the first occurrence (the first one is always flagged without LAST_IE)
+            continue;
+        }
+
+        struct fds_drec_field field;
+        ASSERT_EQ(fds_drec_find(&rec, info->en, info->id, &field), idx);
+        EXPECT_EQ(field.data, it.field.data);
+        EXPECT_EQ(field.size, it.field.size);
+        EXPECT_EQ(field.info, info);
+    }
+}
+
+// PREPARED RECORD ------------------------------------------------------------------------------
+// Fields of a prepared record must match fields returned by the iterator
+TEST_F(drecPrep, matchIterator)
+{
+    std::vector<struct fds_drec_loc> locs(rec.tmplt->fields_cnt_total);
+    struct fds_drec_prep prep;
+    ASSERT_EQ(fds_drec_prepare(&prep, &rec, locs.data(), locs.size()), FDS_OK);
+
+    struct fds_drec_iter it;
+    fds_drec_iter_init(&it, &rec, 0);
+
+    int idx;
+    while ((idx = fds_drec_iter_next(&it)) != FDS_EOC) {
+        struct fds_drec_field field;
+        ASSERT_EQ(fds_drec_prep_get(&prep, idx, &field), idx);
+        EXPECT_EQ(field.data, it.field.data);
+        EXPECT_EQ(field.size, it.field.size);
+        EXPECT_EQ(field.info, it.field.info);
+
+        const struct fds_tfield *info = it.field.info;
+        ASSERT_GE(fds_drec_prep_find(&prep, info->en, info->id, &field), 0);
+        struct fds_drec_field field_ref;
+        const int idx_ref = fds_drec_find(&rec, info->en, info->id, &field_ref);
+        ASSERT_EQ(idx_ref, field.info - rec.tmplt->fields);
+        EXPECT_EQ(field.data, field_ref.data);
+        EXPECT_EQ(field.size, field_ref.size);
+        EXPECT_EQ(field.info, field_ref.info);
+    }
+
+    // Out of range and missing fields
+    struct fds_drec_field field;
+    EXPECT_EQ(fds_drec_prep_get(&prep, rec.tmplt->fields_cnt_total, &field), FDS_EOC);
+    EXPECT_EQ(fds_drec_prep_find(&prep, 0, 1000, &field), FDS_EOC);
+    EXPECT_EQ(fds_drec_prep_find(&prep, 8888, 100, &field), FDS_EOC);
+}
+
+// Check a value of a field after the variable-length fields
+TEST_F(drecPrep, fixedAfterVar)
+{
+    std::vector<struct fds_drec_loc> locs(rec.tmplt->fields_cnt_total);
+    struct fds_drec_prep prep;
+    ASSERT_EQ(fds_drec_prepare(&prep, &rec, locs.data(), locs.size()), FDS_OK);
+
+    struct fds_drec_field field;
+    uint64_t uint64_result;
+    ASSERT_GE(fds_drec_prep_find(&prep, 29305, 2, &field), 0);
+    EXPECT_EQ(field.size, 8);
+    ASSERT_EQ(fds_get_uint_be(field.data, field.size, &uint64_result), FDS_OK);
+    EXPECT_EQ(uint64_result, VALUE_PKTS_R);
+
+    // The last field (the second occurrence of interfaceName)
+    ASSERT_EQ(fds_drec_prep_get(&prep, rec.tmplt->fields_cnt_total - 1, &field),
+        rec.tmplt->fields_cnt_total - 1);
+    EXPECT_EQ(field.size, VALUE_IFC2.size());
+    EXPECT_EQ(memcmp(field.data, VALUE_IFC2.c_str(), field.size), 0);
+}
+
+// Too small array of locations
+TEST_F(drecPrep, smallArray)
+{
+    std::vector<struct fds_drec_loc> locs(rec.tmplt->fields_cnt_total - 1);
+    struct fds_drec_prep prep;
+    EXPECT_EQ(fds_drec_prepare(&prep, &rec, locs.data(), locs.size()), FDS_ERR_ARG);
+}
+
+// Fields exceeding the size of the record
+TEST_F(drecPrep, malformed)
+{
+    std::vector<struct fds_drec_loc> locs(rec.tmplt->fields_cnt_total);
+    struct fds_drec_prep prep;
+    const uint16_t size_orig = rec.size;
+
+    rec.size = size_orig - 1;
+    EXPECT_EQ(fds_drec_prepare(&prep, &rec, locs.data(), locs.size()), FDS_ERR_FORMAT);
+    rec.size = 40;
+    EXPECT_EQ(fds_drec_prepare(&prep, &rec, locs.data(), locs.size()), FDS_ERR_FORMAT);
+    rec.size = size_orig;
+    EXPECT_EQ(fds_drec_prepare(&prep, &rec, locs.data(), locs.size()), FDS_OK);
+}
+
 // ITERATOR -------------------------------------------------------------------------------------
 // Iterate over whole record
 TEST_F(drecIter, overWholeRec) // Automatically skip padding
@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <MsgGen.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+/// Auto-destroyed template
+using unique_tmplt = std::unique_ptr<struct fds_template, decltype(&fds_template_destroy)>;
+/// Auto-destroyed JSON serializer
+using unique_json = std::unique_ptr<fds_json_t, decltype(&fds_json_destroy)>;
+/// Auto-destroyed IE manager
+using unique_iemgr = std::unique_ptr<fds_iemgr_t, decltype(&fds_iemgr_destroy)>;
+/// Auto-freed memory
+using unique_mem = std::unique_ptr<uint8_t, decltype(&free)>;
+
+// Parse a template
+static unique_tmplt
+tmplt_parse(ipfix_trec &trec)
+{
+    uint16_t tmplt_size = trec.size();
+    unique_mem tmplt_raw(trec.release(), &free);
+    struct fds_template *tmplt;
+    if (fds_template_parse(FDS_TYPE_TEMPLATE, tmplt_raw.get(), &tmplt_size, &tmplt) != FDS_OK) {
+        throw std::runtime_error("Failed to parse a template!");
+    }
+    return unique_tmplt(tmplt, &fds_template_destroy);
+}
+
+// Convert a record to a JSON string
+static std::string
+json_conv(fds_json_t *json, struct fds_drec *rec)
+{
+    char *str = nullptr;
+    size_t str_size = 0;
+    int ret = fds_json_drec(json, rec, &str, &str_size);
+    std::unique_ptr<char, decltype(&free)> str_wrap(str, &free);
+    if (ret < 0) {
+        throw std::runtime_error("Conversion failed!");
+    }
+
+    EXPECT_LT(static_cast<size_t>(ret), str_size);
+    EXPECT_EQ(strlen(str), static_cast<size_t>(ret));
+    return std::string(str, ret);
+}
+
+class Json : public ::testing::Test {
+protected:
+    unique_iemgr ie_mgr {nullptr, &fds_iemgr_destroy};
+    unique_tmplt tmplt {nullptr, &fds_template_destroy};
+    unique_mem rec_data {nullptr, &free};
+    struct fds_drec rec;
+
+    void SetUp() override {
+        ie_mgr.reset(fds_iemgr_create());
+        ASSERT_NE(ie_mgr, nullptr);
+        ASSERT_EQ(fds_iemgr_read_file(ie_mgr.get(), "data/iana.xml", true), FDS_OK);
+
+        ipfix_trec trec {256};
+        trec.add_field(  7, 2);                    // sourceTransportPort
+        trec.add_field(  8, 4);                    // sourceIPv4Address
+        trec.add_field( 27, 16);                   // sourceIPv6Address
+        trec.add_field( 56, 6);                    // sourceMacAddress
+        trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName
+        trec.add_field(152, 8);                    // flowStartMilliseconds
+        trec.add_field(154, 8);                    // flowStartMicroseconds
+        trec.add_field(156, 8);                    // flowStartNanoseconds
+        trec.add_field(100, 3, 10000);             // -- field with unknown definition --
+        trec.add_field(210, 2);                    // -- paddingOctets
+        trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName (2nd occurrence)
+        trec.add_field(  1, 4);                    // octetDeltaCount (reduced size)
+        trec.add_field(  4, 2);                    // protocolIdentifier (extended size)
+        trec.add_field( 80, 4);                    // destinationMacAddress (invalid size)
+        tmplt = tmplt_parse(trec);
+        ASSERT_EQ(fds_template_ies_define(tmplt.get(), ie_mgr.get(), false), FDS_OK);
+
+        const uint8_t mac[] = {0x00, 0x1A, 0x2B, 0x3C, 0x4D, 0x5E};
+        const uint8_t octets[] = {0x01, 0xAB, 0xFF};
+        ipfix_drec drec {};
+        drec.append_uint(65000, 2);
+        drec.append_ip("10.0.0.1");
+        drec.append_ip("2001:db8::1");
+        drec.append_octets(mac, 6, false);
+        drec.append_string("eth\"0\"\n");
+        drec.append_datetime(1522670362123ULL, FDS_ET_DATE_TIME_MILLISECONDS);
+        drec.append_datetime({1522670362, 125000000}, FDS_ET_DATE_TIME_MICROSECONDS);
+        drec.append_datetime({1522670363, 500000000}, FDS_ET_DATE_TIME_NANOSECONDS);
+        drec.append_octets(octets, 3, false);
+        drec.append_uint(0, 2);
+        drec.append_string("caf\xC3\xA9\x01\xFF\\");
+        drec.append_uint(1234567, 4);
+        drec.append_uint(6, 2);
+        drec.append_uint(0, 4);
+
+        rec.size = drec.size();
+        rec_data.reset(drec.release());
+        rec.data = rec_data.get();
+        rec.tmplt = tmplt.get();
+        rec.snap = nullptr;
+    }
+};
+
+// Conversion of all supported types
+TEST_F(Json, allTypes)
+{
+    unique_json json(fds_json_create(0), &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+
+    const std::string expected = "{"
+        "\"iana:sourceTransportPort\":65000,"
+        "\"iana:sourceIPv4Address\":\"10.0.0.1\","
+        "\"iana:sourceIPv6Address\":\"2001:db8::1\","
+        "\"iana:sourceMacAddress\":\"00:1A:2B:3C:4D:5E\","
+        "\"iana:interfaceName\":[\"eth\\\"0\\\"\\n\",\"caf\xC3\xA9\\u0001\xEF\xBF\xBD\\\\\"],"
+        "\"iana:flowStartMilliseconds\":\"2018-04-02T11:59:22.123Z\","
+        "\"iana:flowStartMicroseconds\":\"2018-04-02T11:59:22.125000Z\","
+        "\"iana:flowStartNanoseconds\":\"2018-04-02T11:59:23.500000000Z\","
+        "\"en10000:id100\":\"0x01ABFF\","
+        "\"iana:octetDeltaCount\":1234567,"
+        "\"iana:protocolIdentifier\":6,"
+        "\"iana:destinationMacAddress\":null"
+        "}";
+
+    // The second conversion uses cached keys
+    for (int i = 0; i < 2; ++i) {
+        SCOPED_TRACE("Round: " + std::to_string(i));
+        EXPECT_EQ(json_conv(json.get(), &rec), expected);
+    }
+}
+
+// Conversion flags
+TEST_F(Json, flags)
+{
+    unique_json json(fds_json_create(FDS_JSON_TS_NUMERIC | FDS_JSON_UNKNOWN_SKIP),
+        &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+
+    std::string str = json_conv(json.get(), &rec);
+    EXPECT_NE(str.find("\"iana:flowStartMilliseconds\":1522670362123,"), std::string::npos);
+    EXPECT_NE(str.find("\"iana:flowStartNanoseconds\":1522670363500,"), std::string::npos);
+    EXPECT_EQ(str.find("en10000"), std::string::npos);
+}
+
+// Keys must be rebuilt when definitions of Information Elements change
+TEST_F(Json, redefinition)
+{
+    unique_json json(fds_json_create(0), &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+
+    std::string str = json_conv(json.get(), &rec);
+    EXPECT_EQ(str.compare(0, 27, "{\"iana:sourceTransportPort\""), 0);
+
+    // Template copy without definitions (the same layout of fields)
+    unique_tmplt copy(fds_template_copy(tmplt.get()), &fds_template_destroy);
+    ASSERT_NE(copy, nullptr);
+    ASSERT_EQ(fds_template_ies_define(copy.get(), nullptr, false), FDS_OK);
+    rec.tmplt = copy.get();
+
+    str = json_conv(json.get(), &rec);
+    EXPECT_EQ(str.compare(0, 20, "{\"en0:id7\":\"0xFDE8\","), 0) << str;
+    EXPECT_EQ(str.find("iana:"), std::string::npos);
+}
+
+// Sessions with different layouts of the same Template ID are converted alternately
+TEST_F(Json, alternatingLayouts)
+{
+    unique_json json(fds_json_create(0), &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+    const std::string expected_fixture = json_conv(json.get(), &rec);
+
+    // More layouts than the cache can hold per Template ID
+    const int layout_cnt = 6;
+    std::vector<unique_tmplt> tmplts;
+    std::vector<unique_mem> recs_data;
+    std::vector<struct fds_drec> recs(layout_cnt);
+    std::vector<std::string> expected;
+
+    for (int i = 0; i < layout_cnt; ++i) {
+        ipfix_trec trec {256};
+        ipfix_drec drec {};
+        for (int j = 0; j <= i; ++j) {
+            trec.add_field(210, 1 + j); // -- paddingOctets
+            drec.append_uint(0, 1 + j);
+        }
+        trec.add_field(  7, 2);                    // sourceTransportPort
+        trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName
+        drec.append_uint(1000 + i, 2);
+        drec.append_string("eth" + std::to_string(i));
+
+        tmplts.push_back(tmplt_parse(trec));
+        ASSERT_EQ(fds_template_ies_define(tmplts.back().get(), ie_mgr.get(), false), FDS_OK);
+        recs[i].size = drec.size();
+        recs_data.emplace_back(drec.release(), &free);
+        recs[i].data = recs_data.back().get();
+        recs[i].tmplt = tmplts.back().get();
+        recs[i].snap = nullptr;
+        expected.push_back("{\"iana:sourceTransportPort\":" + std::to_string(1000 + i)
+            + ",\"iana:interfaceName\":\"eth" + std::to_string(i) + "\"}");
+    }
+
+    // Two layouts (both keys stay in the cache)
+    for (int round = 0; round < 3; ++round) {
+        SCOPED_TRACE("Round: " + std::to_string(round));
+        EXPECT_EQ(json_conv(json.get(), &rec), expected_fixture);
+        EXPECT_EQ(json_conv(json.get(), &recs[0]), expected[0]);
+    }
+
+    // All layouts (keys are replaced)
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < layout_cnt; ++i) {
+            SCOPED_TRACE("Round: " + std::to_string(round) + ", layout: " + std::to_string(i));
+            EXPECT_EQ(json_conv(json.get(), &recs[i]), expected[i]);
+        }
+        EXPECT_EQ(json_conv(json.get(), &rec), expected_fixture);
+    }
+}
+
+// Elements of a scope without a name (added by fds_iemgr_elem_add()) have numeric keys
+TEST_F(Json, unnamedScope)
+{
+    fds_iemgr_elem elem {};
+    elem.id = 100;
+    elem.name = const_cast<char *>("someElement");
+    elem.data_type = FDS_ET_OCTET_ARRAY;
+    ASSERT_EQ(fds_iemgr_elem_add(ie_mgr.get(), &elem, 10000, false), FDS_OK);
+    ASSERT_EQ(fds_template_ies_define(tmplt.get(), ie_mgr.get(), false), FDS_OK);
+    const struct fds_tfield *tfield = fds_template_cfind(tmplt.get(), 10000, 100);
+    ASSERT_NE(tfield, nullptr);
+    ASSERT_NE(tfield->def, nullptr);
+    ASSERT_EQ(tfield->def->scope->name, nullptr);
+
+    unique_json json(fds_json_create(0), &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+    std::string str = json_conv(json.get(), &rec);
+    EXPECT_NE(str.find("\"en10000:id100\":\"0x01ABFF\""), std::string::npos) << str;
+    EXPECT_NE(str.find("\"iana:sourceTransportPort\""), std::string::npos);
+}
+
+// A user provided buffer is enlarged
+TEST_F(Json, buffer)
+{
+    unique_json json(fds_json_create(0), &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+
+    const std::string expected = json_conv(json.get(), &rec);
+    size_t str_size = 8;
+    char *str = static_cast<char *>(malloc(str_size));
+    ASSERT_NE(str, nullptr);
+
+    int ret = fds_json_drec(json.get(), &rec, &str, &str_size);
+    std::unique_ptr<char, decltype(&free)> str_wrap(str, &free);
+    ASSERT_EQ(ret, static_cast<int>(expected.size()));
+    EXPECT_GT(str_size, expected.size());
+    EXPECT_EQ(std::string(str), expected);
+}
+
+// Malformed record
+TEST_F(Json, malformed)
+{
+    unique_json json(fds_json_create(0), &fds_json_destroy);
+    ASSERT_NE(json, nullptr);
+
+    rec.size -= 3;
+    char *str = nullptr;
+    size_t str_size = 0;
+    EXPECT_EQ(fds_json_drec(json.get(), &rec, &str, &str_size), FDS_ERR_FORMAT);
+    free(str);
+}
@@ -0,0 +1,468 @@
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <MsgGen.h>
+
+#include <memory>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+/// Auto-destroyed template
+using unique_tmplt = std::unique_ptr<struct fds_template, decltype(&fds_template_destroy)>;
+/// Auto-destroyed projection
+using unique_proj = std::unique_ptr<fds_proj_t, decltype(&fds_proj_destroy)>;
+/// Auto-freed memory
+using unique_mem = std::unique_ptr<uint8_t, decltype(&free)>;
+
+// Parse a template
+static unique_tmplt
+tmplt_parse(ipfix_trec &trec)
+{
+    uint16_t tmplt_size = trec.size();
+    unique_mem tmplt_raw(trec.release(), &free);
+    struct fds_template *tmplt;
+    if (fds_template_parse(FDS_TYPE_TEMPLATE, tmplt_raw.get(), &tmplt_size, &tmplt) != FDS_OK) {
+        throw std::runtime_error("Failed to parse a template!");
+    }
+    return unique_tmplt(tmplt, &fds_template_destroy);
+}
+
+// Check that extracted fields match fields found by fds_drec_find()
+static void
+proj_check(fds_proj_t *proj, const std::vector<struct fds_proj_elem> &elems,
+    struct fds_drec *rec, int found_cnt)
+{
+    std::vector<struct fds_drec_field> fields(elems.size());
+    ASSERT_EQ(fds_proj_extract(proj, rec, fields.data()), found_cnt);
+
+    for (size_t i = 0; i < elems.size(); ++i) {
+        SCOPED_TRACE("Element: " + std::to_string(i));
+        struct fds_drec_field ref;
+        if (fds_drec_find(rec, elems[i].en, elems[i].id, &ref) == FDS_EOC) {
+            EXPECT_EQ(fields[i].data, nullptr);
+            EXPECT_EQ(fields[i].size, 0);
+            EXPECT_EQ(fields[i].info, nullptr);
+            continue;
+        }
+
+        EXPECT_EQ(fields[i].data, ref.data);
+        EXPECT_EQ(fields[i].size, ref.size);
+        EXPECT_EQ(fields[i].info, ref.info);
+    }
+}
+
+class Proj : public ::testing::Test {
+protected:
+    // Typical "flow key" projection (+ unknown and duplicated element)
+    std::vector<struct fds_proj_elem> elems {
+        {0, 8}, {0, 12}, {0, 7}, {0, 11}, {0, 4}, {0, 1}, {0, 2}, {0, 152}, {0, 153},
+        {0, 96}, {0, 82}, {8888, 100}, {0, 7}
+    };
+};
+
+// Invalid arguments
+TEST_F(Proj, createInvalid)
+{
+    EXPECT_EQ(fds_proj_create(elems.data(), 0), nullptr);
+}
+
+// Template with fields of fixed length only
+TEST_F(Proj, staticTemplate)
+{
+    ipfix_trec trec {256};
+    trec.add_field(  7, 2); // sourceTransportPort
+    trec.add_field(  8, 4); // sourceIPv4Address
+    trec.add_field( 11, 2); // destinationTransportPort
+    trec.add_field( 12, 4); // destinationIPv4Address
+    trec.add_field(  4, 1); // protocolIdentifier
+    trec.add_field(210, 3); // -- paddingOctets
+    trec.add_field(  1, 8); // octetDeltaCount
+    trec.add_field(  2, 8); // packetDeltaCount
+    unique_tmplt tmplt = tmplt_parse(trec);
+
+    ipfix_drec drec {};
+    drec.append_uint(65000, 2);
+    drec.append_ip("127.0.0.1");
+    drec.append_uint(80, 2);
+    drec.append_ip("8.8.8.8");
+    drec.append_uint(6, 1);
+    drec.append_uint(0, 3);
+    drec.append_uint(1234567, 8);
+    drec.append_uint(12345, 8);
+
+    struct fds_drec rec;
+    rec.size = drec.size();
+    unique_mem rec_data(drec.release(), &free);
+    rec.data = rec_data.get();
+    rec.tmplt = tmplt.get();
+    rec.snap = nullptr;
+
+    unique_proj proj(fds_proj_create(elems.data(), elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+
+    // The second extraction uses the cached plan
+    for (int i = 0; i < 2; ++i) {
+        SCOPED_TRACE("Round: " + std::to_string(i));
+        proj_check(proj.get(), elems, &rec, 8);
+    }
+
+    std::vector<struct fds_drec_field> fields(elems.size());
+    ASSERT_EQ(fds_proj_extract(proj.get(), &rec, fields.data()), 8);
+    uint64_t value;
+    ASSERT_EQ(fds_get_uint_be(fields[5].data, fields[5].size, &value), FDS_OK);
+    EXPECT_EQ(value, 1234567U);
+    ASSERT_EQ(fds_get_uint_be(fields[12].data, fields[12].size, &value), FDS_OK);
+    EXPECT_EQ(value, 65000U);
+}
+
+// Template with fields of variable length
+TEST_F(Proj, dynamicTemplate)
+{
+    ipfix_trec trec {300};
+    trec.add_field(  8, 4);                    // sourceIPv4Address
+    trec.add_field( 96, ipfix_trec::SIZE_VAR); // applicationName
+    trec.add_field( 12, 4);                    // destinationIPv4Address
+    trec.add_field( 94, ipfix_trec::SIZE_VAR); // applicationDescription
+    trec.add_field(  7, 2);                    // sourceTransportPort
+    trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName
+    trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName (second occurrence)
+    trec.add_field(  1, 8);                    // octetDeltaCount
+    unique_tmplt tmplt = tmplt_parse(trec);
+
+    std::string app_dsc(300, 'x');
+    ipfix_drec drec {};
+    drec.append_ip("127.0.0.1");
+    drec.append_string("firefox");
+    drec.append_ip("8.8.8.8");
+    drec.var_header(app_dsc.length(), true);
+    drec.append_string(app_dsc, app_dsc.length());
+    drec.append_uint(65000, 2);
+    drec.var_header(0, false);
+    drec.append_string("eth0");
+    drec.append_uint(1234567, 8);
+
+    struct fds_drec rec;
+    rec.size = drec.size();
+    unique_mem rec_data(drec.release(), &free);
+    rec.data = rec_data.get();
+    rec.tmplt = tmplt.get();
+    rec.snap = nullptr;
+
+    unique_proj proj(fds_proj_create(elems.data(), elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+    for (int i = 0; i < 2; ++i) {
+        SCOPED_TRACE("Round: " + std::to_string(i));
+        proj_check(proj.get(), elems, &rec, 7);
+    }
+
+    std::vector<struct fds_drec_field> fields(elems.size());
+    ASSERT_EQ(fds_proj_extract(proj.get(), &rec, fields.data()), 7);
+    uint64_t value;
+    ASSERT_EQ(fds_get_uint_be(fields[5].data, fields[5].size, &value), FDS_OK);
+    EXPECT_EQ(value, 1234567U);
+    EXPECT_EQ(fields[10].size, 0); // The first occurrence of interfaceName
+    EXPECT_EQ(fields[9].size, 7U);
+    EXPECT_EQ(memcmp(fields[9].data, "firefox", 7), 0);
+}
+
+// Redefinition of a template with the same ID must recompile the plan
+TEST_F(Proj, redefinition)
+{
+    unique_proj proj(fds_proj_create(elems.data(), elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+
+    // The first definition
+    ipfix_trec trec1 {256};
+    trec1.add_field(  8, 4);                    // sourceIPv4Address
+    trec1.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName
+    trec1.add_field(  7, 2);                    // sourceTransportPort
+    unique_tmplt tmplt1 = tmplt_parse(trec1);
+
+    ipfix_drec drec1 {};
+    drec1.append_ip("127.0.0.1");
+    drec1.append_string("eth0");
+    drec1.append_uint(65000, 2);
+
+    struct fds_drec rec1;
+    rec1.size = drec1.size();
+    unique_mem rec1_data(drec1.release(), &free);
+    rec1.data = rec1_data.get();
+    rec1.tmplt = tmplt1.get();
+    rec1.snap = nullptr;
+    proj_check(proj.get(), elems, &rec1, 4);
+
+    // A copy of the template has the same layout
+    unique_tmplt tmplt1_cpy(fds_template_copy(tmplt1.get()), &fds_template_destroy);
+    ASSERT_NE(tmplt1_cpy, nullptr);
+    EXPECT_EQ(tmplt1_cpy->index.layout_id, tmplt1->index.layout_id);
+    rec1.tmplt = tmplt1_cpy.get();
+    proj_check(proj.get(), elems, &rec1, 4);
+
+    // The second definition (different layout)
+    ipfix_trec trec2 {256};
+    trec2.add_field(  7, 2); // sourceTransportPort
+    trec2.add_field( 12, 4); // destinationIPv4Address
+    trec2.add_field(  4, 1); // protocolIdentifier
+    unique_tmplt tmplt2 = tmplt_parse(trec2);
+    EXPECT_NE(tmplt2->index.layout_id, tmplt1->index.layout_id);
+
+    ipfix_drec drec2 {};
+    drec2.append_uint(80, 2);
+    drec2.append_ip("8.8.8.8");
+    drec2.append_uint(17, 1);
+
+    struct fds_drec rec2;
+    rec2.size = drec2.size();
+    unique_mem rec2_data(drec2.release(), &free);
+    rec2.data = rec2_data.get();
+    rec2.tmplt = tmplt2.get();
+    rec2.snap = nullptr;
+    proj_check(proj.get(), elems, &rec2, 4);
+
+    // Back to the first definition
+    rec1.tmplt = tmplt1.get();
+    proj_check(proj.get(), elems, &rec1, 4);
+}
+
+// Sessions with different layouts of the same Template ID are processed alternately
+TEST_F(Proj, alternatingLayouts)
+{
+    unique_proj proj(fds_proj_create(elems.data(), elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+
+    // More layouts than the cache can hold per Template ID
+    const int layout_cnt = 6;
+    std::vector<unique_tmplt> tmplts;
+    std::vector<unique_mem> recs_data;
+    std::vector<struct fds_drec> recs(layout_cnt);
+
+    for (int i = 0; i < layout_cnt; ++i) {
+        ipfix_trec trec {256};
+        ipfix_drec drec {};
+        for (int j = 0; j <= i; ++j) {
+            trec.add_field(210, 1 + j); // -- paddingOctets
+            drec.append_uint(0, 1 + j);
+        }
+        trec.add_field(  8, 4);                    // sourceIPv4Address
+        trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName
+        trec.add_field(  7, 2);                    // sourceTransportPort
+        drec.append_ip("127.0.0.1");
+        drec.append_string("eth" + std::to_string(i));
+        drec.append_uint(1000 + i, 2);
+
+        tmplts.push_back(tmplt_parse(trec));
+        recs[i].size = drec.size();
+        recs_data.emplace_back(drec.release(), &free);
+        recs[i].data = recs_data.back().get();
+        recs[i].tmplt = tmplts.back().get();
+        recs[i].snap = nullptr;
+    }
+
+    // Alternate 2 layouts (both plans stay in the cache), then all of them (plans are replaced)
+    for (int cnt : {2, layout_cnt}) {
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < cnt; ++i) {
+                SCOPED_TRACE("Layouts: " + std::to_string(cnt) + ", round: "
+                    + std::to_string(round) + ", layout: " + std::to_string(i));
+                proj_check(proj.get(), elems, &recs[i], 4);
+
+                std::vector<struct fds_drec_field> fields(elems.size());
+                ASSERT_EQ(fds_proj_extract(proj.get(), &recs[i], fields.data()), 4);
+                uint64_t value;
+                ASSERT_EQ(fds_get_uint_be(fields[12].data, fields[12].size, &value), FDS_OK);
+                EXPECT_EQ(value, 1000U + i);
+            }
+        }
+    }
+}
+
+// Extraction of Data Records of a Data Set into columns
+TEST_F(Proj, columns)
+{
+    // IE manager (required for timestamps)
+    std::unique_ptr<fds_iemgr_t, decltype(&fds_iemgr_destroy)> ie_mgr(fds_iemgr_create(),
+        &fds_iemgr_destroy);
+    ASSERT_NE(ie_mgr, nullptr);
+    ASSERT_EQ(fds_iemgr_read_file(ie_mgr.get(), "data/iana.xml", true), FDS_OK);
+
+    ipfix_trec trec {256};
+    trec.add_field(  7, 2);                    // sourceTransportPort
+    trec.add_field( 82, ipfix_trec::SIZE_VAR); // interfaceName
+    trec.add_field(  4, 1);                    // protocolIdentifier
+    trec.add_field(152, 8);                    // flowStartMilliseconds
+    trec.add_field(100, 4, 10000);             // -- field with unknown definition --
+    trec.add_field(  1, 4);                    // octetDeltaCount (reduced size)
+    unique_tmplt tmplt = tmplt_parse(trec);
+    ASSERT_EQ(fds_template_ies_define(tmplt.get(), ie_mgr.get(), false), FDS_OK);
+
+    const uint16_t rec_cnt = 150;
+    const uint64_t ts_base = 1522670362000ULL;
+    ipfix_set set {256};
+    for (uint16_t i = 0; i < rec_cnt; ++i) {
+        ipfix_drec rec {};
+        rec.append_uint(1000U + i, 2);
+        rec.append_string(std::string("interface") + std::to_string(i)); // > 8 bytes
+        rec.append_uint(i % 2 == 0 ? 6 : 17, 1);
+        rec.append_datetime(ts_base + i, FDS_ET_DATE_TIME_MILLISECONDS);
+        rec.append_float(i / 2.0, 4);
+        rec.append_uint(i * 100U, 4);
+        set.add_rec(rec);
+    }
+    unique_mem set_data(reinterpret_cast<uint8_t *>(set.release()), &free);
+    auto set_hdr = reinterpret_cast<struct fds_ipfix_set_hdr *>(set_data.get());
+
+    const std::vector<struct fds_proj_elem> col_elems {
+        {0, 7}, {0, 4}, {0, 152}, {10000, 100}, {0, 1}, {0, 2}, {0, 82}
+    };
+    unique_proj proj(fds_proj_create(col_elems.data(), col_elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+
+    // Columns (smaller than the number of records)
+    const uint32_t rows_max = 100;
+    std::vector<uint64_t> port(rows_max), proto(rows_max), ts(rows_max);
+    std::vector<uint64_t> pkts(rows_max), ifc(rows_max);
+    std::vector<int64_t> bytes_int(rows_max);
+    std::vector<double> unknown(rows_max);
+    std::vector<std::vector<uint8_t>> valid(col_elems.size(), std::vector<uint8_t>(13, 0xFF));
+
+    const std::vector<struct fds_proj_col> cols {
+        {FDS_PROJ_COL_UINT,     port.data(),      valid[0].data()},
+        {FDS_PROJ_COL_UINT,     proto.data(),     valid[1].data()},
+        {FDS_PROJ_COL_DATETIME, ts.data(),        valid[2].data()},
+        {FDS_PROJ_COL_FLOAT,    unknown.data(),   valid[3].data()},
+        {FDS_PROJ_COL_INT,      bytes_int.data(), valid[4].data()},
+        {FDS_PROJ_COL_UINT,     pkts.data(),      valid[5].data()}, // missing in the template
+        {FDS_PROJ_COL_UINT,     ifc.data(),       valid[6].data()}  // too long to be converted
+    };
+
+    auto is_valid = [&valid](size_t col, uint32_t row) -> bool {
+        return (valid[col][row / 8] & (1U << (row % 8))) != 0;
+    };
+
+    struct fds_dset_iter it;
+    fds_dset_iter_init(&it, set_hdr, tmplt.get());
+
+    uint32_t rec_idx = 0;
+    uint32_t rows_cnt;
+    int rc;
+    while ((rc = fds_proj_columns(proj.get(), &it, cols.data(), rows_max, &rows_cnt)) == FDS_OK) {
+        ASSERT_GT(rows_cnt, 0U);
+        ASSERT_LE(rows_cnt, rows_max);
+        for (uint32_t row = 0; row < rows_cnt; ++row, ++rec_idx) {
+            SCOPED_TRACE("Record " + std::to_string(rec_idx));
+            EXPECT_TRUE(is_valid(0, row));
+            EXPECT_EQ(port[row], 1000U + rec_idx);
+            EXPECT_TRUE(is_valid(1, row));
+            EXPECT_EQ(proto[row], (rec_idx % 2 == 0) ? 6U : 17U);
+            EXPECT_TRUE(is_valid(2, row));
+            EXPECT_EQ(ts[row], ts_base + rec_idx);
+            EXPECT_TRUE(is_valid(3, row));
+            EXPECT_DOUBLE_EQ(unknown[row], rec_idx / 2.0);
+            EXPECT_TRUE(is_valid(4, row));
+            EXPECT_EQ(bytes_int[row], rec_idx * 100);
+            EXPECT_FALSE(is_valid(5, row));
+            EXPECT_EQ(pkts[row], 0U);
+            EXPECT_FALSE(is_valid(6, row));
+            EXPECT_EQ(ifc[row], 0U);
+        }
+
+        // Bits behind the last row must be cleared
+        for (uint32_t row = rows_cnt; row < 13 * 8; ++row) {
+            EXPECT_FALSE(is_valid(0, row));
+        }
+    }
+
+    EXPECT_EQ(rc, FDS_EOC);
+    EXPECT_EQ(rec_idx, rec_cnt);
+}
+
+// Extraction of Data Records based on a template with fixed-length fields only
+TEST_F(Proj, columnsStatic)
+{
+    ipfix_trec trec {256};
+    trec.add_field(  7, 2);        // sourceTransportPort
+    trec.add_field(  4, 1);        // protocolIdentifier
+    trec.add_field(100, 4, 10000); // -- field with unknown definition --
+    trec.add_field(  1, 8);        // octetDeltaCount
+    unique_tmplt tmplt = tmplt_parse(trec);
+
+    const uint16_t rec_cnt = 70;
+    ipfix_set set {256};
+    for (uint16_t i = 0; i < rec_cnt; ++i) {
+        ipfix_drec rec {};
+        rec.append_uint(1000U + i, 2);
+        rec.append_uint(i % 256, 1);
+        rec.append_float(-i / 4.0, 4);
+        rec.append_uint(i * 1000000000ULL, 8);
+        set.add_rec(rec);
+    }
+    unique_mem set_data(reinterpret_cast<uint8_t *>(set.release()), &free);
+    auto set_hdr = reinterpret_cast<struct fds_ipfix_set_hdr *>(set_data.get());
+
+    const std::vector<struct fds_proj_elem> col_elems {{0, 1}, {10000, 100}, {0, 4}, {0, 7}};
+    unique_proj proj(fds_proj_create(col_elems.data(), col_elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+
+    std::vector<uint64_t> bytes(rec_cnt), port(rec_cnt);
+    std::vector<double> unknown(rec_cnt);
+    std::vector<int64_t> proto(rec_cnt);
+    std::vector<std::vector<uint8_t>> valid(col_elems.size(), std::vector<uint8_t>(9));
+    const std::vector<struct fds_proj_col> cols {
+        {FDS_PROJ_COL_UINT,  bytes.data(),   valid[0].data()},
+        {FDS_PROJ_COL_FLOAT, unknown.data(), valid[1].data()},
+        {FDS_PROJ_COL_INT,   proto.data(),   valid[2].data()},
+        {FDS_PROJ_COL_UINT,  port.data(),    valid[3].data()}
+    };
+
+    struct fds_dset_iter it;
+    fds_dset_iter_init(&it, set_hdr, tmplt.get());
+    uint32_t rows_cnt;
+    ASSERT_EQ(fds_proj_columns(proj.get(), &it, cols.data(), rec_cnt, &rows_cnt), FDS_OK);
+    ASSERT_EQ(rows_cnt, rec_cnt);
+    for (uint32_t row = 0; row < rows_cnt; ++row) {
+        SCOPED_TRACE("Record " + std::to_string(row));
+        for (size_t c = 0; c < cols.size(); ++c) {
+            EXPECT_NE(valid[c][row / 8] & (1U << (row % 8)), 0);
+        }
+        EXPECT_EQ(bytes[row], row * 1000000000ULL);
+        EXPECT_DOUBLE_EQ(unknown[row], -(row / 4.0));
+        EXPECT_EQ(proto[row], static_cast<int8_t>(row % 256));
+        EXPECT_EQ(port[row], 1000U + row);
+    }
+
+    EXPECT_EQ(fds_proj_columns(proj.get(), &it, cols.data(), rec_cnt, &rows_cnt), FDS_EOC);
+    EXPECT_EQ(rows_cnt, 0U);
+}
+
+// Extraction of Data Records based on a template with zero-length fields only
+TEST_F(Proj, columnsZeroLength)
+{
+    ipfix_trec trec {256};
+    trec.add_field(1, 0); // octetDeltaCount
+    unique_tmplt tmplt = tmplt_parse(trec);
+    ASSERT_EQ(tmplt->data_length, 0U);
+
+    ipfix_set set {256};
+    set.add_padding(4);
+    unique_mem set_data(reinterpret_cast<uint8_t *>(set.release()), &free);
+    auto set_hdr = reinterpret_cast<struct fds_ipfix_set_hdr *>(set_data.get());
+
+    const std::vector<struct fds_proj_elem> col_elems {{0, 1}};
+    unique_proj proj(fds_proj_create(col_elems.data(), col_elems.size()), &fds_proj_destroy);
+    ASSERT_NE(proj, nullptr);
+
+    std::vector<uint64_t> bytes(8);
+    std::vector<uint8_t> valid(1);
+    const std::vector<struct fds_proj_col> cols {{FDS_PROJ_COL_UINT, bytes.data(), valid.data()}};
+
+    struct fds_dset_iter it;
+    fds_dset_iter_init(&it, set_hdr, tmplt.get());
+    uint32_t rows_cnt = 1;
+    EXPECT_EQ(fds_proj_columns(proj.get(), &it, cols.data(), 8, &rows_cnt), FDS_EOC);
+    EXPECT_EQ(rows_cnt, 0U);
+    EXPECT_EQ(valid[0], 0U);
+}
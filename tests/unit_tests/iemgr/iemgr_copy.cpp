@@ -3,6 +3,9 @@
  * \date   8.8.17
  */
 
+#include <string>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <libfds.h>
 #include "iemgr_common.h"
@@ -89,3 +92,121 @@ TEST(Test, pen_copy)
     fds_iemgr_destroy(mgr_copy);
 }
 
+
+TEST_F(Mgr, frozen_share)
+{
+    ASSERT_EQ(fds_iemgr_read_file(mgr, FILES_VALID "pen.xml", true), FDS_OK);
+    ASSERT_EQ(fds_iemgr_freeze(mgr), FDS_OK);
+    ASSERT_EQ(fds_iemgr_freeze(mgr), FDS_OK);
+
+    // Elements are shared by all copies
+    fds_iemgr_t *copy1 = fds_iemgr_copy(mgr);
+    ASSERT_NE(copy1, nullptr);
+    fds_iemgr_t *copy2 = fds_iemgr_copy(copy1);
+    ASSERT_NE(copy2, nullptr);
+
+    const fds_iemgr_elem *elem = fds_iemgr_elem_find_id(mgr, 0, 1);
+    ASSERT_NE(elem, nullptr);
+    ASSERT_NE(elem->reverse_elem, nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy1, 0, 1), elem);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy2, 0, 1), elem);
+    const std::string name = std::string(elem->scope->name) + ":" + elem->name;
+    EXPECT_EQ(fds_iemgr_elem_find_name(copy2, name.c_str()), elem);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy2, 1, 1), elem->reverse_elem);
+    EXPECT_EQ(fds_iemgr_scope_find_pen(copy2, 0), elem->scope);
+    EXPECT_EQ(fds_iemgr_compare_timestamps(copy2), FDS_OK);
+
+    // The definitions stay valid until the last manager is destroyed
+    fds_iemgr_destroy(mgr);
+    fds_iemgr_destroy(copy1);
+    mgr = copy2;
+    EXPECT_EQ(elem->id, 1);
+    EXPECT_EQ(elem->name, name.substr(name.find(':') + 1));
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 0, 1), elem);
+    EXPECT_EQ(fds_iemgr_elem_find_name(mgr, name.c_str()), elem);
+    EXPECT_EQ(fds_iemgr_elem_find_name(mgr, elem->name), elem);
+}
+
+TEST_F(Fill, frozen_modify)
+{
+    ASSERT_EQ(fds_iemgr_freeze(mgr), FDS_OK);
+    fds_iemgr_t *copy = fds_iemgr_copy(mgr);
+    ASSERT_NE(copy, nullptr);
+    const fds_iemgr_elem *elem = fds_iemgr_elem_find_id(mgr, 0, 1);
+    ASSERT_NE(elem, nullptr);
+
+    // The modified manager gets its own elements, other managers are not affected
+    EXPECT_EQ(fds_iemgr_elem_remove(copy, 0, 2), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy, 0, 2), nullptr);
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr, 0, 2), nullptr);
+
+    const fds_iemgr_elem *elem_copy = fds_iemgr_elem_find_id(copy, 0, 1);
+    ASSERT_NE(elem_copy, nullptr);
+    EXPECT_NE(elem_copy, elem);
+    EXPECT_STREQ(elem_copy->name, elem->name);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 0, 1), elem);
+
+    // Re-freeze the modified manager
+    ASSERT_EQ(fds_iemgr_freeze(copy), FDS_OK);
+    fds_iemgr_t *copy2 = fds_iemgr_copy(copy);
+    ASSERT_NE(copy2, nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy2, 0, 1), elem_copy);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy2, 0, 2), nullptr);
+    fds_iemgr_destroy(copy);
+    fds_iemgr_destroy(copy2);
+
+    // Reading a new file replaces shared elements
+    fds_iemgr_t *copy3 = fds_iemgr_copy(mgr);
+    ASSERT_NE(copy3, nullptr);
+    EXPECT_EQ(fds_iemgr_read_file(mgr, FILES_VALID "pen.xml", true), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy3, 0, 1), elem);
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr, 0, 1), elem);
+    fds_iemgr_destroy(copy3);
+}
+
+// Each thread uses its own copy of a frozen manager
+TEST_F(Fill, frozen_threads)
+{
+    ASSERT_EQ(fds_iemgr_freeze(mgr), FDS_OK);
+    const fds_iemgr_elem *elem = fds_iemgr_elem_find_id(mgr, 0, 1);
+    ASSERT_NE(elem, nullptr);
+
+    std::vector<fds_iemgr_t *> copies;
+    for (int i = 0; i < 4; ++i) {
+        fds_iemgr_t *copy = fds_iemgr_copy(mgr);
+        ASSERT_NE(copy, nullptr);
+        copies.push_back(copy);
+    }
+
+    const std::string name = std::string(elem->scope->name) + ":" + elem->name;
+    auto thread_fn = [elem, &name](fds_iemgr_t *copy, bool modify) {
+        for (int i = 0; i < 200; ++i) {
+            const fds_iemgr_elem *res = fds_iemgr_elem_find_id(copy, 0, 1);
+            ASSERT_NE(res, nullptr);
+            EXPECT_EQ(res->id, 1);
+            EXPECT_STREQ(res->name, elem->name);
+
+            fds_iemgr_t *tmp = fds_iemgr_copy(copy);
+            ASSERT_NE(tmp, nullptr);
+            EXPECT_EQ(fds_iemgr_elem_find_name(tmp, name.c_str()), res);
+            if (modify) {
+                EXPECT_EQ(fds_iemgr_elem_remove(tmp, 0, 1), FDS_OK);
+                EXPECT_EQ(fds_iemgr_elem_find_id(tmp, 0, 1), nullptr);
+            }
+            fds_iemgr_destroy(tmp);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < copies.size(); ++i) {
+        threads.emplace_back(thread_fn, copies[i], i % 2 == 0);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (auto copy : copies) {
+        EXPECT_EQ(fds_iemgr_elem_find_id(copy, 0, 1), elem);
+        fds_iemgr_destroy(copy);
+    }
+}
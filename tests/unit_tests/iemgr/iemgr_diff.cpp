@@ -0,0 +1,180 @@
+/**
+ * \brief Test cases for sharing of unchanged scopes and diffs of managers
+ */
+
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include "iemgr_common.h"
+
+/** PEN of the vendor scope */
+static const uint32_t VENDOR_PEN = 1000;
+
+/**
+ * \brief Create a manager with IANA elements and a vendor scope
+ * \param[in] type Data type of the vendor elements
+ * \param[in] cnt  Number of the vendor elements
+ */
+static fds_iemgr_t *
+mgr_build(enum fds_iemgr_element_type type, uint16_t cnt = 3)
+{
+    fds_iemgr_t *mgr = fds_iemgr_create();
+    EXPECT_NE(mgr, nullptr);
+    EXPECT_EQ(fds_iemgr_read_file(mgr, FILES_VALID "pen.xml", true), FDS_OK);
+
+    for (uint16_t i = 0; i < cnt; ++i) {
+        const std::string name = "vendorElem" + std::to_string(i);
+        fds_iemgr_elem elem{};
+        elem.id = 100 + i;
+        elem.name = const_cast<char *>(name.c_str());
+        elem.data_type = type;
+        EXPECT_EQ(fds_iemgr_elem_add(mgr, &elem, VENDOR_PEN, false), FDS_OK);
+    }
+
+    return mgr;
+}
+
+TEST(Diff, empty)
+{
+    fds_iemgr_diff_t *diff = fds_iemgr_diff_create(nullptr, nullptr);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 0U);
+    EXPECT_FALSE(fds_iemgr_diff_find(diff, 0, 1));
+    EXPECT_FALSE(fds_iemgr_diff_find_pen(diff, 0));
+    fds_iemgr_diff_destroy(diff);
+
+    // All elements are added
+    fds_iemgr_t *mgr = mgr_build(FDS_ET_UNSIGNED_32);
+    diff = fds_iemgr_diff_create(nullptr, mgr);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_GT(fds_iemgr_diff_cnt(diff), 3U);
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, 0, 1));
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, 1, 1));
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, VENDOR_PEN, 102));
+    EXPECT_FALSE(fds_iemgr_diff_find(diff, VENDOR_PEN, 103));
+    EXPECT_TRUE(fds_iemgr_diff_find_pen(diff, VENDOR_PEN));
+    EXPECT_FALSE(fds_iemgr_diff_find_pen(diff, 2));
+    const size_t cnt = fds_iemgr_diff_cnt(diff);
+    fds_iemgr_diff_destroy(diff);
+
+    // All elements are removed
+    diff = fds_iemgr_diff_create(mgr, nullptr);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), cnt);
+    fds_iemgr_diff_destroy(diff);
+
+    // The same manager
+    diff = fds_iemgr_diff_create(mgr, mgr);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 0U);
+    fds_iemgr_diff_destroy(diff);
+    fds_iemgr_destroy(mgr);
+}
+
+// Definitions are compared by identity
+TEST(Diff, independent)
+{
+    fds_iemgr_t *mgr1 = mgr_build(FDS_ET_UNSIGNED_32);
+    fds_iemgr_t *mgr2 = mgr_build(FDS_ET_UNSIGNED_32, 4);
+
+    fds_iemgr_diff_t *diff = fds_iemgr_diff_create(mgr1, nullptr);
+    ASSERT_NE(diff, nullptr);
+    const size_t cnt = fds_iemgr_diff_cnt(diff);
+    fds_iemgr_diff_destroy(diff);
+
+    diff = fds_iemgr_diff_create(mgr1, mgr2);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), cnt + 1);
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, 0, 1));
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, VENDOR_PEN, 103));
+    fds_iemgr_diff_destroy(diff);
+
+    // Copies of an immutable manager share all definitions
+    ASSERT_EQ(fds_iemgr_freeze(mgr1), FDS_OK);
+    fds_iemgr_t *copy = fds_iemgr_copy(mgr1);
+    ASSERT_NE(copy, nullptr);
+    diff = fds_iemgr_diff_create(mgr1, copy);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 0U);
+    fds_iemgr_diff_destroy(diff);
+
+    fds_iemgr_destroy(copy);
+    fds_iemgr_destroy(mgr1);
+    fds_iemgr_destroy(mgr2);
+}
+
+TEST(Rebase, vendor_changed)
+{
+    fds_iemgr_t *mgr1 = mgr_build(FDS_ET_UNSIGNED_32);
+    fds_iemgr_t *mgr2 = mgr_build(FDS_ET_UNSIGNED_64);
+
+    // The base manager must be immutable
+    EXPECT_EQ(fds_iemgr_rebase(mgr2, mgr1), FDS_ERR_ARG);
+    EXPECT_STRNE(fds_iemgr_last_err(mgr2), ERR_MSG);
+    ASSERT_EQ(fds_iemgr_freeze(mgr1), FDS_OK);
+    ASSERT_EQ(fds_iemgr_rebase(mgr2, mgr1), FDS_OK);
+
+    // Scopes with the same definitions are shared (including the reverse scope)
+    const fds_iemgr_elem *elem = fds_iemgr_elem_find_id(mgr1, 0, 1);
+    ASSERT_NE(elem, nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr2, 0, 1), elem);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr2, 1, 1), elem->reverse_elem);
+    EXPECT_EQ(fds_iemgr_scope_find_pen(mgr2, 0), elem->scope);
+    const std::string name = std::string(elem->scope->name) + ":" + elem->name;
+    EXPECT_EQ(fds_iemgr_elem_find_name(mgr2, name.c_str()), elem);
+
+    const fds_iemgr_elem *vendor = fds_iemgr_elem_find_id(mgr2, VENDOR_PEN, 100);
+    ASSERT_NE(vendor, nullptr);
+    EXPECT_NE(vendor, fds_iemgr_elem_find_id(mgr1, VENDOR_PEN, 100));
+    EXPECT_EQ(vendor->data_type, FDS_ET_UNSIGNED_64);
+
+    // Only the vendor scope differs
+    fds_iemgr_diff_t *diff = fds_iemgr_diff_create(mgr1, mgr2);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 3U);
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, VENDOR_PEN, 100));
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, VENDOR_PEN, 102));
+    EXPECT_FALSE(fds_iemgr_diff_find(diff, 0, 1));
+    EXPECT_FALSE(fds_iemgr_diff_find_pen(diff, 0));
+    EXPECT_TRUE(fds_iemgr_diff_find_pen(diff, VENDOR_PEN));
+    fds_iemgr_diff_destroy(diff);
+
+    // Shared definitions are valid after destruction of the base manager
+    fds_iemgr_destroy(mgr1);
+    EXPECT_EQ(elem->id, 1);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr2, 0, 1), elem);
+
+    // Another version based on the rebased manager (the same definitions)
+    fds_iemgr_t *mgr3 = mgr_build(FDS_ET_UNSIGNED_64);
+    ASSERT_EQ(fds_iemgr_rebase(mgr3, mgr2), FDS_OK);
+    diff = fds_iemgr_diff_create(mgr2, mgr3);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 0U);
+    fds_iemgr_diff_destroy(diff);
+    fds_iemgr_destroy(mgr2);
+
+    // Modification of the rebased manager (shared definitions are released)
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr3, 0, 1), elem);
+    const std::string elem_name = elem->name;
+    EXPECT_EQ(fds_iemgr_elem_remove(mgr3, VENDOR_PEN, 101), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr3, VENDOR_PEN, 101), nullptr);
+    const fds_iemgr_elem *elem_copy = fds_iemgr_elem_find_id(mgr3, 0, 1);
+    ASSERT_NE(elem_copy, nullptr);
+    EXPECT_EQ(elem_copy->name, elem_name);
+    fds_iemgr_destroy(mgr3);
+}
+
+TEST(Rebase, nothing_shared)
+{
+    fds_iemgr_t *mgr1 = mgr_build(FDS_ET_UNSIGNED_32);
+    fds_iemgr_t *mgr2 = fds_iemgr_create();
+    ASSERT_NE(mgr2, nullptr);
+    ASSERT_EQ(fds_iemgr_read_file(mgr2, FILES_VALID "split.xml", true), FDS_OK);
+    ASSERT_EQ(fds_iemgr_freeze(mgr1), FDS_OK);
+    ASSERT_EQ(fds_iemgr_rebase(mgr2, mgr1), FDS_OK);
+
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr2, 0, 1), fds_iemgr_elem_find_id(mgr1, 0, 1));
+    EXPECT_EQ(fds_iemgr_scope_find_pen(mgr2, VENDOR_PEN), nullptr);
+    fds_iemgr_destroy(mgr1);
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr2, 0, 1), nullptr);
+    fds_iemgr_destroy(mgr2);
+}
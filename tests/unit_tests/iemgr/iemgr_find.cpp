@@ -102,3 +102,121 @@ TEST_F(Fill, scope_pen_out_of_range)
     EXPECT_EQ(elem, nullptr);
     EXPECT_NO_ERROR;
 }
+
+TEST_F(Fill, elem_id_enterprise)
+{
+    // Enough elements to resize the lookup table of enterprise-specific elements
+    // (IDs must be unique among all scopes while adding elements)
+    auto id_get = [](uint32_t pen, uint16_t id) { return uint16_t((pen - 1000) * 300 + id * 3); };
+    fds_iemgr_elem elem{};
+    elem.data_type = FDS_ET_UNSIGNED_64;
+    for (uint32_t pen = 1000; pen < 1010; ++pen) {
+        for (uint16_t id = 1; id <= 100; ++id) {
+            const std::string name = "e" + std::to_string(pen) + "id" + std::to_string(id);
+            elem.id = id_get(pen, id);
+            elem.name = const_cast<char*>(name.c_str());
+            ASSERT_EQ(fds_iemgr_elem_add(mgr, &elem, pen, false), FDS_OK);
+        }
+    }
+
+    for (uint32_t pen = 1000; pen < 1010; ++pen) {
+        for (uint16_t id = 1; id <= 100; ++id) {
+            auto res = fds_iemgr_elem_find_id(mgr, pen, id_get(pen, id));
+            ASSERT_NE(res, nullptr);
+            EXPECT_EQ(res->id, id_get(pen, id));
+            EXPECT_EQ(res->scope->pen, pen);
+            EXPECT_EQ(fds_iemgr_elem_find_id(mgr, pen, id_get(pen, id) + 1), nullptr);
+            EXPECT_EQ(fds_iemgr_elem_find_id(mgr, pen + 1, id_get(pen, id)), nullptr);
+        }
+    }
+
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 1010, 3003), nullptr);
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr, 0, 1), nullptr);
+
+    // Removed elements cannot be found anymore, others remain
+    EXPECT_EQ(fds_iemgr_elem_remove(mgr, 1005, id_get(1005, 10)), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 1005, id_get(1005, 10)), nullptr);
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr, 1005, id_get(1005, 11)), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_remove(mgr, 0, 1), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 0, 1), nullptr);
+
+    fds_iemgr_clear(mgr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 0, 2), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 1009, id_get(1009, 100)), nullptr);
+}
+
+TEST_F(Fill, elem_id_reverse)
+{
+    auto elem = fds_iemgr_elem_find_id(mgr, 0, 1);
+    ASSERT_NE(elem, nullptr);
+    ASSERT_NE(elem->reverse_elem, nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, elem->reverse_elem->scope->pen,
+        elem->reverse_elem->id), elem->reverse_elem);
+
+    // Copy of the manager has its own lookup tables
+    fds_iemgr_t *copy = fds_iemgr_copy(mgr);
+    ASSERT_NE(copy, nullptr);
+    auto elem_copy = fds_iemgr_elem_find_id(copy, 0, 1);
+    ASSERT_NE(elem_copy, nullptr);
+    EXPECT_NE(elem_copy, elem);
+    EXPECT_STREQ(elem_copy->name, elem->name);
+    ASSERT_NE(elem_copy->reverse_elem, nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(copy, elem->reverse_elem->scope->pen,
+        elem->reverse_elem->id), elem_copy->reverse_elem);
+    fds_iemgr_destroy(copy);
+}
+
+TEST_F(Fill, elem_name_len)
+{
+    const char *str = "iana:abc";
+    auto elem = fds_iemgr_elem_find_name_len(mgr, str, 6);
+    ASSERT_NE(elem, nullptr);
+    EXPECT_EQ(elem, fds_iemgr_elem_find_name(mgr, "iana:a"));
+    EXPECT_EQ(elem->id, 1);
+
+    // Name without scope in the middle of a string
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, str + 5, 1), elem);
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, str, 5), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, str, 4), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, str, 0), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, "iana:a:", 7), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, "ian:a", 5), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, ":a", 2), nullptr);
+
+    // Reverse elements
+    ASSERT_NE(elem->reverse_elem, nullptr);
+    const std::string rev_name = std::string(elem->reverse_elem->scope->name) + ":"
+        + elem->reverse_elem->name;
+    EXPECT_EQ(fds_iemgr_elem_find_name(mgr, rev_name.c_str()), elem->reverse_elem);
+}
+
+TEST_F(Fill, elem_name_batch)
+{
+    const char *names[] = {"a", "iana:c", "not_existing_name", "iana:a:", "d", "iana:e", "f",
+        "g", "h", "i", "iana:f", "iana:g", "iana:h", "iana:i", "not_existing_scope_name:a", "c",
+        "e", "a"};
+    const size_t cnt = sizeof(names) / sizeof(names[0]);
+    const struct fds_iemgr_elem *elems[cnt];
+
+    size_t found = 0;
+    for (size_t i = 0; i < cnt; ++i) {
+        found += (fds_iemgr_elem_find_name(mgr, names[i]) != nullptr);
+    }
+    EXPECT_EQ(fds_iemgr_elem_find_names(mgr, names, cnt, elems), found);
+    EXPECT_EQ(found, cnt - 3);
+    for (size_t i = 0; i < cnt; ++i) {
+        SCOPED_TRACE("Name: " + std::string(names[i]));
+        EXPECT_EQ(elems[i], fds_iemgr_elem_find_name(mgr, names[i]));
+    }
+
+    // The same results after failed modification of the manager (without lookup tables)
+    std::vector<const struct fds_iemgr_elem *> prev(elems, elems + cnt);
+    EXPECT_NE(fds_iemgr_read_file(mgr, FILES_INVALID "same_biflow_id.xml", false), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_names(mgr, names, cnt, elems), found);
+    for (size_t i = 0; i < cnt; ++i) {
+        SCOPED_TRACE("Name: " + std::string(names[i]));
+        EXPECT_EQ(elems[i], prev[i]);
+        EXPECT_EQ(fds_iemgr_elem_find_name(mgr, names[i]), prev[i]);
+    }
+    EXPECT_EQ(fds_iemgr_elem_find_name_len(mgr, "iana:ab", 6), prev[0]);
+}
@@ -0,0 +1,248 @@
+/**
+ * \brief Test cases for binary images of the manager
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include "iemgr_common.h"
+
+/** Temporary copy of a directory with definition files */
+class Image: public ::testing::Test
+{
+protected:
+    fds_iemgr_t* mgr = nullptr;
+    std::string dir;
+    std::string image;
+
+    void SetUp() override {
+        mgr = fds_iemgr_create();
+        char tmpl[] = "/tmp/iemgr_image_XXXXXX";
+        if (!mgr || !mkdtemp(tmpl)) {
+            throw std::runtime_error("Failed to prepare a manager or a directory!");
+        }
+
+        dir = tmpl;
+        image = dir + "/image.bin";
+        for (const char *sub: {"/system", "/system/elements", "/user", "/user/elements"}) {
+            mkdir((dir + sub).c_str(), 0700);
+        }
+        for (const char *file: {"individual.xml", "pen.xml", "split.xml"}) {
+            file_copy(FILES_VALID "valid/system/elements/" + std::string(file),
+                dir + "/system/elements/" + file);
+        }
+    }
+
+    void TearDown() override {
+        fds_iemgr_destroy(mgr);
+        for (const char *sub: {"/system/elements", "/user/elements"}) {
+            for (const char *file: {"individual.xml", "pen.xml", "split.xml", "new.xml"}) {
+                unlink((dir + sub + "/" + file).c_str());
+            }
+        }
+        for (const char *sub: {"/system/elements", "/system", "/user/elements", "/user"}) {
+            rmdir((dir + sub).c_str());
+        }
+        unlink(image.c_str());
+        rmdir(dir.c_str());
+    }
+
+    static void file_copy(const std::string& src, const std::string& dst) {
+        std::ifstream in(src, std::ios::binary);
+        std::ofstream out(dst, std::ios::binary);
+        out << in.rdbuf();
+    }
+
+    /** \brief Write to a file without changing its modification time */
+    static void file_overwrite(const std::string& path, const std::string& content) {
+        struct stat sb{};
+        ASSERT_EQ(stat(path.c_str(), &sb), 0);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+        const struct timespec times[2] = {sb.st_atim, sb.st_mtim};
+        ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+    }
+
+    /** \brief Change the modification time of a file */
+    static void file_touch(const std::string& path) {
+        const struct timespec times[2] = {{1, 0}, {1, 0}};
+        ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+    }
+
+    /** \brief Check that both managers define the same elements */
+    static void expect_same(const fds_iemgr_t *lhs, const fds_iemgr_t *rhs) {
+        size_t cnt = 0;
+        for (uint32_t pen = 0; pen < 4; ++pen) {
+            for (uint16_t id = 0; id < 128; ++id) {
+                SCOPED_TRACE("PEN: " + std::to_string(pen) + ", ID: " + std::to_string(id));
+                const fds_iemgr_elem *l = fds_iemgr_elem_find_id(lhs, pen, id);
+                const fds_iemgr_elem *r = fds_iemgr_elem_find_id(rhs, pen, id);
+                ASSERT_EQ(l == nullptr, r == nullptr);
+                if (l == nullptr) {
+                    continue;
+                }
+
+                cnt++;
+                EXPECT_STREQ(l->name, r->name);
+                EXPECT_EQ(l->data_type, r->data_type);
+                EXPECT_EQ(l->data_semantic, r->data_semantic);
+                EXPECT_EQ(l->data_unit, r->data_unit);
+                EXPECT_EQ(l->status, r->status);
+                EXPECT_EQ(l->is_reverse, r->is_reverse);
+                EXPECT_EQ(l->scope->pen, r->scope->pen);
+                EXPECT_STREQ(l->scope->name, r->scope->name);
+                EXPECT_EQ(l->scope->biflow_mode, r->scope->biflow_mode);
+                EXPECT_EQ(l->scope->biflow_id, r->scope->biflow_id);
+                ASSERT_EQ(l->reverse_elem == nullptr, r->reverse_elem == nullptr);
+                if (l->reverse_elem != nullptr) {
+                    EXPECT_EQ(l->reverse_elem->id, r->reverse_elem->id);
+                    EXPECT_EQ(l->reverse_elem->scope->pen, r->reverse_elem->scope->pen);
+                    EXPECT_EQ(r->reverse_elem->reverse_elem, r);
+                }
+
+                const std::string name = std::string(r->scope->name) + ":" + r->name;
+                EXPECT_EQ(fds_iemgr_elem_find_name(rhs, name.c_str()), r);
+            }
+        }
+
+        EXPECT_GT(cnt, 0U);
+    }
+};
+
+TEST_F(Image, round_trip)
+{
+    ASSERT_EQ(fds_iemgr_read_dir(mgr, dir.c_str()), FDS_OK);
+    ASSERT_EQ(fds_iemgr_save_bin(mgr, image.c_str()), FDS_OK);
+
+    fds_iemgr_t *res = fds_iemgr_create();
+    ASSERT_NE(res, nullptr);
+    ASSERT_EQ(fds_iemgr_read_bin(res, image.c_str()), FDS_OK);
+    EXPECT_STREQ(fds_iemgr_last_err(res), ERR_MSG);
+    expect_same(mgr, res);
+    EXPECT_EQ(fds_iemgr_compare_timestamps(res), FDS_OK);
+
+    const fds_iemgr_scope *scope = fds_iemgr_scope_find_pen(res, 0);
+    ASSERT_NE(scope, nullptr);
+    EXPECT_EQ(fds_iemgr_scope_find_name(res, scope->name), scope);
+
+    // Copy of the loaded manager
+    fds_iemgr_t *copy = fds_iemgr_copy(res);
+    ASSERT_NE(copy, nullptr);
+    expect_same(res, copy);
+    fds_iemgr_destroy(copy);
+
+    // Image of an image
+    const std::string image2 = image + "2";
+    ASSERT_EQ(fds_iemgr_save_bin(res, image2.c_str()), FDS_OK);
+    fds_iemgr_clear(res);
+    EXPECT_EQ(fds_iemgr_elem_find_id(res, 0, 1), nullptr);
+    ASSERT_EQ(fds_iemgr_read_bin(res, image2.c_str()), FDS_OK);
+    expect_same(mgr, res);
+    unlink(image2.c_str());
+    fds_iemgr_destroy(res);
+}
+
+TEST_F(Image, modify)
+{
+    ASSERT_EQ(fds_iemgr_read_dir(mgr, dir.c_str()), FDS_OK);
+    ASSERT_EQ(fds_iemgr_save_bin(mgr, image.c_str()), FDS_OK);
+    ASSERT_EQ(fds_iemgr_read_bin(mgr, image.c_str()), FDS_OK);
+
+    // The first modification converts the manager to a regular one
+    fds_iemgr_elem elem{};
+    elem.id = 100;
+    elem.name = const_cast<char*>("new_elem");
+    elem.data_type = FDS_ET_UNSIGNED_64;
+    ASSERT_EQ(fds_iemgr_elem_add(mgr, &elem, 0, false), FDS_OK);
+    EXPECT_NE(fds_iemgr_elem_find_id(mgr, 0, 100), nullptr);
+    EXPECT_NE(fds_iemgr_elem_find_name(mgr, "new_elem"), nullptr);
+
+    ASSERT_EQ(fds_iemgr_elem_remove(mgr, 0, 100), FDS_OK);
+    EXPECT_EQ(fds_iemgr_elem_find_id(mgr, 0, 100), nullptr);
+
+    fds_iemgr_t *orig = fds_iemgr_create();
+    ASSERT_NE(orig, nullptr);
+    ASSERT_EQ(fds_iemgr_read_dir(orig, dir.c_str()), FDS_OK);
+    expect_same(orig, mgr);
+    fds_iemgr_destroy(orig);
+}
+
+TEST_F(Image, outdated)
+{
+    ASSERT_EQ(fds_iemgr_read_dir(mgr, dir.c_str()), FDS_OK);
+    ASSERT_EQ(fds_iemgr_save_bin(mgr, image.c_str()), FDS_OK);
+    file_touch(dir + "/system/elements/pen.xml");
+
+    fds_iemgr_elem elem{};
+    elem.id = 200;
+    elem.name = const_cast<char*>("other_elem");
+    elem.data_type = FDS_ET_UNSIGNED_64;
+    fds_iemgr_t *res = fds_iemgr_create();
+    ASSERT_NE(res, nullptr);
+    ASSERT_EQ(fds_iemgr_elem_add(res, &elem, 0, false), FDS_OK);
+
+    // The manager is not modified
+    EXPECT_EQ(fds_iemgr_read_bin(res, image.c_str()), FDS_ERR_DIFF);
+    EXPECT_STRNE(fds_iemgr_last_err(res), ERR_MSG);
+    EXPECT_NE(fds_iemgr_elem_find_id(res, 0, 200), nullptr);
+    EXPECT_EQ(fds_iemgr_elem_find_id(res, 0, 1), nullptr);
+    fds_iemgr_destroy(res);
+}
+
+TEST_F(Image, malformed)
+{
+    EXPECT_EQ(fds_iemgr_read_bin(mgr, image.c_str()), FDS_ERR_FORMAT);
+    EXPECT_ERROR;
+
+    std::ofstream(image, std::ios::binary) << "This is not an image of the manager";
+    EXPECT_EQ(fds_iemgr_read_bin(mgr, image.c_str()), FDS_ERR_FORMAT);
+
+    // Truncated image
+    ASSERT_EQ(fds_iemgr_read_dir(mgr, dir.c_str()), FDS_OK);
+    ASSERT_EQ(fds_iemgr_save_bin(mgr, image.c_str()), FDS_OK);
+    struct stat sb{};
+    ASSERT_EQ(stat(image.c_str(), &sb), 0);
+    for (off_t size: {sb.st_size - 1, off_t(sb.st_size / 2), off_t(40), off_t(0)}) {
+        ASSERT_EQ(truncate(image.c_str(), size), 0);
+        EXPECT_EQ(fds_iemgr_read_bin(mgr, image.c_str()), FDS_ERR_FORMAT);
+        EXPECT_NE(fds_iemgr_elem_find_id(mgr, 0, 1), nullptr);
+    }
+
+    EXPECT_EQ(fds_iemgr_save_bin(mgr, "/nonexistent_dir/image.bin"), FDS_ERR_DENIED);
+}
+
+TEST_F(Image, cached)
+{
+    // The image is created
+    ASSERT_EQ(fds_iemgr_read_dir_cached(mgr, dir.c_str(), image.c_str()), FDS_OK);
+    EXPECT_NO_ERROR;
+    ASSERT_EQ(access(image.c_str(), R_OK), 0);
+
+    // The image is used even if the content of files has changed (timestamps are the same)
+    const std::string path = dir + "/system/elements/split.xml";
+    file_overwrite(path, "<invalid>");
+    fds_iemgr_t *res = fds_iemgr_create();
+    ASSERT_NE(res, nullptr);
+    ASSERT_EQ(fds_iemgr_read_dir_cached(res, dir.c_str(), image.c_str()), FDS_OK);
+    EXPECT_STREQ(fds_iemgr_last_err(res), ERR_MSG);
+    expect_same(mgr, res);
+
+    // A new file in the directory -> XML files are parsed
+    file_copy(path, dir + "/user/elements/new.xml");
+    EXPECT_EQ(fds_iemgr_read_dir_cached(res, dir.c_str(), image.c_str()), FDS_ERR_FORMAT);
+
+    // Repaired files -> a new image is created
+    unlink((dir + "/user/elements/new.xml").c_str());
+    file_copy(FILES_VALID "valid/system/elements/split.xml", path);
+    file_touch(image);
+    ASSERT_EQ(fds_iemgr_read_dir_cached(res, dir.c_str(), image.c_str()), FDS_OK);
+    struct stat sb{};
+    ASSERT_EQ(stat(image.c_str(), &sb), 0);
+    EXPECT_GT(sb.st_mtim.tv_sec, 1);
+    expect_same(mgr, res);
+    fds_iemgr_destroy(res);
+}
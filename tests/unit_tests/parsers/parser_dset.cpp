@@ -1,6 +1,7 @@
 #include <string>
 #include <memory>
 #include <cstdlib>
+#include <vector>
 #include <gtest/gtest.h>
 #include <libfds.h>
 #include <MsgGen.h>
@@ -677,3 +678,186 @@ TEST(dsetIterMalformed, tooLongVar)
         fds_template_destroy(tmplt);
     }
 }
+
+// Batch decoder ---------------------------------------------------------------------------------
+
+// Compare results of the batch decoder with results of the iterator
+static void
+dset_batch_cmp(struct fds_ipfix_set_hdr *set, const struct fds_template *tmplt,
+    uint32_t batch_size)
+{
+    SCOPED_TRACE("Batch size " + std::to_string(batch_size));
+    // Reference (record-by-record) iteration
+    std::vector<struct fds_dset_rec> recs_ref;
+    fds_dset_iter iter;
+    fds_dset_iter_init(&iter, set, tmplt);
+    int rc_ref;
+    while ((rc_ref = fds_dset_iter_next(&iter)) == FDS_OK) {
+        recs_ref.push_back({iter.rec, iter.size});
+    }
+
+    // Batch iteration
+    std::vector<struct fds_dset_rec> recs;
+    std::vector<struct fds_dset_rec> batch(batch_size);
+    uint32_t batch_cnt;
+    fds_dset_iter_init(&iter, set, tmplt);
+    int rc;
+    while ((rc = fds_dset_iter_batch(&iter, batch.data(), batch_size, &batch_cnt)) == FDS_OK) {
+        ASSERT_GT(batch_cnt, 0U);
+        ASSERT_LE(batch_cnt, batch_size);
+        recs.insert(recs.end(), batch.begin(), batch.begin() + batch_cnt);
+        EXPECT_EQ(iter.rec, batch[batch_cnt - 1].rec);
+        EXPECT_EQ(iter.size, batch[batch_cnt - 1].size);
+    }
+    if (rc == FDS_ERR_FORMAT) {
+        // Records before the malformed one
+        recs.insert(recs.end(), batch.begin(), batch.begin() + batch_cnt);
+        EXPECT_NE(fds_dset_iter_err(&iter), NO_ERR_STRING);
+    } else {
+        EXPECT_EQ(batch_cnt, 0U);
+        EXPECT_EQ(fds_dset_iter_err(&iter), NO_ERR_STRING);
+    }
+
+    EXPECT_EQ(rc, rc_ref);
+    ASSERT_EQ(recs.size(), recs_ref.size());
+    for (size_t i = 0; i < recs.size(); ++i) {
+        EXPECT_EQ(recs[i].rec, recs_ref[i].rec);
+        EXPECT_EQ(recs[i].size, recs_ref[i].size);
+    }
+}
+
+// Data Sets with static and dynamic records (with and without padding)
+TEST(dsetBatch, validSets)
+{
+    // Templates with static and variable-length fields
+    for (bool is_dynamic : {false, true}) {
+        SCOPED_TRACE("Dynamic template " + std::to_string(is_dynamic));
+        ipfix_trec tmplt_raw {256};
+        tmplt_raw.add_field(10, 4);
+        tmplt_raw.add_field(20, is_dynamic ? ipfix_trec::SIZE_VAR : 8);
+        tmplt_raw.add_field(30, 3);
+        if (is_dynamic) {
+            tmplt_raw.add_field(40, ipfix_trec::SIZE_VAR);
+        }
+
+        uint16_t tmplt_size = tmplt_raw.size();
+        uint8_uniq tmplt_data(tmplt_raw.release(), &free);
+        struct fds_template *tmplt;
+        ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, tmplt_data.get(), &tmplt_size, &tmplt),
+            FDS_OK);
+        ASSERT_EQ((tmplt->flags & FDS_TEMPLATE_DYNAMIC) != 0, is_dynamic);
+
+        for (uint16_t rec_cnt : {1, 2, 7, 50}) {
+            for (uint16_t padding : {0, 1, 3}) {
+                SCOPED_TRACE("Records " + std::to_string(rec_cnt) + ", padding "
+                    + std::to_string(padding));
+                ipfix_set set {256};
+                for (uint16_t i = 0; i < rec_cnt; ++i) {
+                    ipfix_drec rec {};
+                    rec.append_uint(i, 4);
+                    if (is_dynamic) {
+                        // Short and long variable-length headers (including empty fields)
+                        const std::string str1(i * 7U, 'a');
+                        const std::string str2(i, 'b');
+                        rec.var_header(str1.length());
+                        if (!str1.empty()) {
+                            rec.append_string(str1, str1.length());
+                        }
+                        rec.append_uint(i, 3);
+                        rec.var_header(str2.length(), true);
+                        if (!str2.empty()) {
+                            rec.append_string(str2, str2.length());
+                        }
+                    } else {
+                        rec.append_uint(i, 8);
+                        rec.append_uint(i, 3);
+                    }
+                    set.add_rec(rec);
+                }
+                set.add_padding(padding);
+                set_uniq hdr_set(set.release(), &free);
+
+                for (uint32_t batch_size : {1U, 3U, 64U}) {
+                    dset_batch_cmp(hdr_set.get(), tmplt, batch_size);
+                }
+            }
+        }
+
+        fds_template_destroy(tmplt);
+    }
+}
+
+// Malformed Data Sets
+TEST(dsetBatch, malformedSets)
+{
+    ipfix_trec tmplt_raw {256};
+    tmplt_raw.add_field(10, 4);
+    tmplt_raw.add_field(20, ipfix_trec::SIZE_VAR);
+    tmplt_raw.add_field(30, 8);
+
+    uint16_t tmplt_size = tmplt_raw.size();
+    uint8_uniq tmplt_data(tmplt_raw.release(), &free);
+    struct fds_template *tmplt;
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, tmplt_data.get(), &tmplt_size, &tmplt),
+        FDS_OK);
+
+    // Empty Data Set
+    {
+        ipfix_set set {256};
+        set_uniq hdr_set(set.release(), &free);
+        dset_batch_cmp(hdr_set.get(), tmplt, 8);
+    }
+
+    // The last record is longer than its enclosing Data Set
+    {
+        ipfix_set set {256};
+        for (uint16_t i = 0; i < 5; ++i) {
+            ipfix_drec rec {};
+            rec.append_uint(i, 4);
+            rec.append_string("Some random string");
+            rec.append_uint(i, 8);
+            set.add_rec(rec);
+        }
+        set.overwrite_len(set.size() - 10);
+        set_uniq hdr_set(set.release(), &free);
+
+        for (uint32_t batch_size : {1U, 2U, 8U}) {
+            dset_batch_cmp(hdr_set.get(), tmplt, batch_size);
+        }
+    }
+
+    fds_template_destroy(tmplt);
+}
+
+// Template with zero-length fields only (no record can be decoded, the content is padding)
+TEST(dsetBatch, zeroLengthFields)
+{
+    ipfix_trec tmplt_raw {256};
+    tmplt_raw.add_field(1, 0);
+
+    uint16_t tmplt_size = tmplt_raw.size();
+    uint8_uniq tmplt_data(tmplt_raw.release(), &free);
+    struct fds_template *tmplt;
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, tmplt_data.get(), &tmplt_size, &tmplt),
+        FDS_OK);
+    ASSERT_EQ(tmplt->data_length, 0U);
+
+    ipfix_set set {256};
+    set.add_padding(4);
+    set_uniq hdr_set(set.release(), &free);
+    ASSERT_EQ(ntohs(hdr_set->length), 8U);
+
+    fds_dset_iter iter;
+    fds_dset_iter_init(&iter, hdr_set.get(), tmplt);
+    EXPECT_EQ(fds_dset_iter_next(&iter), FDS_EOC);
+    EXPECT_EQ(fds_dset_iter_err(&iter), NO_ERR_STRING);
+
+    struct fds_dset_rec recs[8];
+    uint32_t recs_cnt = 1;
+    fds_dset_iter_init(&iter, hdr_set.get(), tmplt);
+    EXPECT_EQ(fds_dset_iter_batch(&iter, recs, 8, &recs_cnt), FDS_EOC);
+    EXPECT_EQ(recs_cnt, 0U);
+    EXPECT_EQ(fds_dset_iter_err(&iter), NO_ERR_STRING);
+
+    fds_template_destroy(tmplt);
+}
@@ -0,0 +1,231 @@
+/**
+ * \brief Test cases for the cache of parsed templates
+ */
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <libfds.h>
+
+#include <TGenerator.h>
+
+constexpr uint16_t VAR_IE = 65535;
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+class Cache : public ::testing::Test {
+private:
+    // File with few IANA elements
+    const char *ie_path = "data/iana.xml";
+protected:
+    fds_iemgr_t *ie_mgr = nullptr;
+    fds_tcache_t *cache = nullptr;
+
+    /** \brief Prepare IE DB and a cache */
+    void SetUp() override {
+        ie_mgr = fds_iemgr_create();
+        cache = fds_tcache_create(4);
+        if (!ie_mgr || !cache) {
+            throw std::runtime_error("Failed to create an IE manager or a cache!");
+        }
+
+        if (fds_iemgr_read_file(ie_mgr, ie_path, true) != FDS_OK) {
+            throw std::runtime_error("Failed to load Information Elements: "
+                + std::string(fds_iemgr_last_err(ie_mgr)));
+        }
+    }
+
+    /** \brief Destroy the cache and IE DB */
+    void TearDown() override {
+        fds_tcache_destroy(cache);
+        fds_iemgr_destroy(ie_mgr);
+    }
+
+    /** \brief Create a raw biflow template */
+    static std::unique_ptr<TGenerator> biflow(uint16_t id) {
+        std::unique_ptr<TGenerator> gen(new TGenerator(id, 6));
+        gen->append(  8,      4);        // sourceIPv4Address
+        gen->append( 12,      4);        // destinationIPv4Address
+        gen->append(460, VAR_IE);        // httpRequestHost
+        gen->append(  2,      8);        // packetDeltaCount
+        gen->append(  2,      8, 29305); // packetDeltaCount (reverse)
+        gen->append(  1,      8, 29305); // octetDeltaCount (reverse)
+        return gen;
+    }
+
+    /** \brief Get statistics of the cache */
+    struct fds_tcache_stats stats() {
+        struct fds_tcache_stats result;
+        fds_tcache_stats(cache, &result);
+        return result;
+    }
+};
+
+// Invalid capacity
+TEST_F(Cache, create)
+{
+    EXPECT_EQ(fds_tcache_create(0), nullptr);
+    struct fds_tcache_stats st = stats();
+    EXPECT_EQ(st.hits, 0U);
+    EXPECT_EQ(st.misses, 0U);
+    EXPECT_EQ(st.evictions, 0U);
+    EXPECT_EQ(st.entries, 0U);
+}
+
+// The same template is parsed only once
+TEST_F(Cache, hitMiss)
+{
+    auto gen = biflow(256);
+    struct fds_template *ref;
+    uint16_t len = gen->length();
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, gen->get(), &len, &ref), FDS_OK);
+    ASSERT_EQ(fds_template_ies_define(ref, ie_mgr, false), FDS_OK);
+
+    std::vector<struct fds_template *> parsed;
+    for (int i = 0; i < 3; ++i) {
+        struct fds_template *tmplt;
+        uint16_t len_cache = gen->length() + 10U; // Followed by another data
+        ASSERT_EQ(fds_tcache_parse(cache, FDS_TYPE_TEMPLATE, gen->get(), &len_cache, ie_mgr,
+            &tmplt), FDS_OK);
+        EXPECT_EQ(len_cache, len);
+        parsed.push_back(tmplt);
+
+        // Check the template content
+        EXPECT_EQ(fds_template_cmp(tmplt, ref), 0);
+        EXPECT_EQ(tmplt->flags, ref->flags);
+        EXPECT_NE(tmplt->flags & FDS_TEMPLATE_BIFLOW, 0);
+        ASSERT_NE(tmplt->fields_rev, nullptr);
+        for (uint16_t idx = 0; idx < tmplt->fields_cnt_total; ++idx) {
+            EXPECT_EQ(tmplt->fields[idx].def, ref->fields[idx].def);
+            EXPECT_EQ(tmplt->fields[idx].flags, ref->fields[idx].flags);
+            EXPECT_EQ(tmplt->fields_rev[idx].def, ref->fields_rev[idx].def);
+        }
+    }
+
+    struct fds_tcache_stats st = stats();
+    EXPECT_EQ(st.misses, 1U);
+    EXPECT_EQ(st.hits, 2U);
+    EXPECT_EQ(st.entries, 1U);
+
+    // Returned templates are independent copies
+    EXPECT_NE(parsed[0], parsed[1]);
+    EXPECT_NE(parsed[1], parsed[2]);
+    parsed[0]->time.first_seen = 100;
+    EXPECT_EQ(fds_template_flowkey_define(parsed[0], 1), FDS_OK);
+    fds_template_destroy(parsed[0]);
+    EXPECT_EQ(parsed[1]->time.first_seen, 0U);
+    EXPECT_EQ(fds_template_flowkey_cmp(parsed[1], 0), 0);
+
+    // A different IE manager (or none) is a different entry
+    struct fds_template *tmplt;
+    len = gen->length();
+    ASSERT_EQ(fds_tcache_parse(cache, FDS_TYPE_TEMPLATE, gen->get(), &len, nullptr, &tmplt),
+        FDS_OK);
+    EXPECT_EQ(tmplt->fields[0].def, nullptr);
+    EXPECT_EQ(tmplt->fields_rev, nullptr);
+    EXPECT_EQ(stats().misses, 2U);
+    fds_template_destroy(tmplt);
+
+    fds_template_destroy(parsed[1]);
+    fds_template_destroy(parsed[2]);
+    fds_template_destroy(ref);
+}
+
+// The least recently used templates are removed
+TEST_F(Cache, capacity)
+{
+    auto parse = [&](uint16_t id) {
+        auto gen = biflow(id);
+        struct fds_template *tmplt;
+        uint16_t len = gen->length();
+        ASSERT_EQ(fds_tcache_parse(cache, FDS_TYPE_TEMPLATE, gen->get(), &len, ie_mgr, &tmplt),
+            FDS_OK);
+        EXPECT_EQ(tmplt->id, id);
+        fds_template_destroy(tmplt);
+    };
+
+    for (uint16_t id = 256; id < 260; ++id) {
+        parse(id);
+    }
+    parse(256); // 257 is the least recently used one now
+    parse(260);
+
+    struct fds_tcache_stats st = stats();
+    EXPECT_EQ(st.misses, 5U);
+    EXPECT_EQ(st.hits, 1U);
+    EXPECT_EQ(st.evictions, 1U);
+    EXPECT_EQ(st.entries, 4U);
+
+    parse(256);
+    EXPECT_EQ(stats().hits, 2U);
+    parse(257);
+    EXPECT_EQ(stats().misses, 6U);
+
+    fds_tcache_clear(cache);
+    st = stats();
+    EXPECT_EQ(st.entries, 0U);
+    EXPECT_EQ(st.evictions, 2U);
+    parse(256);
+    EXPECT_EQ(stats().misses, 7U);
+}
+
+// Withdrawals and malformed templates
+TEST_F(Cache, notCached)
+{
+    TGenerator withdrawal(256, 0);
+    struct fds_template *tmplt;
+    uint16_t len = withdrawal.length();
+    ASSERT_EQ(fds_tcache_parse(cache, FDS_TYPE_TEMPLATE, withdrawal.get(), &len, ie_mgr, &tmplt),
+        FDS_OK);
+    EXPECT_EQ(tmplt->fields_cnt_total, 0);
+    EXPECT_EQ(len, 4U);
+    fds_template_destroy(tmplt);
+
+    auto gen = biflow(256);
+    len = gen->length() - 1U;
+    EXPECT_EQ(fds_tcache_parse(cache, FDS_TYPE_TEMPLATE, gen->get(), &len, ie_mgr, &tmplt),
+        FDS_ERR_FORMAT);
+    EXPECT_EQ(len, gen->length() - 1U);
+
+    struct fds_tcache_stats st = stats();
+    EXPECT_EQ(st.hits, 0U);
+    EXPECT_EQ(st.entries, 0U);
+}
+
+// Multiple threads share the same cache
+TEST_F(Cache, threads)
+{
+    const int threads_cnt = 4;
+    const int rounds = 500;
+
+    auto worker = [&]() {
+        for (int i = 0; i < rounds; ++i) {
+            auto gen = biflow(256 + (i % 8));
+            struct fds_template *tmplt;
+            uint16_t len = gen->length();
+            ASSERT_EQ(fds_tcache_parse(cache, FDS_TYPE_TEMPLATE, gen->get(), &len, ie_mgr,
+                &tmplt), FDS_OK);
+            ASSERT_EQ(tmplt->id, 256 + (i % 8));
+            ASSERT_NE(tmplt->fields_rev, nullptr);
+            fds_template_destroy(tmplt);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threads_cnt; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    struct fds_tcache_stats st = stats();
+    EXPECT_EQ(st.hits + st.misses, uint64_t(threads_cnt * rounds));
+    EXPECT_LE(st.entries, 4U);
+}
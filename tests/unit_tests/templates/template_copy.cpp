@@ -59,6 +59,16 @@ TEST(Copy, simpleCheck)
     size_t fields_size = tmplt->fields_cnt_total * sizeof(struct fds_tfield);
     EXPECT_EQ(std::memcmp(copy->fields, tmplt->fields, fields_size), 0);
 
+    // Check layout of variable-length fields (4 segments of fixed-length fields)
+    ASSERT_EQ(tmplt->index.var_cnt, 3);
+    EXPECT_EQ(copy->index.var_cnt, tmplt->index.var_cnt);
+    EXPECT_NE(copy->index.var_segs, tmplt->index.var_segs);
+    const uint16_t segs[] = {12, 0, 1, 8};
+    for (uint16_t i = 0; i <= tmplt->index.var_cnt; ++i) {
+        EXPECT_EQ(tmplt->index.var_segs[i], segs[i]);
+        EXPECT_EQ(copy->index.var_segs[i], segs[i]);
+    }
+
     // Compare
     EXPECT_EQ(fds_template_cmp(tmplt, copy), 0);
 
@@ -66,6 +76,52 @@ TEST(Copy, simpleCheck)
     fds_template_destroy(copy);
 }
 
+// All parts of the copy are independent of the original template
+TEST(Copy, singleBlock)
+{
+    TGenerator tdata(256, 4, 0);
+    tdata.append(  8,      4); // sourceIPv4Address
+    tdata.append(460, VAR_IE); // httpRequestHost
+    tdata.append(  2,      8); // packetDeltaCount
+    tdata.append(2, 8, 29305); // packetDeltaCount (reverse)
+
+    struct fds_template *tmplt, *copy;
+    uint16_t len = tdata.length();
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, tdata.get(), &len, &tmplt), FDS_OK);
+    ASSERT_EQ(tmplt->fields_rev, nullptr);
+
+    // Reverse fields are created on demand
+    fds_iemgr_t *iemgr = fds_iemgr_create();
+    ASSERT_NE(iemgr, nullptr);
+    ASSERT_EQ(fds_iemgr_read_file(iemgr, "data/iana.xml", true), FDS_OK);
+    ASSERT_EQ(fds_template_ies_define(tmplt, iemgr, false), FDS_OK);
+    ASSERT_NE(tmplt->fields_rev, nullptr);
+    fds_iemgr_destroy(iemgr);
+
+    copy = fds_template_copy(tmplt);
+    ASSERT_NE(copy, nullptr);
+    fds_template_destroy(tmplt);
+
+    // The parts are placed behind the fields
+    const uint8_t *fields_end = reinterpret_cast<const uint8_t *>(&copy->fields[4]);
+    EXPECT_GE(reinterpret_cast<const uint8_t *>(copy->fields_rev), fields_end);
+    EXPECT_GE(copy->raw.data, fields_end);
+    EXPECT_GE(reinterpret_cast<const uint8_t *>(copy->index.slots), fields_end);
+
+    ASSERT_EQ(copy->raw.length, tdata.length());
+    EXPECT_EQ(std::memcmp(copy->raw.data, tdata.get(), copy->raw.length), 0);
+    EXPECT_EQ(copy->fields_rev[2].en, 29305U);
+    EXPECT_EQ(copy->fields_rev[3].en, 0U);
+    EXPECT_EQ(fds_template_cfind(copy, 0, 460), &copy->fields[1]);
+    EXPECT_EQ(fds_template_cfind(copy, 29305, 2), &copy->fields[3]);
+    EXPECT_EQ(copy->index.var_segs[0], 4);
+
+    // Definitions are removed together with the reverse fields
+    ASSERT_EQ(fds_template_ies_define(copy, nullptr, false), FDS_OK);
+    EXPECT_EQ(copy->fields_rev, nullptr);
+    fds_template_destroy(copy);
+}
+
 TEST(compare, simple)
 {
     TGenerator tdata1(256, 3, 0);
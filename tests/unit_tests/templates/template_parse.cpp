@@ -94,6 +94,14 @@ template_tester(const exp_template_params &tmplt, const std::vector<exp_field_pa
         ct_tfield_flags(tfield, field.flags);
         idx++;
 
+        // Lookup must always return the first occurrence of the field
+        const fds_tfield *tfind = fds_template_cfind(tmplt_rec, field.en, field.id);
+        ASSERT_NE(tfind, nullptr);
+        EXPECT_LE(tfind, tfield);
+        EXPECT_EQ(tfind->id, field.id);
+        EXPECT_EQ(tfind->en, field.en);
+        EXPECT_TRUE(tfind == tfield || (tfield->flags & FDS_TFIELD_MULTI_IE) != 0);
+
         // Calculate next offset
         if (exp_offset == VAR_IE) {
             continue;
@@ -224,6 +232,39 @@ TEST(Parse, MultiIE)
     template_tester(tmplt, fields);
 }
 
+// Lookup of fields in a template with a lot of fields
+TEST(Parse, FindManyFields)
+{
+    const uint16_t fields_cnt = 1000;
+    TGenerator tdata(300, fields_cnt, 0);
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        // Combination of IANA and enterprise elements (each element is present twice)
+        tdata.append((i / 2) % 250, 4, (i % 2 == 0) ? 0 : 8057);
+    }
+
+    struct fds_template *tmplt;
+    uint16_t tmplt_len = tdata.length();
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, tdata.get(), &tmplt_len, &tmplt), FDS_OK);
+
+    for (uint16_t i = 0; i < fields_cnt; ++i) {
+        const uint16_t id = (i / 2) % 250;
+        const uint32_t en = (i % 2 == 0) ? 0 : 8057;
+        const struct fds_tfield *field = fds_template_cfind(tmplt, en, id);
+        ASSERT_NE(field, nullptr);
+        EXPECT_EQ(field->id, id);
+        EXPECT_EQ(field->en, en);
+        // The first occurrence must be always returned
+        EXPECT_EQ(field - tmplt->fields, i % 500);
+        EXPECT_EQ(field->offset, 4U * (i % 500));
+    }
+
+    // Missing fields
+    EXPECT_EQ(fds_template_cfind(tmplt, 0, 250), nullptr);
+    EXPECT_EQ(fds_template_cfind(tmplt, 8057, 251), nullptr);
+    EXPECT_EQ(fds_template_cfind(tmplt, 1, 1), nullptr);
+    fds_template_destroy(tmplt);
+}
+
 TEST(Parse, Withdrawal)
 {
     // Standard template
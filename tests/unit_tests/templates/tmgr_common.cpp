@@ -7,6 +7,9 @@
 #include <TGenerator.h>
 #include <TMock.h>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
 int main(int argc, char **argv)
 {
@@ -161,6 +164,76 @@ TEST_P(Common, maxTemplates)
     }
 }
 
+// Grow snapshots over the limit of the compact layout and shrink them back
+TEST_P(Common, snapshotGrowAndShrink)
+{
+    const unsigned int tmplt_cnt = 40;
+    const unsigned int tmplt_step = 37; // Spread across multiple L2 tables
+    std::vector<const fds_tsnapshot_t *> snaps;
+
+    for (unsigned int i = 0; i < tmplt_cnt; ++i) {
+        TMock::type type = (i % 2)
+            ? TMock::type::DATA_BASIC_FLOW
+            : TMock::type::DATA_BASIC_BIFLOW;
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, 100 + i), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(type, 256 + i * tmplt_step)), FDS_OK);
+
+        const fds_tsnapshot_t *snap = nullptr;
+        ASSERT_EQ(fds_tmgr_snapshot_get(tmgr, &snap), FDS_OK);
+        snaps.push_back(snap);
+    }
+
+    // Each snapshot must contain only templates defined so far
+    for (unsigned int i = 0; i < tmplt_cnt; ++i) {
+        for (unsigned int j = 0; j < tmplt_cnt; ++j) {
+            const uint16_t id = 256 + j * tmplt_step;
+            const struct fds_template *tmplt = fds_tsnapshot_template_get(snaps[i], id);
+            if (j > i) {
+                EXPECT_EQ(tmplt, nullptr);
+                continue;
+            }
+
+            ASSERT_NE(tmplt, nullptr);
+            EXPECT_EQ(tmplt->id, id);
+        }
+    }
+
+    // Remove most of the templates
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+    for (unsigned int j = 0; j < tmplt_cnt - 5; ++j) {
+        ASSERT_EQ(fds_tmgr_template_remove(tmgr, 256 + j * tmplt_step, FDS_TYPE_TEMPLATE_UNDEF),
+            FDS_OK);
+    }
+
+    const fds_tsnapshot_t *snap = nullptr;
+    ASSERT_EQ(fds_tmgr_snapshot_get(tmgr, &snap), FDS_OK);
+    for (unsigned int j = 0; j < tmplt_cnt; ++j) {
+        const uint16_t id = 256 + j * tmplt_step;
+        const struct fds_template *tmplt = fds_tsnapshot_template_get(snap, id);
+        EXPECT_EQ(tmplt != nullptr, j >= tmplt_cnt - 5);
+        // Previously obtained snapshots must remain untouched
+        tmplt = fds_tsnapshot_template_get(snaps[tmplt_cnt - 1], id);
+        ASSERT_NE(tmplt, nullptr);
+        EXPECT_EQ(tmplt->id, id);
+    }
+
+    // Refresh the remaining templates
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 300), FDS_OK);
+    for (unsigned int j = tmplt_cnt - 5; j < tmplt_cnt; ++j) {
+        TMock::type type = (j % 2)
+            ? TMock::type::DATA_BASIC_FLOW
+            : TMock::type::DATA_BASIC_BIFLOW;
+        EXPECT_EQ(fds_tmgr_template_add(tmgr, TMock::create(type, 256 + j * tmplt_step)), FDS_OK);
+    }
+
+    const struct fds_template *tmplt = nullptr;
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, 256 + (tmplt_cnt - 1) * tmplt_step, &tmplt), FDS_OK);
+    uint32_t last_seen;
+    fds_tmgr_template_time(tmgr, tmplt, &last_seen, nullptr);
+    EXPECT_EQ(last_seen, 300U);
+    EXPECT_EQ(fds_tmgr_template_get(tmgr, 256, &tmplt), FDS_ERR_NOTFOUND);
+}
+
 // Try to add withdrawal templates (not permitted)
 TEST_P(Common, refuseWithdrawalTemplate)
 {
@@ -207,7 +280,9 @@ TEST_P(Common, templateRefresh)
 
         // Start time should be still the same. Last time should be modified.
         EXPECT_EQ(tmplt2check->time.first_seen, time_start);
-        EXPECT_EQ(tmplt2check->time.last_seen, time_now);
+        uint32_t last_seen;
+        fds_tmgr_template_time(tmgr, tmplt2check, &last_seen, nullptr);
+        EXPECT_EQ(last_seen, time_now);
     }
 
     fds_template_destroy(aux_tmplt);
@@ -389,7 +464,9 @@ TEST_P(Common, setFlowKey)
     EXPECT_TRUE((tmplt2check->flags & FDS_TEMPLATE_FKEY) != 0);
     EXPECT_EQ(fds_template_flowkey_cmp(tmplt2check, fkey), 0);
     EXPECT_EQ(tmplt2check->time.first_seen, 0);
-    EXPECT_EQ(tmplt2check->time.last_seen, 10);
+    uint32_t last_seen;
+    fds_tmgr_template_time(tmgr, tmplt2check, &last_seen, nullptr);
+    EXPECT_EQ(last_seen, 10);
 
     // Remove the flow key
     EXPECT_EQ(fds_tmgr_template_set_fkey(tmgr, tid1, 0), FDS_OK);
@@ -590,7 +667,9 @@ TEST_P(Common, ieManagerSimple)
     EXPECT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_BIFLOW, tid1)), FDS_OK);
     ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt2check), FDS_OK);
     EXPECT_EQ(tmplt2check->time.first_seen, 0);
-    EXPECT_EQ(tmplt2check->time.last_seen, 10);
+    uint32_t last_seen;
+    fds_tmgr_template_time(tmgr, tmplt2check, &last_seen, nullptr);
+    EXPECT_EQ(last_seen, 10);
     EXPECT_NE(tmplt2check->flags & FDS_TEMPLATE_BIFLOW, 0);
     for (uint16_t i = 0; i < tmplt2check->fields_cnt_total; ++i) {
         const struct fds_tfield *field = &tmplt2check->fields[i];
@@ -762,6 +841,219 @@ TEST_P(Common, ieManagerRedefine)
 }
 
 
+// Replace IE manager with a new version that differs only in a vendor scope
+TEST_P(Common, ieManagerUpdate)
+{
+    const uint32_t vendor_pen = 8888;
+    const uint16_t vendor_id = 1000;
+    auto iemgr_build = [&](enum fds_iemgr_element_type type) -> fds_iemgr_t * {
+        fds_iemgr_t *iemgr = fds_iemgr_create();
+        EXPECT_NE(iemgr, nullptr);
+        EXPECT_EQ(fds_iemgr_read_file(iemgr, "./data/iana.xml", false), FDS_OK);
+
+        struct fds_iemgr_elem elem;
+        memset(&elem, 0, sizeof(elem));
+        elem.id = vendor_id;
+        elem.name = const_cast<char *>("vendorCounter");
+        elem.data_type = type;
+        EXPECT_EQ(fds_iemgr_elem_add(iemgr, &elem, vendor_pen, false), FDS_OK);
+        EXPECT_EQ(fds_iemgr_freeze(iemgr), FDS_OK);
+        return iemgr;
+    };
+
+    fds_iemgr_t *iemgr_v1 = iemgr_build(FDS_ET_UNSIGNED_32);
+    ASSERT_EQ(fds_tmgr_set_iemgr(tmgr, iemgr_v1), FDS_OK);
+    EXPECT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+
+    const uint16_t tid1 = 256;
+    const uint16_t tid2 = 257;
+    EXPECT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_BIFLOW, tid1)),
+        FDS_OK);
+    TGenerator gen(tid2, 2);
+    gen.append(1, 8);
+    gen.append(vendor_id, 4, vendor_pen);
+    struct fds_template *t2 = nullptr;
+    uint16_t t2_len = gen.length();
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, gen.get(), &t2_len, &t2), FDS_OK);
+    EXPECT_EQ(fds_tmgr_template_add(tmgr, t2), FDS_OK);
+
+    const struct fds_template *t1_old, *t2_old;
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &t1_old), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid2, &t2_old), FDS_OK);
+
+    // Another snapshot
+    const uint16_t tid3 = 258;
+    EXPECT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+    EXPECT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid3)),
+        FDS_OK);
+    const struct fds_template *t3_old;
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid3, &t3_old), FDS_OK);
+
+    // Only the vendor element has been changed
+    fds_iemgr_t *iemgr_v2 = iemgr_build(FDS_ET_UNSIGNED_64);
+    ASSERT_EQ(fds_iemgr_rebase(iemgr_v2, iemgr_v1), FDS_OK);
+    fds_iemgr_diff_t *diff = fds_iemgr_diff_create(iemgr_v1, iemgr_v2);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 1U);
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, vendor_pen, vendor_id));
+
+    ASSERT_EQ(fds_tmgr_update_iemgr(tmgr, iemgr_v2, diff), FDS_OK);
+    fds_iemgr_diff_destroy(diff);
+    // Unchanged definitions are shared with the new manager
+    fds_iemgr_destroy(iemgr_v1);
+
+    // Only the template with the vendor element has been redefined
+    const struct fds_template *tmplt2check;
+    EXPECT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid3, &tmplt2check), FDS_OK);
+    EXPECT_EQ(tmplt2check, t3_old);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt2check), FDS_OK);
+    EXPECT_EQ(tmplt2check, t1_old);
+    EXPECT_NE(tmplt2check->flags & FDS_TEMPLATE_BIFLOW, 0);
+    const struct fds_tfield *field = fds_template_cfind(tmplt2check, 0, 1);
+    ASSERT_NE(field, nullptr);
+    EXPECT_EQ(field->def, fds_iemgr_elem_find_id(iemgr_v2, 0, 1));
+
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid2, &tmplt2check), FDS_OK);
+    EXPECT_NE(tmplt2check, t2_old);
+    field = fds_template_cfind(tmplt2check, vendor_pen, vendor_id);
+    ASSERT_NE(field, nullptr);
+    ASSERT_NE(field->def, nullptr);
+    EXPECT_EQ(field->def, fds_iemgr_elem_find_id(iemgr_v2, vendor_pen, vendor_id));
+    EXPECT_EQ(field->def->data_type, FDS_ET_UNSIGNED_64);
+    t2_old = tmplt2check;
+
+    // Nothing has been changed
+    fds_iemgr_t *iemgr_v3 = fds_iemgr_copy(iemgr_v2);
+    ASSERT_NE(iemgr_v3, nullptr);
+    diff = fds_iemgr_diff_create(iemgr_v2, iemgr_v3);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 0U);
+    ASSERT_EQ(fds_tmgr_update_iemgr(tmgr, iemgr_v3, diff), FDS_OK);
+    fds_iemgr_diff_destroy(diff);
+    fds_iemgr_destroy(iemgr_v2);
+
+    EXPECT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid2, &tmplt2check), FDS_OK);
+    EXPECT_EQ(tmplt2check, t2_old);
+
+    // Remove all definitions
+    diff = fds_iemgr_diff_create(iemgr_v3, nullptr);
+    ASSERT_NE(diff, nullptr);
+    ASSERT_EQ(fds_tmgr_update_iemgr(tmgr, nullptr, diff), FDS_OK);
+    fds_iemgr_diff_destroy(diff);
+    fds_iemgr_destroy(iemgr_v3);
+
+    EXPECT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt2check), FDS_OK);
+    EXPECT_EQ(tmplt2check->flags & FDS_TEMPLATE_BIFLOW, 0);
+    for (uint16_t i = 0; i < tmplt2check->fields_cnt_total; ++i) {
+        EXPECT_EQ(tmplt2check->fields[i].def, nullptr);
+    }
+}
+
+// Templates restored from a file are redefined after an update of the IE manager
+TEST_P(Common, ieManagerUpdateLoaded)
+{
+    const uint32_t vendor_pen = 8888;
+    const uint16_t vendor_id = 1000;
+    auto iemgr_build = [&](enum fds_iemgr_element_type type, bool gauge) -> fds_iemgr_t * {
+        fds_iemgr_t *iemgr = fds_iemgr_create();
+        EXPECT_NE(iemgr, nullptr);
+        EXPECT_EQ(fds_iemgr_read_file(iemgr, "./data/iana.xml", false), FDS_OK);
+
+        struct fds_iemgr_elem elem;
+        memset(&elem, 0, sizeof(elem));
+        elem.id = vendor_id;
+        elem.name = const_cast<char *>("vendorCounter");
+        elem.data_type = type;
+        EXPECT_EQ(fds_iemgr_elem_add(iemgr, &elem, vendor_pen, false), FDS_OK);
+        if (gauge) {
+            // Element of another vendor which is not used by any template
+            elem.id = vendor_id + 1;
+            elem.name = const_cast<char *>("vendorGauge");
+            elem.data_type = FDS_ET_UNSIGNED_16;
+            EXPECT_EQ(fds_iemgr_elem_add(iemgr, &elem, vendor_pen + 1, false), FDS_OK);
+        }
+        EXPECT_EQ(fds_iemgr_freeze(iemgr), FDS_OK);
+        return iemgr;
+    };
+
+    fds_iemgr_t *iemgr_v1 = iemgr_build(FDS_ET_UNSIGNED_32, false);
+    ASSERT_EQ(fds_tmgr_set_iemgr(tmgr, iemgr_v1), FDS_OK);
+    EXPECT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+
+    const uint16_t tid1 = 256;
+    const uint16_t tid2 = 257;
+    EXPECT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid1)),
+        FDS_OK);
+    TGenerator gen(tid2, 2);
+    gen.append(1, 8);
+    gen.append(vendor_id, 4, vendor_pen);
+    struct fds_template *t2 = nullptr;
+    uint16_t t2_len = gen.length();
+    ASSERT_EQ(fds_template_parse(FDS_TYPE_TEMPLATE, gen.get(), &t2_len, &t2), FDS_OK);
+    EXPECT_EQ(fds_tmgr_template_add(tmgr, t2), FDS_OK);
+
+    // Restore the state in another manager
+    FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fds_tmgr_save(tmgr, file), FDS_OK);
+    std::rewind(file);
+    fds_tmgr_t *dst = fds_tmgr_create(GetParam());
+    ASSERT_NE(dst, nullptr);
+    ASSERT_EQ(fds_tmgr_set_iemgr(dst, iemgr_v1), FDS_OK);
+    ASSERT_EQ(fds_tmgr_load(dst, file), FDS_OK);
+    std::fclose(file);
+
+    const struct fds_template *t1_old, *t2_old;
+    ASSERT_EQ(fds_tmgr_template_get(dst, tid1, &t1_old), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(dst, tid2, &t2_old), FDS_OK);
+
+    // An element which is not used by any template has been changed -> nothing to do
+    fds_iemgr_t *iemgr_v2 = iemgr_build(FDS_ET_UNSIGNED_32, true);
+    ASSERT_EQ(fds_iemgr_rebase(iemgr_v2, iemgr_v1), FDS_OK);
+    fds_iemgr_diff_t *diff = fds_iemgr_diff_create(iemgr_v1, iemgr_v2);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_EQ(fds_iemgr_diff_cnt(diff), 1U);
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, vendor_pen + 1, vendor_id + 1));
+
+    const fds_tsnapshot_t *snap_old, *snap_new;
+    ASSERT_EQ(fds_tmgr_snapshot_get(dst, &snap_old), FDS_OK);
+    ASSERT_EQ(fds_tmgr_update_iemgr(dst, iemgr_v2, diff), FDS_OK);
+    fds_iemgr_diff_destroy(diff);
+    EXPECT_EQ(fds_tmgr_set_time(dst, 100), FDS_OK);
+    ASSERT_EQ(fds_tmgr_snapshot_get(dst, &snap_new), FDS_OK);
+    EXPECT_EQ(snap_new, snap_old);
+
+    // The vendor element used by the restored template has been changed
+    fds_iemgr_t *iemgr_v3 = iemgr_build(FDS_ET_UNSIGNED_64, true);
+    ASSERT_EQ(fds_iemgr_rebase(iemgr_v3, iemgr_v2), FDS_OK);
+    diff = fds_iemgr_diff_create(iemgr_v2, iemgr_v3);
+    ASSERT_NE(diff, nullptr);
+    EXPECT_TRUE(fds_iemgr_diff_find(diff, vendor_pen, vendor_id));
+    ASSERT_EQ(fds_tmgr_update_iemgr(dst, iemgr_v3, diff), FDS_OK);
+    fds_iemgr_diff_destroy(diff);
+
+    const struct fds_template *tmplt2check;
+    EXPECT_EQ(fds_tmgr_set_time(dst, 100), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(dst, tid1, &tmplt2check), FDS_OK);
+    EXPECT_EQ(tmplt2check, t1_old);
+    ASSERT_EQ(fds_tmgr_template_get(dst, tid2, &tmplt2check), FDS_OK);
+    EXPECT_NE(tmplt2check, t2_old);
+    const struct fds_tfield *field = fds_template_cfind(tmplt2check, vendor_pen, vendor_id);
+    ASSERT_NE(field, nullptr);
+    ASSERT_NE(field->def, nullptr);
+    EXPECT_EQ(field->def, fds_iemgr_elem_find_id(iemgr_v3, vendor_pen, vendor_id));
+    EXPECT_EQ(field->def->data_type, FDS_ET_UNSIGNED_64);
+
+    // Templates must not refer to the old managers anymore
+    fds_tmgr_destroy(dst);
+    ASSERT_EQ(fds_tmgr_set_iemgr(tmgr, nullptr), FDS_OK);
+    fds_iemgr_destroy(iemgr_v3);
+    fds_iemgr_destroy(iemgr_v2);
+    fds_iemgr_destroy(iemgr_v1);
+}
 
 // TODO: Multiple updates of the same template at the same time + cleanup
 
@@ -0,0 +1,269 @@
+/**
+ * \brief Test cases for saving and restoring states of template managers
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <TGenerator.h>
+#include <TMock.h>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+class persist : public ::testing::Test {
+protected:
+    fds_iemgr_t *iemgr = nullptr;
+    FILE *file = nullptr;
+
+    /** \brief Prepare an IE manager and a temporary file */
+    void SetUp() override {
+        iemgr = fds_iemgr_create();
+        file = std::tmpfile();
+        if (!iemgr || !file || fds_iemgr_read_file(iemgr, "data/iana.xml", true) != FDS_OK) {
+            throw std::runtime_error("Failed to prepare an IE manager or a file!");
+        }
+    }
+
+    /** \brief Destroy the IE manager and the file */
+    void TearDown() override {
+        std::fclose(file);
+        fds_iemgr_destroy(iemgr);
+    }
+
+    /** \brief Create a UDP manager with timeouts */
+    fds_tmgr_t *udp_create() {
+        fds_tmgr_t *tmgr = fds_tmgr_create(FDS_SESSION_UDP);
+        if (!tmgr || fds_tmgr_set_udp_timeouts(tmgr, 60, 120) != FDS_OK
+                || fds_tmgr_set_iemgr(tmgr, iemgr) != FDS_OK) {
+            throw std::runtime_error("Failed to create a template manager!");
+        }
+        return tmgr;
+    }
+};
+
+// Templates, timestamps and flow keys are restored
+TEST_F(persist, roundTrip)
+{
+    fds_tmgr_t *src = udp_create();
+    ASSERT_EQ(fds_tmgr_set_time(src, 100), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::DATA_BASIC_FLOW, 256)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::DATA_BASIC_BIFLOW, 257)),
+        FDS_OK);
+    ASSERT_EQ(fds_tmgr_set_time(src, 110), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::OPTS_MPROC_STAT, 258)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_set_fkey(src, 256, 0x1F), FDS_OK);
+    for (uint16_t i = 0; i < 40; ++i) {
+        // Enough templates for the large layout of snapshots
+        struct fds_template *tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, 1000 + 3 * i);
+        ASSERT_EQ(fds_tmgr_template_add(src, tmplt), FDS_OK);
+    }
+
+    // Go back in time (the newest state is saved and the time context is preserved)
+    ASSERT_EQ(fds_tmgr_set_time(src, 105), FDS_OK);
+    ASSERT_EQ(fds_tmgr_save(src, file), FDS_OK);
+    const struct fds_template *tmplt;
+    EXPECT_EQ(fds_tmgr_template_get(src, 258, &tmplt), FDS_ERR_NOTFOUND);
+
+    std::rewind(file);
+    fds_tmgr_t *dst = udp_create();
+    ASSERT_EQ(fds_tmgr_load(dst, file), FDS_OK);
+    EXPECT_EQ(std::fgetc(file), EOF);
+
+    ASSERT_EQ(fds_tmgr_set_time(src, 110), FDS_OK);
+    const uint16_t ids[] = {256, 257, 258, 1000, 1117};
+    for (uint16_t id : ids) {
+        SCOPED_TRACE("Template ID: " + std::to_string(id));
+        const struct fds_template *orig, *restored;
+        ASSERT_EQ(fds_tmgr_template_get(src, id, &orig), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_get(dst, id, &restored), FDS_OK);
+        EXPECT_NE(orig, restored);
+        EXPECT_EQ(fds_template_cmp(orig, restored), 0);
+        EXPECT_EQ(restored->time.first_seen, orig->time.first_seen);
+        EXPECT_EQ(restored->time.last_seen, orig->time.last_seen);
+        EXPECT_EQ(restored->time.end_of_life, orig->time.end_of_life);
+        EXPECT_EQ(restored->flags, orig->flags);
+        EXPECT_EQ(restored->fields[0].def, orig->fields[0].def);
+        EXPECT_EQ(restored->fields_rev != nullptr, orig->fields_rev != nullptr);
+    }
+
+    ASSERT_EQ(fds_tmgr_template_get(dst, 256, &tmplt), FDS_OK);
+    EXPECT_EQ(fds_template_flowkey_cmp(tmplt, 0x1F), 0);
+
+    // Templates are expired as before
+    ASSERT_EQ(fds_tmgr_set_time(dst, 175), FDS_OK);
+    EXPECT_EQ(fds_tmgr_template_get(dst, 256, &tmplt), FDS_ERR_NOTFOUND);
+    EXPECT_EQ(fds_tmgr_template_get(dst, 258, &tmplt), FDS_OK);
+
+    fds_tmgr_destroy(src);
+    fds_tmgr_destroy(dst);
+}
+
+// Saving doesn't modify the manager
+TEST_F(persist, readOnly)
+{
+    fds_tmgr_t *src = udp_create();
+    ASSERT_EQ(fds_tmgr_set_time(src, 100), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::DATA_BASIC_FLOW, 256)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_set_time(src, 110), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::DATA_BASIC_FLOW, 257)), FDS_OK);
+
+    // Modification of the history hasn't been propagated to the newest snapshot yet
+    ASSERT_EQ(fds_tmgr_set_time(src, 105), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::OPTS_MPROC_STAT, 258)), FDS_OK);
+    EXPECT_EQ(fds_tmgr_save(src, file), FDS_ERR_ARG);
+    EXPECT_EQ(std::ftell(file), 0);
+
+    // The time context and the modified snapshot are preserved
+    const fds_tsnapshot_t *snap;
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::OPTS_MPROC_STAT, 259)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_snapshot_get(src, &snap), FDS_OK);
+    EXPECT_NE(fds_tsnapshot_template_get(snap, 258), nullptr);
+    EXPECT_NE(fds_tsnapshot_template_get(snap, 259), nullptr);
+    EXPECT_EQ(fds_tsnapshot_template_get(snap, 257), nullptr);
+
+    // Modifications are propagated after a change of the time context
+    ASSERT_EQ(fds_tmgr_set_time(src, 110), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::DATA_BASIC_FLOW, 260)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_save(src, file), FDS_OK);
+
+    // Templates added after saving are not affected
+    ASSERT_EQ(fds_tmgr_template_add(src, TMock::create(TMock::type::DATA_BASIC_FLOW, 261)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_snapshot_get(src, &snap), FDS_OK);
+    EXPECT_NE(fds_tsnapshot_template_get(snap, 258), nullptr);
+    EXPECT_NE(fds_tsnapshot_template_get(snap, 261), nullptr);
+
+    std::rewind(file);
+    fds_tmgr_t *dst = udp_create();
+    ASSERT_EQ(fds_tmgr_load(dst, file), FDS_OK);
+    ASSERT_EQ(fds_tmgr_set_time(dst, 110), FDS_OK);
+    const struct fds_template *tmplt;
+    for (uint16_t id : {256, 257, 258, 259, 260}) {
+        SCOPED_TRACE("Template ID: " + std::to_string(id));
+        EXPECT_EQ(fds_tmgr_template_get(dst, id, &tmplt), FDS_OK);
+    }
+    EXPECT_EQ(fds_tmgr_template_get(dst, 261, &tmplt), FDS_ERR_NOTFOUND);
+
+    fds_tmgr_destroy(src);
+    fds_tmgr_destroy(dst);
+}
+
+// States of multiple managers in the same file, including a manager without time context
+TEST_F(persist, multiple)
+{
+    fds_tmgr_t *empty = fds_tmgr_create(FDS_SESSION_TCP);
+    fds_tmgr_t *tcp = fds_tmgr_create(FDS_SESSION_TCP);
+    ASSERT_NE(empty, nullptr);
+    ASSERT_NE(tcp, nullptr);
+    ASSERT_EQ(fds_tmgr_set_time(tcp, 5000), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tcp, TMock::create(TMock::type::DATA_BASIC_FLOW, 300)), FDS_OK);
+
+    ASSERT_EQ(fds_tmgr_save(empty, file), FDS_OK);
+    ASSERT_EQ(fds_tmgr_save(tcp, file), FDS_OK);
+    fds_tmgr_destroy(empty);
+    fds_tmgr_destroy(tcp);
+
+    std::rewind(file);
+    fds_tmgr_t *dst1 = fds_tmgr_create(FDS_SESSION_TCP);
+    fds_tmgr_t *dst2 = fds_tmgr_create(FDS_SESSION_TCP);
+    ASSERT_EQ(fds_tmgr_load(dst1, file), FDS_OK);
+    ASSERT_EQ(fds_tmgr_load(dst2, file), FDS_OK);
+
+    const struct fds_template *tmplt;
+    EXPECT_EQ(fds_tmgr_template_get(dst1, 300, &tmplt), FDS_ERR_ARG);
+    ASSERT_EQ(fds_tmgr_template_get(dst2, 300, &tmplt), FDS_OK);
+    EXPECT_EQ(tmplt->time.first_seen, 5000U);
+
+    // The manager accepts new templates
+    ASSERT_EQ(fds_tmgr_set_time(dst2, 5010), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(dst2, TMock::create(TMock::type::DATA_BASIC_FLOW, 301)),
+        FDS_OK);
+
+    fds_tmgr_destroy(dst1);
+    fds_tmgr_destroy(dst2);
+}
+
+// Malformed and truncated files
+TEST_F(persist, malformed)
+{
+    fds_tmgr_t *tmgr = udp_create();
+    ASSERT_EQ(fds_tmgr_load(tmgr, file), FDS_ERR_FORMAT);
+
+    std::fputs("This is not a state of a template manager", file);
+    std::rewind(file);
+    ASSERT_EQ(fds_tmgr_load(tmgr, file), FDS_ERR_FORMAT);
+
+    // Truncated file (the manager is empty after failure)
+    FILE *other = std::tmpfile();
+    ASSERT_NE(other, nullptr);
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, 256)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, 257)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_save(tmgr, other), FDS_OK);
+    const long size = std::ftell(other);
+
+    std::rewind(other);
+    std::vector<char> data(size);
+    ASSERT_EQ(std::fread(data.data(), 1, size, other), size_t(size));
+    std::fclose(other);
+
+    fds_tgarbage_t *gc;
+    for (long len : {size - 1, size - 10, 20L}) {
+        SCOPED_TRACE("Length: " + std::to_string(len));
+        FILE *trunc = std::tmpfile();
+        ASSERT_NE(trunc, nullptr);
+        ASSERT_EQ(std::fwrite(data.data(), 1, len, trunc), size_t(len));
+        std::rewind(trunc);
+        EXPECT_EQ(fds_tmgr_load(tmgr, trunc), FDS_ERR_FORMAT);
+        std::fclose(trunc);
+
+        const struct fds_template *tmplt;
+        EXPECT_EQ(fds_tmgr_template_get(tmgr, 256, &tmplt), FDS_ERR_ARG);
+        ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &gc), FDS_OK);
+        fds_tmgr_garbage_destroy(gc);
+    }
+
+    fds_tmgr_destroy(tmgr);
+}
+
+// All sessions of a registry
+TEST_F(persist, registry)
+{
+    const uint64_t sessions = 20000;
+    fds_treg_t *reg = fds_treg_create(nullptr, iemgr);
+    ASSERT_NE(reg, nullptr);
+    for (uint64_t id = 0; id < sessions; ++id) {
+        fds_tmgr_t *tmgr;
+        enum fds_session_type type = (id % 2) ? FDS_SESSION_UDP : FDS_SESSION_TCP;
+        ASSERT_EQ(fds_treg_add(reg, id * 7, type, &tmgr), FDS_OK);
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, 1000 + id), FDS_OK);
+        struct fds_template *tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, 256 + id % 100);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, tmplt), FDS_OK);
+    }
+
+    ASSERT_EQ(fds_treg_save(reg, file), FDS_OK);
+    fds_treg_destroy(reg);
+
+    std::rewind(file);
+    reg = fds_treg_create(nullptr, iemgr);
+    ASSERT_NE(reg, nullptr);
+    ASSERT_EQ(fds_treg_load(reg, file), FDS_OK);
+    EXPECT_EQ(fds_treg_count(reg), sessions);
+
+    for (uint64_t id = 0; id < sessions; ++id) {
+        fds_tmgr_t *tmgr = fds_treg_find(reg, id * 7);
+        ASSERT_NE(tmgr, nullptr);
+        const struct fds_template *tmplt;
+        ASSERT_EQ(fds_tmgr_template_get(tmgr, 256 + id % 100, &tmplt), FDS_OK);
+        EXPECT_EQ(tmplt->time.first_seen, 1000 + id);
+        EXPECT_NE(tmplt->fields[0].def, nullptr);
+    }
+
+    // Sessions cannot be restored twice
+    std::rewind(file);
+    EXPECT_EQ(fds_treg_load(reg, file), FDS_ERR_FORMAT);
+    fds_treg_destroy(reg);
+}
@@ -0,0 +1,160 @@
+/**
+ * \brief Test cases for the pool allocator of template managers
+ */
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <TGenerator.h>
+#include <TMock.h>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+/**
+ * \brief Add templates with different IDs to a manager
+ * \param[in] tmgr Template manager
+ * \param[in] cnt  Number of templates
+ * \param[in] step Distance between IDs of the templates
+ * \return #FDS_OK or the return code of the first failed addition
+ */
+static int
+templates_add(fds_tmgr_t *tmgr, uint16_t cnt, uint16_t step)
+{
+    for (uint16_t i = 0; i < cnt; ++i) {
+        struct fds_template *tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, 256 + i * step);
+        int ret_code = fds_tmgr_template_add(tmgr, tmplt);
+        if (ret_code != FDS_OK) {
+            fds_template_destroy(tmplt);
+            return ret_code;
+        }
+    }
+
+    return FDS_OK;
+}
+
+// Without a pool, the manager uses the heap
+TEST(pool, noPool)
+{
+    fds_tmgr_t *tmgr = fds_tmgr_create_pool(FDS_SESSION_UDP, nullptr);
+    ASSERT_NE(tmgr, nullptr);
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 10), FDS_OK);
+    EXPECT_EQ(templates_add(tmgr, 32, 1), FDS_OK);
+    fds_tmgr_destroy(tmgr);
+}
+
+// Statistics of live objects
+TEST(pool, stats)
+{
+    fds_tpool_t *pool = fds_tpool_create(0);
+    ASSERT_NE(pool, nullptr);
+
+    struct fds_tpool_stats stats;
+    fds_tpool_stats(pool, &stats);
+    EXPECT_EQ(stats.objects, 0U);
+    EXPECT_EQ(stats.bytes, 0U);
+    EXPECT_EQ(stats.reserved, 0U);
+    EXPECT_EQ(stats.failures, 0U);
+
+    fds_tmgr_t *tmgr = fds_tmgr_create_pool(FDS_SESSION_UDP, pool);
+    ASSERT_NE(tmgr, nullptr);
+
+    // A few templates (the compact layout of snapshots)
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 10), FDS_OK);
+    ASSERT_EQ(templates_add(tmgr, 4, 1), FDS_OK);
+    fds_tpool_stats(pool, &stats);
+    EXPECT_EQ(stats.objects, 1U);
+    EXPECT_GT(stats.bytes, 0U);
+    EXPECT_GE(stats.reserved, stats.bytes);
+    const uint64_t small_bytes = stats.bytes;
+
+    // Many templates in multiple snapshots (the large layout with shared tables)
+    for (uint32_t time = 20; time <= 50; time += 10) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, time), FDS_OK);
+        ASSERT_EQ(templates_add(tmgr, 64, 300), FDS_OK);
+    }
+
+    fds_tpool_stats(pool, &stats);
+    EXPECT_GT(stats.objects, 4U);
+    EXPECT_GT(stats.bytes, small_bytes);
+    EXPECT_GE(stats.reserved, stats.bytes);
+
+    // Objects are returned to the pool (the empty snapshot of the time context is recreated)
+    fds_tgarbage_t *garbage;
+    fds_tmgr_clear(tmgr);
+    ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &garbage), FDS_OK);
+    ASSERT_NE(garbage, nullptr);
+    fds_tmgr_garbage_destroy(garbage);
+
+    fds_tpool_stats(pool, &stats);
+    EXPECT_EQ(stats.objects, 1U);
+    EXPECT_EQ(stats.bytes, small_bytes);
+    EXPECT_EQ(stats.failures, 0U);
+
+    fds_tmgr_destroy(tmgr);
+    fds_tpool_stats(pool, &stats);
+    EXPECT_EQ(stats.objects, 0U);
+    EXPECT_EQ(stats.bytes, 0U);
+    fds_tpool_destroy(pool);
+}
+
+// A pool shared by multiple managers can be destroyed before its objects
+TEST(pool, sharedDestroy)
+{
+    fds_tpool_t *pool = fds_tpool_create(0);
+    ASSERT_NE(pool, nullptr);
+
+    std::vector<fds_tmgr_t *> managers;
+    for (int i = 0; i < 4; ++i) {
+        fds_tmgr_t *tmgr = fds_tmgr_create_pool(FDS_SESSION_FILE, pool);
+        ASSERT_NE(tmgr, nullptr);
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+        ASSERT_EQ(templates_add(tmgr, 20, 1), FDS_OK);
+        managers.push_back(tmgr);
+    }
+
+    struct fds_tpool_stats stats;
+    fds_tpool_stats(pool, &stats);
+    EXPECT_GE(stats.objects, 4U);
+    fds_tpool_destroy(pool);
+
+    // Garbage outlives the managers (and the pool)
+    std::vector<fds_tgarbage_t *> garbage;
+    for (auto tmgr : managers) {
+        fds_tgarbage_t *gc;
+        fds_tmgr_clear(tmgr);
+        ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &gc), FDS_OK);
+        ASSERT_NE(gc, nullptr);
+        garbage.push_back(gc);
+        fds_tmgr_destroy(tmgr);
+    }
+
+    for (auto gc : garbage) {
+        fds_tmgr_garbage_destroy(gc);
+    }
+}
+
+// Reserved memory is limited
+TEST(pool, limit)
+{
+    const size_t limit = 256 * 1024;
+    fds_tpool_t *pool = fds_tpool_create(limit);
+    ASSERT_NE(pool, nullptr);
+    fds_tmgr_t *tmgr = fds_tmgr_create_pool(FDS_SESSION_TCP, pool);
+    ASSERT_NE(tmgr, nullptr);
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 10), FDS_OK);
+
+    // Each template in its own L2 table
+    EXPECT_EQ(templates_add(tmgr, 255, 256), FDS_ERR_NOMEM);
+
+    struct fds_tpool_stats stats;
+    fds_tpool_stats(pool, &stats);
+    EXPECT_LE(stats.reserved, limit);
+    EXPECT_GT(stats.failures, 0U);
+
+    fds_tmgr_destroy(tmgr);
+    fds_tpool_destroy(pool);
+}
@@ -0,0 +1,228 @@
+/**
+ * \brief Test cases for publication of template snapshots
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <TGenerator.h>
+#include <TMock.h>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+class publish : public ::testing::Test {
+protected:
+    fds_tmgr_t *tmgr = nullptr;
+    fds_tpub_t *pub = nullptr;
+
+    /** \brief Prepare a template manager and a publisher */
+    void SetUp() override {
+        tmgr = fds_tmgr_create(FDS_SESSION_TCP);
+        pub = fds_tpub_create(4);
+        if (!tmgr || !pub) {
+            throw std::runtime_error("Failed to create a template manager or a publisher!");
+        }
+    }
+
+    /** \brief Destroy the publisher and the template manager */
+    void TearDown() override {
+        fds_tpub_destroy(pub);
+        fds_tmgr_destroy(tmgr);
+    }
+};
+
+// Nothing has been published yet
+TEST_F(publish, empty)
+{
+    EXPECT_EQ(fds_tpub_create(0), nullptr);
+
+    fds_tpub_reader_t *reader = fds_tpub_reader_register(pub);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(fds_tpub_reader_get(reader), nullptr);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 0U);
+
+    // Publish an empty snapshot
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 10), FDS_OK);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    const fds_tsnapshot_t *snap = fds_tpub_reader_get(reader);
+    ASSERT_NE(snap, nullptr);
+    EXPECT_EQ(fds_tsnapshot_template_get(snap, 256), nullptr);
+    fds_tpub_reader_unregister(reader);
+}
+
+// The maximum number of readers
+TEST_F(publish, readersMax)
+{
+    std::vector<fds_tpub_reader_t *> readers;
+    for (int i = 0; i < 4; ++i) {
+        fds_tpub_reader_t *reader = fds_tpub_reader_register(pub);
+        ASSERT_NE(reader, nullptr);
+        readers.push_back(reader);
+    }
+
+    EXPECT_EQ(fds_tpub_reader_register(pub), nullptr);
+    fds_tpub_reader_unregister(readers[2]);
+    readers[2] = fds_tpub_reader_register(pub);
+    EXPECT_NE(readers[2], nullptr);
+
+    for (auto reader : readers) {
+        fds_tpub_reader_unregister(reader);
+    }
+}
+
+// Garbage cannot be destroyed until all online readers pass a quiescent point
+TEST_F(publish, reclaim)
+{
+    const uint16_t tid = 256;
+    fds_tpub_reader_t *r1 = fds_tpub_reader_register(pub);
+    fds_tpub_reader_t *r2 = fds_tpub_reader_register(pub);
+    ASSERT_NE(r1, nullptr);
+    ASSERT_NE(r2, nullptr);
+
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+    struct fds_template *tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, tid);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, tmplt), FDS_OK);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+
+    const fds_tsnapshot_t *snap1 = fds_tpub_reader_get(r1);
+    ASSERT_NE(snap1, nullptr);
+    EXPECT_EQ(fds_tpub_reader_get(r2), snap1);
+    const struct fds_template *tmplt1 = fds_tsnapshot_template_get(snap1, tid);
+    ASSERT_NE(tmplt1, nullptr);
+    EXPECT_EQ(tmplt1->id, tid);
+
+    // Nothing has changed
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    EXPECT_EQ(fds_tpub_reader_get(r1), snap1);
+
+    // Redefine the template (the previous one and the old snapshot become garbage)
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_withdraw(tmgr, tid, FDS_TYPE_TEMPLATE), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_BIFLOW, tid)),
+        FDS_OK);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 1U);
+
+    // Readers still hold the old snapshot
+    EXPECT_EQ(fds_tsnapshot_template_get(snap1, tid), tmplt1);
+    EXPECT_EQ(tmplt1->id, tid);
+
+    fds_tpub_reader_quiescent(r1);
+    const fds_tsnapshot_t *snap2 = fds_tpub_reader_get(r1);
+    ASSERT_NE(snap2, nullptr);
+    EXPECT_NE(snap2, snap1);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 1U);
+
+    // The other reader goes offline
+    fds_tpub_reader_offline(r2);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 0U);
+    fds_tpub_reader_online(r2);
+    EXPECT_EQ(fds_tpub_reader_get(r2), snap2);
+
+    // Withdraw all templates
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 300), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_withdraw_all(tmgr, FDS_TYPE_TEMPLATE_UNDEF), FDS_OK);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    const fds_tsnapshot_t *snap3 = fds_tpub_reader_get(r2);
+    ASSERT_NE(snap3, nullptr);
+    EXPECT_EQ(fds_tsnapshot_template_get(snap3, tid), nullptr);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 1U);
+
+    // Unregistered readers don't block destruction
+    fds_tpub_reader_unregister(r1);
+    fds_tpub_reader_unregister(r2);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 0U);
+}
+
+// Retired garbage is destroyed together with the publisher
+TEST_F(publish, destroyPending)
+{
+    fds_tpub_reader_t *reader = fds_tpub_reader_register(pub);
+    ASSERT_NE(reader, nullptr);
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, 100 * i), FDS_OK);
+        struct fds_template *tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, 256 + i);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, tmplt), FDS_OK);
+        ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    }
+
+    EXPECT_GT(fds_tpub_reclaim(pub), 16U);
+    fds_tpub_reader_unregister(reader);
+}
+
+// Readers in multiple threads access templates while the owner modifies the manager
+TEST_F(publish, threads)
+{
+    const uint16_t tid_cnt = 16;
+    const uint32_t updates = 2000;
+    std::atomic<bool> stop(false);
+
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 0), FDS_OK);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+
+    auto reader_fn = [&]() {
+        fds_tpub_reader_t *reader = fds_tpub_reader_register(pub);
+        ASSERT_NE(reader, nullptr);
+        uint64_t found = 0;
+
+        while (!stop.load()) {
+            const fds_tsnapshot_t *snap = fds_tpub_reader_get(reader);
+            ASSERT_NE(snap, nullptr);
+            for (uint16_t i = 0; i < tid_cnt; ++i) {
+                const uint16_t tid = 256 + i;
+                const struct fds_template *tmplt = fds_tsnapshot_template_get(snap, tid);
+                if (!tmplt) {
+                    continue;
+                }
+
+                // Access the content of the template
+                ASSERT_EQ(tmplt->id, tid);
+                ASSERT_NE(fds_template_cfind(tmplt, 0, 8), nullptr);
+                found++;
+            }
+
+            fds_tpub_reader_quiescent(reader);
+            if (found % 7 == 0) {
+                fds_tpub_reader_offline(reader);
+                std::this_thread::yield();
+                fds_tpub_reader_online(reader);
+            }
+        }
+
+        fds_tpub_reader_unregister(reader);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; ++i) {
+        threads.emplace_back(reader_fn);
+    }
+
+    for (uint32_t i = 1; i <= updates; ++i) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, i), FDS_OK);
+        const uint16_t tid = 256 + (i % tid_cnt);
+        const struct fds_template *tmplt;
+        if (fds_tmgr_template_get(tmgr, tid, &tmplt) == FDS_OK) {
+            // Withdraw the template and define it again later
+            ASSERT_EQ(fds_tmgr_template_withdraw(tmgr, tid, FDS_TYPE_TEMPLATE), FDS_OK);
+        } else {
+            const enum TMock::type type = (i % 3 == 0)
+                ? TMock::type::DATA_BASIC_BIFLOW : TMock::type::DATA_BASIC_FLOW;
+            ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(type, tid)), FDS_OK);
+        }
+        ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    }
+
+    stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(fds_tpub_reclaim(pub), 0U);
+}
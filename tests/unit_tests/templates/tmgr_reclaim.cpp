@@ -0,0 +1,299 @@
+/**
+ * \brief Test cases for background reclamation of template manager garbage
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <TGenerator.h>
+#include <TMock.h>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+class reclaim : public ::testing::Test {
+protected:
+    fds_tmgr_t *tmgr = nullptr;
+
+    /** \brief Prepare a template manager */
+    void SetUp() override {
+        tmgr = fds_tmgr_create(FDS_SESSION_TCP);
+        if (!tmgr) {
+            throw std::runtime_error("Failed to create a template manager!");
+        }
+    }
+
+    /** \brief Destroy the template manager */
+    void TearDown() override {
+        fds_tmgr_destroy(tmgr);
+    }
+
+    /** \brief Redefine a template to produce garbage */
+    void churn(uint32_t time, uint16_t id) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, time), FDS_OK);
+        const struct fds_template *tmplt;
+        if (fds_tmgr_template_get(tmgr, id, &tmplt) == FDS_OK) {
+            ASSERT_EQ(fds_tmgr_template_withdraw(tmgr, id, FDS_TYPE_TEMPLATE), FDS_OK);
+        }
+        const enum TMock::type type = (time % 2)
+            ? TMock::type::DATA_BASIC_BIFLOW : TMock::type::DATA_BASIC_FLOW;
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(type, id)), FDS_OK);
+    }
+};
+
+// Garbage of a manager is destroyed by the worker thread
+TEST_F(reclaim, push)
+{
+    EXPECT_EQ(fds_tgc_create(0), nullptr);
+    fds_tgc_t *tgc = fds_tgc_create(64);
+    ASSERT_NE(tgc, nullptr);
+    EXPECT_EQ(fds_tgc_push(tgc, nullptr), FDS_OK);
+
+    uint64_t pushed = 0;
+    for (uint32_t i = 1; i <= 200; ++i) {
+        churn(i, 256 + (i % 8));
+        fds_tgarbage_t *gc;
+        ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &gc), FDS_OK);
+        if (!gc) {
+            continue;
+        }
+
+        if (fds_tgc_push(tgc, gc) != FDS_OK) {
+            fds_tmgr_garbage_destroy(gc);
+            continue;
+        }
+        pushed++;
+    }
+
+    fds_tgc_flush(tgc);
+    struct fds_tgc_stats stats;
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_GT(pushed, 0U);
+    EXPECT_EQ(stats.pushed, pushed);
+    EXPECT_EQ(stats.reclaimed, pushed);
+    EXPECT_EQ(stats.queue_depth, 0U);
+    EXPECT_GE(stats.queue_peak, 1U);
+    EXPECT_LE(stats.queue_peak, 64U);
+    EXPECT_GT(stats.latency_max, 0U);
+    EXPECT_LE(stats.latency_avg, stats.latency_max);
+
+    // Flush of the empty queue returns immediately
+    fds_tgc_flush(tgc);
+    fds_tgc_destroy(tgc);
+}
+
+// Garbage retired by a publisher waits for quiescent states of its readers
+TEST_F(reclaim, deferred)
+{
+    const uint16_t tid = 256;
+    fds_tgc_t *tgc = fds_tgc_create(2);
+    fds_tpub_t *pub = fds_tpub_create(2);
+    ASSERT_NE(tgc, nullptr);
+    ASSERT_NE(pub, nullptr);
+    fds_tpub_set_tgc(pub, tgc);
+
+    churn(100, tid);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    fds_tgc_flush(tgc);
+    struct fds_tgc_stats stats;
+    fds_tgc_stats(tgc, &stats);
+    const uint64_t base = stats.reclaimed;
+
+    fds_tpub_reader_t *reader = fds_tpub_reader_register(pub);
+    ASSERT_NE(reader, nullptr);
+    const fds_tsnapshot_t *snap = fds_tpub_reader_get(reader);
+    const struct fds_template *tmplt = fds_tsnapshot_template_get(snap, tid);
+    ASSERT_NE(tmplt, nullptr);
+
+    // Fill the queue with garbage that can be held by the reader
+    churn(200, tid);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    churn(300, tid);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 0U);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.queue_depth, 2U);
+    EXPECT_EQ(stats.reclaimed, base);
+    EXPECT_EQ(fds_tsnapshot_template_get(snap, tid), tmplt);
+    EXPECT_EQ(tmplt->id, tid);
+
+    // The queue is full -> the publisher keeps the garbage
+    churn(400, tid);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 1U);
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.rejected, 1U);
+
+    // The reader doesn't hold the snapshot anymore
+    fds_tpub_reader_quiescent(reader);
+    fds_tgc_flush(tgc);
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.queue_depth, 0U);
+    EXPECT_EQ(stats.reclaimed, base + 2);
+    EXPECT_GE(stats.latency_max, 20000000U);
+    EXPECT_EQ(fds_tpub_reclaim(pub), 0U);
+
+    // Garbage of an offline reader is destroyed without waiting
+    fds_tpub_reader_offline(reader);
+    churn(500, tid);
+    ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    fds_tgc_flush(tgc);
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.reclaimed, base + 3);
+
+    fds_tpub_reader_unregister(reader);
+    fds_tpub_destroy(pub);
+    fds_tgc_destroy(tgc);
+}
+
+// Deferred garbage of a publisher doesn't block garbage of others
+TEST_F(reclaim, independentPublishers)
+{
+    const uint16_t tid = 256;
+    fds_tgc_t *tgc = fds_tgc_create(8);
+    fds_tpub_t *pub_stalled = fds_tpub_create(1);
+    fds_tpub_t *pub_other = fds_tpub_create(1);
+    fds_tmgr_t *tmgr_other = fds_tmgr_create(FDS_SESSION_TCP);
+    ASSERT_NE(tgc, nullptr);
+    ASSERT_NE(pub_stalled, nullptr);
+    ASSERT_NE(pub_other, nullptr);
+    ASSERT_NE(tmgr_other, nullptr);
+    fds_tpub_set_tgc(pub_stalled, tgc);
+    fds_tpub_set_tgc(pub_other, tgc);
+
+    // Garbage held by a stalled reader
+    churn(100, tid);
+    ASSERT_EQ(fds_tpub_update(pub_stalled, tmgr), FDS_OK);
+    fds_tgc_flush(tgc);
+    fds_tpub_reader_t *reader = fds_tpub_reader_register(pub_stalled);
+    ASSERT_NE(reader, nullptr);
+    churn(200, tid);
+    ASSERT_EQ(fds_tpub_update(pub_stalled, tmgr), FDS_OK);
+    struct fds_tgc_stats stats;
+    fds_tgc_stats(tgc, &stats);
+    const uint64_t base = stats.reclaimed;
+    ASSERT_EQ(stats.queue_depth, 1U);
+
+    // Garbage of another manager (without readers) is destroyed anyway
+    for (uint32_t time = 1; time <= 3; ++time) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr_other, time), FDS_OK);
+        if (time > 1) {
+            ASSERT_EQ(fds_tmgr_template_withdraw(tmgr_other, tid, FDS_TYPE_TEMPLATE), FDS_OK);
+        }
+        ASSERT_EQ(fds_tmgr_template_add(tmgr_other,
+            TMock::create(TMock::type::DATA_BASIC_FLOW, tid)), FDS_OK);
+        if (time == 2) {
+            fds_tgarbage_t *gc;
+            ASSERT_EQ(fds_tmgr_garbage_get(tmgr_other, &gc), FDS_OK);
+            ASSERT_NE(gc, nullptr);
+            ASSERT_EQ(fds_tgc_push(tgc, gc), FDS_OK);
+        } else {
+            ASSERT_EQ(fds_tpub_update(pub_other, tmgr_other), FDS_OK);
+        }
+    }
+
+    for (int i = 0; i < 1000 && stats.reclaimed < base + 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        fds_tgc_stats(tgc, &stats);
+    }
+    EXPECT_EQ(stats.reclaimed, base + 2);
+    EXPECT_EQ(stats.queue_depth, 1U);
+
+    // Destruction of the other publisher doesn't wait for the stalled reader
+    fds_tpub_destroy(pub_other);
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.queue_depth, 1U);
+
+    fds_tpub_reader_quiescent(reader);
+    fds_tgc_flush(tgc);
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.queue_depth, 0U);
+    EXPECT_EQ(stats.reclaimed, base + 3);
+
+    fds_tpub_reader_unregister(reader);
+    fds_tpub_destroy(pub_stalled);
+    fds_tgc_destroy(tgc);
+    fds_tmgr_destroy(tmgr_other);
+}
+
+// Pending garbage is destroyed together with the service
+TEST_F(reclaim, destroyPending)
+{
+    fds_tgc_t *tgc = fds_tgc_create(128);
+    fds_tpub_t *pub = fds_tpub_create(1);
+    ASSERT_NE(tgc, nullptr);
+    ASSERT_NE(pub, nullptr);
+    fds_tpub_set_tgc(pub, tgc);
+
+    for (uint32_t i = 1; i <= 32; ++i) {
+        churn(i, 256 + i);
+        ASSERT_EQ(fds_tpub_update(pub, tmgr), FDS_OK);
+    }
+
+    // The publisher is destroyed first, therefore, the service has nothing to wait for
+    fds_tpub_destroy(pub);
+    fds_tgc_destroy(tgc);
+}
+
+// Multiple threads share the service
+TEST_F(reclaim, threads)
+{
+    const int threads_cnt = 4;
+    fds_tgc_t *tgc = fds_tgc_create(16);
+    ASSERT_NE(tgc, nullptr);
+
+    auto owner_fn = [&](uint64_t *pushed) {
+        fds_tmgr_t *mgr = fds_tmgr_create(FDS_SESSION_TCP);
+        ASSERT_NE(mgr, nullptr);
+        for (uint32_t i = 1; i <= 1000; ++i) {
+            ASSERT_EQ(fds_tmgr_set_time(mgr, i), FDS_OK);
+            const uint16_t tid = 256 + (i % 16);
+            const struct fds_template *tmplt;
+            if (fds_tmgr_template_get(mgr, tid, &tmplt) == FDS_OK) {
+                ASSERT_EQ(fds_tmgr_template_withdraw(mgr, tid, FDS_TYPE_TEMPLATE), FDS_OK);
+            } else {
+                tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, tid);
+                ASSERT_EQ(fds_tmgr_template_add(mgr, (struct fds_template *) tmplt), FDS_OK);
+            }
+
+            fds_tgarbage_t *gc;
+            ASSERT_EQ(fds_tmgr_garbage_get(mgr, &gc), FDS_OK);
+            if (gc != nullptr && fds_tgc_push(tgc, gc) == FDS_OK) {
+                (*pushed)++;
+            } else {
+                fds_tmgr_garbage_destroy(gc);
+            }
+        }
+
+        fds_tmgr_destroy(mgr);
+    };
+
+    std::vector<uint64_t> pushed(threads_cnt, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threads_cnt; ++i) {
+        threads.emplace_back(owner_fn, &pushed[i]);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    uint64_t total = 0;
+    for (uint64_t cnt : pushed) {
+        total += cnt;
+    }
+
+    fds_tgc_flush(tgc);
+    struct fds_tgc_stats stats;
+    fds_tgc_stats(tgc, &stats);
+    EXPECT_EQ(stats.pushed, total);
+    EXPECT_EQ(stats.reclaimed, total);
+    EXPECT_LE(stats.queue_peak, 16U);
+    fds_tgc_destroy(tgc);
+}
@@ -0,0 +1,208 @@
+/**
+ * \brief Test cases for the registry of template managers
+ */
+
+#include <gtest/gtest.h>
+#include <libfds.h>
+#include <TGenerator.h>
+#include <TMock.h>
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+class registry : public ::testing::Test {
+protected:
+    fds_tpool_t *pool = nullptr;
+    fds_treg_t *reg = nullptr;
+
+    /** \brief Prepare a registry with a shared pool */
+    void SetUp() override {
+        pool = fds_tpool_create(0);
+        reg = fds_treg_create(pool, nullptr);
+        if (!pool || !reg) {
+            throw std::runtime_error("Failed to create a registry!");
+        }
+    }
+
+    /** \brief Destroy the registry and the pool */
+    void TearDown() override {
+        fds_treg_destroy(reg);
+        fds_tpool_destroy(pool);
+    }
+
+    /** \brief Add a session with a template */
+    void session_add(uint64_t id, uint32_t exp_time) {
+        fds_tmgr_t *tmgr;
+        ASSERT_EQ(fds_treg_add(reg, id, FDS_SESSION_TCP, &tmgr), FDS_OK);
+        ASSERT_NE(tmgr, nullptr);
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, exp_time), FDS_OK);
+        struct fds_template *tmplt = TMock::create(TMock::type::DATA_BASIC_FLOW, 256);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, tmplt), FDS_OK);
+    }
+};
+
+// Add, find and remove sessions
+TEST_F(registry, addFindRemove)
+{
+    EXPECT_EQ(fds_treg_count(reg), 0U);
+    EXPECT_EQ(fds_treg_find(reg, 1), nullptr);
+    EXPECT_EQ(fds_treg_remove(reg, 1), FDS_ERR_NOTFOUND);
+
+    const uint64_t sessions = 10000;
+    for (uint64_t id = 0; id < sessions; ++id) {
+        session_add(id << 32, 100);
+    }
+    EXPECT_EQ(fds_treg_count(reg), sessions);
+
+    fds_tmgr_t *tmgr = nullptr;
+    EXPECT_EQ(fds_treg_add(reg, 5ULL << 32, FDS_SESSION_UDP, &tmgr), FDS_ERR_ARG);
+    EXPECT_EQ(tmgr, nullptr);
+
+    for (uint64_t id = 0; id < sessions; ++id) {
+        tmgr = fds_treg_find(reg, id << 32);
+        ASSERT_NE(tmgr, nullptr);
+        const struct fds_template *tmplt;
+        ASSERT_EQ(fds_tmgr_template_get(tmgr, 256, &tmplt), FDS_OK);
+    }
+    EXPECT_EQ(fds_treg_find(reg, 1), nullptr);
+
+    // Remove every other session
+    for (uint64_t id = 0; id < sessions; id += 2) {
+        ASSERT_EQ(fds_treg_remove(reg, id << 32), FDS_OK);
+    }
+    EXPECT_EQ(fds_treg_count(reg), sessions / 2);
+    EXPECT_EQ(fds_treg_find(reg, 0), nullptr);
+    EXPECT_NE(fds_treg_find(reg, 1ULL << 32), nullptr);
+
+    // Templates of removed sessions are in garbage
+    fds_tgarbage_t *gc;
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    ASSERT_NE(gc, nullptr);
+    fds_tmgr_garbage_destroy(gc);
+}
+
+// Garbage of multiple sessions is collected at once
+TEST_F(registry, garbageBatch)
+{
+    fds_tgarbage_t *gc;
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    EXPECT_EQ(gc, nullptr);
+
+    for (uint64_t id = 0; id < 16; ++id) {
+        session_add(id, 100);
+    }
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    fds_tmgr_garbage_destroy(gc);
+
+    // Withdraw the template in a few sessions
+    for (uint64_t id = 0; id < 16; id += 4) {
+        fds_tmgr_t *tmgr = fds_treg_find(reg, id);
+        ASSERT_NE(tmgr, nullptr);
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, 200), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_withdraw(tmgr, 256, FDS_TYPE_TEMPLATE), FDS_OK);
+    }
+
+    struct fds_tpool_stats stats_before, stats_after;
+    fds_tpool_stats(pool, &stats_before);
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    ASSERT_NE(gc, nullptr);
+    fds_tmgr_garbage_destroy(gc);
+    fds_tpool_stats(pool, &stats_after);
+    EXPECT_LT(stats_after.objects, stats_before.objects);
+
+    // Nothing has been accessed since the last collection
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    EXPECT_EQ(gc, nullptr);
+}
+
+// Idle sessions are expired
+TEST_F(registry, idleTimeout)
+{
+    const uint32_t timeout = 600;
+    ASSERT_EQ(fds_treg_set_time(reg, 1000), FDS_OK);
+    fds_treg_set_idle_timeout(reg, timeout);
+
+    for (uint64_t id = 0; id < 100; ++id) {
+        session_add(id, 100);
+    }
+
+    // Keep odd sessions active
+    for (uint32_t now = 1100; now <= 1000 + 3 * timeout; now += 100) {
+        ASSERT_EQ(fds_treg_set_time(reg, now), FDS_OK);
+        for (uint64_t id = 1; id < 100; id += 2) {
+            ASSERT_NE(fds_treg_find(reg, id), nullptr);
+        }
+    }
+
+    EXPECT_EQ(fds_treg_count(reg), 50U);
+    EXPECT_EQ(fds_treg_find(reg, 0), nullptr);
+
+    // Long inactivity (longer than a rotation of the wheel)
+    ASSERT_EQ(fds_treg_set_time(reg, 1000 + 100 * timeout), FDS_OK);
+    EXPECT_EQ(fds_treg_count(reg), 0U);
+
+    fds_tgarbage_t *gc;
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    ASSERT_NE(gc, nullptr);
+    fds_tmgr_garbage_destroy(gc);
+
+    struct fds_tpool_stats stats;
+    fds_tpool_stats(pool, &stats);
+    EXPECT_EQ(stats.objects, 0U);
+}
+
+// Sessions are not expired before their timeout
+TEST_F(registry, idleTimeoutPrecision)
+{
+    const uint32_t timeout = 1000;
+    fds_treg_set_idle_timeout(reg, timeout);
+    ASSERT_EQ(fds_treg_set_time(reg, 5000), FDS_OK);
+    session_add(1, 100);
+
+    ASSERT_EQ(fds_treg_set_time(reg, 5000 + timeout - 1), FDS_OK);
+    EXPECT_EQ(fds_treg_count(reg), 1U);
+    // At most 1/128 of the timeout later
+    ASSERT_EQ(fds_treg_set_time(reg, 5000 + timeout + timeout / 128 + 1), FDS_OK);
+    EXPECT_EQ(fds_treg_count(reg), 0U);
+
+    // Shorten the timeout of existing sessions
+    session_add(2, 100);
+    ASSERT_EQ(fds_treg_set_time(reg, 8000), FDS_OK);
+    fds_treg_set_idle_timeout(reg, 10);
+    ASSERT_EQ(fds_treg_set_time(reg, 8001), FDS_OK);
+    EXPECT_EQ(fds_treg_count(reg), 0U);
+}
+
+// The IE manager is shared by all sessions
+TEST_F(registry, iemgr)
+{
+    fds_iemgr_t *iemgr = fds_iemgr_create();
+    ASSERT_NE(iemgr, nullptr);
+    ASSERT_EQ(fds_iemgr_read_file(iemgr, "data/iana.xml", true), FDS_OK);
+
+    session_add(1, 100);
+    ASSERT_EQ(fds_treg_set_iemgr(reg, iemgr), FDS_OK);
+    session_add(2, 100);
+
+    for (uint64_t id = 1; id <= 2; ++id) {
+        const struct fds_template *tmplt;
+        fds_tmgr_t *tmgr = fds_treg_find(reg, id);
+        ASSERT_NE(tmgr, nullptr);
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_get(tmgr, 256, &tmplt), FDS_OK);
+        EXPECT_NE(tmplt->fields[0].def, nullptr);
+    }
+
+    // Old templates must be destroyed before the IE manager
+    fds_tgarbage_t *gc;
+    ASSERT_EQ(fds_treg_garbage_get(reg, &gc), FDS_OK);
+    fds_tmgr_garbage_destroy(gc);
+    fds_treg_destroy(reg);
+    reg = nullptr;
+    fds_iemgr_destroy(iemgr);
+    reg = fds_treg_create(pool, nullptr);
+    ASSERT_NE(reg, nullptr);
+}
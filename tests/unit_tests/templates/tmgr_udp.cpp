@@ -341,3 +341,175 @@ TEST_P(udp, disableTimeoutLater)
 
 // TODO: Test combination of snapshot timeouts and template timeouts (+ on demand snapshot)
 
+
+// Random access to a long history of snapshots (including timestamp wraparound)
+TEST_P(udp, longHistorySeek)
+{
+    const uint32_t steps = 500;
+    const uint32_t base = UINT32_MAX - 400U;
+    const uint16_t tid1 = 256;
+    const uint16_t tid2 = 300;
+    fds_tmgr_set_snapshot_timeout(tmgr, 2 * steps);
+
+    // Redefine the template every 2 seconds
+    for (uint32_t i = 0; i < steps; ++i) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, base + 2 * i), FDS_OK);
+        const enum TMock::type type = (i % 2 == 0)
+            ? TMock::type::DATA_BASIC_FLOW : TMock::type::DATA_BASIC_BIFLOW;
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(type, tid1)), FDS_OK);
+    }
+
+    auto check = [&](uint32_t i, bool is_defined) {
+        const struct fds_template *tmplt;
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, base + 2 * i + (i % 3 == 0)), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt), FDS_OK);
+        EXPECT_EQ(tmplt->time.first_seen, base + 2 * i);
+        EXPECT_EQ(fds_tmgr_template_get(tmgr, tid2, &tmplt), is_defined ? FDS_OK : FDS_ERR_NOTFOUND);
+    };
+
+    // Jump back and forth through the history
+    const uint32_t middle = steps / 2;
+    for (uint32_t i = 0; i < steps; ++i) {
+        check((i * 7919U) % steps, false);
+        check(steps - 1, false);
+    }
+
+    // Define a template in the history and make sure that it is propagated to newer snapshots
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, base + 2 * middle + 1), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::OPTS_MPROC_RSTAT, tid2)),
+        FDS_OK);
+
+    fds_tgarbage_t *garbage;
+    for (int round = 0; round < 2; ++round) {
+        for (uint32_t i = 0; i < steps; ++i) {
+            const uint32_t idx = (i * 7919U) % steps;
+            check(idx, idx > middle || (idx == middle && idx % 3 == 0));
+            check(0, false);
+        }
+
+        // Remove the hidden snapshots and rebuild the index
+        ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &garbage), FDS_OK);
+        if (garbage != nullptr) {
+            fds_tmgr_garbage_destroy(garbage);
+        }
+    }
+}
+
+// Refresh of the same template at the same Export Time doesn't create a new snapshot
+TEST_P(udp, templateRefreshSameTime)
+{
+    const uint16_t tid1 = 256;
+    fds_tmgr_set_udp_timeouts(tmgr, 10, 10);
+
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 100), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid1)), FDS_OK);
+    const fds_tsnapshot_t *snap1;
+    ASSERT_EQ(fds_tmgr_snapshot_get(tmgr, &snap1), FDS_OK);
+    const struct fds_template *tmplt1 = fds_tsnapshot_template_get(snap1, tid1);
+    ASSERT_NE(tmplt1, nullptr);
+
+    // The snapshot is already frozen, but the refresh doesn't change anything
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid1)),
+            FDS_OK);
+        const fds_tsnapshot_t *snap;
+        ASSERT_EQ(fds_tmgr_snapshot_get(tmgr, &snap), FDS_OK);
+        EXPECT_EQ(snap, snap1);
+        EXPECT_EQ(fds_tsnapshot_template_get(snap, tid1), tmplt1);
+    }
+
+    // Nothing to throw away
+    fds_tgarbage_t *garbage;
+    ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &garbage), FDS_OK);
+    EXPECT_EQ(garbage, nullptr);
+
+    // A refresh at a later Export Time only records new timestamps of the template
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 105), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid1)), FDS_OK);
+    const struct fds_template *tmplt;
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt), FDS_OK);
+    EXPECT_EQ(tmplt, tmplt1);
+    uint32_t last_seen, end_of_life;
+    fds_tmgr_template_time(tmgr, tmplt, &last_seen, &end_of_life);
+    EXPECT_EQ(last_seen, 105U);
+    EXPECT_EQ(end_of_life, 115U);
+    // ... the template itself is never modified
+    EXPECT_EQ(tmplt1->time.first_seen, 100U);
+    EXPECT_EQ(tmplt1->time.last_seen, 100U);
+    EXPECT_EQ(tmplt1->time.end_of_life, 110U);
+
+    // The template expires after the timeout of the last refresh
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 115), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt), FDS_OK);
+    EXPECT_EQ(tmplt, tmplt1);
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, 116), FDS_OK);
+    EXPECT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt), FDS_ERR_NOTFOUND);
+}
+
+// Periodic refreshes of the same template create neither new snapshots nor garbage
+TEST_P(udp, templateRefreshPeriodic)
+{
+    const uint16_t tid1 = 256;
+    const uint16_t tid2 = 257;
+    const uint32_t time_start = 1000;
+    const unsigned int refresh_cnt = 50;
+    fds_tmgr_set_udp_timeouts(tmgr, 10, 10);
+
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, time_start), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid1)), FDS_OK);
+    ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::OPTS_MPROC_STAT, tid2)), FDS_OK);
+    const fds_tsnapshot_t *snap1;
+    ASSERT_EQ(fds_tmgr_snapshot_get(tmgr, &snap1), FDS_OK);
+    const struct fds_template *tmplt1 = fds_tsnapshot_template_get(snap1, tid1);
+    const struct fds_template *tmplt2 = fds_tsnapshot_template_get(snap1, tid2);
+    ASSERT_NE(tmplt1, nullptr);
+    ASSERT_NE(tmplt2, nullptr);
+
+    fds_tgarbage_t *garbage;
+    ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &garbage), FDS_OK);
+    if (garbage != nullptr) {
+        fds_tmgr_garbage_destroy(garbage);
+    }
+
+    // Refresh both templates every second (far beyond their original end of life)
+    for (unsigned int i = 1; i <= refresh_cnt; ++i) {
+        const uint32_t time_now = time_start + i;
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, time_now), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::DATA_BASIC_FLOW, tid1)),
+            FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::OPTS_MPROC_STAT, tid2)),
+            FDS_OK);
+
+        ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &garbage), FDS_OK);
+        EXPECT_EQ(garbage, nullptr);
+        const fds_tsnapshot_t *snap;
+        ASSERT_EQ(fds_tmgr_snapshot_get(tmgr, &snap), FDS_OK);
+        EXPECT_EQ(snap, snap1);
+        EXPECT_EQ(fds_tsnapshot_template_get(snap, tid1), tmplt1);
+        EXPECT_EQ(fds_tsnapshot_template_get(snap, tid2), tmplt2);
+
+        uint32_t last_seen, end_of_life;
+        fds_tmgr_template_time(tmgr, tmplt1, &last_seen, &end_of_life);
+        EXPECT_EQ(last_seen, time_now);
+        EXPECT_EQ(end_of_life, time_now + 10);
+    }
+
+    // Only the second template is refreshed from now on
+    const uint32_t time_last = time_start + refresh_cnt;
+    for (uint32_t time_now = time_last + 1; time_now <= time_last + 10; ++time_now) {
+        ASSERT_EQ(fds_tmgr_set_time(tmgr, time_now), FDS_OK);
+        ASSERT_EQ(fds_tmgr_template_add(tmgr, TMock::create(TMock::type::OPTS_MPROC_STAT, tid2)),
+            FDS_OK);
+        const struct fds_template *tmplt;
+        EXPECT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt), FDS_OK);
+        ASSERT_EQ(fds_tmgr_garbage_get(tmgr, &garbage), FDS_OK);
+        EXPECT_EQ(garbage, nullptr);
+    }
+
+    // The first template expires after the timeout of its last refresh
+    ASSERT_EQ(fds_tmgr_set_time(tmgr, time_last + 11), FDS_OK);
+    const struct fds_template *tmplt;
+    EXPECT_EQ(fds_tmgr_template_get(tmgr, tid1, &tmplt), FDS_ERR_NOTFOUND);
+    ASSERT_EQ(fds_tmgr_template_get(tmgr, tid2, &tmplt), FDS_OK);
+    EXPECT_EQ(tmplt, tmplt2);
+}